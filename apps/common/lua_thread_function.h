@@ -0,0 +1,150 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief A lua function wrapper that is safe to call from several threads.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifdef HAVE_LUA
+
+// user includes
+#include <flecsale/utils/errors.h>
+#include <flecsale/utils/lua_utils.h>
+
+// system includes
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A lua function that can be called from within a parallel region.
+//!
+//! A single lua state cannot be used by more than one thread at a time.
+//! This wrapper gives every OpenMP thread its own interpreter.  The master
+//! thread uses the function it was constructed with, while an interpreter
+//! for each of the other threads is loaded when the wrapper is built, so
+//! any error in the input file is raised there and not from inside a
+//! parallel region.  The input file is therefore executed once per thread.
+//!
+//! A team can turn out larger than the one the interpreters were loaded
+//! for, for example after omp_set_num_threads, or a nested region can
+//! reuse the thread numbers.  The threads without their own interpreter
+//! share one more spare interpreter, and take turns using it.
+////////////////////////////////////////////////////////////////////////////////
+class lua_thread_function_t {
+
+public:
+
+  //! \brief The lua result type.
+  using lua_result_t = flecsale::utils::lua_result_t;
+
+  //! \brief The lua state type.
+  using lua_t = flecsale::utils::lua_t;
+
+  //! \brief The function type used to find the function in a new state.
+  using locator_t = std::function< lua_result_t( const lua_t & ) >;
+
+  //! \brief Main constructor.
+  //! \param [in] file  The input file to load for each new thread.
+  //! \param [in] func  The function to use on the master thread.
+  //! \param [in] locator  Finds the function in a freshly loaded state.
+  lua_thread_function_t(
+    const std::string & file,
+    const lua_result_t & func,
+    const locator_t & locator
+  ) : data_( std::make_shared<data_t>() )
+  {
+    data_->file = file;
+    data_->locator = locator;
+    data_->funcs.emplace_back( std::make_unique<lua_result_t>( func ) );
+#ifdef _OPENMP
+    reserve( omp_get_max_threads() );
+#endif
+    data_->spare = load();
+  }
+
+  //! \brief Load interpreters for a team of threads.
+  //!
+  //! This must be called outside of a parallel region.
+  //! \param [in] num_threads  The number of threads in the team.
+  void reserve( std::size_t num_threads )
+  {
+#ifdef _OPENMP
+    if ( omp_in_parallel() )
+      raise_runtime_error( 
+        "Lua interpreters cannot be loaded inside a parallel region" 
+      );
+#endif
+    while ( data_->funcs.size() < num_threads ) 
+      data_->funcs.emplace_back( load() );
+  }
+
+  //! \brief The number of threads that have their own interpreter.
+  std::size_t num_reserved() const
+  { return data_->funcs.size(); }
+
+  //! \brief Call the function on the current thread's interpreter.
+  //!
+  //! The results are converted before the interpreter is released, since
+  //! they still live on its stack.
+  //! \tparam Ts  The types of the results.
+  //! \param [in] args  The arguments to pass to the function.
+  //! \return The converted results.
+  template< typename... Ts, typename... Args >
+  auto call( Args&&... args ) const
+  {
+    auto func = own();
+    if ( func ) 
+      return (*func)( std::forward<Args>(args)... ).template as<Ts...>();
+    std::lock_guard<std::mutex> lock( data_->spare_mutex );
+    return 
+      (*data_->spare)( std::forward<Args>(args)... ).template as<Ts...>();
+  }
+
+private:
+
+  //! \brief Load the input file into a new interpreter.
+  //! \return The function found in the new interpreter.
+  std::unique_ptr<lua_result_t> load() const
+  {
+    lua_t lua_state;
+    lua_state.loadfile( data_->file );
+    return std::make_unique<lua_result_t>( data_->locator( lua_state ) );
+  }
+
+  //! \brief Return the function of the current thread.
+  //! \return Null if the thread has no interpreter to itself.
+  const lua_result_t * own() const
+  {
+#ifdef _OPENMP
+    // the thread numbers of a nested team are not unique
+    if ( omp_get_active_level() > 1 ) return nullptr;
+    std::size_t tid = omp_get_thread_num();
+#else
+    std::size_t tid = 0;
+#endif
+    return tid < data_->funcs.size() ? data_->funcs[tid].get() : nullptr;
+  }
+
+  //! \brief The data shared by all copies of this function.
+  struct data_t {
+    std::string file;
+    locator_t locator;
+    std::vector< std::unique_ptr<lua_result_t> > funcs;
+    std::unique_ptr<lua_result_t> spare;
+    std::mutex spare_mutex;
+  };
+
+  //! \brief The shared data, so copies of this object share interpreters.
+  std::shared_ptr<data_t> data_;
+};
+
+#endif // HAVE_LUA
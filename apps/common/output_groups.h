@@ -0,0 +1,115 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Named groups of fields that are written on their own schedule.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include <flecsale/mesh/burton/burton.h>
+#include <flecsale/mesh/distributed.h>
+#include <flecsale/mesh/output_fields.h>
+
+// system libraries
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A set of fields written together, on their own schedule.
+//!
+//! A group is written every \e frequency steps, or every \e interval units
+//! of simulated time, or both.  Since the time step is not shortened to
+//! land on the output times, a time based group is written on the first
+//! step at or after each multiple of the interval.
+//!
+//! \tparam T  The real type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct output_group_t {
+
+  //! \brief the group name, appended to the case prefix
+  std::string name;
+  //! \brief the file extension, which picks the format
+  std::string postfix = "dat";
+  //! \brief the persistent fields to write, or all of them if empty
+  std::vector<std::string> fields;
+  //! \brief the number of steps between outputs, zero to disable
+  std::size_t frequency = 0;
+  //! \brief the simulated time between outputs, zero to disable
+  T interval = 0;
+  //! \brief compress the output, if the format supports it
+  bool compress = false;
+
+  //! \brief Check if the group is due for output.
+  //! \param [in] step  The time step counter.
+  //! \param [in] time  The solution time.
+  bool is_due( std::size_t step, T time ) const
+  {
+    if ( frequency > 0 && step % frequency == 0 ) return true;
+    if ( interval > 0 && time >= next_time_ * (1 - 10*eps()) ) return true;
+    return false;
+  }
+
+  //! \brief Record that the group was written at a given time.
+  //! \param [in] time  The solution time.
+  void written( T time )
+  {
+    if ( interval > 0 )
+      next_time_ = ( std::floor( time / interval * (1 + 10*eps()) ) + 1 ) *
+        interval;
+  }
+
+private:
+
+  //! \brief the machine precision
+  static constexpr T eps()
+  { return std::numeric_limits<T>::epsilon(); }
+
+  //! \brief the next time the group is due
+  T next_time_ = 0;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write an output group if it is due.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] prefix  The case prefix.
+//! \param [in,out] group  The output group.
+//! \return True if the group was written.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename T >
+bool write_output_group(
+  M & mesh, const std::string & prefix, output_group_t<T> & group
+) {
+  auto step = mesh.time_step_counter();
+  auto time = mesh.time();
+  if ( !group.is_due( step, time ) ) return false;
+
+  std::stringstream ss;
+  ss << prefix << "-" << group.name;
+  ss << std::setw( 7 ) << std::setfill( '0' ) << step;
+
+  // only write the fields of the group
+  flecsale::mesh::scoped_output_options_t scope(
+    { group.fields, group.compress }
+  );
+
+  std::cout << std::endl;
+  flecsale::mesh::write_mesh(
+    flecsale::mesh::rank_file_name( ss.str(), group.postfix ), mesh
+  );
+  flecsale::mesh::write_index( ss.str(), group.postfix );
+  std::cout << std::endl;
+
+  group.written( time );
+  return true;
+}
@@ -0,0 +1,194 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Decides when a run has to stop early, either because its wall
+///        time budget is almost used up or because it was signaled.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "timings.h"
+
+#include <flecsale/utils/errors.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/time_utils.h>
+
+// system libraries
+#include <algorithm>
+#include <csignal>
+#include <string>
+
+namespace detail {
+
+//! \brief The flag set by the signal handler.  It is constant initialized,
+//! so it is safe to use from within the handler.
+inline volatile std::sig_atomic_t & stop_signal_flag()
+{
+  static volatile std::sig_atomic_t flag = 0;
+  return flag;
+}
+
+//! \brief The handler for the stop signals.
+inline void stop_signal_handler( int )
+{ stop_signal_flag() = 1; }
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Make SIGTERM and SIGUSR1 request a clean stop.
+//!
+//! The handlers only set a flag, which the solver checks once per step.
+////////////////////////////////////////////////////////////////////////////////
+inline void install_stop_signal_handlers()
+{
+  std::signal( SIGTERM, detail::stop_signal_handler );
+  std::signal( SIGUSR1, detail::stop_signal_handler );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Convert a wall time string to seconds.
+//!
+//! Both plain seconds, and the "[[HH:]MM:]SS" format used by the batch
+//! schedulers, are accepted.
+//!
+//! \param [in] str  The wall time string.
+//! \return The number of seconds.
+////////////////////////////////////////////////////////////////////////////////
+inline double parse_walltime( const std::string & str )
+{
+  double seconds = 0;
+  std::size_t start = 0;
+  int num_fields = 0;
+  while ( true ) {
+    auto end = str.find( ':', start );
+    auto field = str.substr( start, end - start );
+    std::size_t pos = 0;
+    double value = -1;
+    try { value = std::stod( field, &pos ); }
+    catch ( ... ) { pos = 0; }
+    if ( field.empty() || pos != field.size() || value < 0 || ++num_fields > 3 )
+      raise_runtime_error( "Invalid wall time \"" << str << "\"" );
+    seconds = 60*seconds + value;
+    if ( end == std::string::npos ) break;
+    start = end + 1;
+  }
+  return seconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The reasons a run can stop early.
+////////////////////////////////////////////////////////////////////////////////
+enum class stop_reason_t : int {
+  none = 0,
+  walltime,
+  signal
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Decides when the solver should write a checkpoint and stop.
+//!
+//! The cost of a step is estimated from the wall time between the checks.
+//! A checkpoint costs the time to copy it, from the "checkpoint" timer, plus
+//! the time its background write takes to reach the disk, which is reported
+//! by the checkpoint writer.  The run stops once there is no longer enough
+//! time left for another step and a checkpoint, with some head room.
+////////////////////////////////////////////////////////////////////////////////
+class run_control_t {
+
+public:
+
+  //! \brief Constructor.
+  //! \param [in] budget  The wall time budget in seconds, zero for none.
+  //! \param [in] start  The wall time the run started at.
+  run_control_t( double budget, double start ) :
+    budget_( budget ), start_( start ), last_( flecsale::utils::get_wall_time() )
+  {}
+
+  //! \brief Check if the run should stop, called once per step.
+  //!
+  //! This is collective, all the ranks get the same answer.
+  //!
+  //! \param [in] timings  The task timers.
+  //! \param [in] write_seconds  How long the last checkpoint took to write,
+  //!   zero if none was written yet.
+  //! \return The reason to stop, if any.
+  stop_reason_t check( const task_timings_t & timings, double write_seconds = 0 )
+  { 
+    return check_at( flecsale::utils::get_wall_time(), timings, write_seconds );
+  }
+
+  //! \brief Check if the run should stop at a given wall time.
+  //! \param [in] now  The current wall time.
+  //! \param [in] timings  The task timers.
+  //! \param [in] write_seconds  How long the last checkpoint took to write.
+  //! \return The reason to stop, if any.
+  stop_reason_t check_at( 
+    double now, const task_timings_t & timings, double write_seconds = 0 
+  ) {
+    max_step_ = std::max( max_step_, now - last_ );
+    last_ = now;
+
+    auto reason = stop_reason_t::none;
+    if ( detail::stop_signal_flag() )
+      reason = stop_reason_t::signal;
+    else if ( budget_ > 0 && 
+              now - start_ + reserve( timings, write_seconds ) > budget_ )
+      reason = stop_reason_t::walltime;
+
+    return static_cast<stop_reason_t>(
+      flecsale::utils::global_max( static_cast<int>(reason) )
+    );
+  }
+
+  //! \brief Return the time needed to finish a step and write a checkpoint.
+  //! \param [in] timings  The task timers.
+  //! \param [in] write_seconds  How long the last checkpoint took to write.
+  double reserve( const task_timings_t & timings, double write_seconds = 0 ) const
+  {
+    // before the first checkpoint, assume copying it and writing it each 
+    // cost as much as a step
+    auto copy = max_step_;
+    const auto & entries = timings.entries();
+    auto it = entries.find( "checkpoint" );
+    if ( it != entries.end() && it->second.calls > 0 )
+      copy = it->second.seconds / it->second.calls;
+    auto write = write_seconds > 0 ? write_seconds : max_step_;
+    return safety_factor * ( max_step_ + copy + write );
+  }
+
+  //! \brief The head room added to the estimates.
+  static constexpr double safety_factor = 2;
+
+private:
+
+  //! \brief the wall time budget
+  double budget_ = 0;
+  //! \brief the wall time the run started at
+  double start_ = 0;
+  //! \brief the wall time of the last check
+  double last_ = 0;
+  //! \brief the longest step so far
+  double max_step_ = 0;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Output the reason for stopping to a stream.
+////////////////////////////////////////////////////////////////////////////////
+inline std::ostream & operator<<( std::ostream & os, stop_reason_t reason )
+{
+  switch ( reason ) {
+    case stop_reason_t::walltime:
+      os << "the wall time budget is almost used up";
+      break;
+    case stop_reason_t::signal:
+      os << "a stop signal was received";
+      break;
+    default:
+      os << "no reason";
+  }
+  return os;
+}
@@ -0,0 +1,98 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests the decision to stop a run early.
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "../run_control.h"
+
+#include <cinchtest.h>
+
+// system includes
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test converting wall times to seconds.
+///////////////////////////////////////////////////////////////////////////////
+TEST(run_control, parse_walltime) 
+{
+
+  ASSERT_EQ( 90, parse_walltime( "90" ) );
+  ASSERT_EQ( 2.5, parse_walltime( "2.5" ) );
+  ASSERT_EQ( 90, parse_walltime( "1:30" ) );
+  ASSERT_EQ( 3600, parse_walltime( "01:00:00" ) );
+  ASSERT_EQ( 3723.5, parse_walltime( "1:02:03.5" ) );
+
+#ifdef ENABLE_EXCEPTIONS
+  using flecsale::utils::ExceptionRunTime;
+  ASSERT_THROW( parse_walltime( "" ), ExceptionRunTime );
+  ASSERT_THROW( parse_walltime( "1:" ), ExceptionRunTime );
+  ASSERT_THROW( parse_walltime( "1h" ), ExceptionRunTime );
+  ASSERT_THROW( parse_walltime( "-5" ), ExceptionRunTime );
+  ASSERT_THROW( parse_walltime( "1:00:00:00" ), ExceptionRunTime );
+#endif
+
+} // TEST
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test when a run with a wall time budget decides to stop.
+///////////////////////////////////////////////////////////////////////////////
+TEST(run_control, walltime) 
+{
+
+  task_timings_t timings;
+  auto start = flecsale::utils::get_wall_time();
+
+  // without a budget the run never stops
+  run_control_t unlimited( 0, start );
+  ASSERT_EQ( stop_reason_t::none, unlimited.check_at( start + 1e6, timings ) );
+
+  // take one second steps with a 100 second budget, and return the step
+  // the run stops at
+  auto stop_step = [&]( double write_seconds ) {
+    run_control_t control( 100, start );
+    for ( int k=1; k<100; ++k ) {
+      auto stop = control.check_at( start + k, timings, write_seconds );
+      if ( stop != stop_reason_t::none ) {
+        EXPECT_EQ( stop_reason_t::walltime, stop );
+        return k;
+      }
+    }
+    return 100;
+  };
+
+  // before any checkpoint, copying and writing one are each assumed to 
+  // cost a step, so the reserve is twice three steps
+  ASSERT_EQ( 95, stop_step( 0 ) );
+
+  // the copies are timed by the "checkpoint" timer
+  timings.add( "checkpoint", 0.5 );
+  ASSERT_EQ( 96, stop_step( 0 ) );
+
+  // a slow background write moves the stop up, the reserve is now
+  // 2 * (1 + 0.5 + 10.25) = 23.5 seconds
+  ASSERT_EQ( 77, stop_step( 10.25 ) );
+
+} // TEST
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test that a stop signal ends the run.
+///////////////////////////////////////////////////////////////////////////////
+TEST(run_control, signal) 
+{
+
+  task_timings_t timings;
+  auto start = flecsale::utils::get_wall_time();
+  run_control_t control( 0, start );
+  ASSERT_EQ( stop_reason_t::none, control.check_at( start + 1, timings ) );
+
+  // the handler only sets the flag
+  detail::stop_signal_handler( SIGUSR1 );
+  ASSERT_EQ( stop_reason_t::signal, control.check_at( start + 2, timings ) );
+  detail::stop_signal_flag() = 0;
+
+} // TEST
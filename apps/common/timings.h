@@ -0,0 +1,120 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some utilities for timing the individual solver tasks.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include <flecsale/utils/errors.h>
+#include <flecsale/utils/time_utils.h>
+
+// system libraries
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Execute a task and accumulate its wall time.
+//!
+//! The task name is used as the timer key.
+//!
+//! \param [in,out] timer  The task_timings_t object to accumulate into.
+//! \param [in] task  The task to execute.
+//! \return The result of the task execution.
+////////////////////////////////////////////////////////////////////////////////
+#define timed_execute_task(timer, task, ...)                                   \
+  timer.measure( #task,                                                        \
+    [&]() { return flecsi_execute_task( task, __VA_ARGS__ ); }                 \
+  )
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A class to accumulate the wall time spent in each task.
+////////////////////////////////////////////////////////////////////////////////
+class task_timings_t {
+
+public:
+
+  //! \brief The accumulated data for a single task.
+  struct entry_t {
+    double seconds = 0;
+    std::size_t calls = 0;
+  };
+
+  //! \brief Add an elapsed time to a task.
+  //! \param [in] name  The name of the task.
+  //! \param [in] seconds  The elapsed wall time in seconds.
+  void add( const std::string & name, double seconds )
+  {
+    auto & e = entries_[name];
+    e.seconds += seconds;
+    e.calls++;
+  }
+
+  //! \brief Call a function and add its elapsed time to a task.
+  //! \param [in] name  The name of the task.
+  //! \param [in] f  The function to call.
+  //! \return The result of the function call.
+  template< typename F >
+  decltype(auto) measure( const std::string & name, F && f )
+  {
+    guard_t guard( *this, name );
+    return std::forward<F>(f)();
+  }
+
+  //! \brief Return the accumulated entries.
+  const auto & entries() const
+  { return entries_; }
+
+  //! \brief Write the timings in CSV format.
+  //! \param [in,out] os  The stream to write to.
+  //! \return The stream.
+  std::ostream & write_csv( std::ostream & os ) const
+  {
+    os << "task,calls,seconds" << std::endl;
+    auto ss = os.precision();
+    os.setf( std::ios::scientific );
+    os.precision(9);
+    for ( const auto & e : entries_ )
+      os << e.first << "," << e.second.calls << "," << e.second.seconds
+         << std::endl;
+    os.unsetf( std::ios::scientific );
+    os.precision(ss);
+    return os;
+  }
+
+  //! \brief Write the timings in CSV format to a file.
+  //! \param [in] filename  The name of the file to write to.
+  void write_csv( const std::string & filename ) const
+  {
+    std::ofstream file( filename );
+    if ( !file.good() )
+      raise_runtime_error( "Problem opening timing file \"" << filename << "\"" );
+    write_csv( file );
+  }
+
+private:
+
+  //! \brief A guard that adds the time spent in its scope on destruction.
+  class guard_t {
+  public:
+    guard_t( task_timings_t & timings, const std::string & name ) :
+      timings_(timings), name_(name),
+      start_( flecsale::utils::get_wall_time() )
+    {}
+    ~guard_t()
+    { timings_.add( name_, flecsale::utils::get_wall_time() - start_ ); }
+  private:
+    task_timings_t & timings_;
+    const std::string & name_;
+    double start_;
+  };
+
+  //! \brief The timing entries, keyed by task name.
+  std::map< std::string, entry_t > entries_;
+
+};
@@ -10,6 +10,7 @@
 
 // user includes
 #include "../inputs.h"
+#include "../../common/lua_thread_function.h"
 
 #include <flecsale/mesh/burton/burton.h>
 #include <flecsale/mesh/factory.h>
@@ -62,18 +63,62 @@ public:
 
     // now set some dimension specific inputs
 
-    // set the ics function
-    auto ics_func = lua_try_access( hydro_input, "ics" );
+    // set the ics function.  each thread gets its own interpreter so the
+    // initial conditions can be evaluated in parallel
+    auto ics_func = lua_thread_function_t(
+      file, lua_try_access( hydro_input, "ics" ),
+      []( const auto & lua_state ) { return lua_state["hydro"]["ics"]; }
+    );
     ics = 
       [ics_func]( const vector_t & x, const real_t & t )
       {
         real_t d, p;
         vector_t v(0);
         std::tie(d, v, p) = 
-          ics_func(x[0], x[1], t).as<real_t, vector_t, real_t>();
+          ics_func.call<real_t, vector_t, real_t>(x[0], x[1], t);
         return std::make_tuple( d, std::move(v), p );
       };
+
+    // the ensemble members can have their own initial conditions
+    auto ensemble_input = hydro_input["ensemble"];
+    for ( int m=0; m<static_cast<int>( ensemble.size() ); ++m ) {
+      auto member_input = ensemble_input[m+1];
+      if ( member_input["ics"].empty() ) continue;
+      auto member_func = lua_thread_function_t(
+        file, lua_try_access( member_input, "ics" ),
+        [m]( const auto & lua_state ) { 
+          return lua_state["hydro"]["ensemble"][m+1]["ics"]; 
+        }
+      );
+      ensemble[m].ics = 
+        [member_func]( const vector_t & x, const real_t & t )
+        {
+          real_t d, p;
+          vector_t v(0);
+          std::tie(d, v, p) = 
+            member_func.call<real_t, vector_t, real_t>(x[0], x[1], t);
+          return std::make_tuple( d, std::move(v), p );
+        };
+    }
       
+    // the regions are optional, the function returns the number of the
+    // region a point is in, starting from one like the list of equations
+    // of state
+    regions = nullptr;
+    if ( !hydro_input["regions"].empty() ) {
+      auto region_func = lua_thread_function_t(
+        file, lua_try_access( hydro_input, "regions" ),
+        []( const auto & lua_state ) { return lua_state["hydro"]["regions"]; }
+      );
+      regions = [region_func]( const vector_t & x ) -> size_t
+        {
+          auto r = region_func.call<int>(x[0], x[1]);
+          if ( r < 1 )
+            raise_runtime_error( "Region numbers start from one, got " << r );
+          return r - 1;
+        };
+    }
+
     // now set the mesh building function
     auto mesh_input = lua_try_access( hydro_input, "mesh" );
     auto mesh_type = lua_try_access_as(mesh_input, "type", std::string );
@@ -87,6 +132,13 @@ public:
           dims[0], dims[1], xmin[0], xmin[1], xmax[0], xmax[1]
         );
       };
+      make_local_mesh = [dims,xmin,xmax](
+        const real_t &, int rank, int size, flecsale::mesh::ownership_t & owners
+      ) {
+        return flecsale::mesh::box_slab<mesh_t>( 
+          dims, xmin, xmax, rank, size, owners
+        );
+      };
     }
     else if (mesh_type == "read" ) {
       auto file = lua_try_access_as( mesh_input, "file", std::string );
@@ -96,6 +148,8 @@ public:
         flecsale::mesh::read_mesh(file, m);
         return m;
       };
+      // every rank reads the whole mesh before it is distributed
+      make_local_mesh = nullptr;
     }
     else {
       raise_implemented_error("Unknown mesh type \""<<mesh_type<<"\"");
@@ -4,6 +4,13 @@ hydro = {
   postfix = "dat",
   -- The frequency of outputs
   output_freq = "7",
+  -- uncomment to write extra groups of fields, each on its own schedule,
+  -- given in steps (frequency) or simulated time (interval)
+  -- outputs = {
+  --   { name = "small", fields = {"density", "pressure"}, frequency = 10,
+  --     postfix = "vtu", compress = true },
+  --   { name = "full", interval = 0.05, postfix = "exo" }
+  -- },
   -- The time stepping parameters
   final_time = 0.2,
   max_steps = 1e6,
@@ -15,7 +22,47 @@ hydro = {
     xmin = {-0.5, -0.5},
     xmax = { 0.5,  0.5}
   },
-  -- the equation of state
+  -- uncomment to adaptively refine the mesh near the fronts
+  -- amr = {
+  --   max_level = 2,
+  --   frequency = 10,
+  --   refine_tolerance = 0.1,
+  --   coarsen_tolerance = 0.01
+  -- },
+  -- uncomment to record the solution at a few points every step, the
+  -- format is "csv" or "binary" and probes can follow the mesh motion
+  -- probes = {
+  --   frequency = 1,
+  --   points = { {-0.25, -0.25}, {0.25, 0.25} },
+  --   fields = { "density", "pressure", "velocity" },
+  --   format = "csv",
+  --   follow_flow = false
+  -- },
+  -- uncomment to write small in-situ extracts, each at its own frequency
+  -- extracts = {
+  --   { type = "slice", frequency = 10, fields = {"density", "pressure"},
+  --     origin = {0, 0}, normal = {0, 1} },
+  --   { type = "lineout", frequency = 10, fields = {"density", "velocity_0"},
+  --     from = {-0.5, -0.5}, to = {0.5, 0.5}, points = 200 },
+  --   { type = "histogram", frequency = 50, fields = {"pressure"}, 
+  --     bins = 20, range = {0, 1.2} },
+  --   { type = "regions", frequency = 1, fields = {"density", "velocity"} }
+  -- },
+  -- uncomment to call process(mesh, time, step) in analysis.py every 10
+  -- steps, where mesh holds numpy views of the fields
+  -- python = { script = "analysis.py", callback = "process", frequency = 10 },
+  -- uncomment to run several cases on the same mesh, each member can
+  -- change the prefix, final time, equation of state and initial conditions
+  -- ensemble = {
+  --   { prefix = "shock_box_2d_g14" },
+  --   { prefix = "shock_box_2d_g16", final_time = 0.15,
+  --     eos = { type = "ideal_gas", gas_constant = 1.6, specific_heat = 1.0 } },
+  --   { ics = function (x,y,t)
+  --       if x < 0 and y < 0 then return 0.1, {0,0}, 0.1 end
+  --       return 1.0, {0,0}, 1.0
+  --     end }
+  -- },
+  -- the equation of state, or a list of them with one per mesh region
   eos = {
     type = "ideal_gas",
     gas_constant = 1.4,
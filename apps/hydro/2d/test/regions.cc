@@ -0,0 +1,98 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Tests assigning the cells of a hydro mesh to regions.
+///////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "../inputs.h"
+
+#include <cinchtest.h>
+
+// system includes
+#include <memory>
+
+using namespace apps::hydro;
+
+using real_t = inputs_t::real_t;
+using size_t = inputs_t::size_t;
+using vector_t = inputs_t::vector_t;
+using ideal_gas_t = flecsale::eos::ideal_gas_t<real_t>;
+
+using flecsale::common::test_tolerance;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Check that the left and right halves of a box mesh are in their
+//! own regions, each with its own gas.
+///////////////////////////////////////////////////////////////////////////////
+void check_two_regions( inputs_t::mesh_t & mesh )
+{
+  ASSERT_EQ( 2, mesh.num_regions() );
+
+  auto cs = mesh.cells();
+  ASSERT_EQ( cs.size()/2, mesh.region_cell_ids(0).size() );
+  ASSERT_EQ( cs.size()/2, mesh.region_cell_ids(1).size() );
+  for ( auto c : cs ) {
+    size_t r = c->centroid()[0] < 0 ? 0 : 1;
+    ASSERT_EQ( r, c->region() );
+  }
+
+  // each region gets its own equation of state
+  auto region_eos = inputs_t::eos_by_region( mesh.num_regions() );
+  ASSERT_EQ( 2, region_eos.size() );
+  ASSERT_NE( region_eos[0], region_eos[1] );
+  // the ideal gas gamma does not depend on the state
+  ASSERT_NEAR( 1.4, region_eos[0]->compute_gamma_dp( 1, 1 ), test_tolerance );
+  ASSERT_NEAR( 1.6, region_eos[1]->compute_gamma_dp( 1, 1 ), test_tolerance );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test assigning regions with the compiled in inputs.
+///////////////////////////////////////////////////////////////////////////////
+TEST(hydro_2d, regions) 
+{
+
+  // without a region function the mesh keeps its single region
+  auto mesh = inputs_t::make_mesh( 0 );
+  inputs_t::assign_regions( mesh );
+  ASSERT_EQ( 1, mesh.num_regions() );
+
+  // split the box down the middle
+  inputs_t::region_eos = {
+    std::make_shared<ideal_gas_t>( 1.4, 1.0 ),
+    std::make_shared<ideal_gas_t>( 1.6, 1.0 )
+  };
+  inputs_t::regions = []( const vector_t & x ) -> size_t 
+    { return x[0] < 0 ? 0 : 1; };
+
+  mesh = flecsale::mesh::box<inputs_t::mesh_t>( 10, 10, -0.5, -0.5, 0.5, 0.5 );
+  inputs_t::assign_regions( mesh );
+  check_two_regions( mesh );
+
+  // restore the defaults
+  inputs_t::region_eos.clear();
+  inputs_t::regions = nullptr;
+
+} // TEST
+
+#ifdef HAVE_LUA
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test assigning regions from a lua input file.
+///////////////////////////////////////////////////////////////////////////////
+TEST(hydro_2d, lua_regions) 
+{
+
+  inputs_t::load( "two_region_2d.lua" );
+  ASSERT_TRUE( static_cast<bool>( inputs_t::regions ) );
+
+  auto mesh = inputs_t::make_mesh( 0 );
+  inputs_t::assign_regions( mesh );
+  check_two_regions( mesh );
+
+} // TEST
+
+#endif // HAVE_LUA
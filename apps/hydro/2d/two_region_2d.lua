@@ -0,0 +1,41 @@
+hydro = {
+  -- The case prefix and postfixes
+  prefix = "two_region_2d",
+  postfix = "dat",
+  -- The frequency of outputs
+  output_freq = "10",
+  -- The time stepping parameters
+  final_time = 0.2,
+  max_steps = 1e6,
+  CFL = 1./2.,
+  -- the mesh
+  mesh = {
+    type = "box",
+    dimensions = {10, 10},
+    xmin = {-0.5, -0.5},
+    xmax = { 0.5,  0.5}
+  },
+  -- the left half of the box is one gas, the right half another.  The
+  -- region numbers index the list of equations of state below.
+  regions = function (x,y)
+    if x < 0 then
+      return 1
+    else
+      return 2
+    end
+  end,
+  -- one equation of state per region
+  eos = {
+    { type = "ideal_gas", gas_constant = 1.4, specific_heat = 1.0 },
+    { type = "ideal_gas", gas_constant = 1.6, specific_heat = 1.0 }
+  },
+  -- the initial conditions
+  -- return density, velocity, pressure
+  ics = function (x,y,t)
+    if x < 0 then
+      return 1.0, {0,0}, 1.0
+    else
+      return 0.125, {0,0}, 0.1
+    end
+  end 
+}
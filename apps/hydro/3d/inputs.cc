@@ -30,17 +30,52 @@ template<> string base_t::postfix = "dat";
 // output frequency
 template<> size_t base_t::output_freq = 100;
 
+// no extra output groups
+template<> inputs_t::output_group_list_t base_t::output_groups = {};
+
+// the point probes, off by default
+template<> size_t base_t::probe_frequency = 0;
+template<> string base_t::probe_format = "csv";
+template<> bool base_t::probe_follow_flow = false;
+template<> std::vector<string> base_t::probe_fields = 
+  { "density", "pressure", "velocity" };
+template<> std::vector< inputs_t::array_t<real_t> > base_t::probe_points = {};
+
+// no in-situ extracts by default
+template<> std::vector< inputs_t::extract_spec_t > base_t::extracts = {};
+
+// no checkpoints by default
+template<> size_t base_t::checkpoint_frequency = 0;
+
+// no python callback by default
+template<> size_t base_t::python_frequency = 0;
+template<> string base_t::python_script = "";
+template<> string base_t::python_callback = "process";
+
 // the CFL and final solution time
 template<> real_t base_t::CFL = 1.0/3.0;
 template<> real_t base_t::final_time = 0.2;
 template<> size_t base_t::max_steps = 1e6;
 
+// the adaptive refinement parameters, off by default
+template<> size_t base_t::amr_max_level = 0;
+template<> size_t base_t::amr_frequency = 10;
+template<> real_t base_t::amr_refine_tolerance = 0.1;
+template<> real_t base_t::amr_coarsen_tolerance = 0.01;
+
 // the equation of state
 template<> std::shared_ptr<eos_t> base_t::eos = 
   std::make_shared< flecsale::eos::ideal_gas_t<real_t> >( 
     /* gamma */ 1.4, /* cv */ 1.0 
   ); 
 
+// no per-region equations of state, the one above is used everywhere
+template<> std::vector< std::shared_ptr<eos_t> > base_t::region_eos = {};
+
+// the regions of the mesh are kept
+template<>
+inputs_t::region_function_t base_t::regions = nullptr;
+
 // this is a lambda function to set the initial conditions
 template<>
 inputs_t::ics_function_t base_t::ics = 
@@ -59,6 +94,10 @@ inputs_t::ics_function_t base_t::ics =
     return std::make_tuple( d, v, p );
   };
 
+// a single case is run by default
+template<>
+std::vector< inputs_t::ensemble_member_t > base_t::ensemble = {};
+
 // This function builds and returns a mesh
 template<>
 inputs_t::mesh_function_t base_t::make_mesh = 
@@ -78,5 +117,10 @@ inputs_t::mesh_function_t base_t::make_mesh =
     );
   };
 
+// only the lua box meshes know how to build a single rank's piece, this one
+// is built whole and then distributed
+template<>
+inputs_t::local_mesh_function_t base_t::make_local_mesh = nullptr;
+
 } // namespace
 } // namespace
@@ -15,7 +15,14 @@ hydro = {
     xmin = {-0.5, -0.5, -0.5},
     xmax = { 0.5,  0.5,  0.5}
   },
-  -- the equation of state
+  -- uncomment to adaptively refine the mesh near the fronts
+  -- amr = {
+  --   max_level = 2,
+  --   frequency = 10,
+  --   refine_tolerance = 0.1,
+  --   coarsen_tolerance = 0.01
+  -- },
+  -- the equation of state, or a list of them with one per mesh region
   eos = {
     type = "ideal_gas",
     gas_constant = 1.4,
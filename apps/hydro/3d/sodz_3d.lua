@@ -15,7 +15,7 @@ hydro = {
     xmin = {-0.05, -0.05, -0.5},
     xmax = { 0.05,  0.05,  0.5}
   },
-  -- the equation of state
+  -- the equation of state, or a list of them with one per mesh region
   eos = {
     type = "ideal_gas",
     gas_constant = 1.4,
@@ -23,13 +23,16 @@ namespace hydro {
 //! \brief The main task for setting initial conditions
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \param [in]     ics  the initial conditions to set
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int initial_conditions_task( 
-  mesh_3d_t & mesh, inputs_t::ics_function_t ics 
+  mesh_3d_t & mesh, 
+  const mesh::subdomains_t & subdomains, 
+  inputs_t::ics_function_t ics 
 ) {
-  return initial_conditions( mesh, ics );
+  return initial_conditions( mesh, subdomains, ics );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,12 +41,16 @@ int initial_conditions_task(
 //! Updates the state from density and pressure and computes the new energy.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int update_state_from_pressure_task( 
-  mesh_3d_t & mesh, const eos_t * eos 
+  mesh_3d_t & mesh, 
+  const mesh::subdomains_t & subdomains,
+  const std::vector<const eos_t *> & region_eos
 ) {
-	return update_state_from_pressure( mesh, eos );
+	return update_state_from_pressure( mesh, subdomains, region_eos );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,12 +59,16 @@ int update_state_from_pressure_task(
 //! Updates the state from density and energy and computes the new pressure.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int update_state_from_energy_task( 
-  mesh_3d_t & mesh, const eos_t * eos 
+  mesh_3d_t & mesh, 
+  const mesh::subdomains_t & subdomains,
+  const std::vector<const eos_t *> & region_eos
 ) {
-	return update_state_from_energy( mesh, eos );
+	return update_state_from_energy( mesh, subdomains, region_eos );
 }
 
 
@@ -65,57 +76,69 @@ int update_state_from_energy_task(
 //! \brief The main task to compute the time step size.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
-int evaluate_time_step_task( mesh_3d_t & mesh ) 
-{
+int evaluate_time_step_task( 
+  mesh_3d_t & mesh, const mesh::subdomains_t & subdomains 
+) {
   using eqns_t = eqns_t<mesh_3d_t::num_dimensions>;
-  return evaluate_time_step<eqns_t>( mesh );
+  return evaluate_time_step<eqns_t>( mesh, subdomains );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to evaluate fluxes at each face.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
-int evaluate_fluxes_task( mesh_3d_t & mesh ) 
-{
-  return evaluate_fluxes( mesh );
+int evaluate_fluxes_task( 
+  mesh_3d_t & mesh, const mesh::subdomains_t & subdomains 
+) {
+  return evaluate_fluxes( mesh, subdomains );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to update the solution in each cell.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 solution_error_t apply_update_task( 
-  mesh_3d_t & mesh, real_t tolerance, bool first_time 
+  mesh_3d_t & mesh, 
+  const mesh::subdomains_t & subdomains, 
+  real_t tolerance, 
+  bool first_time
 ) {
-  return apply_update( mesh, tolerance, first_time );
+  return apply_update( mesh, subdomains, tolerance, first_time );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to save the coordinates
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
-int save_solution_task( mesh_3d_t & mesh ) 
-{
-  return save_solution( mesh );
+int save_solution_task( 
+  mesh_3d_t & mesh, const mesh::subdomains_t & subdomains 
+) {
+  return save_solution( mesh, subdomains );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to restore the coordinates
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
-int restore_solution_task( mesh_3d_t & mesh ) 
-{
-  return restore_solution( mesh );
+int restore_solution_task( 
+  mesh_3d_t & mesh, const mesh::subdomains_t & subdomains 
+) {
+  return restore_solution( mesh, subdomains );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
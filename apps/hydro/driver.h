@@ -10,19 +10,36 @@
 
 // hydro includes
 #include "types.h"
+#include "ensemble.h"
 #include "../common/exceptions.h"
+#include "../common/output_groups.h"
 #include "../common/parse_arguments.h"
+#include "../common/run_control.h"
+#include "../common/timings.h"
 
 // user includes
+#include <flecsale/mesh/amr.h>
+#include <flecsale/mesh/distributed.h>
 #include <flecsale/mesh/mesh_utils.h>
+#include <flecsale/mesh/partition.h>
+#include <flecsale/utils/mpi_utils.h>
 #include <flecsale/utils/time_utils.h>
 #include <flecsale/io/catalyst/adaptor.h>
+#include <flecsale/io/checkpoint.h>
+#include <flecsale/io/extracts.h>
+#include <flecsale/io/probes.h>
+
+// Python include should go last cause it conflicts with alot of other 
+// includes.
+#include <flecsale/io/python_bridge.h>
 
 
 // system includes
+#include <algorithm>
 #include <getopt.h>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <utility>
 
@@ -40,6 +57,18 @@ int driver(int argc, char** argv)
   // set exceptions 
   enable_exceptions();
 
+  // make sure mpi is running, and get the layout
+  utils::mpi_session_t mpi_session( argc, argv );
+
+  // the wall time budget is counted from here
+  auto run_start = utils::get_wall_time();
+  auto comm_rank = utils::comm_rank();
+  auto comm_size = utils::comm_size();
+
+  // only the first rank writes to the screen
+  auto cout_buf = std::cout.rdbuf();
+  if ( comm_rank != 0 ) std::cout.rdbuf( nullptr );
+
   //===========================================================================
   // Parse arguments
   //===========================================================================
@@ -49,12 +78,25 @@ int driver(int argc, char** argv)
     std::cout << "Usage: " << argv[0] 
               << " [--file INPUT_FILE]"
               << " [--catalyst PYTHON_SCRIPT]"
+              << " [--timings CSV_FILE]"
+              << " [--partitions NUM_PARTS]"
+              << " [--restart CHECKPOINT]"
+              << " [--walltime SECONDS|HH:MM:SS]"
               << " [--help]"
               << std::endl << std::endl;
     std::cout << "\t--file INPUT_FILE:\t Override the input file "
               << "with INPUT_FILE." << std::endl;
     std::cout << "\t--catalyst PYTHON_SCRIPT:\t Load catalyst with "
               << "using PYTHON_SCRIPT." << std::endl;
+    std::cout << "\t--timings CSV_FILE:\t Write the per-task wall times "
+              << "to CSV_FILE." << std::endl;
+    std::cout << "\t--partitions NUM_PARTS:\t Renumber the mesh so that it "
+              << "is split into NUM_PARTS contiguous partitions, one per "
+              << "thread." << std::endl;
+    std::cout << "\t--restart CHECKPOINT:\t Restart from the CHECKPOINT "
+              << "file, using the same input and number of ranks." << std::endl;
+    std::cout << "\t--walltime SECONDS|HH:MM:SS:\t Write a checkpoint and "
+              << "stop before the wall time budget runs out." << std::endl;
     std::cout << "\t--help:\t Print a help message." << std::endl;
   };
 
@@ -64,9 +106,13 @@ int driver(int argc, char** argv)
       {"help",           no_argument, 0, 'h'},
       {"file",     required_argument, 0, 'f'},
       {"catalyst", required_argument, 0, 'c'},
+      {"timings",  required_argument, 0, 't'},
+      {"partitions", required_argument, 0, 'p'},
+      {"restart",  required_argument, 0, 'r'},
+      {"walltime", required_argument, 0, 'w'},
       {0, 0, 0, 0}
     };
-  const char * short_options = "hf:c:";
+  const char * short_options = "hf:c:t:p:r:w:";
 
   // parse the arguments
   auto args = parse_arguments(argc, argv, long_options, short_options);
@@ -103,6 +149,28 @@ int driver(int argc, char** argv)
               << std::endl;
   }
 
+  // get the timing output file
+  auto timings_file_name = 
+    args.count("t") ? args.at("t") : std::string();
+
+  // the per-task timers
+  task_timings_t timings;
+
+  // get the number of partitions
+  auto num_parts = 
+    args.count("p") ? std::stoul( args.at("p") ) : 0ul;
+
+  // get the checkpoint to restart from
+  auto restart_file_name = 
+    args.count("r") ? args.at("r") : std::string();
+
+  // get the wall time budget
+  auto walltime = 
+    args.count("w") ? parse_walltime( args.at("w") ) : 0.0;
+
+  // a batch system asks a job to stop with a signal
+  install_stop_signal_handlers();
+
 
 
 
@@ -111,10 +179,67 @@ int driver(int argc, char** argv)
   //===========================================================================
 
   // make the mesh
-  auto mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  typename inputs_t::mesh_t mesh;
+
+  // the ghost exchange pattern
+  mesh::halo_t halo;
+
+  if ( comm_size > 1 ) {
+    std::cout << "Distributing the mesh over " << comm_size << " ranks." 
+              << std::endl;
+    // build this rank's piece directly if possible, otherwise build the
+    // whole mesh and split it up
+    mesh::ownership_t owners;
+    auto piece = inputs_t::make_local_mesh ?
+      inputs_t::make_local_mesh( 0.0, comm_rank, comm_size, owners ) :
+      inputs_t::make_mesh( 0.0 );
+    if ( !inputs_t::make_local_mesh ) {
+      auto parts = mesh::partition_cells( piece, comm_size );
+      owners = mesh::global_ownership( piece, parts );
+    }
+    mesh = mesh::distribute( piece, owners, comm_rank, halo );
+  }
+  else {
+    mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  }
+
+  // put the cells in their regions, which picks their equations of state
+  inputs_t::assign_regions( mesh );
+
+  // the thread partitions would break up the owned-first ordering
+  if ( num_parts > 1 && comm_size > 1 )
+    raise_runtime_error( "--partitions can only be used with a single rank" );
+
+  // renumber the mesh so that each thread works on a compact partition
+  std::vector<std::size_t> parts;
+  if ( num_parts > 1 ) {
+    std::cout << "Partitioning the mesh into " << num_parts << " parts." 
+              << std::endl;
+    parts = mesh::partition_cells( mesh, num_parts );
+    mesh = mesh::reorder( mesh, parts );
+    // the reordered cells are grouped by partition
+    std::sort( parts.begin(), parts.end() );
+  }
 
-  // this is the mesh object
-  mesh.is_valid();
+  // each thread works on its own sub-domain.  Without partitions, the owned
+  // cells are split into blocks that keep the current numbering.
+  auto num_subdomains = 
+    num_parts > 1 ? num_parts : mesh::default_num_subdomains();
+  if ( parts.empty() ) 
+    parts = mesh::partition_blocks( mesh, num_subdomains );
+  auto subdomains = mesh::decompose( mesh, parts, num_subdomains );
+
+  if ( num_subdomains != mesh::default_num_subdomains() )
+    std::cout << "Warning: there are " << num_subdomains << " partitions "
+              << "for " << mesh::default_num_subdomains() << " threads." 
+              << std::endl;
+
+  // this is the mesh object.  Bad faces are fatal, but the corner and 
+  // wedge audit only warns, since it was never enforced before
+  mesh.is_valid( true, mesh::burton::validation_level_t::cheap );
+  if ( !mesh.corners_are_valid( false ) )
+    std::cerr << "Warning: the mesh failed the corner and wedge checks, "
+              << "continuing anyway" << std::endl;
   
   cout << mesh;
 
@@ -125,6 +250,7 @@ int driver(int argc, char** argv)
   using mesh_t = decltype(mesh);
   using size_t = typename mesh_t::size_t;
   using real_t = typename mesh_t::real_t;
+  using storage_real_t = typename mesh_t::storage_real_t;
   using vector_t = typename mesh_t::vector_t; 
 
   // get machine zero
@@ -146,55 +272,254 @@ int driver(int argc, char** argv)
   using eqns_t = eqns_t<mesh_t::num_dimensions>;
   using flux_data_t = flux_data_t<mesh_t::num_dimensions>;
 
-  // create some field data.  Fields are registered as struct of arrays.
-  // this allows us to access the data in different patterns.
-  flecsi_register_data(mesh, hydro,  density,   real_t, dense, 2, cells);
-  flecsi_register_data(mesh, hydro, pressure,   real_t, dense, 1, cells);
-  flecsi_register_data(mesh, hydro, velocity, vector_t, dense, 2, cells);
+  // create some field data.  This is done for the initial mesh and again
+  // every time the mesh is adapted.
+  auto register_fields = [&]( mesh_t & m )
+  {
+    // Fields are registered as struct of arrays.  this allows us to access
+    // the data in different patterns.
+    flecsi_register_data(m, hydro,  density,   real_t, dense, 2, cells);
+    flecsi_register_data(m, hydro, pressure,   real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, velocity, vector_t, dense, 2, cells);
+
+    flecsi_register_data(m, hydro, internal_energy, real_t, dense, 2, cells);
+    flecsi_register_data(m, hydro,     temperature, storage_real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro,     sound_speed, storage_real_t, dense, 1, cells);
+
+    // set these variables as persistent for plotting
+    flecsi_get_accessor(m, hydro,  density,   real_t, dense, 0).attributes().set(persistent);
+    flecsi_get_accessor(m, hydro, pressure,   real_t, dense, 0).attributes().set(persistent);
+    flecsi_get_accessor(m, hydro, velocity, vector_t, dense, 0).attributes().set(persistent);
+
+    flecsi_get_accessor(m, hydro, internal_energy, real_t, dense, 0).attributes().set(persistent);
+    flecsi_get_accessor(m, hydro,     temperature, storage_real_t, dense, 0).attributes().set(persistent);
+    flecsi_get_accessor(m, hydro,     sound_speed, storage_real_t, dense, 0).attributes().set(persistent);
+
+    // compute the fluxes.  here I am regestering a struct as the stored data
+    // type since I will only ever be accesissing all the data at once.
+    flecsi_register_data(m, hydro, flux, flux_data_t, dense, 1, faces);
+
+    // register the time step and set a cfl
+    flecsi_register_data( m, hydro, time_step, real_t, global, 1 );
+    flecsi_register_data( m, hydro, cfl, real_t, global, 1 );
+    *flecsi_get_accessor( m, hydro, cfl, real_t, global, 0) = inputs_t::CFL;  
+
+    // Register the total energy
+    flecsi_register_data( m, hydro, sum_total_energy, real_t, global, 1 );
+  };
 
-  flecsi_register_data(mesh, hydro, internal_energy, real_t, dense, 2, cells);
-  flecsi_register_data(mesh, hydro,     temperature, real_t, dense, 1, cells);
-  flecsi_register_data(mesh, hydro,     sound_speed, real_t, dense, 1, cells);
+  register_fields( mesh );
+
+  // the ghost cell values are received from the ranks that own them
+  mesh::halo_exchange_t cell_exchange( halo.cells );
+  auto start_cell_exchange = [&]()
+  {
+    cell_exchange.start(
+      flecsi_get_accessor(mesh, hydro,         density,   real_t, dense, 0),
+      flecsi_get_accessor(mesh, hydro,        pressure,   real_t, dense, 0),
+      flecsi_get_accessor(mesh, hydro,        velocity, vector_t, dense, 0),
+      flecsi_get_accessor(mesh, hydro, internal_energy,   real_t, dense, 0),
+      flecsi_get_accessor(mesh, hydro,     temperature,   storage_real_t, dense, 0),
+      flecsi_get_accessor(mesh, hydro,     sound_speed,   storage_real_t, dense, 0)
+    );
+  };
 
-  // set these variables as persistent for plotting
-  flecsi_get_accessor(mesh, hydro,  density,   real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro, pressure,   real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro, velocity, vector_t, dense, 0).attributes().set(persistent);
 
-  flecsi_get_accessor(mesh, hydro, internal_energy, real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro,     temperature, real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro,     sound_speed, real_t, dense, 0).attributes().set(persistent);
+  // the equation of state of each region
+  auto region_eos = inputs_t::eos_by_region( mesh.num_regions() );
 
-  // compute the fluxes.  here I am regestering a struct as the stored data
-  // type since I will only ever be accesissing all the data at once.
-  flecsi_register_data(mesh, hydro, flux, flux_data_t, dense, 1, faces);
+  //===========================================================================
+  // Ensemble runs
+  //===========================================================================
 
-  // register the time step and set a cfl
-  flecsi_register_data( mesh, hydro, time_step, real_t, global, 1 );
-  flecsi_register_data( mesh, hydro, cfl, real_t, global, 1 );
-  *flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0) = inputs_t::CFL;  
+  // the members of an ensemble share this mesh and take over from here
+  if ( !inputs_t::ensemble.empty() ) {
+    if ( !restart_file_name.empty() || walltime > 0 || 
+         inputs_t::checkpoint_frequency > 0 )
+      raise_runtime_error( "Ensemble runs do not support checkpoints" );
+    if ( inputs_t::amr_max_level > 0 )
+      raise_runtime_error( 
+        "Ensemble runs cannot use adaptive refinement, the mesh is shared" 
+      );
+    if ( inputs_t::probe_frequency > 0 || !inputs_t::extracts.empty() ||
+         inputs_t::python_frequency > 0 || !catalyst_args.empty() )
+      raise_runtime_error( 
+        "Ensemble runs only support the regular outputs and output groups" 
+      );
+
+    auto num_steps = ensemble_driver<inputs_t>( 
+      mesh, subdomains, cell_exchange, timings 
+    );
 
-  // Register the total energy
-  flecsi_register_data( mesh, hydro, sum_total_energy, real_t, global, 1 );
+    auto tdelta = utils::get_wall_time() - tstart;
+    std::cout << "Took " << num_steps << " steps over all members, elapsed "
+              << "wall time is " << std::setprecision(4) << std::fixed 
+              << tdelta << "s." << std::endl;
 
+    // dump the per-task timings
+    if ( !timings_file_name.empty() ) {
+      timings.add( "total", tdelta );
+      timings.write_csv( timings_file_name );
+    }
+
+    // give the screen back to all the ranks
+    std::cout.rdbuf( cout_buf );
+    return 0;
+  }
+
+  //===========================================================================
+  // Checkpoints
+  //===========================================================================
+
+  // apply a function to every version of every field in the solver state
+  auto for_each_state_field = [&]( auto && f )
+  {
+    auto cs = mesh.cells();
+    f( "density.0", cs, flecsi_get_accessor(mesh, hydro, density, real_t, dense, 0) );
+    f( "density.1", cs, flecsi_get_accessor(mesh, hydro, density, real_t, dense, 1) );
+    f( "pressure.0", cs, flecsi_get_accessor(mesh, hydro, pressure, real_t, dense, 0) );
+    f( "velocity.0", cs, flecsi_get_accessor(mesh, hydro, velocity, vector_t, dense, 0) );
+    f( "velocity.1", cs, flecsi_get_accessor(mesh, hydro, velocity, vector_t, dense, 1) );
+    f( "internal_energy.0", cs, flecsi_get_accessor(mesh, hydro, internal_energy, real_t, dense, 0) );
+    f( "internal_energy.1", cs, flecsi_get_accessor(mesh, hydro, internal_energy, real_t, dense, 1) );
+    f( "temperature.0", cs, flecsi_get_accessor(mesh, hydro, temperature, storage_real_t, dense, 0) );
+    f( "sound_speed.0", cs, flecsi_get_accessor(mesh, hydro, sound_speed, storage_real_t, dense, 0) );
+    f( "flux.0", mesh.faces(), flecsi_get_accessor(mesh, hydro, flux, flux_data_t, dense, 0) );
+  };
+
+  // the checkpoints are copied and then written in the background
+  flecsale::io::checkpoint_writer_t checkpoint_writer;
+
+  auto write_checkpoint = [&]()
+  {
+    std::stringstream ss;
+    ss << inputs_t::prefix << "-chk";
+    ss << std::setw( 7 ) << std::setfill( '0' ) << mesh.time_step_counter();
+    auto & w = checkpoint_writer;
+    flecsale::io::add_mesh_state( mesh, w );
+    for_each_state_field( 
+      [&]( const auto & name, const auto & ents, const auto & field ) {
+        w.add_field( name, ents, field );
+      }
+    );
+    w.add_value( "time_step", 
+      *flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 ) );
+    w.add_value( "cfl", 
+      *flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 ) );
+    w.add_value( "sum_total_energy", 
+      *flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 ) );
+    w.commit( flecsale::io::checkpoint_file_name( ss.str() ) );
+    std::cout << "Writing checkpoint \"" << ss.str() << "\"." << std::endl;
+  };
+
+  auto read_checkpoint = [&]( const std::string & file_name )
+  {
+    flecsale::io::checkpoint_reader_t r( 
+      flecsale::io::checkpoint_file_name( file_name ) 
+    );
+    flecsale::io::restore_mesh_state( r, mesh );
+    for_each_state_field( 
+      [&]( const auto & name, const auto & ents, auto field ) {
+        r.read_field( name, ents, field );
+      }
+    );
+    *flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 ) = 
+      r.read_value<real_t>( "time_step" );
+    *flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 ) = 
+      r.read_value<real_t>( "cfl" );
+    *flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 ) = 
+      r.read_value<real_t>( "sum_total_energy" );
+  };
 
   //===========================================================================
   // Initial conditions
   //===========================================================================
   
-  // now call the main task to set the ics.  Here we set primitive/physical 
-  // quanties
-  flecsi_execute_task( initial_conditions_task, loc, single, mesh, inputs_t::ics );
+  if ( !restart_file_name.empty() ) {
+    // the refinement hierarchy is not part of the checkpoint
+    if ( inputs_t::amr_max_level > 0 )
+      raise_runtime_error( 
+        "Restarting is not supported with adaptive refinement" 
+      );
+    std::cout << "Restarting from \"" << restart_file_name << "\"." 
+              << std::endl;
+    timings.measure( "restart", [&]() { read_checkpoint( restart_file_name ); } );
+  }
+  else {
+    // now call the main task to set the ics.  Here we set primitive/physical 
+    // quanties
+    timed_execute_task( 
+      timings, initial_conditions_task, loc, single, mesh, subdomains, 
+      inputs_t::ics 
+    );
+
+    // Update the EOS
+    timed_execute_task( 
+      timings, update_state_from_pressure_task, loc, single, mesh, subdomains,
+      region_eos 
+    );
+  }
   
   #ifdef HAVE_CATALYST
     auto insitu = io::catalyst::adaptor_t(catalyst_scripts);
     std::cout << "Catalyst on!" << std::endl;
   #endif
 
-  // Update the EOS
-  flecsi_execute_task( 
-    update_state_from_pressure_task, loc, single, mesh, inputs_t::eos.get() 
-  );
+  //===========================================================================
+  // Adaptive refinement
+  //===========================================================================
+
+  // the refinement tree, only used if refinement is turned on
+  auto use_amr = inputs_t::amr_max_level > 0;
+  mesh::amr_hierarchy_t<mesh_t::num_dimensions> amr;
+
+  if ( use_amr ) {
+    if ( comm_size > 1 || num_parts > 1 )
+      raise_runtime_error( 
+        "Adaptive refinement can only be used with a single, unpartitioned rank"
+      );
+    if ( inputs_t::amr_frequency < 1 )
+      raise_runtime_error( "The adaptive refinement frequency must be positive" );
+    amr = decltype(amr)( mesh, inputs_t::amr_max_level );
+  }
+
+  // flag, adapt and move the solution over to the new mesh.  Only the
+  // density, velocity and internal energy are transferred.
+  std::vector< mesh::amr_flag_t > amr_flags;
+  auto adapt_mesh = [&]()
+  {
+    evaluate_refinement_flags( 
+      mesh, inputs_t::amr_refine_tolerance, inputs_t::amr_coarsen_tolerance,
+      amr_flags
+    );
+    auto transfer = amr.adapt( amr_flags );
+    if ( !transfer.changed ) return false;
+    auto new_mesh = amr.template build<mesh_t>();
+    register_fields( new_mesh );
+    mesh::transfer_mesh_attributes( mesh, new_mesh, transfer );
+    transfer_solution( mesh, new_mesh, transfer );
+    mesh = std::move( new_mesh );
+    subdomains = mesh::decompose( 
+      mesh, mesh::partition_blocks( mesh, num_subdomains ), num_subdomains 
+    );
+    return true;
+  };
+
+  // refine the initial mesh until it resolves the initial conditions
+  for ( size_t lev=0; use_amr && lev<inputs_t::amr_max_level; ++lev ) {
+    auto changed = timings.measure( "adapt", adapt_mesh );
+    if ( !changed ) break;
+    timed_execute_task( 
+      timings, initial_conditions_task, loc, single, mesh, subdomains, 
+      inputs_t::ics 
+    );
+    timed_execute_task( 
+      timings, update_state_from_pressure_task, loc, single, mesh, subdomains,
+      region_eos 
+    );
+    std::cout << "Refined the initial mesh to " << mesh.num_cells() 
+              << " cells." << std::endl;
+  }
 
   //===========================================================================
   // Pre-processing
@@ -205,6 +530,54 @@ int driver(int argc, char** argv)
   if (inputs_t::output_freq > 0)
     output(mesh, inputs_t::prefix, inputs_t::postfix, 1);
 
+  // and the output groups, each on its own schedule
+  auto output_groups = inputs_t::output_groups;
+  for ( auto & group : output_groups )
+    write_output_group( mesh, inputs_t::prefix, group );
+
+  // set up the point probes, each rank records the ones in its cells
+  using probes_t = flecsale::io::probe_recorder_t<mesh_t>;
+  std::unique_ptr<probes_t> probes;
+  if ( inputs_t::probe_frequency > 0 ) {
+    auto format = 
+      flecsale::io::probe_format_from_string( inputs_t::probe_format );
+    auto ext = ( format == flecsale::io::probe_format_t::csv ) ? "csv" : "bin";
+    probes = std::make_unique<probes_t>( 
+      mesh, inputs_t::probe_points, inputs_t::probe_follow_flow 
+    );
+    add_probe_fields( mesh, *probes, inputs_t::probe_fields );
+    probes->open( 
+      mesh::rank_file_name( inputs_t::prefix + "-probes", ext ), format 
+    );
+    probes->sample( mesh.time(), mesh.time_step_counter() );
+  }
+
+  // set up the in-situ extracts
+  using extracts_t = flecsale::io::extract_writer_t<mesh_t>;
+  std::unique_ptr<extracts_t> extracts;
+  if ( !inputs_t::extracts.empty() ) {
+    extracts = std::make_unique<extracts_t>( 
+      mesh, inputs_t::prefix, inputs_t::extracts 
+    );
+    add_extract_fields( mesh, *extracts );
+    extracts->process( mesh.time(), mesh.time_step_counter() );
+  }
+
+  // set up the python callback, which sees the fields without copies
+#ifdef HAVE_PYTHON
+  using python_t = flecsale::io::python_bridge_t<mesh_t>;
+  std::unique_ptr<python_t> python;
+  if ( inputs_t::python_frequency > 0 ) {
+    python = std::make_unique<python_t>( 
+      mesh, inputs_t::python_script, inputs_t::python_callback 
+    );
+    python->process( mesh.time(), mesh.time_step_counter() );
+  }
+#else
+  if ( inputs_t::python_frequency > 0 )
+    raise_runtime_error( "The python callback needs python support" );
+#endif
+
   //===========================================================================
   // Residual Evaluation
   //===========================================================================
@@ -213,23 +586,59 @@ int driver(int argc, char** argv)
   auto soln_time = mesh.time();
   auto time_cnt  = mesh.time_step_counter();
 
-  // get an accessor for the time step
-  auto time_step = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );   
-
   // a counter for this session
   size_t num_steps = 0; 
 
+  // a restarted run stops where the original one would have
+  auto max_steps = 
+    inputs_t::max_steps - std::min<size_t>( inputs_t::max_steps, time_cnt );
+
+  // decides when to stop early
+  run_control_t run_control( walltime, run_start );
+
   for ( size_t num_retries = 0;
-    (num_steps < inputs_t::max_steps && soln_time < inputs_t::final_time); 
+    (num_steps < max_steps && soln_time < inputs_t::final_time); 
     ++num_steps 
   ) {   
 
+    // adapt the mesh to the current solution, only if this isnt a retry
+    if ( use_amr && num_retries == 0 && num_steps > 0 && 
+         time_cnt % inputs_t::amr_frequency == 0 ) 
+    {
+      auto changed = timings.measure( "adapt", adapt_mesh );
+      if ( changed ) {
+        timed_execute_task( 
+          timings, update_state_from_energy_task, loc, single, mesh, 
+          subdomains, region_eos 
+        );
+        std::cout << "Adapted the mesh to " << mesh.num_cells() << " cells." 
+                  << std::endl;
+        // the cells were renumbered, so the points have to be found again
+        if ( probes ) probes->relocate( true );
+        if ( extracts ) extracts->reset();
+#ifdef HAVE_PYTHON
+        if ( python ) python->reset();
+#endif
+      }
+    }
+
+    // get an accessor for the time step, the mesh may have changed
+    auto time_step = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );   
+
+    // compute the time step.  this only needs the owned cells, so it is
+    // done while the ghost values from the last step are still arriving
+    timed_execute_task( 
+      timings, evaluate_time_step_task, loc, single, mesh, subdomains 
+    );
+
+    // now the ghost values are needed
+    timings.measure( "halo_exchange", [&]() { cell_exchange.finish(); } );
+
     // store the initial solution, only if this isnt a retry
     if (num_retries == 0)
-      flecsi_execute_task( save_solution_task, loc, single, mesh );
-
-    // compute the time step
-    flecsi_execute_task( evaluate_time_step_task, loc, single, mesh );
+      timed_execute_task( 
+        timings, save_solution_task, loc, single, mesh, subdomains 
+      );
  
     // access the computed time step and make sure its not too large
     *time_step = std::min( *time_step, inputs_t::final_time - soln_time );       
@@ -238,7 +647,9 @@ int driver(int argc, char** argv)
     // try a timestep
 
     // compute the fluxes
-    flecsi_execute_task( evaluate_fluxes_task, loc, single, mesh );
+    timed_execute_task( 
+      timings, evaluate_fluxes_task, loc, single, mesh, subdomains 
+    );
 
     // reset the time stepping mode
     auto mode = mode_t::normal;
@@ -260,8 +671,9 @@ int driver(int argc, char** argv)
 
       // Loop over each cell, scattering the fluxes to the cell
       auto err = 
-        flecsi_execute_task( 
-          apply_update_task, loc, single, mesh, machine_zero, true 
+        timed_execute_task( 
+          timings, apply_update_task, loc, single, mesh, subdomains, 
+          machine_zero, true 
         );
       auto update_flag = err.get();
 
@@ -300,7 +712,9 @@ int driver(int argc, char** argv)
       // if we are retrying or restarting, restore the original solution
       if (mode==mode_t::retry || mode==mode_t::restart) {
         // restore the initial solution
-        flecsi_execute_task( restore_solution_task, loc, single, mesh );
+        timed_execute_task( 
+          timings, restore_solution_task, loc, single, mesh, subdomains 
+        );
         // don't retry forever
         if ( ++num_retries > max_retries ) {
           // Print a message we are exiting
@@ -320,8 +734,9 @@ int driver(int argc, char** argv)
     if (mode==mode_t::restart) continue;
 
     // Update derived solution quantities
-    flecsi_execute_task( 
-      update_state_from_energy_task, loc, single, mesh, inputs_t::eos.get() 
+    timed_execute_task( 
+      timings, update_state_from_energy_task, loc, single, mesh, subdomains,
+      region_eos 
     );
 
     // now we can quit after the solution has been reset to the previous step's
@@ -331,26 +746,94 @@ int driver(int argc, char** argv)
     if (!catalyst_scripts.empty()) {
       auto vtk_grid = mesh::to_vtk( mesh );
       insitu.process( 
-        vtk_grid, soln_time, num_steps, (num_steps==inputs_t::max_steps-1)
+        vtk_grid, soln_time, num_steps, (num_steps==max_steps-1)
       );
     }
     #endif
 
+    // send the new owned values to the neighbors
+    start_cell_exchange();
+
     // update time
     soln_time = mesh.increment_time( *time_step );
     time_cnt = mesh.increment_time_step_counter();
 
+    // the ghost values are only needed right away if they are written out
+    auto output_due = 
+      inputs_t::output_freq > 0 && time_cnt % inputs_t::output_freq == 0;
+    for ( const auto & group : output_groups )
+      output_due = output_due || group.is_due( time_cnt, soln_time );
+    auto checkpoint_due = inputs_t::checkpoint_frequency > 0 && 
+      time_cnt % inputs_t::checkpoint_frequency == 0;
+    auto python_due = inputs_t::python_frequency > 0 && 
+      time_cnt % inputs_t::python_frequency == 0;
+    if ( output_due || checkpoint_due || python_due ) cell_exchange.finish();
+
     // now output the solution
-    output(mesh, inputs_t::prefix, inputs_t::postfix, inputs_t::output_freq);
+    timings.measure( "output", [&]() {
+      for ( auto & group : output_groups )
+        write_output_group( mesh, inputs_t::prefix, group );
+      return output(
+        mesh, inputs_t::prefix, inputs_t::postfix, inputs_t::output_freq
+      );
+    } );
+
+    // save the state, the file is written in the background
+    if ( checkpoint_due )
+      timings.measure( "checkpoint", write_checkpoint );
+
+    // sample the probes
+    if ( probes && time_cnt % inputs_t::probe_frequency == 0 )
+      timings.measure( "probes", [&]() { 
+        probes->sample( soln_time, time_cnt ); 
+      } );
+
+    // compute the extracts that are due
+    if ( extracts )
+      timings.measure( "extracts", [&]() { 
+        extracts->process( soln_time, time_cnt ); 
+      } );
+
+#ifdef HAVE_PYTHON
+    // hand the solution to python
+    if ( python && time_cnt % inputs_t::python_frequency == 0 )
+      timings.measure( "python", [&]() { 
+        python->process( soln_time, time_cnt ); 
+      } );
+#endif
 
     // reset the number of retrys if we eventually made it through a time step
     num_retries  = 0;
 
+    // stop early, with a checkpoint, if the job is about to run out of time
+    // or was asked to stop
+    auto stop = run_control.check( 
+      timings, checkpoint_writer.last_write_seconds() 
+    );
+    if ( stop != stop_reason_t::none ) {
+      std::cout << "Stopping early because " << stop << "." << std::endl;
+      if ( !checkpoint_due ) {
+        cell_exchange.finish();
+        timings.measure( "checkpoint", write_checkpoint );
+      }
+      ++num_steps;
+      break;
+    }
+
   }
 
   //===========================================================================
   // Post-process
   //===========================================================================
+
+  // make sure all the ghost values have arrived
+  cell_exchange.finish();
+
+  // write any buffered probe samples
+  if ( probes ) probes->flush();
+
+  // make sure the last checkpoint made it to disk
+  checkpoint_writer.wait();
     
   // now output the solution
   if ( (inputs_t::output_freq > 0) && (time_cnt % inputs_t::output_freq != 0) )
@@ -365,10 +848,18 @@ int driver(int argc, char** argv)
   std::cout << "Elapsed wall time is " << std::setprecision(4) << std::fixed 
             << tdelta << "s." << std::endl;
 
+  // dump the per-task timings
+  if ( !timings_file_name.empty() ) {
+    timings.add( "total", tdelta );
+    timings.write_csv( timings_file_name );
+  }
+
 
   // now output the checksums
   mesh::checksum(mesh);
 
+  // give the screen back to all the ranks
+  std::cout.rdbuf( cout_buf );
 
   // success if you reached here
   return 0;
@@ -0,0 +1,347 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+///////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Runs several independent cases on one mesh.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// hydro includes
+#include "ensemble_tasks.h"
+#include "types.h"
+#include "../common/output_groups.h"
+#include "../common/timings.h"
+
+// user includes
+#include <flecsale/mesh/distributed.h>
+#include <flecsale/mesh/mesh_utils.h>
+#include <flecsale/mesh/partition.h>
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace apps {
+namespace hydro {
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Run every member of an ensemble on the same mesh.
+//!
+//! The mesh topology and geometry are built once and shared.  The states of
+//! all the members are stored together, with the members of each cell next
+//! to each other, and every kernel loops over the members innermost.  So
+//! the members advance together, one step at a time, but each has its own
+//! time step size, final time, retries and output under its own prefix.  A
+//! member that is done, or that waits to redo a step, is masked out.  Every
+//! member has to use the same kind of equation of state in a region, so
+//! the loops over the members do not branch on it.
+//!
+//! \param [in,out] mesh  The mesh, with the hydro fields registered.
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] cell_exchange  Exchanges the ghost cell values.
+//! \param [in,out] timings  The per-task timers.
+//! \return The total number of steps taken by all the members.
+///////////////////////////////////////////////////////////////////////////////
+template< typename inputs_t, typename mesh_t >
+std::size_t ensemble_driver(
+  mesh_t & mesh,
+  const mesh::subdomains_t & subdomains,
+  mesh::halo_exchange_t & cell_exchange,
+  task_timings_t & timings
+) {
+
+  //===========================================================================
+  // Some typedefs
+  //===========================================================================
+
+  using size_t = typename mesh_t::size_t;
+  using real_t = typename mesh_t::real_t;
+  using eos_t = typename inputs_t::eos_t;
+  using eqns_t = eqns_t<mesh_t::num_dimensions>;
+  using ics_function_t = typename inputs_t::ics_function_t;
+
+  // get machine zero
+  constexpr auto epsilon = std::numeric_limits<real_t>::epsilon();
+  const auto machine_zero = std::sqrt(epsilon);
+
+  // the maximum number of retries
+  constexpr int max_retries = 5;
+
+  // set the solution time and step counter of the mesh
+  auto set_clock = [&]( real_t time, size_t step )
+  {
+    mesh.set_time( time );
+    mesh.increment_time_step_counter( step - mesh.time_step_counter() );
+  };
+
+  //===========================================================================
+  // The members
+  //===========================================================================
+
+  const auto & members = inputs_t::ensemble;
+  auto num_members = members.size();
+  auto num_regions = mesh.num_regions();
+  size_t num_steps = 0;
+
+  std::cout << "Running an ensemble of " << num_members << " members on "
+            << "one mesh." << std::endl;
+
+  // the inputs of each member
+  std::vector<ics_function_t> ics;
+  std::vector< std::vector<const eos_t *> > member_eos;
+  std::vector< decltype(inputs_t::output_groups) > output_groups;
+
+  for ( const auto & input : members ) {
+    ics.emplace_back( input.ics ? input.ics : inputs_t::ics );
+    member_eos.emplace_back( input.eos ?
+      std::vector<const eos_t *>( num_regions, input.eos.get() ) :
+      inputs_t::eos_by_region( num_regions )
+    );
+    output_groups.emplace_back( inputs_t::output_groups );
+  }
+
+  // the progress of each member
+  std::vector<real_t> soln_time( num_members, 0 );
+  std::vector<real_t> time_step( num_members, 0 );
+  std::vector<size_t> time_cnt( num_members, 0 );
+  std::vector<int> num_retries( num_members, 0 );
+  member_mask_t active( num_members, 1 );
+  member_mask_t quit( num_members, 0 );
+
+  auto any = []( const member_mask_t & mask ) {
+    return std::any_of( mask.begin(), mask.end(), []( char b ) { return b; } );
+  };
+
+  // the solution of every member, interleaved by cell
+  ensemble_state_t<mesh_t> state( 
+    mesh.num_cells(), mesh.num_faces(), num_members 
+  );
+
+  // copy a member into the mesh fields and write whatever output is due
+  auto write_output = [&]( size_t m, size_t freq )
+  {
+    timings.measure( "output", [&]() {
+      set_clock( soln_time[m], time_cnt[m] );
+      auto due = freq > 0 && time_cnt[m] % freq == 0;
+      for ( const auto & group : output_groups[m] )
+        due = due || group.is_due( time_cnt[m], soln_time[m] );
+      if ( !due ) return 0;
+      ensemble_copy_member( mesh, state, m );
+      for ( auto & group : output_groups[m] )
+        write_output_group( mesh, members[m].prefix, group );
+      return output( mesh, members[m].prefix, inputs_t::postfix, freq );
+    } );
+  };
+
+  //===========================================================================
+  // Initial conditions
+  //===========================================================================
+
+  // every member starts from the beginning
+  set_clock( 0, 0 );
+
+  timings.measure( "initial_conditions", [&]() {
+    return ensemble_initial_conditions( mesh, subdomains, state, ics );
+  } );
+  auto ener0 = timings.measure( "update_state_from_pressure", [&]() {
+    return ensemble_update_state_from_pressure( 
+      mesh, subdomains, state, member_eos 
+    );
+  } );
+
+  for ( size_t m=0; m<num_members; ++m )
+    write_output( m, inputs_t::output_freq > 0 ? 1 : 0 );
+
+  //===========================================================================
+  // Residual Evaluation
+  //===========================================================================
+
+  while ( true ) {
+
+    // retire the members that are done
+    for ( size_t m=0; m<num_members; ++m ) {
+      if ( !active[m] ) continue;
+      if ( !quit[m] && time_cnt[m] < inputs_t::max_steps && 
+           soln_time[m] < members[m].final_time ) 
+        continue;
+      active[m] = 0;
+
+      if ( (inputs_t::output_freq > 0) &&
+           (time_cnt[m] % inputs_t::output_freq != 0) ) {
+        set_clock( soln_time[m], time_cnt[m] );
+        ensemble_copy_member( mesh, state, m );
+        output( mesh, members[m].prefix, inputs_t::postfix, 1 );
+      }
+
+      cout << "Member " << m << " (\"" << members[m].prefix << "\") final "
+           << "solution time is " << std::scientific << std::setprecision(2)
+           << soln_time[m] << " after " << time_cnt[m] << " steps." 
+           << std::endl;
+      cout.unsetf( std::ios::scientific );
+
+      ensemble_copy_member( mesh, state, m );
+      mesh::checksum(mesh);
+    }
+
+    if ( !any(active) ) break;
+
+    // compute the time step, and make sure its not too large
+    time_step = timings.measure( "evaluate_time_step", [&]() {
+      return ensemble_evaluate_time_step<eqns_t>( 
+        mesh, subdomains, state, active 
+      );
+    } );
+    for ( size_t m=0; m<num_members; ++m )
+      if ( active[m] ) 
+        time_step[m] = 
+          std::min( time_step[m], members[m].final_time - soln_time[m] );
+
+    // store the old solution
+    timings.measure( "save_solution", [&]() {
+      return ensemble_save_solution( mesh, subdomains, state, active );
+    } );
+
+    //-------------------------------------------------------------------------
+    // try a timestep
+
+    // compute the fluxes
+    timings.measure( "evaluate_fluxes", [&]() {
+      return ensemble_evaluate_fluxes( mesh, subdomains, state, active );
+    } );
+
+    // the members that took the step, and those still trying it
+    auto stepped = active;
+    auto trying = active;
+
+    // the stage update is re-executed for the members that retry
+    while ( any(trying) ) {
+
+      // output the time step
+      cout << std::string(80, '=') << endl;
+      auto ss = cout.precision();
+      cout.setf( std::ios::scientific );
+      cout.precision(6);
+      for ( size_t m=0; m<num_members; ++m ) {
+        if ( !trying[m] ) continue;
+        cout << "|  " << "Member:" << std::setw(4) << m
+             << "  |  Step:" << std::setw(8) << time_cnt[m]+1
+             << "  |  Time:" << std::setw(14) << soln_time[m] + time_step[m]
+             << "  |  Step Size:" << std::setw(14) << time_step[m]
+             << "  |" << std::endl;
+      }
+      cout.unsetf( std::ios::scientific );
+      cout.precision(ss);
+
+      // Loop over each cell, scattering the fluxes to the cell
+      auto errors = timings.measure( "apply_update", [&]() {
+        return ensemble_apply_update( 
+          mesh, subdomains, state, trying, time_step, machine_zero, ener0 
+        );
+      } );
+
+      // sort out the members that failed
+      member_mask_t failed( num_members, 0 );
+      member_mask_t retry( num_members, 0 );
+
+      for ( size_t m=0; m<num_members; ++m ) {
+
+        // if there is no error, this member is done with the step
+        if ( !trying[m] || errors[m] == solution_error_t::ok ) continue;
+        failed[m] = 1;
+
+        // dump the current errored solution to a file
+        if ( inputs_t::output_freq > 0 ) {
+          set_clock( soln_time[m], time_cnt[m] );
+          ensemble_copy_member( mesh, state, m );
+          output( mesh, members[m].prefix+"-error", inputs_t::postfix, 1 );
+        }
+
+        // if we got an unphysical solution, half the time step and try again
+        if ( errors[m] == solution_error_t::unphysical ) {
+          std::cout << "Unphysical solution detected in member " << m 
+                    << ", halfing timestep..." << std::endl;
+          time_step[m] *= 0.5;
+          retry[m] = 1;
+        }
+
+        // if there was variance, retry the whole step
+        else {
+          std::cout << "Variance in solution detected in member " << m 
+                    << ", retrying..." << std::endl;
+          stepped[m] = 0;
+        }
+
+        // don't retry forever
+        if ( ++num_retries[m] > max_retries ) {
+          std::cout << "Too many retries, member " << m << " is stopping..."
+                    << std::endl;
+          quit[m] = 1;
+          stepped[m] = 0;
+          retry[m] = 0;
+        }
+
+      }
+
+      // restore the initial solution of the failed members
+      if ( any(failed) )
+        timings.measure( "restore_solution", [&]() {
+          return ensemble_restore_solution( mesh, subdomains, state, failed );
+        } );
+
+      trying = retry;
+
+    }
+
+    // end timestep
+    //-------------------------------------------------------------------------
+
+    // Update derived solution quantities
+    timings.measure( "update_state_from_energy", [&]() {
+      return ensemble_update_state_from_energy( 
+        mesh, subdomains, state, member_eos, stepped 
+      );
+    } );
+
+    // update the ghost values, one member at a time
+    timings.measure( "halo_exchange", [&]() {
+      auto & u = state.u;
+      for ( size_t m=0; m<num_members; ++m ) {
+        if ( !stepped[m] ) continue;
+        auto member = [&]( auto & field ) {
+          using value_t = std::decay_t<decltype(field[0])>;
+          return member_field_t<value_t>( field.data(), num_members, m );
+        };
+        cell_exchange.exchange(
+          member(u.d), member(u.p), member(u.v), member(u.e), member(u.t), 
+          member(u.a)
+        );
+      }
+    } );
+
+    // update time, and output the members that took the step
+    for ( size_t m=0; m<num_members; ++m ) {
+      if ( !stepped[m] ) continue;
+      soln_time[m] += time_step[m];
+      ++time_cnt[m];
+      ++num_steps;
+      write_output( m, inputs_t::output_freq );
+      // reset the number of retrys if we eventually made it through a step
+      num_retries[m] = 0;
+    }
+
+  }
+
+  return num_steps;
+
+}
+
+} // namespace
+} // namespace
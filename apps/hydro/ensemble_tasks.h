@@ -0,0 +1,843 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief The tasks that advance every member of an ensemble at once.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// hydro includes
+#include "tasks.h"
+#include "types.h"
+
+// user includes
+#include <flecsale/eos/visit.h>
+#include <flecsale/mesh/partition.h>
+#include <flecsale/utils/errors.h>
+#include <flecsale/utils/first_touch.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/reduction.h>
+
+// system includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace apps {
+namespace hydro {
+
+//! \brief Flags the ensemble members a task works on.
+using member_mask_t = std::vector<char>;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The cell state of a set of ensemble members.
+//!
+//! The value of entity \e i and member \e m is stored at \f$ i M + m \f$,
+//! where \e M is the number of members.  So the members of one cell are
+//! next to each other, and a kernel that loops over the members innermost
+//! walks every field with unit stride, while the geometry of the cell is
+//! loaded only once.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+struct ensemble_fields_t {
+
+  //! \brief the value types
+  //! \{
+  using real_t = typename M::real_t;
+  using storage_real_t = typename M::storage_real_t;
+  using vector_t = typename M::vector_t;
+  //! \}
+
+  //! \brief the storage type, placed by the threads that first write it
+  template< typename T >
+  using storage_t = flecsale::utils::first_touch_vector<T>;
+
+  //! \brief the density, pressure and internal energy
+  storage_t<real_t> d, p, e;
+  //! \brief the velocity
+  storage_t<vector_t> v;
+  //! \brief the temperature and sound speed
+  storage_t<storage_real_t> t, a;
+
+  //! \brief Size every field, without writing to it.
+  //! \param [in] n  The number of values.
+  void resize( std::size_t n )
+  {
+    d.resize(n);  p.resize(n);  e.resize(n);
+    v.resize(n);  t.resize(n);  a.resize(n);
+  }
+
+  //! \brief Return a tuple of references to one state, in the same order as
+  //!        state_accessor.
+  //! \param [in] i  The index of the state.
+  auto operator()( std::size_t i )
+  { return std::forward_as_tuple( d[i], v[i], p[i], e[i], t[i], a[i] ); }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The solution of every ensemble member.
+//!
+//! Only the mesh topology and geometry are shared.  The state, the state at
+//! the start of the step and the face fluxes are stored for every member,
+//! interleaved like ensemble_fields_t.  Nothing is written when the store
+//! is created, the kernels write it first one sub-domain per thread.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+struct ensemble_state_t {
+
+  //! \brief the value types
+  //! \{
+  using real_t = typename M::real_t;
+  using vector_t = typename M::vector_t;
+  using flux_t = flux_data_t<M::num_dimensions>;
+  //! \}
+
+  //! \brief the storage type
+  template< typename T >
+  using storage_t = flecsale::utils::first_touch_vector<T>;
+
+  //! \brief Constructor.
+  //! \param [in] num_cells  The number of cells, including ghosts.
+  //! \param [in] num_faces  The number of faces.
+  //! \param [in] num_members  The number of ensemble members.
+  ensemble_state_t(
+    std::size_t num_cells, std::size_t num_faces, std::size_t num_members
+  ) : num_members( num_members )
+  {
+    u.resize( num_cells * num_members );
+    d0.resize( num_cells * num_members );
+    v0.resize( num_cells * num_members );
+    e0.resize( num_cells * num_members );
+    flux.resize( num_faces * num_members );
+  }
+
+  //! \brief Return the index of the first member of an entity.
+  //! \param [in] i  The entity id.
+  std::size_t index( std::size_t i ) const
+  { return i * num_members; }
+
+  //! \brief the number of members
+  std::size_t num_members = 0;
+  //! \brief the current state
+  ensemble_fields_t<M> u;
+  //! \brief the density, velocity and internal energy at the start of the
+  //!        step
+  //! \{
+  storage_t<real_t> d0, e0;
+  storage_t<vector_t> v0;
+  //! \}
+  //! \brief the face fluxes, scaled by the face area
+  storage_t<flux_t> flux;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief One member of an interleaved field, indexable by entity id.
+//!
+//! This lets the ghost exchange send the members one at a time.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+class member_field_t {
+
+public:
+
+  //! \brief Constructor.
+  //! \param [in] data  The interleaved values.
+  //! \param [in] num_members  The number of members.
+  //! \param [in] member  The member to access.
+  member_field_t( T * data, std::size_t num_members, std::size_t member ) :
+    data_( data ), num_members_( num_members ), member_( member )
+  {}
+
+  //! \brief Access the value of an entity.
+  //! \param [in] i  The entity id.
+  T & operator[]( std::size_t i ) const
+  { return data_[ i*num_members_ + member_ ]; }
+
+private:
+
+  //! \brief the interleaved values
+  T * data_ = nullptr;
+  //! \brief the number of members
+  std::size_t num_members_ = 0;
+  //! \brief the member accessed
+  std::size_t member_ = 0;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to every cell, one region at a time, with the
+//!        equations of state of all the members.
+//!
+//! Every member has to use the same kind of equation of state in a region,
+//! only the parameters may differ.  The function gets them all cast to
+//! that kind, so the loop over the members has no dispatch.  Each thread
+//! sweeps its own sub-domain, and the ghost cells of other ranks are swept
+//! afterwards.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] member_eos  The equation of state of each region, for each
+//!                         member.
+//! \param [in] owned_only  If true, skip the ghost cells of other ranks.
+//! \param [in] f  Called as f(c, eos) for each cell, where eos[m] is the
+//!                equation of state of member m.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS, typename F >
+void for_each_member_region_cell(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  const std::vector< std::vector<const EOS *> > & member_eos,
+  bool owned_only,
+  F && f
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  auto num_owned = mesh.num_owned_cells();
+  auto num_regions = mesh.num_regions();
+  auto num_members = member_eos.size();
+  counter_t num_subdomains = subdomains.size();
+
+  if ( num_members == 0 ) return;
+
+  for ( size_t r=0; r<num_regions; r++ ) {
+
+    flecsale::eos::visit( *member_eos[0][r], [&]( const auto & first ) {
+
+      using eos_type = std::decay_t<decltype(first)>;
+
+      std::vector<const eos_type *> eos( num_members );
+      for ( size_t m=0; m<num_members; m++ ) {
+        eos[m] = dynamic_cast<const eos_type *>( member_eos[m][r] );
+        if ( !eos[m] )
+          raise_runtime_error(
+            "Ensemble member " << m << " uses a different kind of equation "
+            << "of state than member 0 in region " << r
+          );
+      }
+
+      #pragma omp parallel for schedule(static)
+      for ( counter_t s=0; s<num_subdomains; s++ ) {
+        const auto & sub = subdomains[s];
+        auto last = sub.region_offsets[r+1];
+        for ( auto i=sub.region_offsets[r]; i<last; i++ )
+          std::forward<F>(f)( cs[ sub.cells[i] ], eos );
+      }
+
+      if ( owned_only ) return;
+
+      // the ids are sorted, so the ghost cells come last
+      auto ids = mesh.region_cell_ids(r);
+      counter_t first_ghost =
+        std::lower_bound( ids.begin(), ids.end(), num_owned ) - ids.begin();
+      counter_t num_ids = ids.size();
+
+      #pragma omp parallel for
+      for ( counter_t i=first_ghost; i<num_ids; i++ )
+        std::forward<F>(f)( cs[ ids[i] ], eos );
+
+    } );
+
+  } // region
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sum a quantity of every member, independent of the number of
+//!        threads.
+//!
+//! \param [in] n  The number of items.
+//! \param [in] num_members  The number of members.
+//! \param [in] zero  The value of an empty sum.
+//! \param [in] f  Called as f(i, sums) for each item i, in order within a
+//!                block.  It adds the contribution of each member m to
+//!                sums[m].
+//! \return The total of each member.
+//! \see utils::reproducible_sum
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+std::vector<T> member_sums(
+  std::size_t n, std::size_t num_members, const T & zero, F && f
+) {
+
+  utils::blocked_sum_t<T> blocks( n, zero );
+  std::vector< utils::blocked_sum_t<T> > sums( num_members, blocks );
+  auto num_blocks = blocks.num_blocks();
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; ++b ) {
+    std::vector<T> block_sums( num_members, zero );
+    auto end = blocks.end(b);
+    for ( auto i=blocks.begin(b); i<end; ++i ) f( i, block_sums );
+    for ( std::size_t m=0; m<num_members; ++m ) sums[m][b] = block_sums[m];
+  }
+
+  std::vector<T> totals;
+  totals.reserve( num_members );
+  for ( const auto & sum : sums ) totals.emplace_back( sum.sum() );
+
+  return totals;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Set the initial conditions of every member.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] ics  The initial conditions of each member.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+int ensemble_initial_conditions(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const std::vector<F> & ics
+) {
+
+  // type aliases
+  using vector_t = typename T::vector_t;
+
+  // get the current time
+  auto soln_time = mesh.time();
+  auto num_members = state.num_members;
+
+  auto xc = flecsi_get_accessor( mesh, mesh, cell_centroid, vector_t, dense, 0 );
+
+  auto & d = state.u.d;
+  auto & v = state.u.v;
+  auto & p = state.u.p;
+
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
+    auto i = state.index( c.id() );
+    for ( size_t m=0; m<num_members; m++ )
+      std::tie( d[i+m], v[i+m], p[i+m] ) = ics[m]( xc[c], soln_time );
+  } );
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Update the state of every member from density and pressure.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] member_eos  The equation of state of each region, for each
+//!                         member.
+//! \return The total energy of each member.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS >
+std::vector<typename T::real_t> ensemble_update_state_from_pressure(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const std::vector< std::vector<const EOS *> > & member_eos
+) {
+
+  // type aliases
+  using real_t = typename T::real_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+
+  auto num_members = state.num_members;
+
+  for_each_member_region_cell( mesh, subdomains, member_eos, false,
+    [&]( auto c, const auto & eos ) {
+      auto i = state.index( c.id() );
+      #pragma omp simd
+      for ( size_t m=0; m<num_members; m++ ) {
+        auto u = state.u( i+m );
+        eqns_t::update_state_from_pressure( u, *eos[m] );
+      }
+    }
+  );
+
+  // sum total energy, ghost cells are counted by their owner
+  auto cs = mesh.cells();
+  auto volume = mesh.cell_volumes();
+
+  auto ener = member_sums(
+    mesh.num_owned_cells(), num_members, real_t(0),
+    [&]( std::size_t i, std::vector<real_t> & sums ) {
+      auto c = cs[i];
+      auto j = state.index( i );
+      for ( size_t m=0; m<num_members; m++ ) {
+        auto u = state.u( j+m );
+        sums[m] +=
+          eqns_t::density(u) * eqns_t::total_energy(u) * volume[c];
+      }
+    }
+  );
+
+  utils::global_sum( ener.data(), ener.size() );
+
+  return ener;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Update the state of some members from density and energy.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] member_eos  The equation of state of each region, for each
+//!                         member.
+//! \param [in] mask  The members to update.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS >
+int ensemble_update_state_from_energy(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const std::vector< std::vector<const EOS *> > & member_eos,
+  const member_mask_t & mask
+) {
+
+  // type aliases
+  using eqns_t = eqns_t<T::num_dimensions>;
+
+  auto num_members = state.num_members;
+
+  // the ghost cells are filled in by their owners
+  for_each_member_region_cell( mesh, subdomains, member_eos, true,
+    [&]( auto c, const auto & eos ) {
+      auto i = state.index( c.id() );
+      #pragma omp simd
+      for ( size_t m=0; m<num_members; m++ ) {
+        if ( !mask[m] ) continue;
+        auto u = state.u( i+m );
+        eqns_t::update_state_from_energy( u, *eos[m] );
+      }
+    }
+  );
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Compute the time step size of some members.
+//!
+//! \tparam E  The equations to use.
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] state  The ensemble solution.
+//! \param [in] mask  The members to compute the time step of.
+//! \return The time step size of each member, zero for the others.
+////////////////////////////////////////////////////////////////////////////////
+template< typename E, typename T >
+std::vector<typename T::real_t> ensemble_evaluate_time_step(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const member_mask_t & mask
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+
+  // access what we need
+  const auto cfl = flecsi_get_accessor( mesh, hydro, cfl, real_t, global, 0 );
+
+  auto area   = mesh.face_areas();
+  auto normal = mesh.face_normals();
+  auto volume = mesh.cell_volumes();
+
+  auto cs = mesh.cells();
+  auto num_members = state.num_members;
+  counter_t num_subdomains = subdomains.size();
+
+  // the maximum 1/dt of each sub-domain and member
+  std::vector<real_t> dt_inv( num_subdomains * num_members, 0 );
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+
+    std::vector<real_t> sub_dt_inv( num_members, 0 );
+
+    for ( auto cid : subdomains[s].cells ) {
+      auto c = cs[cid];
+      auto i = state.index( cid );
+
+      // loop over each face
+      for ( auto f : mesh.faces(c) ) {
+        // estimate the length scale normal to the face
+        auto delta_x = volume[c] / area[f];
+        const auto & n = normal[f];
+        // compute the inverse of the time scale of each member
+        #pragma omp simd
+        for ( size_t m=0; m<num_members; m++ ) {
+          if ( !mask[m] ) continue;
+          auto u = state.u( i+m );
+          auto dti = E::fastest_wavespeed( u, n ) / delta_x;
+          sub_dt_inv[m] = std::max( dti, sub_dt_inv[m] );
+        }
+      } // edge
+
+    } // cell
+
+    std::copy(
+      sub_dt_inv.begin(), sub_dt_inv.end(),
+      dt_inv.begin() + s*num_members
+    );
+
+  } // sub-domain
+
+  // the smallest time step over all sub-domains and ranks
+  std::vector<real_t> dt( num_members, 0 );
+  for ( counter_t s=0; s<num_subdomains; s++ )
+    for ( size_t m=0; m<num_members; m++ )
+      dt[m] = std::max( dt[m], dt_inv[ s*num_members + m ] );
+
+  utils::global_max( dt.data(), dt.size() );
+
+  // invert dt and apply cfl
+  for ( size_t m=0; m<num_members; m++ ) {
+    if ( !mask[m] ) continue;
+    assert( dt[m] > 0 && "infinite delta t" );
+    dt[m] = static_cast<real_t>(cfl) / dt[m];
+  }
+
+  return dt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Evaluate the fluxes of some members at each face.
+//!
+//! Each thread computes the faces owned by its sub-domain.  The states of
+//! the ghost cells, for all the members, are first copied into a halo
+//! local to the thread.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] mask  The members to compute the fluxes of.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int ensemble_evaluate_fluxes(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const member_mask_t & mask
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+  using flux_t = typename ensemble_state_t<T>::flux_t;
+  using fields_t = ensemble_fields_t<T>;
+
+  auto area   = mesh.face_areas();
+  auto normal = mesh.face_normals();
+
+  auto fs = mesh.faces();
+  auto num_members = state.num_members;
+  counter_t num_subdomains = subdomains.size();
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+
+    const auto & sub = subdomains[s];
+    auto num_ghosts = sub.ghost_cells.size();
+
+    // the halo exchange, the ghost values were already brought up to date
+    // by their owners
+    fields_t halo;
+    halo.resize( num_ghosts * num_members );
+    for ( size_t g=0; g<num_ghosts; g++ ) {
+      auto i = state.index( sub.ghost_cells[g] );
+      for ( size_t m=0; m<num_members; m++ )
+        halo( g*num_members + m ) = state.u( i+m );
+    }
+
+    // where the states of a cell are, either in place or in the halo
+    auto states_of = [&]( auto c ) -> std::pair< fields_t *, std::size_t >
+    {
+      auto g = sub.ghost_index( c.id() );
+      if ( g == mesh::subdomain_t::npos )
+        return { &state.u, state.index( c.id() ) };
+      return { &halo, g*num_members };
+    };
+
+    for ( auto fid : sub.faces ) {
+      auto f = fs[fid];
+      auto i = state.index( fid );
+      const auto & n = normal[f];
+      auto a = area[f];
+
+      // get the cell neighbors
+      auto cells = mesh.cells(f);
+      auto left = states_of( cells[0] );
+
+      // interior cell
+      if ( cells.size() == 2 ) {
+        auto right = states_of( cells[1] );
+        #pragma omp simd
+        for ( size_t m=0; m<num_members; m++ ) {
+          if ( !mask[m] ) continue;
+          auto w_left = (*left.first)( left.second + m );
+          auto w_right = (*right.first)( right.second + m );
+          state.flux[i+m] = flux_function<eqns_t>( w_left, w_right, n );
+          state.flux[i+m] *= a;
+        }
+      }
+      // boundary cell
+      else {
+        #pragma omp simd
+        for ( size_t m=0; m<num_members; m++ ) {
+          if ( !mask[m] ) continue;
+          auto w_left = (*left.first)( left.second + m );
+          state.flux[i+m] = flux_t( boundary_flux<eqns_t>( w_left, n ) );
+          state.flux[i+m] *= a;
+        }
+      }
+
+    } // face
+
+  } // sub-domain
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Update the solution of some members in each cell.
+//!
+//! A member fails if a cell gets a negative density or internal energy, or
+//! if its total energy changes by more than \e tolerance.  The total energy
+//! of a member that succeeds is stored for its next step.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] mask  The members to update.
+//! \param [in] delta_t  The time step size of each member.
+//! \param [in] tolerance  The allowed change in total energy.
+//! \param [in,out] ener0  The total energy of each member.
+//! \return The outcome for each member, ok for the members not updated.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+std::vector<solution_error_t> ensemble_apply_update(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const member_mask_t & mask,
+  const std::vector<typename T::real_t> & delta_t,
+  typename T::real_t tolerance,
+  std::vector<typename T::real_t> & ener0
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+  using flux_t = typename ensemble_state_t<T>::flux_t;
+
+  auto volume = mesh.cell_volumes();
+
+  auto cs = mesh.cells();
+  auto num_members = state.num_members;
+  counter_t num_subdomains = subdomains.size();
+
+  // the members with a bad cell in each sub-domain
+  std::vector<int> bad_cells( num_subdomains * num_members, 0 );
+
+  //----------------------------------------------------------------------------
+  // Loop over each owned cell, one sub-domain per thread, scattering the
+  // fluxes of every member to the cell.  The ghost cells are updated by
+  // their owners.
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+
+    std::vector<flux_t> delta_u( num_members );
+    auto bad_cell = bad_cells.data() + s*num_members;
+
+    for ( auto cid : subdomains[s].cells ) {
+
+      auto c = cs[cid];
+      auto i = state.index( cid );
+
+      std::fill( delta_u.begin(), delta_u.end(), flux_t(0) );
+
+      // loop over each connected edge, adding the contribution to this cell
+      for ( auto f : mesh.faces(c) ) {
+        auto j = state.index( f.id() );
+        real_t sign = ( mesh.cells(f)[0] == c ) ? -1 : 1;
+        #pragma omp simd
+        for ( size_t m=0; m<num_members; m++ )
+          delta_u[m] += sign * state.flux[j+m];
+      } // edge
+
+      // now compute the final update, and check the solution quantities
+      #pragma omp simd
+      for ( size_t m=0; m<num_members; m++ ) {
+        if ( !mask[m] ) continue;
+        delta_u[m] *= delta_t[m] / volume[c];
+        auto u = state.u( i+m );
+        eqns_t::update_state_from_flux( u, delta_u[m] );
+        if ( eqns_t::internal_energy(u) < 0 || eqns_t::density(u) < 0 )
+          bad_cell[m] = 1;
+      }
+
+    } // cell
+
+  } // sub-domain
+  //----------------------------------------------------------------------------
+
+  // the total energy is summed in fixed blocks of cells, so it does not
+  // depend on the number of threads or sub-domains
+  auto ener = member_sums(
+    mesh.num_owned_cells(), num_members, real_t(0),
+    [&]( std::size_t i, std::vector<real_t> & sums ) {
+      auto c = cs[i];
+      auto j = state.index( i );
+      for ( size_t m=0; m<num_members; m++ ) {
+        auto u = state.u( j+m );
+        sums[m] +=
+          eqns_t::density(u) * eqns_t::total_energy(u) * volume[c];
+      }
+    }
+  );
+
+  // combine the sub-domains and sum over all the ranks
+  std::vector<int> bad( num_members, 0 );
+  for ( counter_t s=0; s<num_subdomains; s++ )
+    for ( size_t m=0; m<num_members; m++ )
+      bad[m] = std::max( bad[m], bad_cells[ s*num_members + m ] );
+
+  utils::global_max( bad.data(), bad.size() );
+  utils::global_sum( ener.data(), ener.size() );
+
+  //----------------------------------------------------------------------------
+  // check the invariants
+
+  std::vector<solution_error_t> errors( num_members, solution_error_t::ok );
+
+  for ( size_t m=0; m<num_members; m++ ) {
+    if ( !mask[m] ) continue;
+    if ( bad[m] )
+      errors[m] = solution_error_t::unphysical;
+    else if ( std::abs( ener0[m] - ener[m] ) > tolerance )
+      errors[m] = solution_error_t::variance;
+    else
+      ener0[m] = ener[m];
+  }
+
+  return errors;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Save the solution of some members at the start of a step.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] mask  The members to save.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int ensemble_save_solution(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const member_mask_t & mask
+) {
+
+  auto num_members = state.num_members;
+
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
+    auto i = state.index( c.id() );
+    #pragma omp simd
+    for ( size_t m=0; m<num_members; m++ ) {
+      if ( !mask[m] ) continue;
+      state.d0[i+m] = state.u.d[i+m];
+      state.v0[i+m] = state.u.v[i+m];
+      state.e0[i+m] = state.u.e[i+m];
+    }
+  } );
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Restore the solution of some members to the start of the step.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in,out] state  The ensemble solution.
+//! \param [in] mask  The members to restore.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int ensemble_restore_solution(
+  T & mesh,
+  const mesh::subdomains_t & subdomains,
+  ensemble_state_t<T> & state,
+  const member_mask_t & mask
+) {
+
+  auto num_members = state.num_members;
+
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
+    auto i = state.index( c.id() );
+    #pragma omp simd
+    for ( size_t m=0; m<num_members; m++ ) {
+      if ( !mask[m] ) continue;
+      state.u.d[i+m] = state.d0[i+m];
+      state.u.v[i+m] = state.v0[i+m];
+      state.u.e[i+m] = state.e0[i+m];
+    }
+  } );
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Copy the solution of one member into the mesh fields, so it can
+//!        be written out.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] state  The ensemble solution.
+//! \param [in] member  The member to copy.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int ensemble_copy_member(
+  T & mesh, ensemble_state_t<T> & state, std::size_t member
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+
+  state_accessor<T> fields( mesh );
+
+  auto cs = mesh.cells();
+  counter_t num_cells = cs.size();
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; i++ )
+    fields( cs[i] ) = state.u( state.index(i) + member );
+
+  return 0;
+}
+
+} // namespace hydro
+} // namespace apps
@@ -12,24 +12,79 @@
 // hydro includes
 #include "types.h"
 
+// user includes
+#include <flecsale/eos/visit.h>
+#include <flecsale/mesh/amr.h>
+#include <flecsale/mesh/distributed.h>
+#include <flecsale/mesh/partition.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/reduction.h>
+
 // system includes
+#include <algorithm>
+#include <cassert>
 #include <iomanip>
+#include <string>
+#include <vector>
 
 namespace apps {
 namespace hydro {
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to every cell, one sub-domain per thread.
+//!
+//! The ghost cells of other ranks belong to no sub-domain, so they are swept
+//! afterwards with a plain loop.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] owned_only  If true, skip the ghost cells of other ranks.
+//! \param [in] f  Called as f(c) for each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+void for_each_cell( 
+  T & mesh, 
+  const mesh::subdomains_t & subdomains,
+  bool owned_only,
+  F && f
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  counter_t num_subdomains = subdomains.size();
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ )
+    for ( auto cid : subdomains[s].cells )
+      std::forward<F>(f)( cs[cid] );
+
+  if ( owned_only ) return;
+
+  counter_t num_cells = cs.size();
+  counter_t num_owned = mesh.num_owned_cells();
+
+  #pragma omp parallel for
+  for ( counter_t i=num_owned; i<num_cells; i++ )
+    std::forward<F>(f)( cs[i] );
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task for setting initial conditions
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \param [in]     ics  the initial conditions to set
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename F >
-int initial_conditions( T & mesh, F && ics ) {
+int initial_conditions( 
+  T & mesh, const mesh::subdomains_t & subdomains, F && ics 
+) {
 
   // type aliases
-  using counter_t = typename T::counter_t;
   using real_t = typename T::real_t;
   using vector_t = typename T::vector_t;
 
@@ -43,30 +98,104 @@ int initial_conditions( T & mesh, F && ics ) {
 
   auto xc = flecsi_get_accessor( mesh, mesh, cell_centroid, vector_t, dense, 0 );
 
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  // This doesn't work with lua input
-  //#pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
+  // each thread sets its own cells first, so their pages end up on its
+  // socket
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
     std::tie( d[c], v[c], p[c] ) = std::forward<F>(ics)( xc[c], soln_time );
-  }
+  } );
 
   return 0;
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to every cell, one region at a time.
+//!
+//! Each thread sweeps the regions of its own sub-domain, one loop per 
+//! region, and the function is called with the concrete type of that 
+//! region's equation of state.  So the loop body has no per-cell dispatch, 
+//! and every cell in a loop sees the same material.  The ghost cells of 
+//! other ranks belong to no sub-domain, so they are swept afterwards.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] region_eos  The equation of state of each region.
+//! \param [in] owned_only  If true, skip the ghost cells of other ranks.
+//! \param [in] f  Called as f(c, eos) for each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS, typename F >
+void for_each_region_cell( 
+  T & mesh, 
+  const mesh::subdomains_t & subdomains,
+  const std::vector<const EOS *> & region_eos, 
+  bool owned_only,
+  F && f
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  auto num_regions = mesh.num_regions();
+  assert( region_eos.size() == num_regions );
+
+  counter_t num_subdomains = subdomains.size();
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+
+    const auto & sub = subdomains[s];
+    assert( sub.region_offsets.size() == num_regions+1 );
+
+    for ( size_t r=0; r<num_regions; r++ ) {
+      auto first = sub.region_offsets[r];
+      auto last = sub.region_offsets[r+1];
+      flecsale::eos::visit( *region_eos[r], [&]( const auto & eos ) {
+        for ( auto i=first; i<last; i++ )
+          std::forward<F>(f)( cs[ sub.cells[i] ], eos );
+      } );
+    } // region
+
+  } // sub-domain
+
+  if ( owned_only ) return;
+
+  auto num_owned = mesh.num_owned_cells();
+
+  for ( size_t r=0; r<num_regions; r++ ) {
+    
+    // the ids are sorted, so the ghost cells come last
+    auto ids = mesh.region_cell_ids(r);
+    counter_t first = 
+      std::lower_bound( ids.begin(), ids.end(), num_owned ) - ids.begin();
+    counter_t num_ids = ids.size();
+
+    flecsale::eos::visit( *region_eos[r], [&]( const auto & eos ) {
+      #pragma omp parallel for
+      for ( counter_t i=first; i<num_ids; i++ )
+        std::forward<F>(f)( cs[ ids[i] ], eos );
+    } );
+
+  } // region
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task for updating the state using pressure.
 //!
 //! Updates the state from density and pressure and computes the new energy.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename EOS >
-int update_state_from_pressure( T & mesh, const EOS * eos ) 
+int update_state_from_pressure( 
+  T & mesh, 
+  const mesh::subdomains_t & subdomains,
+  const std::vector<const EOS *> & region_eos 
+) 
 {
 
   // type aliases
@@ -80,23 +209,31 @@ int update_state_from_pressure( T & mesh, const EOS * eos )
   auto volume = mesh.cell_volumes();
 
 
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  real_t ener(0);
+  // update each region with its own equation of state
+  for_each_region_cell( mesh, subdomains, region_eos, false, 
+    [&]( auto c, const auto & eos ) {
+      auto u = state(c);
+      eqns_t::update_state_from_pressure( u, eos );
+    }
+  );
 
-  #pragma omp parallel for reduction(+:ener)
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-    auto u = state(c);
-    eqns_t::update_state_from_pressure( u, *eos );
-    // sum total energy
-    auto et = eqns_t::total_energy(u);
-    auto rho  = eqns_t::density(u);
-    ener += rho * et * volume[c];
-  }
+  auto cs = mesh.cells();
+  counter_t num_owned = mesh.num_owned_cells();
+
+  // sum total energy, ghost cells are counted by their owner.  The sum is 
+  // done in fixed blocks so it does not depend on the number of threads
+  auto ener = utils::reproducible_sum(
+    num_owned, real_t(0),
+    [&]( counter_t i, real_t & sum ) {
+      auto c = cs[i];
+      auto u = state(c);
+      auto et = eqns_t::total_energy(u);
+      auto rho  = eqns_t::density(u);
+      sum += rho * et * volume[c];
+    }
+  );
 
-  *ener0 = ener;
+  *ener0 = utils::global_sum( ener );
 
   return 0;
 }
@@ -108,31 +245,32 @@ int update_state_from_pressure( T & mesh, const EOS * eos )
 //! Updates the state from density and energy and computes the new pressure.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename EOS >
-int update_state_from_energy( T & mesh, const EOS * eos ) 
+int update_state_from_energy( 
+  T & mesh, 
+  const mesh::subdomains_t & subdomains,
+  const std::vector<const EOS *> & region_eos 
+) 
 {
 
   // type aliases
-  using counter_t = typename T::counter_t;
   using eqns_t = eqns_t<T::num_dimensions>;
 
   // get the collection accesor
   state_accessor<T> state( mesh );
 
-  // get the cells
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  real_t ener(0);
-
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
-    auto u = state(c);
-    eqns_t::update_state_from_energy( u, *eos );
-  }
+  // update each region with its own equation of state, the ghost cells are
+  // filled in by their owners
+  for_each_region_cell( mesh, subdomains, region_eos, true, 
+    [&]( auto c, const auto & eos ) {
+      auto u = state(c);
+      eqns_t::update_state_from_energy( u, eos );
+    }
+  );
 
   return 0;
 }
@@ -143,10 +281,11 @@ int update_state_from_energy( T & mesh, const EOS * eos )
 //!
 //! \tparam E  The equation of state object to use.
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename E, typename T >
-int evaluate_time_step( T & mesh ) {
+int evaluate_time_step( T & mesh, const mesh::subdomains_t & subdomains ) {
 
   // type aliases
   using  counter_t = typename T::counter_t;
@@ -167,29 +306,33 @@ int evaluate_time_step( T & mesh ) {
   // which is also the maximum 1/dt
   real_t dt_inv(0);
 
-  // get the cells
+  // get the owned cells, each thread works on its own sub-domain
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  counter_t num_subdomains = subdomains.size();
 
-  #pragma omp parallel for reduction(max:dt_inv)
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
+  #pragma omp parallel for schedule(static) reduction(max:dt_inv)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+    for ( auto cid : subdomains[s].cells ) {
+      auto c = cs[cid];
 
-    // get cell properties
-    auto u = state( c );
+      // get cell properties
+      auto u = state( c );
 
-    // loop over each face
-    for ( auto f : mesh.faces(c) ) {
-      // estimate the length scale normal to the face
-      auto delta_x = volume[c] / area[f];
-      // compute the inverse of the time scale
-      auto dti =  E::fastest_wavespeed(u, normal[f]) / delta_x;
-      // std::cout << dti << " " << delta_x << std::endl;
-      // check for the maximum value
-      dt_inv = std::max( dti, dt_inv );
-    } // edge
+      // loop over each face
+      for ( auto f : mesh.faces(c) ) {
+        // estimate the length scale normal to the face
+        auto delta_x = volume[c] / area[f];
+        // compute the inverse of the time scale
+        auto dti =  E::fastest_wavespeed(u, normal[f]) / delta_x;
+        // check for the maximum value
+        dt_inv = std::max( dti, dt_inv );
+      } // edge
+
+    } // cell
+  } // sub-domain
 
-  } // cell
+  // the smallest time step over all ranks
+  dt_inv = utils::global_max( dt_inv );
 
   assert( dt_inv > 0 && "infinite delta t" );
 
@@ -203,17 +346,23 @@ int evaluate_time_step( T & mesh ) {
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task to evaluate fluxes at each face.
 //!
+//! Each thread computes the faces owned by its sub-domain.  The states of 
+//! the ghost cells are first copied into a halo local to the thread, so 
+//! the face loop only reads the thread's own cells and its own copies.
+//!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T >
-int evaluate_fluxes( T & mesh ) {
+int evaluate_fluxes( T & mesh, const mesh::subdomains_t & subdomains ) {
 
   // type aliases
   using counter_t = typename T::counter_t;
   using vector_t = typename T::vector_t;
   using eqns_t = eqns_t<T::num_dimensions>;
   using flux_data_t = flux_data_t<T::num_dimensions>;
+  using state_t = typename state_accessor<T>::value_t;
 
   // access what we need
   auto flux = flecsi_get_accessor( mesh, hydro, flux, flux_data_t, dense, 0 );
@@ -228,40 +377,49 @@ int evaluate_fluxes( T & mesh ) {
  
   // get the faces
   auto fs = mesh.faces();
-  auto num_faces = fs.size();
+  counter_t num_subdomains = subdomains.size();
 
-  //for ( auto fit = fs.begin(); fit < fs.end(); ++fit  ) {
+  #pragma omp parallel for schedule(static)
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
 
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_faces; i++ ) {
-    auto f = fs[i];
-
-    // get the cell neighbors
-    auto cells = mesh.cells(f);
-    auto num_cells = cells.size();
-
-
-    // get the left state
-    auto w_left = state( cells[0] );    
-
-    // compute the face flux
-    //
-    // interior cell
-    if ( num_cells == 2 ) {
-      auto w_right = state( cells[1] );
-      flux[f] = flux_function<eqns_t>( w_left, w_right, normal[f] );
-    } 
-    // boundary cell
-    else {
-      flux[f] = boundary_flux<eqns_t>( w_left, normal[f] );
-    }
-    
-    // scale the flux by the face area
-    flux[f] *= area[f];
+    const auto & sub = subdomains[s];
+
+    // the halo exchange, the ghost values were already brought up to date
+    // by their owners
+    std::vector<state_t> halo;
+    sub.update_ghosts( [&]( auto cid ) { return state( cid ); }, halo );
+
+    // call g with the state of a cell, either in place or from the halo
+    auto with_state = [&]( auto c, auto && g ) -> flux_data_t
+    {
+      auto i = sub.ghost_index( c.id() );
+      return ( i == mesh::subdomain_t::npos ) ? g( state(c) ) : g( halo[i] );
+    };
 
-    // std::cout << flux[f] << std::endl;
+    for ( auto fid : sub.faces ) {
+      auto f = fs[fid];
+
+      // get the cell neighbors
+      auto cells = mesh.cells(f);
+      auto num_cells = cells.size();
+
+      // compute the face flux
+      flux[f] = with_state( cells[0], [&]( const auto & w_left ) {
+        // interior cell
+        if ( num_cells == 2 )
+          return with_state( cells[1], [&]( const auto & w_right ) {
+            return flux_function<eqns_t>( w_left, w_right, normal[f] );
+          } );
+        // boundary cell
+        return flux_data_t( boundary_flux<eqns_t>( w_left, normal[f] ) );
+      } );
+    
+      // scale the flux by the face area
+      flux[f] *= area[f];
     
-  } // for
+    } // face
+
+  } // sub-domain
   //----------------------------------------------------------------------------
 
   return 0;
@@ -271,11 +429,17 @@ int evaluate_fluxes( T & mesh ) {
 //! \brief The main task to update the solution in each cell.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T >
 solution_error_t
-apply_update( T & mesh, real_t tolerance, bool first_time ) 
+apply_update( 
+  T & mesh, 
+  const mesh::subdomains_t & subdomains, 
+  real_t tolerance, 
+  bool first_time 
+) 
 {
 
   // type aliases
@@ -284,6 +448,7 @@ apply_update( T & mesh, real_t tolerance, bool first_time )
   using vector_t = typename T::vector_t;
   using flux_data_t = flux_data_t<T::num_dimensions>;
   using eqns_t = eqns_t<T::num_dimensions>;
+  using equations_t = typename eqns_t::equations;
 
   // access what we need
   auto flux = flecsi_get_accessor( mesh, hydro, flux, flux_data_t, dense, 0 );
@@ -295,68 +460,89 @@ apply_update( T & mesh, real_t tolerance, bool first_time )
   const auto delta_t = flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 );
   auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
 
-  real_t mass(0);
-  vector_t mom(0);
-  real_t ener(0);
   bool bad_cell(false);
 
   //----------------------------------------------------------------------------
-  // Loop over each cell, scattering the fluxes to the cell
+  // Loop over each owned cell, one sub-domain per thread, scattering the 
+  // fluxes to the cell.  The ghost cells are updated by their owners.
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-  
-  #pragma omp declare reduction( + : vector_t : omp_out += omp_in ) \
-    initializer (omp_priv(omp_orig))
+  counter_t num_subdomains = subdomains.size();
 
-  #pragma omp parallel for reduction( + : mass, mom, ener ) \
-    reduction( || : bad_cell )
-  for ( counter_t i=0; i<num_cells; i++ ) {
+  #pragma omp parallel for schedule(static) reduction( || : bad_cell )
+  for ( counter_t s=0; s<num_subdomains; s++ ) {
+
+    for ( auto cid : subdomains[s].cells ) {
     
-    auto c = cs[i];
-    flux_data_t delta_u( 0 );
+      auto c = cs[cid];
+      flux_data_t delta_u( 0 );
 
-    // loop over each connected edge
-    for ( auto f : mesh.faces(c) ) {
+      // loop over each connected edge
+      for ( auto f : mesh.faces(c) ) {
       
-      // get the cell neighbors
-      auto neigh = mesh.cells(f);
-      auto num_neigh = neigh.size();
-
-      // add the contribution to this cell only
-      if ( neigh[0] == c )
-        delta_u -= flux[f];
-      else
-        delta_u += flux[f];
-
-    } // edge
-
-    // now compute the final update
-    delta_u *= static_cast<real_t>(delta_t)/volume[c];
-
-    // apply the update
-    auto u = state( c );
-    eqns_t::update_state_from_flux( u, delta_u );
-
-    // post update sums
-    auto vel = eqns_t::velocity(u);
-    auto ie = eqns_t::internal_energy(u);
-    auto rho  = eqns_t::density(u);
-    auto m = rho*volume[c];
-    mass += m;
-    ener += m * ie;
-    for ( int d=0; d<T::num_dimensions; ++d ) {
-      auto tmp = m * vel[d];
-      mom[d] += tmp;
-      ener += 0.5 * tmp * vel[d];
-    }
+        // get the cell neighbors
+        auto neigh = mesh.cells(f);
+        auto num_neigh = neigh.size();
+
+        // add the contribution to this cell only
+        if ( neigh[0] == c )
+          delta_u -= flux[f];
+        else
+          delta_u += flux[f];
+
+      } // edge
+
+      // now compute the final update
+      delta_u *= static_cast<real_t>(delta_t)/volume[c];
 
-    // check the solution quantities
-    if ( ie < 0 || rho < 0 ) 
-      bad_cell = true;
+      // apply the update
+      auto u = state( c );
+      eqns_t::update_state_from_flux( u, delta_u );
 
-  } // for
+      // check the solution quantities
+      auto ie = eqns_t::internal_energy(u);
+      auto rho  = eqns_t::density(u);
+      if ( ie < 0 || rho < 0 ) 
+        bad_cell = true;
+
+    } // cell
+
+  } // sub-domain
   //----------------------------------------------------------------------------
+
+  // The conserved totals are summed in fixed blocks of cells, so they do not
+  // depend on the number of threads or sub-domains, and the energy check 
+  // below does not trigger spurious retries.
+  auto sums = utils::reproducible_sum(
+    mesh.num_owned_cells(), flux_data_t(0),
+    [&]( counter_t i, flux_data_t & sum ) {
+      auto c = cs[i];
+      auto u = state( c );
+      auto vel = eqns_t::velocity(u);
+      auto ie = eqns_t::internal_energy(u);
+      auto rho  = eqns_t::density(u);
+      auto m = rho*volume[c];
+      sum[ equations_t::index::mass ] += m;
+      sum[ equations_t::index::energy ] += m * ie;
+      for ( int d=0; d<T::num_dimensions; ++d ) {
+        auto tmp = m * vel[d];
+        sum[ equations_t::index::momentum + d ] += tmp;
+        sum[ equations_t::index::energy ] += 0.5 * tmp * vel[d];
+      }
+    }
+  );
+
+  auto mass = sums[ equations_t::index::mass ];
+  auto ener = sums[ equations_t::index::energy ];
+  vector_t mom;
+  for ( int d=0; d<T::num_dimensions; ++d )
+    mom[d] = sums[ equations_t::index::momentum + d ];
+
+  // sum over all the ranks
+  mass = utils::global_sum( mass );
+  ener = utils::global_sum( ener );
+  utils::global_sum( mom.data(), mom.size() );
+  bad_cell = utils::global_or( bad_cell );
   
   // return unphysical if something went wrong
   if (bad_cell) {
@@ -407,13 +593,13 @@ apply_update( T & mesh, real_t tolerance, bool first_time )
 //! \brief The main task to save the coordinates
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T >
-int save_solution( T & mesh ) {
+int save_solution( T & mesh, const mesh::subdomains_t & subdomains ) {
 
   // type aliases
-  using counter_t = typename T::counter_t;
   using real_t = typename T::real_t;
   using vector_t = typename T::vector_t;
 
@@ -428,16 +614,11 @@ int save_solution( T & mesh ) {
   auto ener0 = flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 1 );
 
   // Loop over cells
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; i++ ) {
-    auto c = cs[i];
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
     rho0[c] = rho[c];
     vel0[c] = vel[c];
     ener0[c] = ener[c];
-  }
+  } );
 
   return 0;
 
@@ -448,13 +629,13 @@ int save_solution( T & mesh ) {
 //! \brief The main task to restore the coordinates
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] subdomains  The sub-domains of the mesh.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T >
-int restore_solution( T & mesh ) {
+int restore_solution( T & mesh, const mesh::subdomains_t & subdomains ) {
 
   // type aliases
-  using counter_t = typename T::counter_t;
   using real_t = typename T::real_t;
   using vector_t = typename T::vector_t;
 
@@ -469,22 +650,318 @@ int restore_solution( T & mesh ) {
   auto ener0 = flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 1 );
 
   // Loop over cells
+  for_each_cell( mesh, subdomains, false, [&]( auto c ) {
+    rho[c] = rho0[c];
+    vel[c] = vel0[c];
+    ener[c] = ener0[c];
+  } );
+
+  return 0;
+
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Flag the cells for adaptive refinement.
+//!
+//! The indicator is the largest relative jump in density or pressure across
+//! the faces of a cell.  Cells above \e refine_tol are refined, and cells
+//! below \e coarsen_tol may be coarsened.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] refine_tol  the jump above which a cell is refined
+//! \param [in] coarsen_tol  the jump below which a cell is coarsened
+//! \param [out] flags  the flag of each cell
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int evaluate_refinement_flags( 
+  T & mesh, 
+  real_t refine_tol, 
+  real_t coarsen_tol,
+  std::vector< flecsale::mesh::amr_flag_t > & flags
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using flecsale::mesh::amr_flag_t;
+
+  // access what we need
+  auto d = flecsi_get_accessor( mesh, hydro, density,  real_t, dense, 0 );
+  auto p = flecsi_get_accessor( mesh, hydro, pressure, real_t, dense, 0 );
+
+  // the relative jump between two values
+  auto jump = []( real_t a, real_t b ) 
+  {
+    auto sum = std::abs(a) + std::abs(b);
+    return ( sum > 0 ) ? std::abs(a - b) / sum : 0;
+  };
+
   auto cs = mesh.cells();
   auto num_cells = cs.size();
+  flags.resize( num_cells );
 
   #pragma omp parallel for
   for ( counter_t i=0; i<num_cells; i++ ) {
     auto c = cs[i];
-    rho[c] = rho0[c];
-    vel[c] = vel0[c];
-    ener[c] = ener0[c];
+    real_t err = 0;
+    for ( auto f : mesh.faces(c) ) {
+      for ( auto n : mesh.cells(f) ) {
+        if ( n == c ) continue;
+        err = std::max( err, jump( d[c], d[n] ) );
+        err = std::max( err, jump( p[c], p[n] ) );
+      }
+    }
+    if ( err > refine_tol ) 
+      flags[i] = amr_flag_t::refine;
+    else if ( err < coarsen_tol )
+      flags[i] = amr_flag_t::coarsen;
+    else
+      flags[i] = amr_flag_t::keep;
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Transfer the solution to an adapted mesh.
+//!
+//! Mass, momentum and total energy are volume averaged, so they are
+//! conserved.  Split cells get the state of their parent, and merged cells
+//! get the mass weighted velocity and energy of their children.  Only the
+//! density, velocity and internal energy are set, the rest of the state has
+//! to be updated from the energy afterwards.
+//!
+//! \param [in] old_mesh  the mesh the solution lives on
+//! \param [in,out] new_mesh  the adapted mesh
+//! \param [in] transfer  the map from the new cells to the old ones
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int transfer_solution( 
+  const T & old_mesh, 
+  T & new_mesh, 
+  const flecsale::mesh::amr_transfer_t & transfer 
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+
+  // access what we need
+  auto d0 = flecsi_get_accessor( old_mesh, hydro, density, real_t, dense, 0 );
+  auto v0 = flecsi_get_accessor( old_mesh, hydro, velocity, vector_t, dense, 0 );
+  auto e0 = flecsi_get_accessor( old_mesh, hydro, internal_energy, real_t, dense, 0 );
+  auto ener0 = flecsi_get_accessor( old_mesh, hydro, sum_total_energy, real_t, global, 0 );
+
+  auto d = flecsi_get_accessor( new_mesh, hydro, density, real_t, dense, 0 );
+  auto v = flecsi_get_accessor( new_mesh, hydro, velocity, vector_t, dense, 0 );
+  auto e = flecsi_get_accessor( new_mesh, hydro, internal_energy, real_t, dense, 0 );
+  auto ener = flecsi_get_accessor( new_mesh, hydro, sum_total_energy, real_t, global, 0 );
+
+  auto num_cells = static_cast<counter_t>( transfer.num_cells() );
+  
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; i++ ) {
+    // average the conserved quantities
+    real_t mass = 0, et = 0;
+    vector_t mom(0);
+    for ( auto j=transfer.offsets[i]; j<transfer.offsets[i+1]; ++j ) {
+      auto src = transfer.sources[j];
+      auto m = transfer.weights[j] * d0[src];
+      mass += m;
+      mom += m * v0[src];
+      et += m * ( e0[src] + 0.5 * dot_product( v0[src], v0[src] ) );
+    }
+    // and convert them back to the primitive ones
+    d[i] = mass;
+    v[i] = mom / mass;
+    e[i] = et / mass - 0.5 * dot_product( v[i], v[i] );
   }
 
+  // the total energy does not change
+  *ener = *ener0;
+
   return 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Add the requested fields to a probe recorder.
+//!
+//! The accessors are fetched every time the probes are sampled, so they stay
+//! valid if the data is registered again, for example after the mesh adapts.
+//!
+//! \param [in] mesh  the mesh object
+//! \param [in,out] probes  the probe recorder
+//! \param [in] names  the names of the fields to record
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename R >
+int add_probe_fields( 
+  T & mesh, 
+  R & probes, 
+  const std::vector<std::string> & names 
+) {
+
+  // type aliases
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using storage_real_t = typename T::storage_real_t;
+  using probe_real_t = typename R::real_t;
+  using cell_list_t = std::vector<std::size_t>;
+  constexpr auto num_dims = T::num_dimensions;
+
+  // copy the probe cell values out of an accessor
+  auto add_scalar = [&]( const std::string & name, auto get ) {
+    probes.add_field( name, 1, 
+      [&mesh, get]( const cell_list_t & cells, probe_real_t * vals ) {
+        auto a = get();
+        auto cs = mesh.cells();
+        for ( std::size_t i=0; i<cells.size(); ++i )
+          vals[i] = a[ cs[cells[i]] ];
+      } 
+    );
+  };
+
+  auto add_vector = [&]( const std::string & name, auto get ) {
+    probes.add_field( name, num_dims, 
+      [&mesh, get, num_dims]( const cell_list_t & cells, probe_real_t * vals ) {
+        auto a = get();
+        auto cs = mesh.cells();
+        for ( std::size_t i=0; i<cells.size(); ++i )
+          for ( std::size_t d=0; d<num_dims; ++d )
+            vals[ i*num_dims + d ] = a[ cs[cells[i]] ][d];
+      } 
+    );
+  };
+
+  for ( const auto & name : names ) {
+    if ( name == "density" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, density, real_t, dense, 0 ); 
+      } );
+    else if ( name == "pressure" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, pressure, real_t, dense, 0 ); 
+      } );
+    else if ( name == "velocity" )
+      add_vector( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, velocity, vector_t, dense, 0 ); 
+      } );
+    else if ( name == "internal_energy" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 0 ); 
+      } );
+    else if ( name == "temperature" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, temperature, storage_real_t, dense, 0 ); 
+      } );
+    else if ( name == "sound_speed" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, sound_speed, storage_real_t, dense, 0 ); 
+      } );
+    else
+      raise_runtime_error( "Unknown probe field \"" << name << "\"" );
+  }
 
+  return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Register the fields needed by the in-situ extracts.
+//!
+//! The scalar fields are used as is.  A vector field gives its magnitude,
+//! and its components are named with a suffix, as in "velocity_0".
+//!
+//! \param [in] mesh  the mesh object
+//! \param [in,out] extracts  the extract writer
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename W >
+int add_extract_fields( T & mesh, W & extracts ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using storage_real_t = typename T::storage_real_t;
+  using values_t = std::vector<typename W::real_t>;
+  constexpr auto num_dims = T::num_dimensions;
+
+  // copy the cell values out of an accessor
+  auto add_scalar = [&]( const std::string & name, auto get ) {
+    extracts.add_field( name, [&mesh, get]( values_t & vals ) {
+      auto a = get();
+      auto cs = mesh.cells();
+      counter_t num_cells = cs.size();
+      vals.resize( num_cells );
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_cells; ++i )
+        vals[i] = a[ cs[i] ];
+    } );
+  };
+
+  // either one component, or the magnitude when the component is num_dims
+  auto add_vector = [&]( const std::string & name, auto get, std::size_t k ) {
+    extracts.add_field( name, [&mesh, get, k, num_dims]( values_t & vals ) {
+      auto a = get();
+      auto cs = mesh.cells();
+      counter_t num_cells = cs.size();
+      vals.resize( num_cells );
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_cells; ++i ) {
+        const auto & v = a[ cs[i] ];
+        vals[i] = ( k < num_dims ) ? v[k] : magnitude( v );
+      }
+    } );
+  };
+
+  // check if a name refers to a vector field, and which component
+  auto component = [&]( const std::string & name, const std::string & base )
+    -> std::size_t
+  {
+    if ( name == base ) return num_dims;
+    for ( std::size_t k=0; k<num_dims; ++k )
+      if ( name == base + "_" + std::to_string(k) ) return k;
+    return num_dims + 1;
+  };
+
+  for ( const auto & name : extracts.field_names() ) {
+    if ( name == "density" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, density, real_t, dense, 0 ); 
+      } );
+    else if ( name == "pressure" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, pressure, real_t, dense, 0 ); 
+      } );
+    else if ( name == "internal_energy" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 0 ); 
+      } );
+    else if ( name == "temperature" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, temperature, storage_real_t, dense, 0 ); 
+      } );
+    else if ( name == "sound_speed" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, sound_speed, storage_real_t, dense, 0 ); 
+      } );
+    else if ( component( name, "velocity" ) <= num_dims )
+      add_vector( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, velocity, vector_t, dense, 0 ); 
+      }, component( name, "velocity" ) );
+    else
+      raise_runtime_error( "Unknown extract field \"" << name << "\"" );
+  }
 
+  return 0;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief Output the solution.
@@ -507,9 +984,10 @@ int output( T & mesh,
   std::stringstream ss;
   ss << prefix;
   ss << std::setw( 7 ) << std::setfill( '0' ) << cnt++;
-  ss << "."+postfix;
   
-  mesh::write_mesh( ss.str(), mesh );
+  // each rank writes its own piece, which are tied together by an index
+  mesh::write_mesh( mesh::rank_file_name( ss.str(), postfix ), mesh );
+  mesh::write_index( ss.str(), postfix );
   
   return 0;
 }
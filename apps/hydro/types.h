@@ -18,6 +18,8 @@
 
 #include <flecsale/mesh/burton/burton.h>
 
+// system includes
+#include <tuple>
 
 namespace apps {
 namespace hydro {
@@ -105,8 +107,15 @@ public:
 
   //! typedefs
   using real_t = typename M::real_t;
+  using storage_real_t = typename M::storage_real_t;
   using vector_t = typename M::vector_t;
 
+  //! \brief a copy of the state of one element, in the same order as the
+  //!        references returned by the accessor
+  using value_t = std::tuple< 
+    real_t, vector_t, real_t, real_t, storage_real_t, storage_real_t 
+  >;
+
   //! \brief determine the type of accessor
   //! \tparam T the data type we are accessing
   template< typename T >
@@ -120,8 +129,8 @@ public:
     p( flecsi_get_accessor( mesh, hydro, pressure, real_t, dense, 0 ) ),
     v( flecsi_get_accessor( mesh, hydro, velocity, vector_t, dense, 0 ) ),
     e( flecsi_get_accessor( mesh, hydro, internal_energy, real_t, dense, 0 ) ),
-    t( flecsi_get_accessor( mesh, hydro, temperature, real_t, dense, 0 ) ),
-    a( flecsi_get_accessor( mesh, hydro, sound_speed, real_t, dense, 0 ) )
+    t( flecsi_get_accessor( mesh, hydro, temperature, storage_real_t, dense, 0 ) ),
+    a( flecsi_get_accessor( mesh, hydro, sound_speed, storage_real_t, dense, 0 ) )
   {}
 
   //! \brief main accessor
@@ -167,8 +176,8 @@ private:
   accessor_t<real_t>   p;
   accessor_t<vector_t> v;
   accessor_t<real_t>   e;
-  accessor_t<real_t>   t;
-  accessor_t<real_t>   a;
+  accessor_t<storage_real_t> t;
+  accessor_t<storage_real_t> a;
        
 };
 
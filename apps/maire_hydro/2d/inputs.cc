@@ -69,6 +69,34 @@ template<> string base_t::postfix = "dat";
 // output frequency
 template<> size_t base_t::output_freq = 20;
 
+// no extra output groups
+template<> inputs_t::output_group_list_t base_t::output_groups = {};
+
+// the point probes, off by default
+template<> size_t base_t::probe_frequency = 0;
+template<> string base_t::probe_format = "csv";
+template<> bool base_t::probe_follow_flow = false;
+template<> std::vector<string> base_t::probe_fields = 
+  { "cell_density", "cell_pressure", "cell_velocity" };
+template<> std::vector< inputs_t::array_t<real_t> > base_t::probe_points = {};
+
+// no in-situ extracts by default
+template<> std::vector< inputs_t::extract_spec_t > base_t::extracts = {};
+
+// no checkpoints by default
+template<> size_t base_t::checkpoint_frequency = 0;
+
+// purely lagrangian by default
+template<> size_t base_t::ale_frequency = 0;
+template<> real_t base_t::ale_quality_tolerance = 0;
+template<> size_t base_t::ale_sweeps = 10;
+template<> real_t base_t::ale_relaxation = 1;
+
+// no python callback by default
+template<> size_t base_t::python_frequency = 0;
+template<> string base_t::python_script = "";
+template<> string base_t::python_callback = "process";
+
 // the CFL and final solution time
 template<> time_constants_t base_t::CFL = 
 { .accoustic = 0.25, .volume = 0.1, .growth = 1.01 };
@@ -83,6 +111,13 @@ template<> std::shared_ptr<eos_t> base_t::eos =
     /* gamma */ 1.4, /* cv */ 1.0 
   ); 
 
+// no per-region equations of state, the one above is used everywhere
+template<> std::vector< std::shared_ptr<eos_t> > base_t::region_eos = {};
+
+// the regions of the mesh are kept
+template<>
+inputs_t::region_function_t base_t::regions = nullptr;
+
 // this is a lambda function to set the initial conditions
 template<>
 inputs_t::ics_function_t base_t::ics = 
@@ -109,6 +144,11 @@ inputs_t::mesh_function_t base_t::make_mesh =
     );
   };
 
+// only the lua box meshes know how to build a single rank's piece, this one
+// is built whole and then distributed
+template<>
+inputs_t::local_mesh_function_t base_t::make_local_mesh = nullptr;
+
 // install each boundary
 //
 // - both +ve and -ve side boundaries can be installed at once since 
@@ -38,7 +38,34 @@ hydro = {
     xmax = length
   },
 
-  -- the equation of state
+  -- uncomment to record the solution at a few points every step, the
+  -- format is "csv" or "binary" and probes can follow the mesh motion
+  -- probes = {
+  --   frequency = 1,
+  --   points = { {0.3, 0.0}, {0.3, 0.3} },
+  --   fields = { "cell_density", "cell_pressure", "cell_velocity" },
+  --   format = "csv",
+  --   follow_flow = true
+  -- },
+
+  -- uncomment to write small in-situ extracts, each at its own frequency
+  -- extracts = {
+  --   { type = "lineout", frequency = 5, fields = {"cell_density"},
+  --     from = {0, 0}, to = {1.2, 1.2}, points = 200 },
+  --   { type = "regions", frequency = 1, fields = {"cell_pressure"} }
+  -- },
+
+  -- uncomment to smooth the mesh and remap the solution every so many
+  -- steps, or whenever the worst cell quality drops below a fraction of its
+  -- value after the last rezone
+  -- ale = {
+  --   frequency = 10,
+  --   quality_tolerance = 0.3,
+  --   sweeps = 10,
+  --   relaxation = 1.0
+  -- },
+
+  -- the equation of state, or a list of them with one per mesh region
   eos = {
     type = "ideal_gas",
     gas_constant = 1.4,
@@ -24,7 +24,7 @@ hydro = {
     xmax = length
   },
 
-  -- the equation of state
+  -- the equation of state, or a list of them with one per mesh region
   eos = {
     type = "ideal_gas",
     gas_constant = 1.4,
@@ -38,12 +38,13 @@ int initial_conditions_task(
 //! Updates the state from density and pressure and computes the new energy.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int update_state_from_pressure_task( 
-  const mesh_3d_t & mesh, const eos_t * eos
+  const mesh_3d_t & mesh, const std::vector<const eos_t *> & region_eos
 ) {
-	return update_state_from_pressure( mesh, eos );
+	return update_state_from_pressure( mesh, region_eos );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,12 +53,13 @@ int update_state_from_pressure_task(
 //! Updates the state from density and energy and computes the new pressure.
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 int update_state_from_energy_task( 
-  mesh_3d_t & mesh, const eos_t * eos
+  mesh_3d_t & mesh, const std::vector<const eos_t *> & region_eos
 ) {
-	return update_state_from_energy( mesh, eos );
+	return update_state_from_energy( mesh, region_eos );
 }
 
 
@@ -176,6 +178,31 @@ int restore_solution_task( mesh_3d_t & mesh )
   return restore_solution( mesh );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to store the conserved quantities for a remap.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in,out] source  the mesh holding the remap fields
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+int save_remap_fields_task( mesh_3d_t & mesh, mesh_3d_t & source ) 
+{
+  return save_remap_fields( mesh, source );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to recover the solution after a remap.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+int restore_remap_fields_task( 
+  mesh_3d_t & mesh, const std::vector<const eos_t *> & region_eos
+) {
+  return restore_remap_fields( mesh, region_eos );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // TASK REGISTRATION
 ////////////////////////////////////////////////////////////////////////////////
@@ -193,6 +220,8 @@ flecsi_register_task(save_coordinates_task, loc, single);
 flecsi_register_task(restore_coordinates_task, loc, single);
 flecsi_register_task(save_solution_task, loc, single);
 flecsi_register_task(restore_solution_task, loc, single);
+flecsi_register_task(save_remap_fields_task, loc, single);
+flecsi_register_task(restore_remap_fields_task, loc, single);
 
 } // namespace
 } // namespace
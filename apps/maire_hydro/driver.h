@@ -10,17 +10,37 @@
 // hydro incdludes
 #include "types.h"
 #include "../common/exceptions.h"
+#include "../common/output_groups.h"
 #include "../common/parse_arguments.h"
+#include "../common/run_control.h"
+#include "../common/timings.h"
 
 // user includes
 #include <flecsale/eos/ideal_gas.h>
+#include <flecsale/mesh/distributed.h>
 #include <flecsale/mesh/mesh_utils.h>
+#include <flecsale/mesh/partition.h>
+#include <flecsale/mesh/rezone.h>
+#include <flecsale/utils/mpi_utils.h>
 #include <flecsale/utils/time_utils.h>
+#include <flecsale/io/checkpoint.h>
+#include <flecsale/io/extracts.h>
+#include <flecsale/io/probes.h>
+
+#ifdef HAVE_PORTAGE
+#  include <flecsale/mesh/portage/portage.h>
+#endif
+
+// Python include should go last cause it conflicts with alot of other 
+// includes.
+#include <flecsale/io/python_bridge.h>
 
 // system includes
 #include <getopt.h>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <utility>
 
@@ -38,6 +58,18 @@ int driver(int argc, char** argv)
   // set exceptions 
   enable_exceptions();
 
+  // make sure mpi is running, and get the layout
+  utils::mpi_session_t mpi_session( argc, argv );
+
+  // the wall time budget is counted from here
+  auto run_start = utils::get_wall_time();
+  auto comm_rank = utils::comm_rank();
+  auto comm_size = utils::comm_size();
+
+  // only the first rank writes to the screen
+  auto cout_buf = std::cout.rdbuf();
+  if ( comm_rank != 0 ) std::cout.rdbuf( nullptr );
+
   //===========================================================================
   // Parse arguments
   //===========================================================================
@@ -46,10 +78,22 @@ int driver(int argc, char** argv)
   auto print_usage = [&argv]() {
     std::cout << "Usage: " << argv[0] 
               << " [--file INPUT_FILE]"
+              << " [--timings CSV_FILE]"
+              << " [--partitions NUM_PARTS]"
+              << " [--restart CHECKPOINT]"
+              << " [--walltime SECONDS|HH:MM:SS]"
               << " [--help]"
               << std::endl << std::endl;
     std::cout << "\t--file INPUT_FILE:\t Override the input file "
               << "with INPUT_FILE." << std::endl;
+    std::cout << "\t--timings CSV_FILE:\t Write the per-task wall times "
+              << "to CSV_FILE." << std::endl;
+    std::cout << "\t--partitions NUM_PARTS:\t Renumber the mesh so that it "
+              << "is split into NUM_PARTS contiguous partitions." << std::endl;
+    std::cout << "\t--restart CHECKPOINT:\t Restart from the CHECKPOINT "
+              << "file, using the same input and number of ranks." << std::endl;
+    std::cout << "\t--walltime SECONDS|HH:MM:SS:\t Write a checkpoint and "
+              << "stop before the wall time budget runs out." << std::endl;
     std::cout << "\t--help:\t Print a help message." << std::endl;
   };
 
@@ -57,10 +101,14 @@ int driver(int argc, char** argv)
   struct option long_options[] =
     {
       {"help",       no_argument, 0, 'h'},
-      {"file", required_argument, 0, 'f'},
+      {"file",    required_argument, 0, 'f'},
+      {"timings", required_argument, 0, 't'},
+      {"partitions", required_argument, 0, 'p'},
+      {"restart", required_argument, 0, 'r'},
+      {"walltime", required_argument, 0, 'w'},
       {0, 0, 0, 0}
     };
-  const char * short_options = "hf:";
+  const char * short_options = "hf:t:p:r:w:";
 
   // parse the arguments
   auto args = parse_arguments(argc, argv, long_options, short_options);
@@ -86,15 +134,78 @@ int driver(int argc, char** argv)
     inputs_t::load( input_file_name );
   }
 
+  // get the timing output file
+  auto timings_file_name = 
+    args.count("t") ? args.at("t") : std::string();
+
+  // the per-task timers
+  task_timings_t timings;
+
+  // get the number of partitions
+  auto num_parts = 
+    args.count("p") ? std::stoul( args.at("p") ) : 0ul;
+
+  // get the checkpoint to restart from
+  auto restart_file_name = 
+    args.count("r") ? args.at("r") : std::string();
+
+  // get the wall time budget
+  auto walltime = 
+    args.count("w") ? parse_walltime( args.at("w") ) : 0.0;
+
+  // a batch system asks a job to stop with a signal
+  install_stop_signal_handlers();
+
   //===========================================================================
   // Mesh Setup
   //===========================================================================
 
   // make the mesh
-  auto mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  typename inputs_t::mesh_t mesh;
+
+  // the ghost exchange pattern
+  mesh::halo_t halo;
 
-  // this is the mesh object
-  mesh.is_valid();
+  if ( comm_size > 1 ) {
+    std::cout << "Distributing the mesh over " << comm_size << " ranks." 
+              << std::endl;
+    // build this rank's piece directly if possible, otherwise build the
+    // whole mesh and split it up
+    mesh::ownership_t owners;
+    auto piece = inputs_t::make_local_mesh ?
+      inputs_t::make_local_mesh( 0.0, comm_rank, comm_size, owners ) :
+      inputs_t::make_mesh( 0.0 );
+    if ( !inputs_t::make_local_mesh ) {
+      auto parts = mesh::partition_cells( piece, comm_size );
+      owners = mesh::global_ownership( piece, parts );
+    }
+    mesh = mesh::distribute( piece, owners, comm_rank, halo );
+  }
+  else {
+    mesh = inputs_t::make_mesh( /* solution time */ 0.0 );
+  }
+
+  // put the cells in their regions, which picks their equations of state
+  inputs_t::assign_regions( mesh );
+
+  // the thread partitions would break up the owned-first ordering
+  if ( num_parts > 1 && comm_size > 1 )
+    raise_runtime_error( "--partitions can only be used with a single rank" );
+
+  // renumber the mesh so that each thread works on a compact partition
+  if ( num_parts > 1 ) {
+    std::cout << "Partitioning the mesh into " << num_parts << " parts." 
+              << std::endl;
+    auto parts = mesh::partition_cells( mesh, num_parts );
+    mesh = mesh::reorder( mesh, parts );
+  }
+
+  // this is the mesh object.  Bad faces are fatal, but the corner and 
+  // wedge audit only warns, since it was never enforced before
+  mesh.is_valid( true, mesh::burton::validation_level_t::cheap );
+  if ( !mesh.corners_are_valid( false ) )
+    std::cerr << "Warning: the mesh failed the corner and wedge checks, "
+              << "continuing anyway" << std::endl;
   
   cout << mesh;
 
@@ -105,6 +216,7 @@ int driver(int argc, char** argv)
   using mesh_t = decltype(mesh);
   using size_t = typename mesh_t::size_t;
   using real_t = typename mesh_t::real_t;
+  using storage_real_t = typename mesh_t::storage_real_t;
   using vector_t = typename mesh_t::vector_t; 
 
   // get machine zero
@@ -137,8 +249,8 @@ int driver(int argc, char** argv)
 
   flecsi_register_data(mesh, hydro, cell_density,         real_t, dense, 2, cells);
   flecsi_register_data(mesh, hydro, cell_internal_energy, real_t, dense, 2, cells);
-  flecsi_register_data(mesh, hydro, cell_temperature,     real_t, dense, 1, cells);
-  flecsi_register_data(mesh, hydro, cell_sound_speed,     real_t, dense, 1, cells);
+  flecsi_register_data(mesh, hydro, cell_temperature,     storage_real_t, dense, 1, cells);
+  flecsi_register_data(mesh, hydro, cell_sound_speed,     storage_real_t, dense, 1, cells);
 
   // node state
   flecsi_register_data(mesh, hydro, node_coordinates, vector_t, dense, 1, vertices);
@@ -149,6 +261,23 @@ int driver(int argc, char** argv)
 
   flecsi_register_data(mesh, hydro, corner_normal, vector_t, dense, 1, corners);
   flecsi_register_data(mesh, hydro, corner_force, vector_t, dense, 1, corners);
+
+  // the conserved quantities per unit volume, which are remapped when the
+  // mesh is rezoned
+  auto register_remap_fields = []( mesh_t & m )
+  {
+    flecsi_register_data(m, hydro, remap_density,         real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, remap_momentum_x,      real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, remap_momentum_y,      real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, remap_momentum_z,      real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, remap_total_energy,    real_t, dense, 1, cells);
+    flecsi_register_data(m, hydro, remap_internal_energy, real_t, dense, 1, cells);
+  };
+
+  // the mesh is only rezoned if asked to
+  auto use_ale = 
+    inputs_t::ale_frequency > 0 || inputs_t::ale_quality_tolerance > 0;
+  if ( use_ale ) register_remap_fields( mesh );
   
   // register the time step and set a cfl
   flecsi_register_data( mesh, hydro, time_step, real_t, global, 1 );
@@ -160,6 +289,41 @@ int driver(int argc, char** argv)
   // Register the total energy
   flecsi_register_data( mesh, hydro, sum_total_energy, real_t, global, 1 );
 
+  // the ghost values are received from the ranks that own them
+  mesh::halo_exchange_t cell_exchange( halo.cells );
+  mesh::halo_exchange_t vertex_exchange( halo.vertices );
+
+  auto exchange_cell_state = [&]()
+  {
+    timings.measure( "halo_exchange", [&]() {
+      cell_exchange.exchange(
+        flecsi_get_accessor(mesh, hydro,          cell_volume,   real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,            cell_mass,   real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,        cell_pressure,   real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,        cell_velocity, vector_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,         cell_density,   real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro, cell_internal_energy,   real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,     cell_temperature,   storage_real_t, dense, 0),
+        flecsi_get_accessor(mesh, hydro,     cell_sound_speed,   storage_real_t, dense, 0)
+      );
+    } );
+  };
+
+  // the nodal velocities of the shared vertices are computed by every rank,
+  // only the outer ghost vertices really need the owner's values, and only
+  // once the mesh is moved
+  auto start_vertex_exchange = [&]()
+  {
+    vertex_exchange.start(
+      flecsi_get_accessor(mesh, hydro, node_velocity, vector_t, dense, 0)
+    );
+  };
+
+  auto finish_vertex_exchange = [&]()
+  {
+    timings.measure( "halo_exchange", [&]() { vertex_exchange.finish(); } );
+  };
+
   // set the persistent variables, i.e. the ones that will be plotted
   flecsi_get_accessor(mesh, hydro, cell_mass,       real_t, dense, 0).attributes().set(persistent);
   flecsi_get_accessor(mesh, hydro, cell_pressure,   real_t, dense, 0).attributes().set(persistent);
@@ -167,8 +331,8 @@ int driver(int argc, char** argv)
 
   flecsi_get_accessor(mesh, hydro, cell_density,         real_t, dense, 0).attributes().set(persistent);
   flecsi_get_accessor(mesh, hydro, cell_internal_energy, real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro, cell_temperature,     real_t, dense, 0).attributes().set(persistent);
-  flecsi_get_accessor(mesh, hydro, cell_sound_speed,     real_t, dense, 0).attributes().set(persistent);
+  flecsi_get_accessor(mesh, hydro, cell_temperature,     storage_real_t, dense, 0).attributes().set(persistent);
+  flecsi_get_accessor(mesh, hydro, cell_sound_speed,     storage_real_t, dense, 0).attributes().set(persistent);
 
   flecsi_get_accessor(mesh, hydro, node_velocity, vector_t, dense, 0).attributes().set(persistent);
 
@@ -203,19 +367,107 @@ int driver(int argc, char** argv)
   }
 
 
+  // the equation of state of each region
+  auto region_eos = inputs_t::eos_by_region( mesh.num_regions() );
+
+  //===========================================================================
+  // Checkpoints
+  //===========================================================================
+
+  // apply a function to every version of every field in the solver state
+  auto for_each_state_field = [&]( auto && f )
+  {
+    auto cs = mesh.cells();
+    auto vs = mesh.vertices();
+#ifdef USE_IMPLICIT_DUAL
+    auto cns = mesh.dual().corners();
+#else
+    auto cns = mesh.corners();
+#endif
+    f( "cell_volume.0", cs, flecsi_get_accessor(mesh, hydro, cell_volume, real_t, dense, 0) );
+    f( "cell_mass.0", cs, flecsi_get_accessor(mesh, hydro, cell_mass, real_t, dense, 0) );
+    f( "cell_pressure.0", cs, flecsi_get_accessor(mesh, hydro, cell_pressure, real_t, dense, 0) );
+    f( "cell_velocity.0", cs, flecsi_get_accessor(mesh, hydro, cell_velocity, vector_t, dense, 0) );
+    f( "cell_velocity.1", cs, flecsi_get_accessor(mesh, hydro, cell_velocity, vector_t, dense, 1) );
+    f( "cell_density.0", cs, flecsi_get_accessor(mesh, hydro, cell_density, real_t, dense, 0) );
+    f( "cell_density.1", cs, flecsi_get_accessor(mesh, hydro, cell_density, real_t, dense, 1) );
+    f( "cell_internal_energy.0", cs, flecsi_get_accessor(mesh, hydro, cell_internal_energy, real_t, dense, 0) );
+    f( "cell_internal_energy.1", cs, flecsi_get_accessor(mesh, hydro, cell_internal_energy, real_t, dense, 1) );
+    f( "cell_temperature.0", cs, flecsi_get_accessor(mesh, hydro, cell_temperature, storage_real_t, dense, 0) );
+    f( "cell_sound_speed.0", cs, flecsi_get_accessor(mesh, hydro, cell_sound_speed, storage_real_t, dense, 0) );
+    f( "cell_residual.0", cs, flecsi_get_accessor(mesh, hydro, cell_residual, flux_data_t, dense, 0) );
+    f( "node_coordinates.0", vs, flecsi_get_accessor(mesh, hydro, node_coordinates, vector_t, dense, 0) );
+    f( "node_velocity.0", vs, flecsi_get_accessor(mesh, hydro, node_velocity, vector_t, dense, 0) );
+    f( "corner_normal.0", cns, flecsi_get_accessor(mesh, hydro, corner_normal, vector_t, dense, 0) );
+    f( "corner_force.0", cns, flecsi_get_accessor(mesh, hydro, corner_force, vector_t, dense, 0) );
+  };
+
+  // the checkpoints are copied and then written in the background
+  flecsale::io::checkpoint_writer_t checkpoint_writer;
+
+  auto write_checkpoint = [&]()
+  {
+    std::stringstream ss;
+    ss << inputs_t::prefix << "-chk";
+    ss << std::setw( 7 ) << std::setfill( '0' ) << mesh.time_step_counter();
+    auto & w = checkpoint_writer;
+    // the moved vertex coordinates are part of the mesh state
+    flecsale::io::add_mesh_state( mesh, w );
+    for_each_state_field( 
+      [&]( const auto & name, const auto & ents, const auto & field ) {
+        w.add_field( name, ents, field );
+      }
+    );
+    w.add_value( "time_step", 
+      *flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 ) );
+    w.add_value( "cfl", 
+      *flecsi_get_accessor( mesh, hydro, cfl, time_constants_t, global, 0 ) );
+    w.add_value( "sum_total_energy", 
+      *flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 ) );
+    w.commit( flecsale::io::checkpoint_file_name( ss.str() ) );
+    std::cout << "Writing checkpoint \"" << ss.str() << "\"." << std::endl;
+  };
+
+  auto read_checkpoint = [&]( const std::string & file_name )
+  {
+    flecsale::io::checkpoint_reader_t r( 
+      flecsale::io::checkpoint_file_name( file_name ) 
+    );
+    flecsale::io::restore_mesh_state( r, mesh );
+    for_each_state_field( 
+      [&]( const auto & name, const auto & ents, auto field ) {
+        r.read_field( name, ents, field );
+      }
+    );
+    *flecsi_get_accessor( mesh, hydro, time_step, real_t, global, 0 ) = 
+      r.read_value<real_t>( "time_step" );
+    *flecsi_get_accessor( mesh, hydro, cfl, time_constants_t, global, 0 ) = 
+      r.read_value<time_constants_t>( "cfl" );
+    *flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 ) = 
+      r.read_value<real_t>( "sum_total_energy" );
+  };
+
   //===========================================================================
   // Initial conditions
   //===========================================================================
   
-  // now call the main task to set the ics.  Here we set primitive/physical 
-  // quanties
-  flecsi_execute_task( initial_conditions_task, loc, single, mesh, inputs_t::ics );
-  
-
-  // Update the EOS
-  flecsi_execute_task( 
-    update_state_from_pressure_task, loc, single, mesh, inputs_t::eos.get()
-  );
+  if ( !restart_file_name.empty() ) {
+    std::cout << "Restarting from \"" << restart_file_name << "\"." 
+              << std::endl;
+    timings.measure( "restart", [&]() { read_checkpoint( restart_file_name ); } );
+    soln_time = mesh.time();
+    time_cnt = mesh.time_step_counter();
+  }
+  else {
+    // now call the main task to set the ics.  Here we set primitive/physical 
+    // quanties
+    timed_execute_task( timings, initial_conditions_task, loc, single, mesh, inputs_t::ics );
+
+    // Update the EOS
+    timed_execute_task( 
+      timings, update_state_from_pressure_task, loc, single, mesh, region_eos
+    );
+  }
 
 
   //===========================================================================
@@ -225,8 +477,152 @@ int driver(int argc, char** argv)
   // now output the solution
   if ( inputs_t::output_freq > 0 )
     output(mesh, inputs_t::prefix, inputs_t::postfix, 1);
+
+  // and the output groups, each on its own schedule
+  auto output_groups = inputs_t::output_groups;
+  for ( auto & group : output_groups )
+    write_output_group( mesh, inputs_t::prefix, group );
   
 
+  // set up the point probes, each rank records the ones in its cells
+  using probes_t = flecsale::io::probe_recorder_t<mesh_t>;
+  std::unique_ptr<probes_t> probes;
+  if ( inputs_t::probe_frequency > 0 ) {
+    auto format = 
+      flecsale::io::probe_format_from_string( inputs_t::probe_format );
+    auto ext = ( format == flecsale::io::probe_format_t::csv ) ? "csv" : "bin";
+    probes = std::make_unique<probes_t>( 
+      mesh, inputs_t::probe_points, inputs_t::probe_follow_flow 
+    );
+    add_probe_fields( mesh, *probes, inputs_t::probe_fields );
+    probes->open( 
+      mesh::rank_file_name( inputs_t::prefix + "-probes", ext ), format 
+    );
+    probes->sample( mesh.time(), mesh.time_step_counter() );
+  }
+
+  // set up the in-situ extracts
+  using extracts_t = flecsale::io::extract_writer_t<mesh_t>;
+  std::unique_ptr<extracts_t> extracts;
+  if ( !inputs_t::extracts.empty() ) {
+    extracts = std::make_unique<extracts_t>( 
+      mesh, inputs_t::prefix, inputs_t::extracts 
+    );
+    add_extract_fields( mesh, *extracts );
+    extracts->process( mesh.time(), mesh.time_step_counter() );
+  }
+
+  // set up the python callback, which sees the fields without copies
+#ifdef HAVE_PYTHON
+  using python_t = flecsale::io::python_bridge_t<mesh_t>;
+  std::unique_ptr<python_t> python;
+  if ( inputs_t::python_frequency > 0 ) {
+    python = std::make_unique<python_t>( 
+      mesh, inputs_t::python_script, inputs_t::python_callback 
+    );
+    python->process( mesh.time(), mesh.time_step_counter() );
+  }
+#else
+  if ( inputs_t::python_frequency > 0 )
+    raise_runtime_error( "The python callback needs python support" );
+#endif
+
+  //===========================================================================
+  // Rezone and remap
+  //===========================================================================
+
+  // the vertex neighbors used for smoothing, and the quality to compare to
+  mesh::vertex_graph_t vertex_graph;
+  // the worst cell quality at the start, and right after the last rezone
+  real_t initial_quality = 0;
+  real_t rezone_quality = 0;
+
+  if ( use_ale ) {
+    // the relaxation and the remap only see the local piece of the mesh
+    if ( comm_size > 1 )
+      raise_runtime_error( "Rezoning the mesh can only be used with a single rank" );
+#ifndef HAVE_PORTAGE
+    raise_runtime_error( "Rezoning the mesh needs portage for the remap" );
+#endif
+    vertex_graph = mesh::vertex_graph( mesh );
+    initial_quality = mesh::min_cell_quality( mesh );
+    rezone_quality = initial_quality;
+  }
+
+  // rezone every few steps, or once the cells are squashed too much.  The
+  // quality is measured against what it was after the last rezone, so a 
+  // mesh that smoothing cannot fix is not rezoned again every step.
+  auto rezone_due = [&]()
+  {
+    if ( !use_ale ) return false;
+    if ( inputs_t::ale_frequency > 0 && time_cnt % inputs_t::ale_frequency == 0 )
+      return true;
+    return inputs_t::ale_quality_tolerance > 0 &&
+      mesh::min_cell_quality( mesh ) < 
+        inputs_t::ale_quality_tolerance * rezone_quality;
+  };
+
+  // relax the vertices and conservatively remap the solution onto the new
+  // mesh.  The node velocities are recomputed at the start of the next step.
+  auto rezone_and_remap = [&]()
+  {
+#ifdef HAVE_PORTAGE
+    // a copy of the lagrangian mesh is the source of the remap, a single
+    // partition keeps the cells in the same order
+    auto source = 
+      mesh::reorder( mesh, std::vector<std::size_t>( mesh.num_cells(), 0 ) );
+    register_remap_fields( source );
+    timed_execute_task( 
+      timings, save_remap_fields_task, loc, single, mesh, source 
+    );
+
+    // smooth the vertices, backing off if any cell gets turned inside out
+    timed_execute_task( timings, save_coordinates_task, loc, single, mesh );
+    auto relaxation = inputs_t::ale_relaxation;
+    for ( int tries = 0; ; ++tries ) {
+      mesh::relax_vertices( 
+        mesh, vertex_graph, inputs_t::ale_sweeps, relaxation 
+      );
+      mesh.update_geometry();
+      if ( mesh::min_cell_quality( mesh ) > 0 ) break;
+      timed_execute_task( timings, restore_coordinates_task, loc, single, mesh );
+      mesh.update_geometry();
+      if ( tries == max_retries ) {
+        std::cout << "Could not rezone the mesh without tangling it." 
+                  << std::endl;
+        return false;
+      }
+      relaxation *= 0.5;
+    }
+
+    // the conserved quantities are remapped
+    std::vector<std::string> remap_names = 
+      { "remap_density", "remap_momentum_x", "remap_momentum_y" };
+    if ( mesh_t::num_dimensions > 2 ) 
+      remap_names.emplace_back( "remap_momentum_z" );
+    remap_names.emplace_back( "remap_total_energy" );
+    remap_names.emplace_back( "remap_internal_energy" );
+
+    mesh::portage_mesh_t<mesh_t> source_mesh( source );
+    mesh::portage_mesh_t<mesh_t> target_mesh( mesh );
+    mesh::portage_state_t<mesh_t> source_state( source );
+    mesh::portage_state_t<mesh_t> target_state( mesh );
+    mesh::portage_1st_order_driver_t<mesh_t> remapper( 
+      source_mesh, source_state, target_mesh, target_state
+    );
+    remapper.set_remap_var_names( remap_names );
+    remapper.run( false );
+
+    // and the rest of the state is rebuilt from them
+    timed_execute_task( 
+      timings, restore_remap_fields_task, loc, single, mesh, region_eos 
+    );
+    return true;
+#else
+    return false;
+#endif
+  };
+
   //===========================================================================
   // Residual Evaluation
   //===========================================================================
@@ -237,9 +633,16 @@ int driver(int argc, char** argv)
   // a counter for this session
   size_t num_steps = 0; 
 
+  // a restarted run stops where the original one would have
+  auto max_steps = 
+    inputs_t::max_steps - std::min<size_t>( inputs_t::max_steps, time_cnt );
+
+  // decides when to stop early
+  run_control_t run_control( walltime, run_start );
+
   for (
     size_t num_retries = 0;
-    (num_steps < inputs_t::max_steps && soln_time < inputs_t::final_time); 
+    (num_steps < max_steps && soln_time < inputs_t::final_time); 
     ++num_steps 
   ) {   
 
@@ -249,8 +652,8 @@ int driver(int argc, char** argv)
 
     // Save solution at n=0
     if (num_retries == 0) {
-      flecsi_execute_task( save_coordinates_task, loc, single, mesh );
-      flecsi_execute_task( save_solution_task, loc, single, mesh );
+      timed_execute_task( timings, save_coordinates_task, loc, single, mesh );
+      timed_execute_task( timings, save_solution_task, loc, single, mesh );
     }
 
     // keep the old time step
@@ -261,15 +664,16 @@ int driver(int argc, char** argv)
     //--------------------------------------------------------------------------
 
     // estimate the nodal velocity at n=0
-    flecsi_execute_task( estimate_nodal_state_task, loc, single, mesh );
+    timed_execute_task( timings, estimate_nodal_state_task, loc, single, mesh );
 
     // compute the nodal velocity at n=0
-    flecsi_execute_task( 
-      evaluate_nodal_state_task, loc, single, mesh, boundaries
+    timed_execute_task( 
+      timings, evaluate_nodal_state_task, loc, single, mesh, boundaries
     );
+    start_vertex_exchange();
 
     // compute the fluxes
-    flecsi_execute_task( evaluate_residual_task, loc, single, mesh );
+    timed_execute_task( timings, evaluate_residual_task, loc, single, mesh );
 
     //--------------------------------------------------------------------------
     // Time step evaluation
@@ -277,11 +681,14 @@ int driver(int argc, char** argv)
 
     // compute the time step
     std::string limit_string;
-    flecsi_execute_task( evaluate_time_step_task, loc, single, mesh, limit_string );
+    timed_execute_task( timings, evaluate_time_step_task, loc, single, mesh, limit_string );
     
     // access the computed time step and make sure its not too large
     *time_step = std::min( *time_step, inputs_t::final_time - soln_time );       
 
+    // the residual and time step did not need the ghost vertices
+    finish_vertex_exchange();
+
     cout << std::string(60, '=') << endl;
     auto ss = cout.precision();
     cout.setf( std::ios::scientific );
@@ -314,12 +721,15 @@ int driver(int argc, char** argv)
       //------------------------------------------------------------------------
       // Move to n^stage
 
+      // all the vertices need their final velocity before they are moved
+      finish_vertex_exchange();
+
       // move the mesh to n+1/2
-      flecsi_execute_task( move_mesh_task, loc, single, mesh, stages[istage] );
+      timed_execute_task( timings, move_mesh_task, loc, single, mesh, stages[istage] );
 
       // update solution to n+1/2
-      auto err = flecsi_execute_task( 
-        apply_update_task, loc, single, mesh, stages[istage], machine_zero, (istage==0)
+      auto err = timed_execute_task( 
+        timings, apply_update_task, loc, single, mesh, stages[istage], machine_zero, (istage==0)
       );
       auto update_flag = err.get();
       
@@ -357,8 +767,8 @@ int driver(int argc, char** argv)
       // if we are retrying or restarting, restore the original solution
       if (mode == mode_t::restart || mode == mode_t::retry) {
         // restore the initial solution
-        flecsi_execute_task( restore_coordinates_task, loc, single, mesh );
-        flecsi_execute_task( restore_solution_task, loc, single, mesh );
+        timed_execute_task( timings, restore_coordinates_task, loc, single, mesh );
+        timed_execute_task( timings, restore_solution_task, loc, single, mesh );
         mesh.update_geometry();
         // don't retry forever
         if ( ++num_retries > max_retries ) {
@@ -370,14 +780,18 @@ int driver(int argc, char** argv)
       }
 
       // Update derived solution quantities
-      flecsi_execute_task( 
-        update_state_from_energy_task, loc, single, mesh, inputs_t::eos.get() 
+      timed_execute_task( 
+        timings, update_state_from_energy_task, loc, single, mesh, region_eos 
       );
 
+      // the nodal solve needs the ghost cells
+      exchange_cell_state();
+
       // compute the current nodal velocity
-      flecsi_execute_task( 
-        evaluate_nodal_state_task, loc, single, mesh, boundaries
+      timed_execute_task( 
+        timings, evaluate_nodal_state_task, loc, single, mesh, boundaries
       );
+      start_vertex_exchange();
 
       // if we are retrying, then restart the loop since all the state has been 
       // reset
@@ -398,17 +812,20 @@ int driver(int argc, char** argv)
       // Corrector : Evaluate Forces at n^stage
 
       // compute the fluxes
-      flecsi_execute_task( evaluate_residual_task, loc, single, mesh );
+      timed_execute_task( timings, evaluate_residual_task, loc, single, mesh );
 
       //------------------------------------------------------------------------
       // Move to n+1
 
       // restore the solution to n=0
-      flecsi_execute_task( restore_coordinates_task, loc, single, mesh );
-      flecsi_execute_task( restore_solution_task, loc, single, mesh );
+      timed_execute_task( timings, restore_coordinates_task, loc, single, mesh );
+      timed_execute_task( timings, restore_solution_task, loc, single, mesh );
 
     } while(true); // do
 
+    // the nodal velocities are written out
+    finish_vertex_exchange();
+
     //--------------------------------------------------------------------------
     // End Time step
     //--------------------------------------------------------------------------
@@ -421,15 +838,69 @@ int driver(int argc, char** argv)
     // update time
     soln_time = mesh.increment_time( *time_step );
     time_cnt = mesh.increment_time_step_counter();
+
+    // rezone the mesh and remap the solution onto it
+    if ( rezone_due() ) {
+      std::cout << "Rezoning the mesh and remapping the solution." << std::endl;
+      if ( !timings.measure( "rezone", rezone_and_remap ) )
+        std::cout << "Continuing with the Lagrangian mesh." << std::endl;
+      // a failed rezone also waits for the quality to drop further
+      rezone_quality = 
+        std::min( initial_quality, mesh::min_cell_quality( mesh ) );
+    }
   
     // now output the solution
-    output(
-      mesh, inputs_t::prefix, inputs_t::postfix, inputs_t::output_freq
-    );
+    timings.measure( "output", [&]() {
+      for ( auto & group : output_groups )
+        write_output_group( mesh, inputs_t::prefix, group );
+      return output(
+        mesh, inputs_t::prefix, inputs_t::postfix, inputs_t::output_freq
+      );
+    } );
+
+    // save the state, the file is written in the background
+    auto checkpoint_due = inputs_t::checkpoint_frequency > 0 && 
+      time_cnt % inputs_t::checkpoint_frequency == 0;
+    if ( checkpoint_due )
+      timings.measure( "checkpoint", write_checkpoint );
+
+    // sample the probes, the mesh has moved since they were last located
+    if ( probes && time_cnt % inputs_t::probe_frequency == 0 )
+      timings.measure( "probes", [&]() { 
+        probes->relocate();
+        probes->sample( soln_time, time_cnt ); 
+      } );
+
+    // compute the extracts that are due
+    if ( extracts )
+      timings.measure( "extracts", [&]() { 
+        extracts->process( soln_time, time_cnt ); 
+      } );
+
+#ifdef HAVE_PYTHON
+    // hand the solution to python
+    if ( python && time_cnt % inputs_t::python_frequency == 0 )
+      timings.measure( "python", [&]() { 
+        python->process( soln_time, time_cnt ); 
+      } );
+#endif
 
     // if we got through a whole cycle, reset the retry counter
     num_retries = 0;
 
+    // stop early, with a checkpoint, if the job is about to run out of time
+    // or was asked to stop
+    auto stop = run_control.check( 
+      timings, checkpoint_writer.last_write_seconds() 
+    );
+    if ( stop != stop_reason_t::none ) {
+      std::cout << "Stopping early because " << stop << "." << std::endl;
+      if ( !checkpoint_due ) 
+        timings.measure( "checkpoint", write_checkpoint );
+      ++num_steps;
+      break;
+    }
+
   }
 
 
@@ -437,6 +908,12 @@ int driver(int argc, char** argv)
   // Post-process
   //===========================================================================
     
+  // write any buffered probe samples
+  if ( probes ) probes->flush();
+
+  // make sure the last checkpoint made it to disk
+  checkpoint_writer.wait();
+
   // now output the solution
   if ( (inputs_t::output_freq > 0) && (time_cnt % inputs_t::output_freq != 0) )
     output(mesh, inputs_t::prefix, inputs_t::postfix, 1);
@@ -449,10 +926,19 @@ int driver(int argc, char** argv)
   auto tdelta = utils::get_wall_time() - tstart;
   std::cout << "Elapsed wall time is " << std::setprecision(4) << std::fixed 
             << tdelta << "s." << std::endl;
+
+  // dump the per-task timings
+  if ( !timings_file_name.empty() ) {
+    timings.add( "total", tdelta );
+    timings.write_csv( timings_file_name );
+  }
   
   // now output the checksums
   mesh::checksum(mesh);
 
+  // give the screen back to all the ranks
+  std::cout.rdbuf( cout_buf );
+
   // success
   return 0;
 
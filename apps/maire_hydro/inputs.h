@@ -10,13 +10,18 @@
 
 // user includes
 #include "types.h"
+#include "../common/output_groups.h"
 
 #include <flecsale/eos/eos_base.h>
 #include <flecsale/eos/ideal_gas.h>
+#include <flecsale/io/extracts.h>
 #include <flecsale/mesh/burton/burton.h>
+#include <flecsale/mesh/distributed.h>
+#include <flecsale/mesh/factory.h>
 #include <flecsale/utils/lua_utils.h>
 
 // system includes
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -46,6 +51,13 @@ public:
   //! the eos type
   using eos_t = flecsale::eos::eos_base_t<real_t>;
 
+  //! the list of output groups
+  using output_group_list_t = std::vector< output_group_t<real_t> >;
+
+  //! the in-situ extract type
+  using extract_spec_t = 
+    flecsale::io::extract_spec_t<real_t, num_dimensions>;
+
   //! a dimensioned array type helper
   template< typename T>
   using array_t = std::array<T, num_dimensions>;
@@ -57,9 +69,18 @@ public:
     std::function< ics_return_t(const vector_t & x, const real_t & t) >;
   //! \}
 
+  //! the region function type, which returns the region of a point
+  using region_function_t = std::function< size_t(const vector_t & x) >;
+
   //! the mesh function type
   using mesh_function_t = std::function< mesh_t(const real_t & t) >;
 
+  //! the distributed mesh function type, which builds the piece of the mesh
+  //! needed by one rank
+  using local_mesh_function_t = std::function< 
+    mesh_t(const real_t & t, int rank, int size, flecsale::mesh::ownership_t &)
+  >;
+
   //! the bcs function type
   //! \{
   using bcs_t = boundary_condition_t<num_dimensions>;
@@ -78,6 +99,42 @@ public:
   //! \brief output frequency
   static size_t output_freq;
 
+  //! \brief extra groups of fields, each written on its own schedule
+  static output_group_list_t output_groups;
+
+  //! \brief the point probe parameters.  The probes are off when the 
+  //! frequency is zero.
+  //! \{
+  static size_t probe_frequency;
+  static std::string probe_format;
+  static bool probe_follow_flow;
+  static std::vector<std::string> probe_fields;
+  static std::vector< array_t<real_t> > probe_points;
+  //! \}
+
+  //! \brief the in-situ extracts, each with its own frequency
+  static std::vector<extract_spec_t> extracts;
+
+  //! \brief the number of steps between checkpoints, zero to disable
+  static size_t checkpoint_frequency;
+
+  //! \brief the rezone and remap parameters.  The mesh is purely Lagrangian
+  //! when both the frequency and the quality tolerance are zero.
+  //! \{
+  static size_t ale_frequency;
+  static real_t ale_quality_tolerance;
+  static size_t ale_sweeps;
+  static real_t ale_relaxation;
+  //! \}
+
+  //! \brief the python function called with the solution.  It is off when
+  //! the frequency is zero.
+  //! \{
+  static size_t python_frequency;
+  static std::string python_script;
+  static std::string python_callback;
+  //! \}
+
   //! \brief the CFL and final solution time
   //! \{
   static time_constants_t CFL;
@@ -89,15 +146,58 @@ public:
   //! \brief the equation of state
   static std::shared_ptr<eos_t> eos;
 
+  //! \brief the equation of state of each region.  If it is empty, \e eos
+  //! is used everywhere.
+  static std::vector< std::shared_ptr<eos_t> > region_eos;
+
   //! \brief this is a lambda function to set the initial conditions
   static ics_function_t ics;
 
+  //! \brief This function assigns the cells to regions by their centroids.
+  //! If it is empty, the regions of the mesh are kept.
+  static region_function_t regions;
+
   //! \brief This function builds and returns a mesh
   static mesh_function_t make_mesh; 
 
+  //! \brief This function builds the piece of the mesh needed by one rank.
+  //! If it is empty, the whole mesh is built and then distributed.
+  static local_mesh_function_t make_local_mesh;
+
   //! \brief this is a list of lambda functions to set the boundary conditions
   static bcs_list_t bcs;
 
+  //===========================================================================
+  //! \brief Return the equation of state to use for each region.
+  //! \param [in] num_regions  The number of regions in the mesh.
+  //! \return A list of non-owning pointers, one per region.
+  //===========================================================================
+  static auto eos_by_region( size_t num_regions ) 
+  {
+    std::vector<const eos_t *> res( num_regions, eos.get() );
+    if ( region_eos.empty() ) return res;
+    if ( region_eos.size() != num_regions )
+      raise_runtime_error( 
+        "The mesh has " << num_regions << " regions but " 
+        << region_eos.size() << " equations of state were given"
+      );
+    for ( size_t r=0; r<num_regions; ++r )
+      res[r] = region_eos[r].get();
+    return res;
+  }
+
+  //===========================================================================
+  //! \brief Assign the cells to regions if a region function was given.
+  //! There is one region for each equation of state in the list.
+  //! \param [in,out] mesh  The mesh whose cells are assigned.
+  //===========================================================================
+  static void assign_regions( mesh_t & mesh ) 
+  {
+    if ( !regions ) return;
+    auto num_regions = std::max<size_t>( region_eos.size(), 1 );
+    flecsale::mesh::assign_regions( mesh, num_regions, regions );
+  }
+
 #ifdef HAVE_LUA
 
   //===========================================================================
@@ -127,17 +227,158 @@ public:
     CFL.volume    = lua_try_access_as( cfl_ics, "volume",    real_t );
     CFL.growth    = lua_try_access_as( cfl_ics, "growth",    real_t );
 
+    // the output groups are optional
+    if ( !hydro_input["outputs"].empty() ) {
+      auto output_input = lua_try_access( hydro_input, "outputs" );
+      auto num_groups = output_input.size();
+      output_groups.clear();
+      for ( int i=1; i<=num_groups; ++i ) {
+        auto input = output_input[i];
+        output_group_t<real_t> group;
+        group.name = lua_try_access_as( input, "name", std::string );
+        if ( !input["postfix"].empty() )
+          group.postfix = lua_try_access_as( input, "postfix", std::string );
+        if ( !input["fields"].empty() )
+          group.fields = 
+            lua_try_access_as( input, "fields", std::vector<std::string> );
+        if ( !input["frequency"].empty() )
+          group.frequency = lua_try_access_as( input, "frequency", size_t );
+        if ( !input["interval"].empty() )
+          group.interval = lua_try_access_as( input, "interval", real_t );
+        if ( !input["compress"].empty() )
+          group.compress = lua_try_access_as( input, "compress", bool );
+        if ( group.frequency == 0 && !( group.interval > 0 ) )
+          raise_runtime_error( 
+            "Output group \"" << group.name << "\" needs a frequency or "
+            << "an interval"
+          );
+        output_groups.emplace_back( std::move(group) );
+      }
+    }
+
+    // the point probes are optional
+    if ( !hydro_input["probes"].empty() ) {
+      auto probe_input = lua_try_access( hydro_input, "probes" );
+      probe_frequency = 
+        lua_try_access_as( probe_input, "frequency", size_t );
+      probe_points = lua_try_access_as( 
+        probe_input, "points", std::vector< array_t<real_t> > 
+      );
+      if ( !probe_input["fields"].empty() )
+        probe_fields = lua_try_access_as( 
+          probe_input, "fields", std::vector<std::string> 
+        );
+      if ( !probe_input["format"].empty() )
+        probe_format = lua_try_access_as( probe_input, "format", std::string );
+      if ( !probe_input["follow_flow"].empty() )
+        probe_follow_flow = 
+          lua_try_access_as( probe_input, "follow_flow", bool );
+    }
+
+    // the in-situ extracts are optional
+    if ( !hydro_input["extracts"].empty() ) {
+      auto extract_input = lua_try_access( hydro_input, "extracts" );
+      auto num_extracts = extract_input.size();
+      extracts.clear();
+      for ( int i=1; i<=num_extracts; ++i ) {
+        auto input = extract_input[i];
+        extract_spec_t spec;
+        spec.type = flecsale::io::extract_type_from_string(
+          lua_try_access_as( input, "type", std::string )
+        );
+        spec.frequency = lua_try_access_as( input, "frequency", size_t );
+        spec.fields = 
+          lua_try_access_as( input, "fields", std::vector<std::string> );
+        switch ( spec.type ) {
+          case flecsale::io::extract_type_t::slice:
+            spec.origin = lua_try_access_as( input, "origin", array_t<real_t> );
+            spec.normal = lua_try_access_as( input, "normal", array_t<real_t> );
+            break;
+          case flecsale::io::extract_type_t::lineout:
+            spec.from = lua_try_access_as( input, "from", array_t<real_t> );
+            spec.to = lua_try_access_as( input, "to", array_t<real_t> );
+            if ( !input["points"].empty() )
+              spec.num_points = lua_try_access_as( input, "points", size_t );
+            break;
+          case flecsale::io::extract_type_t::histogram:
+            if ( !input["bins"].empty() )
+              spec.num_bins = lua_try_access_as( input, "bins", size_t );
+            if ( !input["range"].empty() ) {
+              auto range = lua_try_access_as( 
+                input, "range", std::array<real_t, 2> 
+              );
+              spec.min = range[0];
+              spec.max = range[1];
+            }
+            break;
+          case flecsale::io::extract_type_t::regions:
+            break;
+        }
+        extracts.emplace_back( std::move(spec) );
+      }
+    }
+
+    // the python callback is optional
+    if ( !hydro_input["python"].empty() ) {
+      auto python_input = lua_try_access( hydro_input, "python" );
+      python_frequency = 
+        lua_try_access_as( python_input, "frequency", size_t );
+      python_script = 
+        lua_try_access_as( python_input, "script", std::string );
+      if ( !python_input["callback"].empty() )
+        python_callback = 
+          lua_try_access_as( python_input, "callback", std::string );
+    }
+
+    // the rezone and remap parameters are optional
+    if ( !hydro_input["ale"].empty() ) {
+      auto ale_input = lua_try_access( hydro_input, "ale" );
+      if ( !ale_input["frequency"].empty() )
+        ale_frequency = lua_try_access_as( ale_input, "frequency", size_t );
+      if ( !ale_input["quality_tolerance"].empty() )
+        ale_quality_tolerance = 
+          lua_try_access_as( ale_input, "quality_tolerance", real_t );
+      if ( !ale_input["sweeps"].empty() )
+        ale_sweeps = lua_try_access_as( ale_input, "sweeps", size_t );
+      if ( !ale_input["relaxation"].empty() )
+        ale_relaxation = lua_try_access_as( ale_input, "relaxation", real_t );
+    }
+
+    // checkpoints are optional
+    if ( !hydro_input["checkpoint"].empty() ) {
+      auto checkpoint_input = lua_try_access( hydro_input, "checkpoint" );
+      checkpoint_frequency = 
+        lua_try_access_as( checkpoint_input, "frequency", size_t );
+    }
+
     // setup the equation of state
+    auto make_eos = []( const auto & eos_input ) -> std::shared_ptr<eos_t>
+    {
+      auto eos_type = lua_try_access_as( eos_input, "type", std::string );
+      if ( eos_type == "ideal_gas" ){
+        using ideal_gas_t = flecsale::eos::ideal_gas_t<real_t>;
+        auto g  = lua_try_access_as( eos_input, "gas_constant", real_t );
+        auto cv = lua_try_access_as( eos_input, "specific_heat", real_t );
+        return std::make_shared<ideal_gas_t>( g, cv );
+      }
+      else {
+        raise_implemented_error("Unknown eos type \""<<eos_type<<"\"");
+      }
+    };
+
+    // either one equation of state, or a list with one per region
     auto eos_input = lua_try_access( hydro_input, "eos" );
-    auto eos_type = lua_try_access_as( eos_input, "type", std::string );
-    if ( eos_type == "ideal_gas" ){
-      using ideal_gas_t = flecsale::eos::ideal_gas_t<real_t>;
-      auto g  = lua_try_access_as( eos_input, "gas_constant", real_t );
-      auto cv = lua_try_access_as( eos_input, "specific_heat", real_t );
-      eos = std::make_shared<ideal_gas_t>( g, cv );
+    region_eos.clear();
+    if ( eos_input["type"].empty() ) {
+      auto num_regions = eos_input.size();
+      if ( num_regions == 0 )
+        raise_runtime_error( "No equations of state given" );
+      for ( int r=1; r<=num_regions; ++r )
+        region_eos.emplace_back( make_eos( eos_input[r] ) );
+      eos = region_eos.front();
     }
     else {
-      raise_implemented_error("Unknown eos type \""<<eos_type<<"\"");
+      eos = make_eos( eos_input );
     }
 
     // return the state
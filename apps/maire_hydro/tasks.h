@@ -12,13 +12,25 @@
 // hydro includes
 #include "types.h"
 
+#include <flecsale/eos/visit.h>
 #include <flecsale/linalg/qr.h>
+#include <flecsale/mesh/distributed.h>
+#include <flecsale/mesh/rezone.h>
 #include <flecsale/utils/algorithm.h>
 #include <flecsale/utils/array_view.h>
 #include <flecsale/utils/filter_iterator.h>
+#include <flecsale/utils/mpi_utils.h>
+#include <flecsale/utils/reduction.h>
 
 // system includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
  #include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
  
 namespace apps {
 namespace hydro {
@@ -53,8 +65,7 @@ int initial_conditions( T & mesh, F && ics ) {
   auto cs = mesh.cells();
   auto num_cells = cs.size();
 
-  // This doesn't work with lua input
-  // #pragma omp parallel for
+  #pragma omp parallel for
   for ( counter_t i=0; i<num_cells; ++i ) {
     auto c = cs[i];
     // now copy the state to flexi
@@ -69,14 +80,64 @@ int initial_conditions( T & mesh, F && ics ) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to every cell, one region at a time.
+//!
+//! Each region is swept in its own loop, and the function is called with 
+//! the concrete type of that region's equation of state.  So the loop body 
+//! has no per-cell dispatch, and every cell in a loop sees the same 
+//! material.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
+//! \param [in] owned_only  If true, skip the ghost cells.
+//! \param [in] f  Called as f(c, eos) for each cell.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS, typename F >
+void for_each_region_cell( 
+  T & mesh, 
+  const std::vector<const EOS *> & region_eos, 
+  bool owned_only,
+  F && f
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  auto num_owned = mesh.num_owned_cells();
+  auto num_regions = mesh.num_regions();
+  assert( region_eos.size() == num_regions );
+
+  for ( size_t r=0; r<num_regions; r++ ) {
+    
+    // the ids are sorted, so the owned cells come first
+    auto ids = mesh.region_cell_ids(r);
+    counter_t num_ids = owned_only ? 
+      std::lower_bound( ids.begin(), ids.end(), num_owned ) - ids.begin() :
+      ids.size();
+
+    flecsale::eos::visit( *region_eos[r], [&]( const auto & eos ) {
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_ids; i++ )
+        std::forward<F>(f)( cs[ ids[i] ], eos );
+    } );
+
+  } // region
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief The main task for setting initial conditions
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename EOS >
-int update_state_from_pressure( T & mesh, const EOS * eos ) {
+int update_state_from_pressure( 
+  T & mesh, const std::vector<const EOS *> & region_eos 
+) {
 
   // type aliases
   using counter_t = typename T::counter_t;
@@ -86,23 +147,31 @@ int update_state_from_pressure( T & mesh, const EOS * eos ) {
   auto cell_state = cell_state_accessor<T>( mesh );
   auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
 
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  real_t ener(0);
+  // update each region with its own equation of state
+  for_each_region_cell( mesh, region_eos, false, 
+    [&]( auto c, const auto & eos ) {
+      auto u = cell_state(c);
+      eqns_t::update_state_from_pressure( u, eos );
+    }
+  );
 
-  #pragma omp parallel for reduction(+:ener)
-  for ( counter_t i=0; i<num_cells; ++i ) {
-    auto c = cs[i];
-    auto u = cell_state(c);
-    eqns_t::update_state_from_pressure( u, *eos );
-    // sum total energy
-    auto et = eqns_t::total_energy(u);
-    auto m  = eqns_t::mass(u);
-    ener += m * et;
-  }
+  auto cs = mesh.cells();
+  counter_t num_owned = mesh.num_owned_cells();
+
+  // sum total energy, ghost cells are counted by their owner.  The sum is 
+  // done in fixed blocks so it does not depend on the number of threads
+  auto ener = utils::reproducible_sum(
+    num_owned, real_t(0),
+    [&]( counter_t i, real_t & sum ) {
+      auto c = cs[i];
+      auto u = cell_state(c);
+      auto et = eqns_t::total_energy(u);
+      auto m  = eqns_t::mass(u);
+      sum += m * et;
+    }
+  );
 
-  *ener0 = ener;
+  *ener0 = utils::global_sum( ener );
 
   return 0;
 }
@@ -112,10 +181,13 @@ int update_state_from_pressure( T & mesh, const EOS * eos ) {
 //! \brief The main task for setting initial conditions
 //!
 //! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
 //! \return 0 for success
 ////////////////////////////////////////////////////////////////////////////////
 template< typename T, typename EOS >
-int update_state_from_energy( T & mesh, const EOS * eos ) {
+int update_state_from_energy( 
+  T & mesh, const std::vector<const EOS *> & region_eos 
+) {
 
   // type aliases
   using counter_t = typename T::counter_t;
@@ -125,17 +197,14 @@ int update_state_from_energy( T & mesh, const EOS * eos ) {
   // get the collection accesor
   auto cell_state = cell_state_accessor<T>( mesh );
 
-  auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  // loop over materials first?
-
-  #pragma omp parallel for
-  for ( counter_t i=0; i<num_cells; ++i ) {
-    auto c = cs[i];
-    auto u = cell_state(c);
-    eqns_t::update_state_from_energy( u, *eos );
-  }
+  // update each region with its own equation of state, the ghost cells are
+  // filled in by their owners
+  for_each_region_cell( mesh, region_eos, true, 
+    [&]( auto c, const auto & eos ) {
+      auto u = cell_state(c);
+      eqns_t::update_state_from_energy( u, eos );
+    }
+  );
 
   return 0;
 }
@@ -155,12 +224,13 @@ int evaluate_time_step( T & mesh, std::string & limit_string )
   // type aliases
   using counter_t = typename T::counter_t;
   using real_t = typename T::real_t;
+  using storage_real_t = typename T::storage_real_t;
   using vector_t = typename T::vector_t;
   using eqns_t = eqns_t<T::num_dimensions>;
   using flux_data_t = flux_data_t<T::num_dimensions>;
 
   // access what we need
-  auto sound_speed = flecsi_get_accessor( mesh, hydro, cell_sound_speed, real_t, dense, 0 );
+  auto sound_speed = flecsi_get_accessor( mesh, hydro, cell_sound_speed, storage_real_t, dense, 0 );
 
   auto dudt = flecsi_get_accessor( mesh, hydro, cell_residual, flux_data_t, dense, 0 );
   auto cell_volume = mesh.cell_volumes();
@@ -177,7 +247,7 @@ int evaluate_time_step( T & mesh, std::string & limit_string )
   real_t dt_vol_inv(0);
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
+  auto num_cells = mesh.num_owned_cells();
 
   #pragma omp parallel for reduction( max : dt_acc_inv, dt_vol_inv )
   for ( counter_t i=0; i<num_cells; ++i ) {
@@ -197,6 +267,9 @@ int evaluate_time_step( T & mesh, std::string & limit_string )
   } // cell
   //----------------------------------------------------------------------------
 
+  // the smallest time steps over all ranks
+  dt_acc_inv = utils::global_max( dt_acc_inv );
+  dt_vol_inv = utils::global_max( dt_vol_inv );
 
   assert( dt_acc_inv > 0 && "infinite delta t" );
   assert( dt_vol_inv > 0 && "infinite delta t" );
@@ -295,23 +368,42 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
   auto cell_state = cell_state_accessor<T>( mesh );
   auto vertex_velocity = flecsi_get_accessor( mesh, hydro, node_velocity, vector_t, dense, 0 );
 
-  auto wedge_facet_normal = mesh.wedge_facet_normals();
-  auto wedge_facet_area = mesh.wedge_facet_areas(); 
-  auto wedge_facet_centroid = mesh.wedge_facet_centroids();
-
   auto npc = flecsi_get_accessor( mesh, hydro, corner_normal, vector_t, dense, 0 );
   auto Fpc = flecsi_get_accessor( mesh, hydro, corner_force, vector_t, dense, 0 );
 
   // get the current time
   auto soln_time = mesh.time();
 
+  auto cs = mesh.cells();
+  auto fs = mesh.faces();
+  auto vs = mesh.vertices();
+  auto num_verts = vs.size();
+
+  // the corner and wedge connectivity, either indexed implicitly or through
+  // the corner and wedge entities
+#ifdef USE_IMPLICIT_DUAL
+  const auto & dual = mesh.dual();
+  const auto & wedge_facet_normal = dual.facet_normals();
+  const auto & wedge_facet_area = dual.facet_areas(); 
+  const auto & wedge_facet_centroid = dual.facet_centroids();
+  auto vertex_corners = [&]( auto vt ) { return dual.vertex_corners( vt.id() ); };
+  auto corner_cell = [&]( auto cn ) { return cs[ dual.corner_cell(cn) ]; };
+  auto corner_wedges = [&]( auto cn ) { return dual.corner_wedges(cn); };
+  auto wedge_face = [&]( auto w ) { return fs[ dual.wedge_face(w) ]; };
+#else
+  auto wedge_facet_normal = mesh.wedge_facet_normals();
+  auto wedge_facet_area = mesh.wedge_facet_areas(); 
+  auto wedge_facet_centroid = mesh.wedge_facet_centroids();
+  auto vertex_corners = [&]( auto vt ) { return mesh.corners(vt); };
+  auto corner_cell = [&]( auto cn ) { return mesh.cells(cn).front(); };
+  auto corner_wedges = [&]( auto cn ) { return mesh.wedges(cn); };
+  auto wedge_face = [&]( auto w ) { return mesh.faces(w).front(); };
+#endif
+
   //----------------------------------------------------------------------------
   // Loop over each vertex
   //----------------------------------------------------------------------------
 
-  auto vs = mesh.vertices();
-  auto num_verts = vs.size();
-
   #pragma omp parallel for schedule(dynamic)
   for ( counter_t i=0; i<num_verts; ++i ) {
 
@@ -322,7 +414,7 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
     vector_t rhs(0);
 
     // get the corners
-    auto cnrs = mesh.corners(vt);
+    auto cnrs = vertex_corners(vt);
     auto num_corners = cnrs.size();
 
     // create some corner storage
@@ -340,7 +432,7 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
       npc[cn] = 0;
 
       // corner attaches to one cell and one point
-      auto cl = mesh.cells(cn).front();
+      auto cl = corner_cell(cn);
       // get the cell state (there is only one)
       auto state = cell_state(cl);
       // the corner quantities are approximated as cell ones
@@ -352,7 +444,7 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
       auto zc = dc * ac;
 
       // iterate over the wedges in pairs
-      auto ws = mesh.wedges(cn);
+      auto ws = corner_wedges(cn);
       for ( auto w : ws ) 
       {
         // get the first wedge normal
@@ -401,11 +493,11 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
       }
 
       // otherwise, apply the pressure conditions
-      auto bnd_wedges = filter_boundary( mesh.wedges(vt) );
-      for ( auto w : bnd_wedges ) 
+      for ( auto cn : cnrs ) 
+      for ( auto w : corner_wedges(cn) ) 
       {
-        auto f = mesh.faces(w).front();
-        auto c = mesh.cells(w).front();
+        auto f = wedge_face(w);
+        if ( !f->is_boundary() ) continue;
         for ( auto tag : f->tags() ) {
           auto b = boundary_map.at( tag );
           // PRESSURE CONDITION
@@ -502,8 +594,6 @@ int evaluate_nodal_state( T & mesh, const BC & boundary_map ) {
 
       // get the corner
       auto cn = cnrs[j];
-      // corner attaches to one cell and one point
-      auto cl = mesh.cells(cn).front();
 
       // now add the vertex component to the force
       matrix_vector( 
@@ -550,11 +640,25 @@ int32_t evaluate_residual( T & mesh ) {
   //----------------------------------------------------------------------------
   // TASK: loop over each cell and compute the residual
   
-  // get the cells
+  // get the cells, only the owned ones are updated
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-
-  #pragma omp parallel for
+  auto vs = mesh.vertices();
+  auto num_cells = mesh.num_owned_cells();
+
+  // the corner connectivity, either indexed implicitly or through the 
+  // corner entities
+#ifdef USE_IMPLICIT_DUAL
+  const auto & dual = mesh.dual();
+  auto cell_corners = [&]( auto cl ) { return dual.cell_corners( cl.id() ); };
+  auto corner_vertex = [&]( auto cn ) { return vs[ dual.corner_vertex(cn) ]; };
+#else
+  auto cell_corners = [&]( auto cl ) { return mesh.corners(cl); };
+  auto corner_vertex = [&]( auto cn ) { return mesh.vertices(cn).front(); };
+#endif
+
+  // the implicit corners were first written with this static schedule, so 
+  // each thread reads the ones in its own memory
+  #pragma omp parallel for schedule(static)
   for ( counter_t i=0; i<num_cells; i++ ) {
     
     // get the cell_t pointer
@@ -567,9 +671,9 @@ int32_t evaluate_residual( T & mesh ) {
     dudt[cl] = 0;
 
     // compute subcell forces
-    for ( auto cn : mesh.corners(cl) ) {
+    for ( auto cn : cell_corners(cl) ) {
       // corner attaches to one point and zone
-      auto pt = mesh.vertices(cn).front();
+      auto pt = corner_vertex(cn);
       // add contribution
       eqns_t::compute_update( uv[pt], Fpc[cn], npc[cn], dudt[cl] );
     }// corners    
@@ -597,6 +701,7 @@ apply_update( T & mesh, real_t coef, real_t tolerance, bool first_time )
   using vector_t = typename T::vector_t;
   using flux_data_t = flux_data_t<T::num_dimensions>;
   using eqns_t = eqns_t<T::num_dimensions>;
+  using equations_t = typename eqns_t::equations;
 
 
   // access what we need
@@ -613,57 +718,81 @@ apply_update( T & mesh, real_t coef, real_t tolerance, bool first_time )
   // the time step factor
   auto fact = coef * (*delta_t);
 
-  real_t mass(0);
-  vector_t mom(0);
-  real_t ener(0);
   bool bad_cell(false);
  
   //----------------------------------------------------------------------------
-  // Loop over each cell, scattering the fluxes to the cell
+  // Loop over each owned cell, scattering the fluxes to the cell.  The ghost
+  // cells are updated by their owners.
+  //
+  // The conserved totals are summed in fixed blocks of cells, so they do not
+  // depend on the number of threads.
 
   auto cs = mesh.cells();
-  auto num_cells = cs.size();
-  
-  #pragma omp declare reduction( + : vector_t : omp_out += omp_in ) \
-    initializer (omp_priv(omp_orig))
+  auto num_cells = mesh.num_owned_cells();
 
-  #pragma omp parallel for reduction( + : mass, mom, ener ) \
-    reduction( || : bad_cell )
-  for ( counter_t i=0; i<num_cells; i++ ) {
+  utils::blocked_sum_t<flux_data_t> totals( num_cells, flux_data_t(0) );
+  counter_t num_blocks = totals.num_blocks();
 
-    // get the cell_t pointer
-    auto cl = cs[i];
+  #pragma omp parallel for reduction( || : bad_cell )
+  for ( counter_t b=0; b<num_blocks; b++ ) {
+
+    // the mass, momentum and energy of this block
+    flux_data_t block_sum( 0 );
+
+    counter_t block_end = totals.end(b);
+    for ( counter_t i=totals.begin(b); i<block_end; i++ ) {
+
+      // get the cell_t pointer
+      auto cl = cs[i];
  
-    //--------------------------------------------------------------------------
-    // Using the cell residual, update the state
-
-    // get the cell state
-    auto u = cell_state( cl );
-
-    // apply the update
-    eqns_t::update_state_from_flux( u, dudt[cl], fact );
-    eqns_t::update_volume( u, cell_volume[cl] );
-
-    // post update sums
-    auto vel = eqns_t::velocity(u);
-    auto ie = eqns_t::internal_energy(u);
-    auto m  = eqns_t::mass(u);
-    auto rho  = eqns_t::density(u);
-    mass += m;
-    ener += m * ie;
-    for ( int d=0; d<T::num_dimensions; ++d ) {
-      auto tmp = m * vel[d];
-      mom[d] += tmp;
-      ener += 0.5 * tmp * vel[d];
-    }
+      //------------------------------------------------------------------------
+      // Using the cell residual, update the state
+
+      // get the cell state
+      auto u = cell_state( cl );
+
+      // apply the update
+      eqns_t::update_state_from_flux( u, dudt[cl], fact );
+      eqns_t::update_volume( u, cell_volume[cl] );
+
+      // post update sums
+      auto vel = eqns_t::velocity(u);
+      auto ie = eqns_t::internal_energy(u);
+      auto m  = eqns_t::mass(u);
+      auto rho  = eqns_t::density(u);
+      block_sum[ equations_t::index::mass ] += m;
+      block_sum[ equations_t::index::energy ] += m * ie;
+      for ( int d=0; d<T::num_dimensions; ++d ) {
+        auto tmp = m * vel[d];
+        block_sum[ equations_t::index::momentum + d ] += tmp;
+        block_sum[ equations_t::index::energy ] += 0.5 * tmp * vel[d];
+      }
     
-    // check the solution quantities
-    if ( ie < 0 || rho < 0 || cell_volume[cl] < 0 )
-      bad_cell = true;
+      // check the solution quantities
+      if ( ie < 0 || rho < 0 || cell_volume[cl] < 0 )
+        bad_cell = true;
+
+    } // cell
+
+    totals[b] = block_sum;
 
-  } // for
+  } // block
   //----------------------------------------------------------------------------
 
+  // combine the blocks in a fixed order
+  auto sums = totals.sum();
+  auto mass = sums[ equations_t::index::mass ];
+  auto ener = sums[ equations_t::index::energy ];
+  vector_t mom;
+  for ( int d=0; d<T::num_dimensions; ++d )
+    mom[d] = sums[ equations_t::index::momentum + d ];
+
+  // sum over all the ranks
+  mass = utils::global_sum( mass );
+  ener = utils::global_sum( ener );
+  utils::global_sum( mom.data(), mom.size() );
+  bad_cell = utils::global_or( bad_cell );
+
   // return unphysical if something went wrong
   if (bad_cell) {
     std::cout << "Negative internal energy or density encountered in a cell" 
@@ -890,6 +1019,341 @@ int restore_solution( T & mesh ) {
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to store the conserved quantities for a remap.
+//!
+//! The density, momentum, total energy and internal energy per unit volume
+//! of each cell are written to the remap fields of another mesh with the
+//! same cells, usually a copy of this mesh before it is rezoned.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in,out] source  the mesh holding the remap fields
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+int save_remap_fields( T & mesh, T & source ) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+
+  // access what we need
+  auto d = flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 );
+  auto v = flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 );
+  auto e = flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 );
+
+  auto rho = flecsi_get_accessor( source, hydro, remap_density, real_t, dense, 0 );
+  auto mom_x = flecsi_get_accessor( source, hydro, remap_momentum_x, real_t, dense, 0 );
+  std::array< decltype(mom_x), 3 > mom = {{
+    mom_x,
+    flecsi_get_accessor( source, hydro, remap_momentum_y, real_t, dense, 0 ),
+    flecsi_get_accessor( source, hydro, remap_momentum_z, real_t, dense, 0 )
+  }};
+  auto rho_et = flecsi_get_accessor( source, hydro, remap_total_energy, real_t, dense, 0 );
+  auto rho_ie = flecsi_get_accessor( source, hydro, remap_internal_energy, real_t, dense, 0 );
+
+  // the cells of both meshes are in the same order
+  auto cs = mesh.cells();
+  auto source_cs = source.cells();
+  counter_t num_cells = cs.size();
+
+  if ( source_cs.size() != cs.size() )
+    raise_runtime_error( "The remap source does not match the mesh" );
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; i++ ) {
+    auto c = cs[i];
+    auto sc = source_cs[i];
+    rho[sc] = d[c];
+    real_t ke = 0;
+    for ( int dim=0; dim<T::num_dimensions; ++dim ) {
+      mom[dim][sc] = d[c] * v[c][dim];
+      ke += v[c][dim] * v[c][dim];
+    }
+    rho_et[sc] = d[c] * ( e[c] + 0.5 * ke );
+    rho_ie[sc] = d[c] * e[c];
+  }
+
+  return 0;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The main task to recover the solution after a remap.
+//!
+//! The cell state is rebuilt from the remapped quantities and the current
+//! geometry.  Total energy is conserved unless that would leave a cell
+//! with a non-positive internal energy, in which case the remapped internal
+//! energy is used for that cell.  A cell whose remapped density collapses
+//! keeps its state from before the remap, and the number of such cells is
+//! reported.
+//!
+//! \param [in,out] mesh the mesh object
+//! \param [in] region_eos  The equation of state of each region.
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename EOS >
+int restore_remap_fields( 
+  T & mesh, const std::vector<const EOS *> & region_eos 
+) {
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using eqns_t = eqns_t<T::num_dimensions>;
+
+  // access what we need
+  auto cell_state = cell_state_accessor<T>( mesh );
+  auto ener0 = flecsi_get_accessor( mesh, hydro, sum_total_energy, real_t, global, 0 );
+
+  auto M = flecsi_get_accessor( mesh, hydro, cell_mass, real_t, dense, 0 );
+  auto V = flecsi_get_accessor( mesh, hydro, cell_volume, real_t, dense, 0 );
+  auto d = flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 );
+  auto v = flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 );
+  auto e = flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 );
+
+  auto rho = flecsi_get_accessor( mesh, hydro, remap_density, real_t, dense, 0 );
+  auto mom_x = flecsi_get_accessor( mesh, hydro, remap_momentum_x, real_t, dense, 0 );
+  std::array< decltype(mom_x), 3 > mom = {{
+    mom_x,
+    flecsi_get_accessor( mesh, hydro, remap_momentum_y, real_t, dense, 0 ),
+    flecsi_get_accessor( mesh, hydro, remap_momentum_z, real_t, dense, 0 )
+  }};
+  auto rho_et = flecsi_get_accessor( mesh, hydro, remap_total_energy, real_t, dense, 0 );
+  auto rho_ie = flecsi_get_accessor( mesh, hydro, remap_internal_energy, real_t, dense, 0 );
+
+  auto cell_vol = mesh.cell_volumes();
+
+  auto cs = mesh.cells();
+  counter_t num_cells = cs.size();
+  counter_t num_owned = mesh.num_owned_cells();
+
+  // a cell whose density drops below this fraction of its old value is 
+  // considered to have collapsed
+  const auto min_fraction = std::sqrt( std::numeric_limits<real_t>::epsilon() );
+
+  std::size_t num_collapsed = 0;
+
+  #pragma omp parallel for reduction( + : num_collapsed )
+  for ( counter_t i=0; i<num_cells; i++ ) {
+    auto c = cs[i];
+    vector_t cell_mom(0);
+    for ( int dim=0; dim<T::num_dimensions; ++dim ) 
+      cell_mom[dim] = mom[dim][c];
+    // a collapsed cell keeps its state from before the remap
+    auto ok = mesh::recover_remapped_state(
+      static_cast<real_t>( rho[c] ), cell_mom, 
+      static_cast<real_t>( rho_et[c] ), static_cast<real_t>( rho_ie[c] ), 
+      min_fraction * d[c], d[c], v[c], e[c]
+    );
+    if ( !ok && i < num_owned ) ++num_collapsed;
+    V[c] = cell_vol[c];
+    M[c] = d[c] * cell_vol[c];
+  }
+
+  num_collapsed = utils::global_sum( num_collapsed );
+  if ( num_collapsed > 0 )
+    std::cout << "The density collapsed in " << num_collapsed << " remapped "
+      << "cells, they kept their state from before the remap." << std::endl;
+
+  // the pressure, temperature and sound speed follow from the energy
+  update_state_from_energy( mesh, region_eos );
+
+  // the remap changes the discrete total energy a little, so the
+  // conservation check starts over from here
+  auto ener = utils::reproducible_sum(
+    num_owned, real_t(0),
+    [&]( counter_t i, real_t & sum ) {
+      auto c = cs[i];
+      auto u = cell_state(c);
+      auto et = eqns_t::total_energy(u);
+      auto m  = eqns_t::mass(u);
+      sum += m * et;
+    }
+  );
+
+  *ener0 = utils::global_sum( ener );
+
+  return 0;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Add the requested fields to a probe recorder.
+//!
+//! The accessors are fetched every time the probes are sampled, so they
+//! always point at the current data.
+//!
+//! \param [in] mesh  the mesh object
+//! \param [in,out] probes  the probe recorder
+//! \param [in] names  the names of the fields to record
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename R >
+int add_probe_fields( 
+  T & mesh, 
+  R & probes, 
+  const std::vector<std::string> & names 
+) {
+
+  // type aliases
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using storage_real_t = typename T::storage_real_t;
+  using probe_real_t = typename R::real_t;
+  using cell_list_t = std::vector<std::size_t>;
+  constexpr auto num_dims = T::num_dimensions;
+
+  // copy the probe cell values out of an accessor
+  auto add_scalar = [&]( const std::string & name, auto get ) {
+    probes.add_field( name, 1, 
+      [&mesh, get]( const cell_list_t & cells, probe_real_t * vals ) {
+        auto a = get();
+        auto cs = mesh.cells();
+        for ( std::size_t i=0; i<cells.size(); ++i )
+          vals[i] = a[ cs[cells[i]] ];
+      } 
+    );
+  };
+
+  auto add_vector = [&]( const std::string & name, auto get ) {
+    probes.add_field( name, num_dims, 
+      [&mesh, get, num_dims]( const cell_list_t & cells, probe_real_t * vals ) {
+        auto a = get();
+        auto cs = mesh.cells();
+        for ( std::size_t i=0; i<cells.size(); ++i )
+          for ( std::size_t d=0; d<num_dims; ++d )
+            vals[ i*num_dims + d ] = a[ cs[cells[i]] ][d];
+      } 
+    );
+  };
+
+  for ( const auto & name : names ) {
+    if ( name == "cell_density" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_pressure" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_pressure, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_velocity" )
+      add_vector( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_internal_energy" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_temperature" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_temperature, storage_real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_sound_speed" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_sound_speed, storage_real_t, dense, 0 ); 
+      } );
+    else
+      raise_runtime_error( "Unknown probe field \"" << name << "\"" );
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Register the fields needed by the in-situ extracts.
+//!
+//! The scalar fields are used as is.  A vector field gives its magnitude,
+//! and its components are named with a suffix, as in "cell_velocity_0".
+//!
+//! \param [in] mesh  the mesh object
+//! \param [in,out] extracts  the extract writer
+//! \return 0 for success
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename W >
+int add_extract_fields( T & mesh, W & extracts ) 
+{
+
+  // type aliases
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  using storage_real_t = typename T::storage_real_t;
+  using values_t = std::vector<typename W::real_t>;
+  constexpr auto num_dims = T::num_dimensions;
+
+  // copy the cell values out of an accessor
+  auto add_scalar = [&]( const std::string & name, auto get ) {
+    extracts.add_field( name, [&mesh, get]( values_t & vals ) {
+      auto a = get();
+      auto cs = mesh.cells();
+      counter_t num_cells = cs.size();
+      vals.resize( num_cells );
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_cells; ++i )
+        vals[i] = a[ cs[i] ];
+    } );
+  };
+
+  // either one component, or the magnitude when the component is num_dims
+  auto add_vector = [&]( const std::string & name, auto get, std::size_t k ) {
+    extracts.add_field( name, [&mesh, get, k, num_dims]( values_t & vals ) {
+      auto a = get();
+      auto cs = mesh.cells();
+      counter_t num_cells = cs.size();
+      vals.resize( num_cells );
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_cells; ++i ) {
+        const auto & v = a[ cs[i] ];
+        vals[i] = ( k < num_dims ) ? v[k] : magnitude( v );
+      }
+    } );
+  };
+
+  // check if a name refers to a vector field, and which component
+  auto component = [&]( const std::string & name, const std::string & base )
+    -> std::size_t
+  {
+    if ( name == base ) return num_dims;
+    for ( std::size_t k=0; k<num_dims; ++k )
+      if ( name == base + "_" + std::to_string(k) ) return k;
+    return num_dims + 1;
+  };
+
+  for ( const auto & name : extracts.field_names() ) {
+    if ( name == "cell_density" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_pressure" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_pressure, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_internal_energy" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_temperature" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_temperature, storage_real_t, dense, 0 ); 
+      } );
+    else if ( name == "cell_sound_speed" )
+      add_scalar( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_sound_speed, storage_real_t, dense, 0 ); 
+      } );
+    else if ( component( name, "cell_velocity" ) <= num_dims )
+      add_vector( name, [&mesh]() { 
+        return flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 ); 
+      }, component( name, "cell_velocity" ) );
+    else
+      raise_runtime_error( "Unknown extract field \"" << name << "\"" );
+  }
+
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief Output the solution
 //!
@@ -911,10 +1375,11 @@ int output( T & mesh,
   std::stringstream ss;
   ss << prefix;
   ss << std::setw( 7 ) << std::setfill( '0' ) << cnt++;
-  ss << "."+postfix;
   
+  // each rank writes its own piece, which are tied together by an index
   cout << endl;
-  mesh::write_mesh( ss.str(), mesh );
+  mesh::write_mesh( mesh::rank_file_name( ss.str(), postfix ), mesh );
+  mesh::write_index( ss.str(), postfix );
   cout << endl;
   
   return 0;
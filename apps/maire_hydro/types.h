@@ -162,6 +162,7 @@ public:
   
   //! some type aliases
   using real_t = typename M::real_t;
+  using storage_real_t = typename M::storage_real_t;
   using vector_t = typename M::vector_t;
 
   //! \brief determine the type of accessor
@@ -179,8 +180,8 @@ public:
     v( flecsi_get_accessor( mesh, hydro, cell_velocity, vector_t, dense, 0 ) ),
     d( flecsi_get_accessor( mesh, hydro, cell_density, real_t, dense, 0 ) ),
     e( flecsi_get_accessor( mesh, hydro, cell_internal_energy, real_t, dense, 0 ) ),
-    t( flecsi_get_accessor( mesh, hydro, cell_temperature, real_t, dense, 0 ) ),
-    a( flecsi_get_accessor( mesh, hydro, cell_sound_speed, real_t, dense, 0 ) )
+    t( flecsi_get_accessor( mesh, hydro, cell_temperature, storage_real_t, dense, 0 ) ),
+    a( flecsi_get_accessor( mesh, hydro, cell_sound_speed, storage_real_t, dense, 0 ) )
   {}
 
   //! \brief main accessor
@@ -232,8 +233,8 @@ private:
   accessor_t<vector_t> v;
   accessor_t<real_t>   d;
   accessor_t<real_t>   e;
-  accessor_t<real_t>   t;
-  accessor_t<real_t>   a;
+  accessor_t<storage_real_t> t;
+  accessor_t<storage_real_t> a;
        
 };
 
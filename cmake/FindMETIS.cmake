@@ -0,0 +1,25 @@
+#------------------------------------------------------------------------------#
+# Copyright (c) 2016 Los Alamos National Security, LLC
+# All rights reserved.
+#------------------------------------------------------------------------------#
+
+# - Find metis
+# Find the native METIS headers and libraries.
+#
+#  METIS_INCLUDE_DIRS - where to find metis.h, etc.
+#  METIS_LIBRARIES    - List of libraries when using metis.
+#  METIS_FOUND        - True if metis found.
+
+find_path(METIS_INCLUDE_DIR metis.h)
+
+find_library(METIS_LIBRARY NAMES metis)
+
+set(METIS_LIBRARIES ${METIS_LIBRARY} )
+set(METIS_INCLUDE_DIRS ${METIS_INCLUDE_DIR} )
+
+include(FindPackageHandleStandardArgs)
+# handle the QUIETLY and REQUIRED arguments and set METIS_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(METIS DEFAULT_MSG METIS_LIBRARY METIS_INCLUDE_DIR )
+
+mark_as_advanced(METIS_INCLUDE_DIR METIS_LIBRARY)
@@ -31,6 +31,15 @@ using real_t = double;
 using real_t = float;
 #endif
 
+//! real precision type used to store fields that can tolerate less
+//! precision, like derived or output-only quantities.  Arithmetic on these
+//! is still carried out in real_t.
+#if defined(DOUBLE_PRECISION) && defined(USE_MIXED_PRECISION)
+using storage_real_t = float;
+#else
+using storage_real_t = real_t;
+#endif
+
 //! type of integer ids to use
 #ifdef USE_64BIT_IDS
 using index_t = uint64_t;
@@ -38,6 +47,13 @@ using index_t = uint64_t;
 using index_t = uint32_t;
 #endif
 
+//! type of integer ids local to a process, used by the graph, ghost list
+//! and output buffers built in this library
+using local_index_t = index_t;
+
+//! type of integer ids that are unique across all processes
+using global_index_t = uint64_t;
+
 //! type of integer data to use
 #ifdef DOUBLE_PRECISION
 using integer_t = int64_t;
@@ -25,7 +25,7 @@ namespace eos {
 //! \brief Ideal gas specialization of the equation of state
 ////////////////////////////////////////////////////////////////////////////////
 template <typename T>
-class ideal_gas_t : public eos_base_t<T> {
+class ideal_gas_t final : public eos_base_t<T> {
 
   using base_t = eos_base_t<T>;
   using real_t = typename base_t::real_t;
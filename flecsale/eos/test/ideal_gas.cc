@@ -13,11 +13,13 @@
 // system includes
 #include <cinchtest.h>
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
 // user includes
 #include "flecsale/common/types.h"
 #include "flecsale/eos/ideal_gas.h"
+#include "flecsale/eos/visit.h"
 #include "flecsale/utils/tasks.h"
 
 
@@ -82,3 +84,23 @@ TEST(eos, ideal_gas) {
 } // TEST_F
 
 
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test recovering the concrete type of an equation of state.
+///////////////////////////////////////////////////////////////////////////////
+TEST(eos, visit) {
+
+  ideal_gas_t<real_t> ideal( 1.4, 2.0 );
+  const eos_base_t<real_t> & eos = ideal;
+
+  auto is_ideal = visit( eos, []( const auto & e ) {
+    return std::is_same< std::decay_t<decltype(e)>, ideal_gas_t<real_t> >::value;
+  } );
+  ASSERT_TRUE( is_ideal );
+
+  auto p = visit( eos, []( const auto & e ) { 
+    return e.compute_pressure_de( 2.0, 3.0 ); 
+  } );
+  ASSERT_NEAR( 0.4 * 2.0 * 3.0, p, test_tolerance );
+
+}
@@ -0,0 +1,46 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+/// 
+/// \brief Recover the concrete type of an equation of state.
+///
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "eos_base.h"
+#include "ideal_gas.h"
+
+// system includes
+#include <utility>
+
+namespace flecsale {
+namespace eos {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Call a function with the concrete type of an equation of state.
+//!
+//! Calls through eos_base_t are virtual, so a loop over cells that uses it
+//! pays for a dispatch per cell and cannot be vectorized.  Visiting the 
+//! equation of state once outside the loop lets the loop body be 
+//! instantiated for the concrete, final type instead.  Unknown types are
+//! passed on as eos_base_t.
+//!
+//! \param [in] eos  The equation of state.
+//! \param [in] f  The function to call with the concrete type.
+//! \return The result of \e f.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+decltype(auto) visit( const eos_base_t<T> & eos, F && f )
+{
+  if ( auto ig = dynamic_cast< const ideal_gas_t<T> * >( &eos ) )
+    return std::forward<F>(f)( *ig );
+  return std::forward<F>(f)( eos );
+}
+
+} // namespace
+} // namespace
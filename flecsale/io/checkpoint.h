@@ -0,0 +1,638 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Checkpoint files that hold the complete state of a solver.
+///
+/// A checkpoint is a single binary file made up of a header, a table of
+/// named sections, and the section data.  Every section starts on a 64 byte
+/// boundary, so a restart can map the file into memory and copy each
+/// section straight into its field.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// user includes
+#include "flecsale/mesh/distributed.h"
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace io {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The on-disk layout of a checkpoint.
+////////////////////////////////////////////////////////////////////////////////
+namespace checkpoint_format {
+
+//! \brief The identifying string at the start of every file.
+constexpr char magic[8] = { 'F', 'L', 'E', 'C', 'S', 'C', 'K', 'P' };
+
+//! \brief The version of the layout.
+constexpr std::uint32_t version = 1;
+
+//! \brief The alignment of the sections.
+constexpr std::size_t alignment = 64;
+
+//! \brief The maximum length of a section name.
+constexpr std::size_t max_name_length = 47;
+
+//! \brief The file header.
+struct header_t {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t num_sections;
+  std::uint64_t data_offset;
+  std::uint64_t file_size;
+};
+
+//! \brief One entry of the section table.
+struct section_t {
+  char name[max_name_length+1];
+  std::uint64_t offset;
+  std::uint64_t bytes;
+};
+
+//! \brief Round a size up to the section alignment.
+constexpr std::size_t aligned( std::size_t bytes )
+{ return ( bytes + alignment - 1 ) / alignment * alignment; }
+
+} // namespace checkpoint_format
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the name of the checkpoint file of this rank.
+//!
+//! \param [in] name  The checkpoint name, with or without the ".bin"
+//!                   extension.
+//! \return The file name, with the rank number if there are several ranks.
+////////////////////////////////////////////////////////////////////////////////
+inline std::string checkpoint_file_name( std::string name )
+{
+  const std::string ext = ".bin";
+  if ( name.size() > ext.size() && 
+       name.compare( name.size()-ext.size(), ext.size(), ext ) == 0 )
+    name.erase( name.size()-ext.size() );
+  return mesh::rank_file_name( name, "bin" );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Writes checkpoint files.
+//!
+//! The sections are copied into a staging buffer as they are added.  When
+//! the checkpoint is committed, the buffer is handed to a background thread
+//! that writes it to a temporary file and renames it into place, so the
+//! solver only waits for the copies.  A file that is found on disk is
+//! therefore always complete.  The background thread times each write, 
+//! including the sync to disk, so callers can budget for the next one.
+//!
+//! \code
+//!   checkpoint_writer_t writer;
+//!   writer.add_field( "density", mesh.cells(), density );
+//!   writer.add_value( "cfl", *cfl );
+//!   writer.commit( "case-chk0000100.bin" );
+//! \endcode
+////////////////////////////////////////////////////////////////////////////////
+class checkpoint_writer_t {
+
+public:
+
+  //! \brief Default constructor.
+  checkpoint_writer_t() = default;
+
+  //! \brief Destructor.  Waits for an outstanding write.
+  ~checkpoint_writer_t()
+  {
+    try { wait(); }
+    catch (...) {}
+  }
+
+  //! \brief Disallow copying.
+  //! \{
+  checkpoint_writer_t( const checkpoint_writer_t & ) = delete;
+  checkpoint_writer_t & operator=( const checkpoint_writer_t & ) = delete;
+  //! \}
+
+  //! \brief Add a section of raw bytes.
+  //! \param [in] name  The section name.
+  //! \param [in] data  The data to copy.
+  //! \param [in] bytes  The number of bytes to copy.
+  void add_bytes( const std::string & name, const void * data, std::size_t bytes )
+  {
+    auto pos = reserve( name, bytes );
+    if ( bytes > 0 ) std::memcpy( pos, data, bytes );
+  }
+
+  //! \brief Add a section holding a single value.
+  //! \param [in] name  The section name.
+  //! \param [in] value  The value to copy.
+  template< typename T >
+  void add_value( const std::string & name, const T & value )
+  {
+    static_assert( std::is_trivially_copyable<T>::value,
+      "checkpoint values must be trivially copyable" );
+    add_bytes( name, &value, sizeof(T) );
+  }
+
+  //! \brief Add a section holding a list of values.
+  //! \param [in] name  The section name.
+  //! \param [in] values  The values to copy.
+  template< typename T >
+  void add_values( const std::string & name, const std::vector<T> & values )
+  {
+    static_assert( std::is_trivially_copyable<T>::value,
+      "checkpoint values must be trivially copyable" );
+    add_bytes( name, values.data(), values.size()*sizeof(T) );
+  }
+
+  //! \brief Add a section holding the values of a field.
+  //!
+  //! The field must be indexable by the entities and store trivially
+  //! copyable values.
+  //!
+  //! \param [in] name  The section name.
+  //! \param [in] ents  The entities to copy the values of.
+  //! \param [in] field  The field.
+  template< typename E, typename A >
+  void add_field( const std::string & name, const E & ents, const A & field )
+  {
+    using value_t = std::decay_t<decltype(field[ents[0]])>;
+    static_assert( std::is_trivially_copyable<value_t>::value,
+      "checkpoint values must be trivially copyable" );
+
+    using counter_t = std::make_signed_t< decltype(ents.size()) >;
+    counter_t num_ents = ents.size();
+    auto pos = reserve( name, num_ents*sizeof(value_t) );
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_ents; ++i ) {
+      const value_t & val = field[ ents[i] ];
+      std::memcpy( pos + i*sizeof(value_t), &val, sizeof(value_t) );
+    }
+  }
+
+  //! \brief Write the staged sections to a file.
+  //!
+  //! This returns as soon as the write has been started.  The previous
+  //! write, if any, is finished first.
+  //!
+  //! \param [in] filename  The name of the file to write.
+  void commit( const std::string & filename )
+  {
+    wait();
+    pending_ = std::async( std::launch::async,
+      [ filename, sections = std::move(sections_), data = std::move(data_) ]()
+      { 
+        using clock_t = std::chrono::steady_clock;
+        auto start = clock_t::now();
+        write( filename, sections, data ); 
+        return std::chrono::duration<double>( clock_t::now() - start ).count();
+      }
+    );
+    sections_.clear();
+    data_.clear();
+  }
+
+  //! \brief Wait for the outstanding write to finish.
+  //!
+  //! Any error raised while writing is rethrown here.
+  void wait()
+  {
+    if ( pending_.valid() ) last_write_seconds_ = pending_.get();
+  }
+
+  //! \brief Return how long the last finished write took.
+  //!
+  //! This does not block.  A write that is still running is not counted
+  //! until it finishes.
+  //!
+  //! \return The wall time of the write in seconds, or zero if no write has
+  //!   finished yet.
+  double last_write_seconds()
+  {
+    if ( pending_.valid() && 
+         pending_.wait_for( std::chrono::seconds(0) ) == std::future_status::ready )
+      wait();
+    return last_write_seconds_;
+  }
+
+private:
+
+  //! \brief Make room for a new section.
+  //! \param [in] name  The section name.
+  //! \param [in] bytes  The size of the section.
+  //! \return A pointer to the storage of the section.
+  char * reserve( const std::string & name, std::size_t bytes )
+  {
+    if ( name.size() > checkpoint_format::max_name_length )
+      raise_runtime_error( "Checkpoint section name \"" << name
+        << "\" is too long" );
+    for ( const auto & s : sections_ )
+      if ( name == s.name )
+        raise_runtime_error( "Duplicate checkpoint section \"" << name << "\"" );
+
+    checkpoint_format::section_t s{};
+    name.copy( s.name, name.size() );
+    s.offset = checkpoint_format::aligned( data_.size() );
+    s.bytes = bytes;
+    sections_.emplace_back( s );
+
+    data_.resize( s.offset + bytes );
+    return data_.data() + s.offset;
+  }
+
+  //! \brief Write a set of sections to a file.
+  //!
+  //! The data goes to a temporary file first, which is renamed once it is
+  //! safely on disk.
+  //!
+  //! \param [in] filename  The name of the file to write.
+  //! \param [in] sections  The section table, with offsets into \a data.
+  //! \param [in] data  The section data.
+  static void write(
+    const std::string & filename,
+    std::vector<checkpoint_format::section_t> sections,
+    const std::vector<char> & data
+  ) {
+    using namespace checkpoint_format;
+
+    auto table_bytes = sizeof(header_t) + sections.size()*sizeof(section_t);
+    auto data_offset = aligned( table_bytes );
+
+    header_t header{};
+    std::copy( std::begin(magic), std::end(magic), header.magic );
+    header.version = version;
+    header.num_sections = sections.size();
+    header.data_offset = data_offset;
+    header.file_size = data_offset + data.size();
+
+    // the offsets in the file are from its beginning
+    for ( auto & s : sections ) s.offset += data_offset;
+
+    std::vector<char> head( data_offset, 0 );
+    std::memcpy( head.data(), &header, sizeof(header_t) );
+    std::memcpy(
+      head.data() + sizeof(header_t), sections.data(),
+      sections.size()*sizeof(section_t)
+    );
+
+    auto tmp_name = filename + ".tmp";
+    auto fd = ::open( tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 )
+      raise_runtime_error( "Could not open checkpoint file \"" << tmp_name
+        << "\": " << std::strerror(errno) );
+
+    auto write_all = [&]( const char * pos, std::size_t bytes ) {
+      while ( bytes > 0 ) {
+        auto n = ::write( fd, pos, bytes );
+        if ( n < 0 && errno == EINTR ) continue;
+        if ( n <= 0 ) {
+          auto err = errno;
+          ::close( fd );
+          raise_runtime_error( "Could not write checkpoint file \""
+            << tmp_name << "\": " << std::strerror(err) );
+        }
+        pos += n;
+        bytes -= n;
+      }
+    };
+    write_all( head.data(), head.size() );
+    write_all( data.data(), data.size() );
+
+    if ( ::fsync( fd ) != 0 || ::close( fd ) != 0 )
+      raise_runtime_error( "Could not flush checkpoint file \"" << tmp_name
+        << "\": " << std::strerror(errno) );
+
+    if ( std::rename( tmp_name.c_str(), filename.c_str() ) != 0 )
+      raise_runtime_error( "Could not rename \"" << tmp_name << "\" to \""
+        << filename << "\": " << std::strerror(errno) );
+  }
+
+  //! \brief the staged section table
+  std::vector<checkpoint_format::section_t> sections_;
+  //! \brief the staged section data
+  std::vector<char> data_;
+  //! \brief the outstanding write, which returns how long it took
+  std::future<double> pending_;
+  //! \brief the wall time of the last finished write
+  double last_write_seconds_ = 0;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Reads checkpoint files.
+//!
+//! The file is mapped into memory for the lifetime of the reader, and the
+//! sections are copied out of the mapping.
+////////////////////////////////////////////////////////////////////////////////
+class checkpoint_reader_t {
+
+public:
+
+  //! \brief Main constructor.
+  //! \param [in] filename  The name of the file to read.
+  explicit checkpoint_reader_t( const std::string & filename )
+    : filename_( filename )
+  {
+    using namespace checkpoint_format;
+
+    auto fd = ::open( filename.c_str(), O_RDONLY );
+    if ( fd < 0 )
+      raise_runtime_error( "Could not open checkpoint file \"" << filename
+        << "\": " << std::strerror(errno) );
+
+    struct stat st;
+    if ( ::fstat( fd, &st ) != 0 || st.st_size <
+      static_cast<off_t>( sizeof(header_t) ) )
+    {
+      ::close( fd );
+      raise_runtime_error( "\"" << filename << "\" is not a checkpoint file" );
+    }
+    size_ = st.st_size;
+
+    auto addr = ::mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if ( addr == MAP_FAILED )
+      raise_runtime_error( "Could not map checkpoint file \"" << filename
+        << "\": " << std::strerror(errno) );
+    data_ = static_cast<const char *>( addr );
+
+    // check the header
+    header_t header;
+    std::memcpy( &header, data_, sizeof(header_t) );
+    if ( !std::equal( std::begin(magic), std::end(magic), header.magic ) ) {
+      unmap();
+      raise_runtime_error( "\"" << filename << "\" is not a checkpoint file" );
+    }
+    if ( header.version != version ) {
+      unmap();
+      raise_runtime_error( "Checkpoint file \"" << filename
+        << "\" has version " << header.version << ", expected " << version );
+    }
+    auto table_end =
+      sizeof(header_t) + header.num_sections * sizeof(section_t);
+    if ( header.file_size != size_ || table_end > size_ ) {
+      unmap();
+      raise_runtime_error( "Checkpoint file \"" << filename
+        << "\" is truncated" );
+    }
+
+    // index the sections
+    for ( std::size_t i=0; i<header.num_sections; ++i ) {
+      section_t s;
+      std::memcpy(
+        &s, data_ + sizeof(header_t) + i*sizeof(section_t), sizeof(section_t)
+      );
+      s.name[max_name_length] = '\0';
+      if ( s.offset + s.bytes > size_ ) {
+        unmap();
+        raise_runtime_error( "Checkpoint file \"" << filename
+          << "\" is truncated" );
+      }
+      sections_.emplace( s.name, s );
+    }
+  }
+
+  //! \brief Destructor.  Unmaps the file.
+  ~checkpoint_reader_t()
+  { unmap(); }
+
+  //! \brief Disallow copying.
+  //! \{
+  checkpoint_reader_t( const checkpoint_reader_t & ) = delete;
+  checkpoint_reader_t & operator=( const checkpoint_reader_t & ) = delete;
+  //! \}
+
+  //! \brief Check if a section is present.
+  //! \param [in] name  The section name.
+  bool has( const std::string & name ) const
+  { return sections_.count( name ); }
+
+  //! \brief Return the size of a section in bytes.
+  //! \param [in] name  The section name.
+  std::size_t bytes( const std::string & name ) const
+  { return section( name ).bytes; }
+
+  //! \brief Return the mapped data of a section.
+  //! \param [in] name  The section name.
+  const char * data( const std::string & name ) const
+  { return data_ + section( name ).offset; }
+
+  //! \brief Read a section holding a single value.
+  //! \param [in] name  The section name.
+  //! \return The stored value.
+  template< typename T >
+  T read_value( const std::string & name ) const
+  {
+    static_assert( std::is_trivially_copyable<T>::value,
+      "checkpoint values must be trivially copyable" );
+    check_size( name, sizeof(T) );
+    T value;
+    std::memcpy( &value, data( name ), sizeof(T) );
+    return value;
+  }
+
+  //! \brief Read a section holding a list of values.
+  //! \param [in] name  The section name.
+  //! \return The stored values.
+  template< typename T >
+  std::vector<T> read_values( const std::string & name ) const
+  {
+    static_assert( std::is_trivially_copyable<T>::value,
+      "checkpoint values must be trivially copyable" );
+    auto n = bytes( name ) / sizeof(T);
+    check_size( name, n*sizeof(T) );
+    std::vector<T> values( n );
+    if ( n > 0 ) std::memcpy( values.data(), data( name ), n*sizeof(T) );
+    return values;
+  }
+
+  //! \brief Read a section into a field.
+  //! \param [in] name  The section name.
+  //! \param [in] ents  The entities to set the values of.
+  //! \param [in,out] field  The field.
+  template< typename E, typename A >
+  void read_field( const std::string & name, const E & ents, A & field ) const
+  {
+    using value_t = std::decay_t<decltype(field[ents[0]])>;
+    static_assert( std::is_trivially_copyable<value_t>::value,
+      "checkpoint values must be trivially copyable" );
+
+    using counter_t = std::make_signed_t< decltype(ents.size()) >;
+    counter_t num_ents = ents.size();
+    check_size( name, num_ents*sizeof(value_t) );
+    auto pos = data( name );
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_ents; ++i ) {
+      value_t & val = field[ ents[i] ];
+      std::memcpy( &val, pos + i*sizeof(value_t), sizeof(value_t) );
+    }
+  }
+
+private:
+
+  //! \brief Look up a section.
+  //! \param [in] name  The section name.
+  const checkpoint_format::section_t & section( const std::string & name ) const
+  {
+    auto it = sections_.find( name );
+    if ( it == sections_.end() )
+      raise_runtime_error( "Checkpoint file \"" << filename_
+        << "\" has no section \"" << name << "\"" );
+    return it->second;
+  }
+
+  //! \brief Make sure a section has the expected size.
+  //! \param [in] name  The section name.
+  //! \param [in] expected  The expected number of bytes.
+  void check_size( const std::string & name, std::size_t expected ) const
+  {
+    auto actual = bytes( name );
+    if ( actual != expected )
+      raise_runtime_error( "Checkpoint section \"" << name << "\" has "
+        << actual << " bytes, expected " << expected );
+  }
+
+  //! \brief Unmap the file.
+  void unmap()
+  {
+    if ( data_ ) ::munmap( const_cast<char *>( data_ ), size_ );
+    data_ = nullptr;
+  }
+
+  //! \brief the file name, for error messages
+  std::string filename_;
+  //! \brief the mapped file
+  const char * data_ = nullptr;
+  //! \brief the size of the mapping
+  std::size_t size_ = 0;
+  //! \brief the section table
+  std::unordered_map<std::string, checkpoint_format::section_t> sections_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Add the state of a mesh to a checkpoint.
+//!
+//! This stores the entity counts, the solution time and step counter, the
+//! vertex coordinates, the cell regions and the boundary tags of the faces.
+//! The connectivity itself is not stored, a restart rebuilds it.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in,out] writer  The checkpoint writer.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void add_mesh_state( const M & mesh, checkpoint_writer_t & writer )
+{
+  using real_t = typename M::real_t;
+  constexpr auto num_dims = M::num_dimensions;
+
+  std::vector<std::uint64_t> counts = {
+    num_dims, sizeof(real_t), mesh.num_cells(), mesh.num_faces(),
+    mesh.num_vertices(), mesh.num_regions(), mesh.num_boundaries()
+  };
+  writer.add_values( "mesh.counts", counts );
+  writer.add_value( "mesh.time", static_cast<real_t>( mesh.time() ) );
+  writer.add_value( "mesh.step",
+    static_cast<std::uint64_t>( mesh.time_step_counter() ) );
+
+  // the vertices move in lagrangian schemes
+  auto vs = mesh.vertices();
+  std::vector<real_t> coords( num_dims * vs.size() );
+  for ( std::size_t i=0; i<vs.size(); ++i ) {
+    const auto & x = vs[i]->coordinates();
+    for ( std::size_t d=0; d<num_dims; ++d ) coords[ i*num_dims + d ] = x[d];
+  }
+  writer.add_values( "mesh.coordinates", coords );
+
+  auto cs = mesh.cells();
+  std::vector<std::uint64_t> regions( cs.size() );
+  for ( std::size_t i=0; i<cs.size(); ++i ) regions[i] = cs[i]->region();
+  writer.add_values( "mesh.regions", regions );
+
+  // the tags of each face, prefixed by their number
+  std::vector<std::uint8_t> tags;
+  for ( auto f : mesh.faces() ) {
+    const auto & ts = f->tags();
+    tags.emplace_back( ts.size() );
+    tags.insert( tags.end(), ts.begin(), ts.end() );
+  }
+  writer.add_values( "mesh.face_tags", tags );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Restore the state of a mesh from a checkpoint.
+//!
+//! The mesh must have been rebuilt the same way as the one that was saved,
+//! which is checked against the stored counts and boundary tags.
+//!
+//! \param [in] reader  The checkpoint reader.
+//! \param [in,out] mesh  The mesh.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void restore_mesh_state( const checkpoint_reader_t & reader, M & mesh )
+{
+  using real_t = typename M::real_t;
+  using size_t = typename M::size_t;
+  constexpr auto num_dims = M::num_dimensions;
+
+  std::vector<std::uint64_t> counts = {
+    num_dims, sizeof(real_t), mesh.num_cells(), mesh.num_faces(),
+    mesh.num_vertices(), mesh.num_regions(), mesh.num_boundaries()
+  };
+  if ( reader.read_values<std::uint64_t>( "mesh.counts" ) != counts )
+    raise_runtime_error( "The checkpoint was written for a different mesh" );
+
+  // the boundary tags come from the rebuilt mesh, they just have to agree
+  std::vector<std::uint8_t> tags;
+  for ( auto f : mesh.faces() ) {
+    const auto & ts = f->tags();
+    tags.emplace_back( ts.size() );
+    tags.insert( tags.end(), ts.begin(), ts.end() );
+  }
+  if ( reader.read_values<std::uint8_t>( "mesh.face_tags" ) != tags )
+    raise_runtime_error(
+      "The boundary tags of the checkpoint do not match the mesh"
+    );
+
+  auto vs = mesh.vertices();
+  auto coords = reader.read_values<real_t>( "mesh.coordinates" );
+  for ( std::size_t i=0; i<vs.size(); ++i ) {
+    auto & x = vs[i]->coordinates();
+    for ( std::size_t d=0; d<num_dims; ++d ) x[d] = coords[ i*num_dims + d ];
+  }
+
+  auto cs = mesh.cells();
+  auto regions = reader.read_values<std::uint64_t>( "mesh.regions" );
+  for ( std::size_t i=0; i<cs.size(); ++i )
+    cs[i]->region() = static_cast<size_t>( regions[i] );
+  mesh.index_regions();
+
+  mesh.set_time( reader.read_value<real_t>( "mesh.time" ) );
+  auto step = reader.read_value<std::uint64_t>( "mesh.step" );
+  mesh.increment_time_step_counter( step - mesh.time_step_counter() );
+
+  mesh.update_geometry();
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,754 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+///
+/// \brief Small in-situ data products: slices, line-outs, histograms and
+///        region statistics.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/mesh/distributed.h"
+#include "flecsale/mesh/search.h"
+#include "flecsale/utils/errors.h"
+#include "flecsale/utils/mpi_utils.h"
+#include "flecsale/utils/reduction.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace flecsale {
+namespace io {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The kinds of extracts.
+////////////////////////////////////////////////////////////////////////////////
+enum class extract_type_t {
+  //! The cells cut by a plane.
+  slice,
+  //! Evenly spaced samples along a line segment.
+  lineout,
+  //! The distribution of the field values.
+  histogram,
+  //! The volume, min, max and mean of each mesh region.
+  regions
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Convert the name of an extract type to its enum.
+//! \param [in] name  One of "slice", "lineout", "histogram" or "regions".
+//! \return The extract type.
+////////////////////////////////////////////////////////////////////////////////
+inline extract_type_t extract_type_from_string( const std::string & name )
+{
+  if ( name == "slice" )
+    return extract_type_t::slice;
+  else if ( name == "lineout" )
+    return extract_type_t::lineout;
+  else if ( name == "histogram" )
+    return extract_type_t::histogram;
+  else if ( name != "regions" )
+    raise_runtime_error( "Unknown extract type \"" << name << "\"" );
+  return extract_type_t::regions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The parameters of a single extract.
+//!
+//! Only the members used by the chosen type need to be set.
+//!
+//! \tparam T  The real type.
+//! \tparam N  The number of dimensions.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t N >
+struct extract_spec_t {
+
+  //! \brief the kind of extract
+  extract_type_t type = extract_type_t::regions;
+  //! \brief the number of time steps between extracts
+  std::size_t frequency = 1;
+  //! \brief the fields to extract
+  std::vector<std::string> fields;
+
+  //! \brief a point on the slice plane, and the plane normal
+  //! \{
+  std::array<T, N> origin = {{}};
+  std::array<T, N> normal = {{}};
+  //! \}
+
+  //! \brief the end points of a line-out, and the number of samples
+  //! \{
+  std::array<T, N> from = {{}};
+  std::array<T, N> to = {{}};
+  std::size_t num_points = 100;
+  //! \}
+
+  //! \brief the number of histogram bins and their range.  The range of the
+  //! data is used when \e min is not less than \e max.
+  //! \{
+  std::size_t num_bins = 20;
+  T min = 0;
+  T max = 0;
+  //! \}
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A histogram of a cell field.
+//! \tparam T  The real type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct histogram_t {
+
+  //! \brief the range covered by the bins
+  //! \{
+  T min = 0;
+  T max = 0;
+  //! \}
+
+  //! \brief the number of cells in each bin
+  std::vector<std::size_t> counts;
+  //! \brief the volume of the cells in each bin
+  std::vector<T> volumes;
+
+  //! \brief Return the lower edge of bin \e b.
+  T bin_min( std::size_t b ) const
+  { return min + (max - min) * b / counts.size(); }
+
+  //! \brief Add another histogram with the same bins.
+  histogram_t & operator+=( const histogram_t & other )
+  {
+    for ( std::size_t b=0; b<counts.size(); ++b ) {
+      counts[b] += other.counts[b];
+      volumes[b] += other.volumes[b];
+    }
+    return *this;
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The statistics of a cell field over a set of cells.
+//! \tparam T  The real type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct region_stats_t {
+
+  //! \brief the total volume
+  T volume = 0;
+  //! \brief the volume integral of the field
+  T integral = 0;
+  //! \brief the extreme values
+  //! \{
+  T min = std::numeric_limits<T>::max();
+  T max = std::numeric_limits<T>::lowest();
+  //! \}
+
+  //! \brief Return the volume weighted mean.
+  T mean() const
+  { return volume > 0 ? integral / volume : 0; }
+
+  //! \brief Combine with the statistics of another set of cells.
+  region_stats_t & operator+=( const region_stats_t & other )
+  {
+    volume += other.volume;
+    integral += other.integral;
+    min = std::min( min, other.min );
+    max = std::max( max, other.max );
+    return *this;
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Find the owned cells cut by a plane.
+//!
+//! A cell is cut if it has a vertex strictly below the plane and one on or
+//! above it, so a plane that lies on a face only picks the cells below it.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] origin  A point on the plane.
+//! \param [in] normal  The plane normal.
+//! \return The ids of the cut cells, in increasing order.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename P, typename V >
+std::vector<std::size_t> slice_cells(
+  const M & mesh, const P & origin, const V & normal
+) {
+  using counter_t = typename M::counter_t;
+  using real_t = typename M::real_t;
+  constexpr auto num_dims = M::num_dimensions;
+
+  auto cs = mesh.cells();
+  counter_t num_owned = mesh.num_owned_cells();
+  std::vector<char> cut( num_owned, 0 );
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_owned; ++i ) {
+    bool below = false, above = false;
+    for ( auto v : mesh.vertices( cs[i] ) ) {
+      const auto & x = v->coordinates();
+      real_t dist = 0;
+      for ( std::size_t d=0; d<num_dims; ++d )
+        dist += ( x[d] - origin[d] ) * normal[d];
+      below = below || dist < 0;
+      above = above || dist >= 0;
+    }
+    cut[i] = below && above;
+  }
+
+  std::vector<std::size_t> ids;
+  for ( counter_t i=0; i<num_owned; ++i )
+    if ( cut[i] ) ids.emplace_back( i );
+  return ids;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return evenly spaced points along a line segment.
+//! \param [in] from,to  The end points.
+//! \param [in] n  The number of points, including both ends.
+//! \return The points.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, std::size_t N >
+std::vector< std::array<T, N> > lineout_points(
+  const std::array<T, N> & from, const std::array<T, N> & to, std::size_t n
+) {
+  std::vector< std::array<T, N> > xs( n, from );
+  for ( std::size_t i=1; i<n; ++i ) {
+    T s = static_cast<T>(i) / (n - 1);
+    for ( std::size_t d=0; d<N; ++d )
+      xs[i][d] = from[d] + s * ( to[d] - from[d] );
+  }
+  return xs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Bin the values of a cell field over all ranks.
+//!
+//! Only owned cells are counted, and values outside the range go in the
+//! end bins.  The sums are independent of the number of threads.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] values  One value per cell.
+//! \param [in] num_bins  The number of bins.
+//! \param [in] min,max  The range of the bins.  If \e min is not less than
+//!                      \e max, the range of the values is used.
+//! \return The histogram.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename V >
+auto compute_histogram(
+  const M & mesh,
+  const V & values,
+  std::size_t num_bins,
+  typename M::real_t min,
+  typename M::real_t max
+) {
+  using counter_t = typename M::counter_t;
+  using real_t = typename M::real_t;
+
+  auto cs = mesh.cells();
+  auto vol = mesh.cell_volumes();
+  counter_t num_owned = mesh.num_owned_cells();
+
+  // use the range of the data
+  if ( !( min < max ) ) {
+    min = std::numeric_limits<real_t>::max();
+    max = std::numeric_limits<real_t>::lowest();
+    #pragma omp parallel for reduction(min: min) reduction(max: max)
+    for ( counter_t i=0; i<num_owned; ++i ) {
+      min = std::min( min, values[i] );
+      max = std::max( max, values[i] );
+    }
+    min = utils::global_min( min );
+    max = utils::global_max( max );
+  }
+
+  histogram_t<real_t> zero;
+  zero.min = min;
+  zero.max = max;
+  zero.counts.resize( num_bins, 0 );
+  zero.volumes.resize( num_bins, 0 );
+
+  auto width = ( max - min ) / num_bins;
+
+  // each block holds a whole histogram, so make sure the blocks are large
+  // enough to amortize that
+  auto block_size = std::max( utils::reduction_block_size, 16 * num_bins );
+
+  auto res = utils::reproducible_sum(
+    num_owned, zero,
+    [&]( auto i, auto & h ) {
+      std::size_t b = 0;
+      if ( width > 0 && values[i] > min )
+        b = std::min<std::size_t>( (values[i] - min) / width, num_bins-1 );
+      h.counts[b]++;
+      h.volumes[b] += vol[ cs[i] ];
+    },
+    block_size
+  );
+
+  utils::global_sum( res.counts.data(), num_bins );
+  utils::global_sum( res.volumes.data(), num_bins );
+
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Compute the statistics of a cell field in each mesh region.
+//!
+//! Only owned cells are counted, and the results are combined over all
+//! ranks.  The sums are independent of the number of threads.
+//!
+//! \param [in] mesh  The mesh.
+//! \param [in] values  One value per cell.
+//! \return The statistics of each region.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename V >
+auto compute_region_stats( const M & mesh, const V & values )
+{
+  using real_t = typename M::real_t;
+  using stats_t = region_stats_t<real_t>;
+
+  auto cs = mesh.cells();
+  auto vol = mesh.cell_volumes();
+  std::size_t num_owned = mesh.num_owned_cells();
+  auto num_regions = mesh.num_regions();
+
+  std::vector<stats_t> res( num_regions );
+
+  for ( std::size_t r=0; r<num_regions; ++r ) {
+    auto ids = mesh.region_cell_ids(r);
+    res[r] = utils::reproducible_sum(
+      ids.size(), stats_t(),
+      [&]( auto i, auto & s ) {
+        std::size_t id = ids[i];
+        if ( id >= num_owned ) return;
+        auto v = vol[ cs[id] ];
+        s.volume += v;
+        s.integral += v * values[id];
+        s.min = std::min( s.min, values[id] );
+        s.max = std::max( s.max, values[id] );
+      }
+    );
+  }
+
+  // combine over ranks
+  std::vector<real_t> sums( 2*num_regions ), mins( num_regions ),
+    maxs( num_regions );
+  for ( std::size_t r=0; r<num_regions; ++r ) {
+    sums[2*r] = res[r].volume;
+    sums[2*r+1] = res[r].integral;
+    mins[r] = res[r].min;
+    maxs[r] = res[r].max;
+  }
+  utils::global_sum( sums.data(), sums.size() );
+  utils::global_min( mins.data(), mins.size() );
+  utils::global_max( maxs.data(), maxs.size() );
+  for ( std::size_t r=0; r<num_regions; ++r ) {
+    res[r].volume = sums[2*r];
+    res[r].integral = sums[2*r+1];
+    res[r].min = mins[r];
+    res[r].max = maxs[r];
+  }
+
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Computes extracts inside the time stepping loop and writes them
+//!        as small text files.
+//!
+//! Each extract has its own frequency.  The fields are registered by name
+//! with add_field(), and each one is evaluated at most once per step, no
+//! matter how many extracts use it.  The files are named after the prefix,
+//! the extract type, its position in the list and the step, e.g.
+//! "sedov-slice0-0000100.csv".
+//!
+//!   - Slices write the cell centroid projected on the plane, and the field
+//!     values, of every owned cell cut by the plane.  Each rank writes its
+//!     own file.
+//!   - Line-outs write the distance along the line, the point and the
+//!     field values of every sample in an owned cell.  Each rank writes its
+//!     own file.
+//!   - Histograms write the bin edges, cell count and cell volume of each
+//!     bin for every field, from the first rank only.
+//!   - Region statistics are appended to a single file per extract, from
+//!     the first rank only, with a row per step, region and field.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+class extract_writer_t {
+
+public:
+
+  //============================================================================
+  // Typedefs
+  //============================================================================
+
+  //! \brief the mesh type
+  using mesh_t = M;
+
+  //! \brief the number of dimensions
+  static constexpr std::size_t num_dimensions = mesh_t::num_dimensions;
+
+  //! \brief the real type
+  using real_t = typename mesh_t::real_t;
+
+  //! \brief the loop counter type
+  using counter_t = typename mesh_t::counter_t;
+
+  //! \brief the extract parameters
+  using spec_t = extract_spec_t<real_t, num_dimensions>;
+
+  //! \brief Fills in one value per cell.
+  using field_function_t = std::function< void( std::vector<real_t> & ) >;
+
+  //============================================================================
+  // Construction
+  //============================================================================
+
+  //! \brief Constructor.
+  //! \param [in] mesh  The mesh.  It must outlive the writer.
+  //! \param [in] prefix  The prefix of the file names.
+  //! \param [in] specs  The extracts to compute.
+  extract_writer_t(
+    const mesh_t & mesh,
+    const std::string & prefix,
+    const std::vector<spec_t> & specs
+  ) : mesh_(&mesh), prefix_(prefix), specs_(specs),
+      region_files_( specs.size() )
+  {
+    for ( const auto & spec : specs_ ) {
+      if ( spec.frequency == 0 )
+        raise_runtime_error( "Extract frequency must be positive" );
+      if ( spec.fields.empty() )
+        raise_runtime_error( "No fields given for extract" );
+      if ( spec.type == extract_type_t::lineout && spec.num_points < 2 )
+        raise_runtime_error( "A line-out needs at least two points" );
+      if ( spec.type == extract_type_t::histogram && spec.num_bins == 0 )
+        raise_runtime_error( "A histogram needs at least one bin" );
+      if ( spec.type == extract_type_t::slice ) {
+        real_t len = 0;
+        for ( auto n : spec.normal ) len += n*n;
+        if ( len == 0 )
+          raise_runtime_error( "The slice normal is zero" );
+      }
+    }
+  }
+
+  //! \brief Return the names of all the fields needed, each one only once.
+  std::vector<std::string> field_names() const
+  {
+    std::vector<std::string> names;
+    for ( const auto & spec : specs_ )
+      for ( const auto & name : spec.fields )
+        if ( std::find( names.begin(), names.end(), name ) == names.end() )
+          names.emplace_back( name );
+    return names;
+  }
+
+  //! \brief Register a field.
+  //! \param [in] name  The name of the field.
+  //! \param [in] f  The function that fills in the values.
+  void add_field( const std::string & name, field_function_t f )
+  {
+    fields_[name] = std::move(f);
+  }
+
+  //! \brief Tell the writer that the cells were renumbered.
+  void reset()
+  {
+    search_.reset();
+  }
+
+  //============================================================================
+  // Output
+  //============================================================================
+
+  //! \brief Compute and write every extract that is due at this step.
+  //! \param [in] time  The solution time.
+  //! \param [in] step  The time step number.
+  void process( real_t time, std::size_t step )
+  {
+    values_.clear();
+    searched_ = false;
+
+    for ( std::size_t k=0; k<specs_.size(); ++k ) {
+      const auto & spec = specs_[k];
+      if ( step % spec.frequency != 0 ) continue;
+      switch ( spec.type ) {
+        case extract_type_t::slice:
+          write_slice( k, time, step );
+          break;
+        case extract_type_t::lineout:
+          write_lineout( k, time, step );
+          break;
+        case extract_type_t::histogram:
+          write_histogram( k, time, step );
+          break;
+        case extract_type_t::regions:
+          write_regions( k, time, step );
+          break;
+      }
+    }
+
+    // the values are not needed until the next step
+    values_.clear();
+  }
+
+private:
+
+  //============================================================================
+  // Private Member Functions
+  //============================================================================
+
+  //! \brief Return the values of a field, evaluating them if needed.
+  const std::vector<real_t> & values( const std::string & name )
+  {
+    auto it = values_.find( name );
+    if ( it != values_.end() ) return it->second;
+    auto f = fields_.find( name );
+    if ( f == fields_.end() )
+      raise_runtime_error( "No extract field named \"" << name << "\"" );
+    auto & vals = values_[name];
+    f->second( vals );
+    return vals;
+  }
+
+  //! \brief Return the base file name of an extract.
+  std::string base_name( std::size_t k, const char * type ) const
+  {
+    std::stringstream ss;
+    ss << prefix_ << "-" << type << k;
+    return ss.str();
+  }
+
+  //! \brief Return the base file name of an extract at a given step.
+  std::string base_name( std::size_t k, const char * type, std::size_t step )
+    const
+  {
+    std::stringstream ss;
+    ss << base_name( k, type ) << "-"
+       << std::setw( 7 ) << std::setfill( '0' ) << step;
+    return ss.str();
+  }
+
+  //! \brief Open a text file for writing.
+  static void open(
+    std::ofstream & file,
+    const std::string & filename,
+    std::ios::openmode mode = std::ios::out | std::ios::trunc
+  ) {
+    file.open( filename, mode );
+    if ( !file.good() )
+      raise_runtime_error( "Could not open extract file \"" << filename << "\"" );
+    file.precision( std::numeric_limits<double>::digits10 );
+  }
+
+  //! \brief Write the column names of the coordinates and fields.
+  void write_header(
+    std::ofstream & file,
+    const spec_t & spec,
+    const char * first,
+    real_t time,
+    std::size_t step
+  ) const {
+    static constexpr const char * axes[] = { "x", "y", "z" };
+    file << "# step " << step << ", time " << time << '\n';
+    if ( first ) file << first << ",";
+    for ( std::size_t d=0; d<num_dimensions; ++d )
+      file << axes[d] << ",";
+    for ( std::size_t f=0; f<spec.fields.size(); ++f )
+      file << ( f>0 ? "," : "" ) << spec.fields[f];
+    file << '\n';
+  }
+
+  //! \brief Write the cells cut by a plane.
+  void write_slice( std::size_t k, real_t time, std::size_t step )
+  {
+    const auto & spec = specs_[k];
+
+    // a unit normal
+    auto normal = spec.normal;
+    real_t len = 0;
+    for ( auto n : normal ) len += n*n;
+    len = std::sqrt( len );
+    for ( auto & n : normal ) n /= len;
+
+    auto ids = slice_cells( *mesh_, spec.origin, normal );
+    if ( ids.empty() ) return;
+
+    std::vector< const std::vector<real_t> * > vals;
+    for ( const auto & name : spec.fields )
+      vals.emplace_back( &values(name) );
+
+    std::ofstream file;
+    open( file, mesh::rank_file_name( base_name(k, "slice", step), "csv" ) );
+    write_header( file, spec, nullptr, time, step );
+
+    auto cs = mesh_->cells();
+    auto xc = mesh_->cell_centroids();
+    for ( auto id : ids ) {
+      // project the centroid on the plane
+      auto x = xc[ cs[id] ];
+      real_t dist = 0;
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        dist += ( x[d] - spec.origin[d] ) * normal[d];
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        file << x[d] - dist * normal[d] << ",";
+      for ( std::size_t f=0; f<vals.size(); ++f )
+        file << ( f>0 ? "," : "" ) << (*vals[f])[id];
+      file << '\n';
+    }
+  }
+
+  //! \brief Write the samples along a line.
+  void write_lineout( std::size_t k, real_t time, std::size_t step )
+  {
+    const auto & spec = specs_[k];
+
+    // the search tree only needs updating once per step
+    if ( !searched_ ) {
+      if ( !search_ || search_->num_cells() != mesh_->num_cells() )
+        search_ = std::make_unique< mesh::cell_search_t<mesh_t> >( *mesh_ );
+      else
+        search_->refit();
+      searched_ = true;
+    }
+
+    auto xs = lineout_points( spec.from, spec.to, spec.num_points );
+    std::vector<std::size_t> ids( xs.size() );
+    search_->find_cells( xs, ids );
+
+    std::size_t num_owned = mesh_->num_owned_cells();
+    if ( std::none_of( ids.begin(), ids.end(),
+      [=]( auto id ) { return id < num_owned; }
+    ) ) return;
+
+    std::vector< const std::vector<real_t> * > vals;
+    for ( const auto & name : spec.fields )
+      vals.emplace_back( &values(name) );
+
+    std::ofstream file;
+    open( file, mesh::rank_file_name( base_name(k, "lineout", step), "csv" ) );
+    write_header( file, spec, "distance", time, step );
+
+    for ( std::size_t i=0; i<xs.size(); ++i ) {
+      auto id = ids[i];
+      if ( id >= num_owned ) continue;
+      real_t dist = 0;
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        dist += std::pow( xs[i][d] - spec.from[d], 2 );
+      file << std::sqrt( dist ) << ",";
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        file << xs[i][d] << ",";
+      for ( std::size_t f=0; f<vals.size(); ++f )
+        file << ( f>0 ? "," : "" ) << (*vals[f])[id];
+      file << '\n';
+    }
+  }
+
+  //! \brief Write a histogram of each field.
+  void write_histogram( std::size_t k, real_t time, std::size_t step )
+  {
+    const auto & spec = specs_[k];
+
+    // every rank takes part in the reductions
+    std::vector< histogram_t<real_t> > hists;
+    for ( const auto & name : spec.fields )
+      hists.emplace_back(
+        compute_histogram(
+          *mesh_, values(name), spec.num_bins, spec.min, spec.max
+        )
+      );
+
+    if ( utils::comm_rank() != 0 ) return;
+
+    std::ofstream file;
+    open( file, base_name(k, "histogram", step) + ".csv" );
+    file << "# step " << step << ", time " << time << '\n';
+    file << "field,bin_min,bin_max,count,volume\n";
+    for ( std::size_t f=0; f<hists.size(); ++f ) {
+      const auto & h = hists[f];
+      for ( std::size_t b=0; b<h.counts.size(); ++b )
+        file << spec.fields[f] << "," << h.bin_min(b) << ","
+             << h.bin_min(b+1) << "," << h.counts[b] << ","
+             << h.volumes[b] << '\n';
+    }
+  }
+
+  //! \brief Append the region statistics of each field.
+  void write_regions( std::size_t k, real_t time, std::size_t step )
+  {
+    const auto & spec = specs_[k];
+
+    // every rank takes part in the reductions
+    std::vector< std::vector< region_stats_t<real_t> > > stats;
+    for ( const auto & name : spec.fields )
+      stats.emplace_back( compute_region_stats( *mesh_, values(name) ) );
+
+    if ( utils::comm_rank() != 0 ) return;
+
+    auto & file = region_files_[k];
+    if ( !file.is_open() ) {
+      open( file, base_name(k, "regions") + ".csv" );
+      file << "step,time,region,field,volume,min,max,mean\n";
+    }
+
+    for ( std::size_t f=0; f<stats.size(); ++f )
+      for ( std::size_t r=0; r<stats[f].size(); ++r ) {
+        const auto & s = stats[f][r];
+        // empty regions have no extreme values
+        auto empty = !( s.volume > 0 );
+        file << step << "," << time << "," << r << "," << spec.fields[f]
+             << "," << s.volume << "," << ( empty ? 0 : s.min ) << ","
+             << ( empty ? 0 : s.max ) << "," << s.mean() << '\n';
+      }
+
+    // the file stays open between steps, so hand each step's rows over
+    file.flush();
+  }
+
+  //============================================================================
+  // Private Data
+  //============================================================================
+
+  //! \brief the mesh
+  const mesh_t * mesh_ = nullptr;
+  //! \brief the prefix of the file names
+  std::string prefix_;
+  //! \brief the extracts
+  std::vector<spec_t> specs_;
+  //! \brief the registered fields
+  std::map< std::string, field_function_t > fields_;
+  //! \brief the field values evaluated this step
+  std::map< std::string, std::vector<real_t> > values_;
+  //! \brief the search tree for the line-outs, built when first needed
+  std::unique_ptr< mesh::cell_search_t<mesh_t> > search_;
+  //! \brief true if the search tree is up to date for this step
+  bool searched_ = false;
+  //! \brief the open region statistics files
+  std::vector< std::ofstream > region_files_;
+
+};
+
+} // namespace
+} // namespace
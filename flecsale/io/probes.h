@@ -0,0 +1,457 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file
+///
+/// \brief Records the time history of the solution at a set of points.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/mesh/search.h"
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace flecsale {
+namespace io {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The file formats a probe history can be written in.
+////////////////////////////////////////////////////////////////////////////////
+enum class probe_format_t {
+  //! One line of comma separated text per probe and sample.
+  csv,
+  //! A header followed by one row of 64-bit floats per probe and sample.
+  binary
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Convert the name of a probe format to its enum.
+//! \param [in] name  Either "csv" or "binary".
+//! \return The format.
+////////////////////////////////////////////////////////////////////////////////
+inline probe_format_t probe_format_from_string( const std::string & name )
+{
+  if ( name == "binary" ) 
+    return probe_format_t::binary;
+  else if ( name != "csv" ) 
+    raise_runtime_error( "Unknown probe format \"" << name << "\"" );
+  return probe_format_t::csv;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Samples fields at a fixed set of points and streams them to a file.
+//!
+//! The points are located once with a mesh::cell_search_t, and each sample
+//! just reads the value of the cell containing each point, which is the
+//! solution of a cell centered, piecewise constant scheme.  Only points in
+//! owned cells are recorded, so every point is written by exactly one rank.
+//!
+//! The rows are accumulated in memory and written when the buffer fills up,
+//! on flush(), and on destruction.  Each row holds the step, the time, the
+//! probe index, the probe position and the components of every field.  The
+//! binary format starts with the magic string "FLCPROBE", a uint32 version,
+//! a uint32 column count and each column name as a uint32 length followed
+//! by its characters.  The file is only created when the rank records its
+//! first row, so ranks that never hold a probe write nothing, while a probe
+//! that moves onto a rank starts a file there.
+//!
+//! When the mesh moves or changes, call relocate().  Probes that follow the
+//! flow stay in their cell, which is the same material on a Lagrangian
+//! mesh, and move with its centroid.  The others are found again, checking
+//! their last cell first.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+class probe_recorder_t {
+
+public:
+
+  //============================================================================
+  // Typedefs
+  //============================================================================
+
+  //! \brief the mesh type
+  using mesh_t = M;
+
+  //! \brief the number of dimensions
+  static constexpr std::size_t num_dimensions = mesh_t::num_dimensions;
+
+  //! \brief the real type
+  using real_t = typename mesh_t::real_t;
+
+  //! \brief the loop counter type
+  using counter_t = typename mesh_t::counter_t;
+
+  //! \brief the probe position type
+  using point_t = std::array<real_t, num_dimensions>;
+
+  //! \brief Fills in the values of a field for a list of cells.
+  //!
+  //! It is called with the cell ids and a pointer to where the values go,
+  //! stored with all the components of each cell together.
+  using field_function_t =
+    std::function< void( const std::vector<std::size_t> &, real_t * ) >;
+
+  //! \brief The version of the binary format.
+  static constexpr std::uint32_t version = 1;
+
+  //============================================================================
+  // Construction
+  //============================================================================
+
+  //! \brief Constructor.
+  //! \param [in] mesh  The mesh to sample.  It must outlive the recorder.
+  //! \param [in] points  The probe positions.
+  //! \param [in] follow_flow  If true, the probes move with the mesh.
+  probe_recorder_t(
+    const mesh_t & mesh,
+    const std::vector<point_t> & points,
+    bool follow_flow = false
+  ) : mesh_(&mesh), search_(mesh), points_(points), follow_flow_(follow_flow)
+  {
+    locate();
+  }
+
+  //! \brief Flush any remaining rows.
+  ~probe_recorder_t()
+  {
+    flush();
+  }
+
+  //! \brief Add a field to record.
+  //! \param [in] name  The name of the field.
+  //! \param [in] num_components  The number of values per cell.
+  //! \param [in] f  The function that fetches the values.
+  void add_field(
+    const std::string & name,
+    std::size_t num_components,
+    field_function_t f
+  ) {
+    if ( !filename_.empty() )
+      raise_runtime_error(
+        "Cannot add field \"" << name << "\" after the probe file is open"
+      );
+    fields_.emplace_back( field_t{ name, num_components, std::move(f) } );
+  }
+
+  //! \brief Set the output file.  It is created with its header when the
+  //! first row is recorded.
+  //! \param [in] filename  The name of the file.
+  //! \param [in] format  The file format.
+  //! \param [in] buffer_size  The number of bytes to buffer between writes.
+  void open(
+    const std::string & filename,
+    probe_format_t format,
+    std::size_t buffer_size = 1 << 20
+  ) {
+    // finish off any previous file
+    flush();
+    if ( file_.is_open() ) file_.close();
+
+    filename_ = filename;
+    format_ = format;
+    buffer_size_ = buffer_size;
+  }
+
+  //============================================================================
+  // Sampling
+  //============================================================================
+
+  //! \brief Update the probe cells after the mesh moved or changed.
+  //! \param [in] rebuild  If true, the mesh was rebuilt, like after an
+  //!   adaptation, and the probes are located from scratch.
+  void relocate( bool rebuild = false )
+  {
+    if ( rebuild || search_.num_cells() != mesh_->num_cells() ) {
+      search_.rebuild();
+      locate();
+      return;
+    }
+
+    auto cs = mesh_->cells();
+    auto cell_centroid = mesh_->cell_centroids();
+    counter_t num_probes = points_.size();
+
+    // probes that follow the flow keep their cell and move with it
+    if ( follow_flow_ ) {
+      #pragma omp parallel for
+      for ( counter_t i=0; i<num_probes; ++i ) {
+        if ( cells_[i] == invalid ) continue;
+        const auto & xc = cell_centroid[ cs[cells_[i]] ];
+        for ( std::size_t d=0; d<num_dimensions; ++d ) {
+          points_[i][d] += xc[d] - centroids_[i][d];
+          centroids_[i][d] = xc[d];
+        }
+      }
+      return;
+    }
+
+    // the others are found again, most likely in the same cell
+    search_.refit();
+    auto num_owned = mesh_->num_owned_cells();
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_probes; ++i ) {
+      if ( cells_[i] != invalid && search_.cell_contains( cells_[i], points_[i] ) )
+        continue;
+      auto id = search_.find_cell( points_[i] );
+      cells_[i] = ( id < num_owned ) ? id : invalid;
+    }
+  }
+
+  //! \brief Record the fields at every probe.
+  //! \param [in] time  The solution time.
+  //! \param [in] step  The time step number.
+  void sample( real_t time, std::size_t step )
+  {
+    // gather the located probes
+    std::vector<std::size_t> probes, cells;
+    for ( std::size_t i=0; i<cells_.size(); ++i )
+      if ( cells_[i] != invalid ) {
+        probes.emplace_back( i );
+        cells.emplace_back( cells_[i] );
+      }
+    if ( probes.empty() ) return;
+
+    // the file is created by the first rows it gets
+    if ( !file_.is_open() ) create_file();
+
+    // fetch all the field values at once
+    std::vector< std::vector<real_t> > values( fields_.size() );
+    for ( std::size_t f=0; f<fields_.size(); ++f ) {
+      values[f].resize( cells.size() * fields_[f].num_components );
+      fields_[f].fetch( cells, values[f].data() );
+    }
+
+    // one row per probe
+    std::vector<double> row;
+    for ( std::size_t j=0; j<probes.size(); ++j ) {
+      auto i = probes[j];
+      row.clear();
+      row.emplace_back( step );
+      row.emplace_back( time );
+      row.emplace_back( i );
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        row.emplace_back( points_[i][d] );
+      for ( std::size_t f=0; f<fields_.size(); ++f ) {
+        auto n = fields_[f].num_components;
+        for ( std::size_t k=0; k<n; ++k )
+          row.emplace_back( values[f][j*n + k] );
+      }
+      append_row( row );
+    }
+
+    if ( buffer_.size() >= buffer_size_ ) flush();
+  }
+
+  //! \brief Write the buffered rows to the file.
+  void flush()
+  {
+    if ( !file_.is_open() || buffer_.empty() ) return;
+    file_.write( buffer_.data(), buffer_.size() );
+    file_.flush();
+    buffer_.clear();
+  }
+
+  //============================================================================
+  // Access
+  //============================================================================
+
+  //! \brief The id used for a probe that is not in an owned cell.
+  static constexpr std::size_t invalid =
+    mesh::cell_search_t<mesh_t>::invalid;
+
+  //! \brief Return the current probe positions.
+  const auto & points() const
+  { return points_; }
+
+  //! \brief Return the cell of each probe, or #invalid.
+  const auto & cells() const
+  { return cells_; }
+
+  //! \brief Return the number of probes recorded by this rank.
+  std::size_t num_located() const
+  { return cells_.size() - std::count( cells_.begin(), cells_.end(), invalid ); }
+
+private:
+
+  //============================================================================
+  // Private Types
+  //============================================================================
+
+  //! \brief A field to record.
+  struct field_t {
+    std::string name;
+    std::size_t num_components;
+    field_function_t fetch;
+  };
+
+  //============================================================================
+  // Private Member Functions
+  //============================================================================
+
+  //! \brief Find the cell of every probe from scratch.
+  void locate()
+  {
+    cells_.resize( points_.size() );
+    search_.find_cells( points_, cells_ );
+
+    // ghost cells are recorded by their owner
+    auto num_owned = mesh_->num_owned_cells();
+    for ( auto & c : cells_ )
+      if ( c >= num_owned ) c = invalid;
+
+    // remember where the cells were, to follow them
+    auto cs = mesh_->cells();
+    auto cell_centroid = mesh_->cell_centroids();
+    centroids_.resize( points_.size() );
+    for ( std::size_t i=0; i<cells_.size(); ++i ) {
+      if ( cells_[i] == invalid ) continue;
+      const auto & xc = cell_centroid[ cs[cells_[i]] ];
+      for ( std::size_t d=0; d<num_dimensions; ++d ) centroids_[i][d] = xc[d];
+    }
+  }
+
+  //! \brief Create the output file and write the header.
+  void create_file()
+  {
+    if ( filename_.empty() )
+      raise_runtime_error( "The probe file must be opened before sampling" );
+
+    auto mode = std::ios::out | std::ios::trunc;
+    if ( format_ == probe_format_t::binary ) mode |= std::ios::binary;
+    file_.open( filename_, mode );
+    if ( !file_.good() )
+      raise_runtime_error( "Could not open probe file \"" << filename_ << "\"" );
+
+    auto names = column_names();
+
+    if ( format_ == probe_format_t::csv ) {
+      std::stringstream ss;
+      for ( std::size_t i=0; i<names.size(); ++i )
+        ss << ( i>0 ? "," : "" ) << names[i];
+      ss << std::endl;
+      append( ss.str() );
+    }
+    else {
+      append( "FLCPROBE", 8 );
+      append_binary( version );
+      append_binary( static_cast<std::uint32_t>( names.size() ) );
+      for ( const auto & name : names ) {
+        append_binary( static_cast<std::uint32_t>( name.size() ) );
+        append( name.data(), name.size() );
+      }
+    }
+    flush();
+  }
+
+  //! \brief Return the name of every column.
+  std::vector<std::string> column_names() const
+  {
+    std::vector<std::string> names = { "step", "time", "probe" };
+    const char * axes[] = { "x", "y", "z" };
+    for ( std::size_t d=0; d<num_dimensions; ++d ) names.emplace_back( axes[d] );
+    for ( const auto & f : fields_ ) {
+      if ( f.num_components == 1 )
+        names.emplace_back( f.name );
+      else
+        for ( std::size_t k=0; k<f.num_components; ++k )
+          names.emplace_back( f.name + "_" + std::to_string(k) );
+    }
+    return names;
+  }
+
+  //! \brief Append raw bytes to the buffer.
+  void append( const char * data, std::size_t n )
+  { buffer_.insert( buffer_.end(), data, data + n ); }
+
+  //! \brief Append a string to the buffer.
+  void append( const std::string & str )
+  { append( str.data(), str.size() ); }
+
+  //! \brief Append the bytes of a value to the buffer.
+  template< typename T >
+  void append_binary( const T & value )
+  { append( reinterpret_cast<const char *>( &value ), sizeof(T) ); }
+
+  //! \brief Append a row of values to the buffer.
+  void append_row( const std::vector<double> & row )
+  {
+    if ( format_ == probe_format_t::binary ) {
+      append( reinterpret_cast<const char *>( row.data() ),
+              row.size() * sizeof(double) );
+      return;
+    }
+    std::stringstream ss;
+    ss.precision( std::numeric_limits<double>::digits10 );
+    // the step and probe index are integers
+    ss << static_cast<std::size_t>( row[0] ) << "," << row[1] << ","
+       << static_cast<std::size_t>( row[2] );
+    for ( std::size_t i=3; i<row.size(); ++i ) ss << "," << row[i];
+    ss << "\n";
+    append( ss.str() );
+  }
+
+  //============================================================================
+  // Private Data
+  //============================================================================
+
+  //! \brief the mesh being sampled
+  const mesh_t * mesh_ = nullptr;
+
+  //! \brief the search tree over the cells
+  mesh::cell_search_t<mesh_t> search_;
+
+  //! \brief the probe positions
+  std::vector<point_t> points_;
+
+  //! \brief the cell containing each probe
+  std::vector<std::size_t> cells_;
+
+  //! \brief the centroid of each probe cell when it was last seen
+  std::vector<point_t> centroids_;
+
+  //! \brief true if the probes move with the mesh
+  bool follow_flow_ = false;
+
+  //! \brief the fields to record
+  std::vector<field_t> fields_;
+
+  //! \brief the output file, its format and the pending output
+  //! \{
+  std::string filename_;
+  std::ofstream file_;
+  probe_format_t format_ = probe_format_t::csv;
+  std::vector<char> buffer_;
+  std::size_t buffer_size_ = 1 << 20;
+  //! \}
+
+};
+
+//! \brief the definitions of the constants, for when they are bound to a 
+//! reference
+//! \{
+template< typename M >
+constexpr std::uint32_t probe_recorder_t<M>::version;
+template< typename M >
+constexpr std::size_t probe_recorder_t<M>::invalid;
+//! \}
+
+} // namespace
+} // namespace
@@ -0,0 +1,292 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Hands the mesh fields to a python function while the solver runs.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifdef HAVE_PYTHON
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Python include should go last cause it conflicts with alot of other
+// includes.
+#include "flecsale/utils/python_utils.h"
+
+namespace flecsale {
+namespace io {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Calls a python function with views of the mesh data.
+//!
+//! The function is called as \c f(mesh, time, step), where \c mesh is a
+//! dictionary with the entries
+//!   - "cells" and "vertices": the persistent fields at each location,
+//!     keyed by label;
+//!   - "coordinates": the vertex coordinates;
+//!   - "cell_vertex_offsets" and "cell_vertex_ids": the cell to vertex
+//!     connectivity in compressed row storage;
+//!   - "num_owned_cells" and "num_owned_vertices": the owned entities come
+//!     first, the rest are ghosts.
+//!
+//! The fields are NumPy arrays, or memoryviews if NumPy is not installed,
+//! that point straight at the field storage.  Vector fields have one row
+//! per entity.  Changes made in python are seen by the solver.
+//!
+//! The vertex coordinates are not stored contiguously by the mesh, so they
+//! are gathered into a buffer owned by this object before each call.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+class python_bridge_t {
+
+public:
+
+  //! \brief the mesh type
+  using mesh_t = M;
+  //! \brief the real type
+  using real_t = typename mesh_t::real_t;
+  //! \brief the storage real type
+  using storage_real_t = typename mesh_t::storage_real_t;
+  //! \brief the vector type
+  using vector_t = typename mesh_t::vector_t;
+  //! \brief the number of dimensions
+  static constexpr auto num_dims = mesh_t::num_dimensions;
+
+  //! \brief Constructor.
+  //!
+  //! The interpreter is started if nobody else did.
+  //!
+  //! \param [in] mesh  The mesh.
+  //! \param [in] script  The python file defining the function.
+  //! \param [in] function  The name of the function.
+  python_bridge_t(
+    mesh_t & mesh, const std::string & script, const std::string & function
+  ) : mesh_( &mesh )
+  {
+    if ( !Py_IsInitialized() ) {
+      utils::python_initialize();
+      owns_interpreter_ = true;
+    }
+
+    // the module is imported from the directory of the script
+    auto slash = script.find_last_of( '/' );
+    auto dir = ( slash == std::string::npos ) ?
+      std::string(".") : script.substr( 0, slash );
+    auto name = ( slash == std::string::npos ) ?
+      script : script.substr( slash+1 );
+    auto dot = name.find_last_of( '.' );
+    if ( dot != std::string::npos && name.substr( dot ) == ".py" )
+      name.erase( dot );
+
+    utils::python_add_to_path( dir );
+    module_ = utils::python_import( name );
+    function_ = utils::python_get_attribute( module_, function );
+  }
+
+  //! \brief Destructor.
+  ~python_bridge_t()
+  {
+    reset();
+    Py_XDECREF( function_ );
+    Py_XDECREF( module_ );
+    if ( owns_interpreter_ ) utils::python_finalize();
+  }
+
+  //! \brief Disallow copying.
+  //! \{
+  python_bridge_t( const python_bridge_t & ) = delete;
+  python_bridge_t & operator=( const python_bridge_t & ) = delete;
+  //! \}
+
+  //! \brief Point to a new mesh, or to a mesh whose storage was reallocated.
+  //! \param [in] mesh  The mesh.
+  void reset( mesh_t & mesh )
+  {
+    reset();
+    mesh_ = &mesh;
+  }
+
+  //! \brief Drop the views, they are rebuilt on the next call.
+  void reset()
+  {
+    Py_XDECREF( dict_ );
+    dict_ = nullptr;
+  }
+
+  //! \brief Call the python function.
+  //! \param [in] time  The solution time.
+  //! \param [in] step  The time step counter.
+  void process( real_t time, std::size_t step )
+  {
+    if ( !dict_ ) build();
+    gather_coordinates();
+    auto pres = utils::python_call_function(
+      function_, dict_, static_cast<double>(time), static_cast<long>(step)
+    );
+    utils::python_free( pres );
+  }
+
+private:
+
+  //! \brief Build the dictionary of views.
+  void build()
+  {
+    using utils::python_array_view;
+    using utils::python_as_numpy;
+    using utils::python_set_item;
+    using utils::python_get_value;
+
+    static_assert( sizeof(vector_t) == num_dims*sizeof(real_t),
+      "vectors must be stored as contiguous reals" );
+
+    auto & mesh = *mesh_;
+    Py_ssize_t num_cells = mesh.num_cells();
+    Py_ssize_t num_verts = mesh.num_vertices();
+
+    dict_ = utils::python_new_dict();
+
+    // add a list of scalar or vector fields
+    auto add_fields = []( PyObject * py_dict, auto && fields, Py_ssize_t n )
+    {
+      for ( auto & f : fields ) {
+        if ( n == 0 ) continue;
+        using value_t = std::decay_t< decltype(f[0]) >;
+        auto data = &f[0];
+        auto view = std::is_same< value_t, vector_t >::value ?
+          python_array_view(
+            reinterpret_cast<real_t *>( data ), {n, Py_ssize_t(num_dims)}
+          ) :
+          python_array_view(
+            reinterpret_cast<real_t *>( data ), {n}
+          );
+        python_set_item( py_dict, f.label(), python_as_numpy( view ) );
+      }
+    };
+
+    // the cell fields
+    auto cell_dict = utils::python_new_dict();
+    add_fields( cell_dict, flecsi_get_accessors_all(
+      mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    ), num_cells );
+#ifdef USE_MIXED_PRECISION
+    add_storage_fields( cell_dict, flecsi_get_accessors_all(
+      mesh, storage_real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    ), num_cells );
+#endif
+    add_fields( cell_dict, flecsi_get_accessors_all(
+      mesh, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+    ), num_cells );
+    python_set_item( dict_, "cells", cell_dict );
+
+    // the vertex fields
+    auto vert_dict = utils::python_new_dict();
+    add_fields( vert_dict, flecsi_get_accessors_all(
+      mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+    ), num_verts );
+    add_fields( vert_dict, flecsi_get_accessors_all(
+      mesh, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
+    ), num_verts );
+    python_set_item( dict_, "vertices", vert_dict );
+
+    // the coordinates are filled in before each call
+    coordinates_.resize( num_dims * num_verts );
+    python_set_item( dict_, "coordinates", python_as_numpy(
+      python_array_view(
+        coordinates_.data(), {num_verts, Py_ssize_t(num_dims)}, false
+      )
+    ) );
+
+    // the connectivity only changes with the mesh
+    cell_vertex_offsets_.assign( 1, 0 );
+    cell_vertex_offsets_.reserve( num_cells+1 );
+    cell_vertex_ids_.clear();
+    for ( auto c : mesh.cells() ) {
+      for ( auto v : mesh.vertices(c) ) cell_vertex_ids_.emplace_back( v.id() );
+      cell_vertex_offsets_.emplace_back( cell_vertex_ids_.size() );
+    }
+    python_set_item( dict_, "cell_vertex_offsets", python_as_numpy(
+      python_array_view(
+        cell_vertex_offsets_.data(), {num_cells+1}, false
+      )
+    ) );
+    python_set_item( dict_, "cell_vertex_ids", python_as_numpy(
+      python_array_view(
+        cell_vertex_ids_.data(),
+        {static_cast<Py_ssize_t>( cell_vertex_ids_.size() )}, false
+      )
+    ) );
+
+    python_set_item( dict_, "num_owned_cells",
+      python_get_value( static_cast<long>( mesh.num_owned_cells() ) ) );
+    python_set_item( dict_, "num_owned_vertices",
+      python_get_value( static_cast<long>( mesh.num_owned_vertices() ) ) );
+  }
+
+#ifdef USE_MIXED_PRECISION
+  //! \brief Add a list of reduced precision scalar fields.
+  template< typename A >
+  static void add_storage_fields(
+    PyObject * py_dict, A && fields, Py_ssize_t n
+  ) {
+    for ( auto & f : fields ) {
+      if ( n == 0 ) continue;
+      auto view = utils::python_array_view(
+        reinterpret_cast<storage_real_t *>( &f[0] ), {n}
+      );
+      utils::python_set_item(
+        py_dict, f.label(), utils::python_as_numpy( view )
+      );
+    }
+  }
+#endif
+
+  //! \brief Copy the vertex coordinates into their buffer.
+  void gather_coordinates()
+  {
+    auto vs = mesh_->vertices();
+    using counter_t = typename mesh_t::counter_t;
+    counter_t num_verts = vs.size();
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_verts; ++i ) {
+      const auto & x = vs[i]->coordinates();
+      for ( std::size_t d=0; d<num_dims; ++d )
+        coordinates_[ i*num_dims + d ] = x[d];
+    }
+  }
+
+  //! \brief the mesh
+  mesh_t * mesh_ = nullptr;
+  //! \brief the user module and function
+  //! \{
+  PyObject * module_ = nullptr;
+  PyObject * function_ = nullptr;
+  //! \}
+  //! \brief the dictionary handed to the function
+  PyObject * dict_ = nullptr;
+  //! \brief true if this object started the interpreter
+  bool owns_interpreter_ = false;
+  //! \brief the gathered vertex coordinates
+  std::vector<real_t> coordinates_;
+  //! \brief the cell to vertex connectivity
+  //! \{
+  std::vector<std::int64_t> cell_vertex_offsets_;
+  std::vector<std::int64_t> cell_vertex_ids_;
+  //! \}
+
+};
+
+} // namespace
+} // namespace
+
+#endif // HAVE_PYTHON
@@ -95,7 +95,7 @@ public:
   constexpr array(const array<T2,N> &rhs) noexcept
   {
     for ( counter_type i=0; i<N; ++i )
-      elems_[i] = rhs.elems_[i]; 
+      elems_[i] = rhs[i]; 
   }
 
   //! \brief Constructor with variadic arguments.
@@ -311,7 +311,7 @@ public:
   //!\brief  assignment with type conversion
   template <typename T2>
   auto & operator= (const array<T2,N>& rhs) {
-    for ( counter_type i=0; i<N; i++ ) elems_[i] = rhs.elems_[i];    
+    for ( counter_type i=0; i<N; i++ ) elems_[i] = rhs[i];    
     return *this;
   }
 
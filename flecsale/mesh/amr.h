@@ -0,0 +1,710 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some functionality for adaptively refining and coarsening the
+///        quadrilateral and hexahedral meshes created by box().
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <deque>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief What should happen to a cell during adaptation.
+////////////////////////////////////////////////////////////////////////////////
+enum class amr_flag_t : signed char {
+  //! Merge the cell with its siblings, if they all agree.
+  coarsen = -1,
+  //! Leave the cell as it is.
+  keep = 0,
+  //! Split the cell into 2^N children.
+  refine = 1
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Maps the cells of an adapted mesh back to the cells they came from.
+//!
+//! Each new cell lists the old cells that overlap it in compressed row
+//! storage, along with the fraction of the new cell's volume that each of
+//! them covers.
+////////////////////////////////////////////////////////////////////////////////
+struct amr_transfer_t {
+
+  //! \brief True if the adaptation changed the mesh.
+  bool changed = false;
+  //! \brief The offsets of the sources of each new cell, with one extra entry.
+  std::vector<common::local_index_t> offsets;
+  //! \brief The old cells that overlap each new cell.
+  std::vector<common::local_index_t> sources;
+  //! \brief The volume fraction of the new cell covered by each source.
+  std::vector<common::real_t> weights;
+
+  //! \brief Return the number of new cells.
+  std::size_t num_cells() const
+  { return offsets.empty() ? 0 : offsets.size()-1; }
+
+  //! \brief Compute the volume average of an old cell field.
+  //!
+  //! Cells that are split get the value of their parent, and cells that are
+  //! merged get the volume average of their children, so integrals of the
+  //! field are conserved.
+  //!
+  //! \param [in] src  The old cell field, indexable by id.
+  //! \param [out] dst  The new cell field, indexable by id.
+  template< typename S, typename D >
+  void average( const S & src, D && dst ) const
+  {
+    using counter_t = long long;
+    counter_t num_new = num_cells();
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_new; ++i ) {
+      auto j = offsets[i];
+      auto val = weights[j] * src[ sources[j] ];
+      for ( ++j; j<offsets[i+1]; ++j ) val += weights[j] * src[ sources[j] ];
+      dst[i] = val;
+    }
+  }
+};
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Hash a fixed size array of integers.
+////////////////////////////////////////////////////////////////////////////////
+struct array_hash_t {
+  template< typename A >
+  std::size_t operator()( const A & a ) const
+  {
+    std::size_t h = 0;
+    for ( auto x : a )
+      h ^= std::hash<std::size_t>()(x) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A refinement tree over the cells of a box() mesh.
+//!
+//! Every root cell of the box can be recursively split into 2^N children,
+//! up to a maximum level.  Only the leaves are stored; each one is
+//! identified by its level and its logical (i,j,k) index on that level's
+//! lattice.  The leaves are kept 2:1 balanced over faces, edges and
+//! vertices, so a cell only ever has hanging nodes at the midpoints of its
+//! edges and faces.
+//!
+//! The leaves are numbered in the same order as the cells of the mesh
+//! returned by build().
+//!
+//! \tparam N The number of dimensions.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+class amr_hierarchy_t {
+
+public:
+
+  //! \brief the real type
+  using real_t = common::real_t;
+
+  //! \brief A logical (i,j,k) index.
+  using ijk_t = std::array<std::size_t, N>;
+
+  //! \brief A leaf is stored as its level followed by its (i,j,k) index.
+  using leaf_t = std::array<std::size_t, N+1>;
+
+  //! \brief The number of children of a refined cell.
+  static constexpr std::size_t num_children = 1 << N;
+
+  //! \brief Default constructor.
+  amr_hierarchy_t() = default;
+
+  //! \brief Start a hierarchy from a structured mesh.
+  //! \param [in] mesh  A mesh created by box().
+  //! \param [in] max_level  The maximum number of times a root cell can be
+  //!   split.
+  template< typename M >
+  amr_hierarchy_t( const M & mesh, std::size_t max_level ) :
+    max_level_( max_level )
+  {
+    if ( !mesh.is_structured() )
+      raise_runtime_error( "Adaptive refinement needs a mesh made by box()" );
+
+    // a finest lattice index has to fit in the id type
+    if ( max_level_ >= 8*sizeof(std::size_t)/2 )
+      raise_runtime_error( "Too many refinement levels: " << max_level_ );
+
+    const auto & grid = mesh.structured();
+    for ( std::size_t d=0; d<N; ++d ) {
+      root_cells_[d] = grid.num_cells(d);
+      origin_[d] = grid.origin()[d];
+      spacing_[d] = grid.spacing()[d];
+    }
+
+    // the roots are numbered lexicographically, just like box()
+    leaves_.reserve( grid.num_cells() );
+    for ( std::size_t c=0; c<grid.num_cells(); ++c ) {
+      auto ijk = grid.cell_ijk( c );
+      leaf_t leaf;
+      leaf[0] = 0;
+      std::copy( ijk.begin(), ijk.end(), leaf.begin()+1 );
+      leaves_.emplace_back( leaf );
+    }
+  }
+
+  //! \brief Return the maximum refinement level.
+  std::size_t max_level() const
+  { return max_level_; }
+
+  //! \brief Return the number of leaves.
+  std::size_t num_cells() const
+  { return leaves_.size(); }
+
+  //! \brief Return the level of leaf \e c.
+  std::size_t level( std::size_t c ) const
+  { return leaves_[c][0]; }
+
+  //! \brief Return the logical index of leaf \e c on its level.
+  ijk_t ijk( std::size_t c ) const
+  {
+    ijk_t ijk;
+    std::copy( leaves_[c].begin()+1, leaves_[c].end(), ijk.begin() );
+    return ijk;
+  }
+
+  //! \brief Adapt the leaves.
+  //!
+  //! Cells flagged for refinement are split, and families whose members are
+  //! all flagged for coarsening are merged.  Extra cells are refined, and
+  //! some families are left alone, to keep the leaves 2:1 balanced.
+  //!
+  //! \param [in] flags  The flag of each current leaf.
+  //! \return The map from the new leaves to the old ones.
+  amr_transfer_t adapt( const std::vector<amr_flag_t> & flags );
+
+  //! \brief Build a mesh from the current leaves.
+  //!
+  //! Hanging nodes turn the coarse side of a refinement jump into a polygon
+  //! in 2D and a polyhedron in 3D.
+  //!
+  //! \return The new mesh.
+  template< typename M >
+  M build() const;
+
+private:
+
+  //! \brief An unordered set of leaves
+  using leaf_set_t = std::unordered_set<leaf_t, detail::array_hash_t>;
+
+  //! \brief Return the parent of \e leaf.
+  static leaf_t parent( leaf_t leaf )
+  {
+    --leaf[0];
+    for ( std::size_t d=1; d<=N; ++d ) leaf[d] /= 2;
+    return leaf;
+  }
+
+  //! \brief Return the \e n'th child of \e leaf, x varies fastest.
+  static leaf_t child( leaf_t leaf, std::size_t n )
+  {
+    ++leaf[0];
+    for ( std::size_t d=1; d<=N; ++d ) leaf[d] = 2*leaf[d] + ( (n >> (d-1)) & 1 );
+    return leaf;
+  }
+
+  //! \brief Return true if \e leaf lies inside the domain.
+  bool in_domain( const leaf_t & leaf ) const
+  {
+    for ( std::size_t d=1; d<=N; ++d )
+      if ( leaf[d] >= ( root_cells_[d-1] << leaf[0] ) ) return false;
+    return true;
+  }
+
+  //! \brief Visit the cells adjacent to \e leaf on its own level.
+  template< typename F >
+  void for_each_neighbor( const leaf_t & leaf, F && f ) const
+  {
+    std::size_t num_neigh = 1;
+    for ( std::size_t d=0; d<N; ++d ) num_neigh *= 3;
+    for ( std::size_t n=0; n<num_neigh; ++n ) {
+      auto neigh = leaf;
+      bool is_self = true, is_good = true;
+      for ( std::size_t d=1, m=n; d<=N; ++d, m/=3 ) {
+        auto off = m % 3;
+        if ( off == 0 && leaf[d] == 0 ) is_good = false;
+        neigh[d] = leaf[d] + off - 1;
+        if ( off != 1 ) is_self = false;
+      }
+      if ( is_self || !is_good || !in_domain(neigh) ) continue;
+      if ( !std::forward<F>(f)( neigh ) ) return;
+    }
+  }
+
+  //! \brief Find the leaf that covers a cell.
+  //! \param [in] leaves  The set of leaves.
+  //! \param [in] cell  The cell to look for.
+  //! \param [out] found  The covering leaf.
+  //! \return False if the cell is split into finer leaves.
+  static bool find_leaf(
+    const leaf_set_t & leaves, leaf_t cell, leaf_t & found
+  ) {
+    while ( true ) {
+      if ( leaves.count(cell) ) { found = cell; return true; }
+      if ( cell[0] == 0 ) return false;
+      cell = parent( cell );
+    }
+  }
+
+  //! \brief Split leaves until the set is 2:1 balanced.
+  void balance( leaf_set_t & leaves ) const;
+
+  //! \brief Order the new leaves following the old ones.
+  void order_leaves( const leaf_set_t & leaves, std::vector<leaf_t> & order ) const;
+
+  //! \brief the number of root cells in each direction
+  ijk_t root_cells_ = {};
+  //! \brief the root grid origin and spacing
+  //! \{
+  std::array<real_t, N> origin_ = {};
+  std::array<real_t, N> spacing_ = {};
+  //! \}
+  //! \brief the maximum refinement level
+  std::size_t max_level_ = 0;
+  //! \brief the leaves, in mesh order
+  std::vector<leaf_t> leaves_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Split leaves until the set is 2:1 balanced.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+void amr_hierarchy_t<N>::balance( leaf_set_t & leaves ) const
+{
+  std::deque<leaf_t> work( leaves.begin(), leaves.end() );
+
+  while ( !work.empty() ) {
+
+    auto leaf = work.front();
+    work.pop_front();
+
+    // it may have been split in the meantime
+    if ( leaf[0] < 2 || !leaves.count(leaf) ) continue;
+
+    for_each_neighbor( leaf, [&]( const leaf_t & neigh ) {
+      leaf_t cover;
+      if ( !find_leaf( leaves, neigh, cover ) || cover[0]+1 >= leaf[0] )
+        return true;
+      // the neighbor is too coarse, split it and check everything again
+      leaves.erase( cover );
+      for ( std::size_t n=0; n<num_children; ++n ) {
+        auto kid = child( cover, n );
+        leaves.insert( kid );
+        work.push_back( kid );
+      }
+      work.push_back( leaf );
+      return false;
+    } );
+
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Order the new leaves following the old ones.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+void amr_hierarchy_t<N>::order_leaves(
+  const leaf_set_t & leaves, std::vector<leaf_t> & order
+) const {
+
+  order.clear();
+  order.reserve( leaves.size() );
+  leaf_set_t emitted;
+
+  // emit the leaves below a cell in child order
+  std::function<void(const leaf_t &)> emit_below = [&]( const leaf_t & cell ) {
+    if ( leaves.count(cell) ) {
+      order.emplace_back( cell );
+      return;
+    }
+    for ( std::size_t n=0; n<num_children; ++n ) emit_below( child(cell, n) );
+  };
+
+  for ( const auto & old : leaves_ ) {
+    leaf_t cover;
+    // the old leaf was kept or merged
+    if ( find_leaf( leaves, old, cover ) ) {
+      if ( emitted.insert( cover ).second ) order.emplace_back( cover );
+    }
+    // the old leaf was split
+    else
+      emit_below( old );
+  }
+
+  assert( order.size() == leaves.size() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adapt the leaves.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+amr_transfer_t amr_hierarchy_t<N>::adapt( const std::vector<amr_flag_t> & flags )
+{
+  auto num_old = leaves_.size();
+  if ( flags.size() != num_old )
+    raise_runtime_error(
+      "Got " << flags.size() << " refinement flags for " << num_old << " cells"
+    );
+
+  std::unordered_map<leaf_t, std::size_t, detail::array_hash_t> old_ids;
+  old_ids.reserve( num_old );
+  for ( std::size_t i=0; i<num_old; ++i ) old_ids.emplace( leaves_[i], i );
+
+  //----------------------------------------------------------------------------
+  // split the flagged cells and restore the balance
+
+  leaf_set_t leaves( leaves_.begin(), leaves_.end() );
+
+  for ( std::size_t i=0; i<num_old; ++i ) {
+    const auto & leaf = leaves_[i];
+    if ( flags[i] != amr_flag_t::refine || leaf[0] >= max_level_ ) continue;
+    leaves.erase( leaf );
+    for ( std::size_t n=0; n<num_children; ++n )
+      leaves.insert( child( leaf, n ) );
+  }
+
+  balance( leaves );
+
+  //----------------------------------------------------------------------------
+  // merge the families that all want to be coarsened, as long as that does
+  // not put them next to cells more than one level finer
+
+  leaf_set_t parents;
+  for ( std::size_t i=0; i<num_old; ++i )
+    if ( flags[i] == amr_flag_t::coarsen && leaves_[i][0] > 0 )
+      parents.insert( parent( leaves_[i] ) );
+
+  std::vector<leaf_t> merged;
+  for ( const auto & p : parents ) {
+    bool ok = true;
+    for ( std::size_t n=0; n<num_children && ok; ++n ) {
+      auto kid = child( p, n );
+      auto it = old_ids.find( kid );
+      ok = leaves.count( kid ) && it != old_ids.end() &&
+        flags[ it->second ] == amr_flag_t::coarsen;
+      if ( !ok ) break;
+      for_each_neighbor( kid, [&]( const leaf_t & neigh ) {
+        leaf_t cover;
+        if ( parent(neigh) != p && !find_leaf( leaves, neigh, cover ) )
+          ok = false;
+        return ok;
+      } );
+    }
+    if ( ok ) merged.emplace_back( p );
+  }
+
+  for ( const auto & p : merged ) {
+    for ( std::size_t n=0; n<num_children; ++n ) leaves.erase( child(p, n) );
+    leaves.insert( p );
+  }
+
+  //----------------------------------------------------------------------------
+  // number the new leaves and map them back to the old ones
+
+  std::vector<leaf_t> new_leaves;
+  order_leaves( leaves, new_leaves );
+
+  amr_transfer_t transfer;
+  transfer.changed = ( new_leaves != leaves_ );
+
+  auto num_new = new_leaves.size();
+  transfer.offsets.reserve( num_new+1 );
+  transfer.offsets.emplace_back( 0 );
+
+  // collect the old leaves below a merged cell
+  std::function<void(const leaf_t &, real_t)> add_below =
+    [&]( const leaf_t & cell, real_t weight )
+    {
+      auto it = old_ids.find( cell );
+      if ( it != old_ids.end() ) {
+        transfer.sources.emplace_back( it->second );
+        transfer.weights.emplace_back( weight );
+        return;
+      }
+      for ( std::size_t n=0; n<num_children; ++n )
+        add_below( child(cell, n), weight / num_children );
+    };
+
+  for ( const auto & leaf : new_leaves ) {
+    // a kept or split cell comes from a single old one
+    auto cell = leaf;
+    auto it = old_ids.find( cell );
+    while ( it == old_ids.end() && cell[0] > 0 ) {
+      cell = parent( cell );
+      it = old_ids.find( cell );
+    }
+    if ( it != old_ids.end() ) {
+      transfer.sources.emplace_back( it->second );
+      transfer.weights.emplace_back( 1 );
+    }
+    // a merged cell comes from its children
+    else
+      add_below( leaf, 1 );
+    transfer.offsets.emplace_back( transfer.sources.size() );
+  }
+
+  leaves_ = std::move( new_leaves );
+
+  return transfer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Build a mesh from the current leaves.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+template< typename M >
+M amr_hierarchy_t<N>::build() const
+{
+  using vertex_t = typename M::vertex_t;
+  using point_t = typename M::point_t;
+
+  // the offsets of the vertices of a cell, in the order used by box()
+  constexpr std::size_t di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+  constexpr std::size_t dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+  constexpr std::size_t dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+  // the lower corner and size of a leaf on the finest lattice
+  auto corner = [&]( const leaf_t & leaf, std::size_t l ) {
+    auto s = std::size_t(1) << ( max_level_ - leaf[0] );
+    ijk_t v;
+    v[0] = ( leaf[1] + di[l] ) * s;
+    v[1] = ( leaf[2] + dj[l] ) * s;
+    if ( N == 3 ) v[N-1] = ( leaf[N] + dk[l] ) * s;
+    return v;
+  };
+
+  //----------------------------------------------------------------------------
+  // number the vertices lexicographically on the finest lattice
+
+  std::unordered_set<ijk_t, detail::array_hash_t> vert_set;
+  for ( const auto & leaf : leaves_ )
+    for ( std::size_t l=0; l<num_children; ++l )
+      vert_set.insert( corner(leaf, l) );
+
+  std::vector<ijk_t> vert_keys( vert_set.begin(), vert_set.end() );
+  std::sort(
+    vert_keys.begin(), vert_keys.end(),
+    []( const ijk_t & a, const ijk_t & b ) {
+      return std::lexicographical_compare(
+        a.rbegin(), a.rend(), b.rbegin(), b.rend()
+      );
+    }
+  );
+
+  std::unordered_map<ijk_t, std::size_t, detail::array_hash_t> vert_ids;
+  vert_ids.reserve( vert_keys.size() );
+  for ( std::size_t i=0; i<vert_keys.size(); ++i )
+    vert_ids.emplace( vert_keys[i], i );
+
+  M mesh;
+  mesh.init_parameters( vert_keys.size() );
+
+  auto fine = std::size_t(1) << max_level_;
+  std::vector<vertex_t*> vs;
+  vs.reserve( vert_keys.size() );
+  for ( const auto & v : vert_keys ) {
+    point_t x;
+    for ( std::size_t d=0; d<N; ++d )
+      x[d] = origin_[d] + v[d] * spacing_[d] / fine;
+    vs.emplace_back( mesh.create_vertex( x ) );
+  }
+
+  // return the vertex halfway between two others, if there is one
+  auto midpoint = [&]( const ijk_t & a, const ijk_t & b ) -> vertex_t * {
+    ijk_t m;
+    for ( std::size_t d=0; d<N; ++d ) {
+      if ( (a[d] + b[d]) % 2 ) return nullptr;
+      m[d] = ( a[d] + b[d] ) / 2;
+    }
+    auto it = vert_ids.find( m );
+    return ( it == vert_ids.end() ) ? nullptr : vs[ it->second ];
+  };
+
+  // walk around a loop of lattice points, adding any hanging nodes
+  auto polygon = [&]( const auto & pts, std::vector<vertex_t*> & poly ) {
+    poly.clear();
+    auto n = pts.size();
+    for ( std::size_t i=0; i<n; ++i ) {
+      poly.emplace_back( vs[ vert_ids.at( pts[i] ) ] );
+      if ( auto m = midpoint( pts[i], pts[(i+1)%n] ) ) poly.emplace_back( m );
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // create the cells
+
+  bool is_uniform = std::all_of(
+    leaves_.begin(), leaves_.end(),
+    [&]( const auto & leaf ) { return leaf[0] == leaves_.front()[0]; }
+  );
+
+  std::vector<vertex_t*> elem_vs;
+
+  // 2d cells, and 3d cells without hanging nodes, only need their vertices
+  if ( N == 2 || is_uniform ) {
+    std::vector<ijk_t> pts( num_children );
+    for ( const auto & leaf : leaves_ ) {
+      for ( std::size_t l=0; l<num_children; ++l ) pts[l] = corner( leaf, l );
+      if ( N == 2 )
+        polygon( pts, elem_vs );
+      else {
+        elem_vs.clear();
+        for ( const auto & p : pts ) elem_vs.emplace_back( vs[ vert_ids.at(p) ] );
+      }
+      mesh.create_cell( elem_vs );
+    }
+  }
+
+  // otherwise 3d cells are built from their faces, which are shared
+  else {
+
+    using face_t = typename M::face_t;
+
+    // the outward oriented faces of a hexahedron
+    constexpr std::size_t hex_faces[6][4] = {
+      {0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4},
+      {2, 3, 7, 6}, {0, 4, 7, 3}, {1, 2, 6, 5}
+    };
+
+    std::map< std::vector<vertex_t*>, face_t* > face_map;
+    std::vector<face_t*> elem_fs;
+    std::vector<ijk_t> pts(4);
+
+    auto add_face = [&]( const std::vector<vertex_t*> & poly ) {
+      auto key = poly;
+      std::sort( key.begin(), key.end() );
+      auto it = face_map.find( key );
+      if ( it == face_map.end() )
+        it = face_map.emplace( key, mesh.create_face( poly ) ).first;
+      elem_fs.emplace_back( it->second );
+    };
+
+    for ( const auto & leaf : leaves_ ) {
+      elem_fs.clear();
+      for ( const auto & hf : hex_faces ) {
+        for ( std::size_t l=0; l<4; ++l ) pts[l] = corner( leaf, hf[l] );
+        auto ctr = midpoint( pts[0], pts[2] );
+        // the neighbor is finer, so split the face into four
+        if ( ctr ) {
+          vertex_t * mid[4];
+          for ( std::size_t l=0; l<4; ++l ) {
+            mid[l] = midpoint( pts[l], pts[(l+1)%4] );
+            assert( mid[l] && "unbalanced refinement" );
+          }
+          for ( std::size_t l=0; l<4; ++l ) {
+            auto v = vs[ vert_ids.at( pts[l] ) ];
+            add_face( { v, mid[l], ctr, mid[(l+3)%4] } );
+          }
+        }
+        else {
+          polygon( pts, elem_vs );
+          add_face( elem_vs );
+        }
+      }
+      mesh.create_cell( elem_fs );
+    }
+
+  }
+
+  // an unrefined hierarchy is still the original box
+  if ( is_uniform && leaves_.front()[0] == 0 ) {
+    point_t min, max;
+    for ( std::size_t d=0; d<N; ++d ) {
+      min[d] = origin_[d];
+      max[d] = origin_[d] + root_cells_[d] * spacing_[d];
+    }
+    mesh.set_structured( root_cells_, min, max );
+  }
+
+  mesh.init();
+
+  return mesh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Carry the mesh attributes over to an adapted mesh.
+//!
+//! The regions of each new cell come from its first source.  A boundary
+//! face of the new mesh gets the tags of the old boundary faces of its
+//! sources that point the same way.  The boundaries are re-installed in
+//! the same order, so the tag ids do not change.
+//!
+//! \param [in] src  The old mesh.
+//! \param [in,out] dst  The adapted mesh.
+//! \param [in] transfer  The map from the new cells to the old ones.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void transfer_mesh_attributes(
+  const T & src, T & dst, const amr_transfer_t & transfer
+) {
+  using counter_t = typename T::counter_t;
+
+  // the solution time
+  dst.set_time( src.time() );
+  dst.increment_time_step_counter(
+    src.time_step_counter() - dst.time_step_counter()
+  );
+
+  // the regions
+  auto src_cells = src.cells();
+  auto dst_cells = dst.cells();
+  counter_t num_cells = dst_cells.size();
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; ++i )
+    dst_cells[i]->region() =
+      src_cells[ transfer.sources[ transfer.offsets[i] ] ]->region();
+  dst.set_num_regions( src.num_regions() );
+
+  // the boundary tags
+  auto src_faces = src.faces();
+  auto src_normals = src.face_normals();
+  auto dst_normals = dst.face_normals();
+  std::vector<char> tagged( src_faces.size() );
+
+  for ( std::size_t tag=0; tag<src.num_boundaries(); ++tag ) {
+    std::fill( tagged.begin(), tagged.end(), 0 );
+    for ( auto f : src.tagged_faces( tag ) ) tagged[ f->template id<0>() ] = 1;
+    dst.install_boundary( [&]( auto f ) {
+      const auto & n = dst_normals[ f->template id<0>() ];
+      auto c = dst.cells( f ).front().id();
+      for ( auto j=transfer.offsets[c]; j<transfer.offsets[c+1]; ++j )
+        for ( auto g : src.faces( src_cells[ transfer.sources[j] ] ) )
+          if ( tagged[ g.id() ] && dot_product( src_normals[g], n ) > 0.5 )
+            return true;
+      return false;
+    } );
+  }
+}
+
+} // namespace
+} // namespace
@@ -50,15 +50,28 @@ struct burton_config_t {
   //! The type for floating-point values.
   using real_t = common::real_t;
 
+  //! The type for floating-point values stored in reduced precision.
+  using storage_real_t = common::storage_real_t;
+
   //! The type for integer values.
   using integer_t = common::integer_t;
 
+  //! The type for process-local entity ids in side buffers.  The topology
+  //! itself keeps the FleCSI id type.
+  using local_index_t = common::local_index_t;
+
+  //! The type for entity ids that are unique across processes.
+  using global_index_t = common::global_index_t;
+
   //! A point type with real_t data and mesh dimension.
   using point_t = geom::point<real_t, num_dimensions>;
 
   //! A space ("physics") vector type with real_t data and mesh dimension.
   using vector_t = math::vector<real_t, num_dimensions>;
 
+  //! A space vector type stored in reduced precision.
+  using storage_vector_t = math::vector<storage_real_t, num_dimensions>;
+
   //! \brief The locations of different bits that we set as flags
   enum bits : uint8_t
   {
@@ -0,0 +1,540 @@
+/*~--------------------------------------------------------------------------~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~--------------------------------------------------------------------------~*/
+////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \brief Provides an implicitly indexed version of the corners and wedges
+//!   for use in burton_mesh_t.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/geom/shapes/triangle.h"
+#include "flecsale/mesh/burton/burton_config.h"
+#include "flecsale/utils/array_ref.h"
+#include "flecsale/utils/errors.h"
+#include "flecsale/utils/first_touch.h"
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+namespace burton {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A contiguous range of implicit entity ids.
+//!
+//! The ids are stored compactly, but handed out as std::size_t so they can be
+//! used directly to index field accessors.
+////////////////////////////////////////////////////////////////////////////////
+class burton_id_range_t {
+
+public:
+
+  //! \brief the id type
+  using id_t = common::local_index_t;
+
+  //! \brief a simple counting iterator
+  class iterator {
+  public:
+    //! \brief Constructor.
+    constexpr explicit iterator( id_t id ) : id_(id) {}
+    //! \brief Dereference to get the id.
+    constexpr std::size_t operator*() const { return id_; }
+    //! \brief Move to the next id.
+    iterator & operator++() { ++id_; return *this; }
+    //! \brief Comparison operators.
+    //! \{
+    constexpr bool operator==( const iterator & o ) const
+    { return id_ == o.id_; }
+    constexpr bool operator!=( const iterator & o ) const
+    { return id_ != o.id_; }
+    //! \}
+  private:
+    //! \brief the current id
+    id_t id_;
+  };
+
+  //! \brief Constructor.
+  //! \param [in] first,last  The half open range of ids.
+  constexpr burton_id_range_t( id_t first, id_t last ) :
+    first_(first), last_(last)
+  {}
+
+  //! \brief Return the number of ids in the range.
+  constexpr std::size_t size() const { return last_ - first_; }
+
+  //! \brief Return the i'th id in the range.
+  constexpr std::size_t operator[]( std::size_t i ) const
+  { return first_ + i; }
+
+  //! \brief Return the first id in the range.
+  constexpr std::size_t front() const { return first_; }
+
+  //! \brief Iterators.
+  //! \{
+  constexpr iterator begin() const { return iterator(first_); }
+  constexpr iterator end() const { return iterator(last_); }
+  //! \}
+
+private:
+
+  //! \brief the range
+  id_t first_, last_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The burton_dual_t type indexes the corners and wedges of a mesh
+//!   implicitly.
+//!
+//! Corner and wedge ids follow from the cell-local ordering.  The corners of
+//! cell \e c are numbered consecutively in the order of vertices(c), and the
+//! wedges of a corner are numbered consecutively in pairs.  In 2d, the first
+//! wedge of a corner is attached to the edge that leads to the next vertex
+//! of the cell, and the second to the edge coming from the previous vertex.
+//! In 3d, each face of the cell that touches the corner vertex contributes
+//! one pair, with the first wedge on the edge that leads to the next vertex
+//! of the outward oriented face.  All wedge facet normals point out of the
+//! cell.
+//!
+//! Only a handful of compact incidence arrays and the wedge geometry are
+//! stored; no mesh entities are created.  The arrays are not zeroed when
+//! they are allocated.  The corner and wedge arrays are first written in
+//! loops over the cells with a static schedule, like the solver loops
+//! that walk the corners of each cell.  So under a first-touch policy,
+//! each thread's part of them ends up in memory local to that thread.
+//!
+//! \tparam N The dimension of the mesh.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+class burton_dual_t {
+
+public:
+
+  //============================================================================
+  // Typedefs
+  //============================================================================
+
+  //! the mesh traits
+  using config_t = burton_config_t<N>;
+
+  //! Type of floating point.
+  using real_t = typename config_t::real_t;
+
+  //! Physics vector type.
+  using vector_t = typename config_t::vector_t;
+
+  //! Reduced precision physics vector type.
+  using storage_vector_t = typename config_t::storage_vector_t;
+
+  //! The type used for loop indexing.
+  using counter_t = typename config_t::counter_t;
+
+  //! The id type.
+  using id_t = common::local_index_t;
+
+  //! A list of ids.
+  using id_list_t = utils::array_ref<id_t>;
+
+  //! The storage type, which is placed by the threads that first write it.
+  template< typename T >
+  using storage_t = utils::first_touch_vector<T>;
+
+  //! A range of ids.
+  using id_range_t = burton_id_range_t;
+
+  //! The dimension of the mesh.
+  static constexpr auto num_dimensions = config_t::num_dimensions;
+
+  //============================================================================
+  // Construction
+  //============================================================================
+
+  //! \brief Build the corner and wedge incidences of a mesh.
+  //! \param [in] mesh  The primal mesh.
+  template< typename M >
+  void build( const M & mesh );
+
+  //! \brief Recompute the wedge geometry.
+  //! \param [in] mesh  The primal mesh.
+  //! \param [in] edge_midpoint  The edge midpoints, indexable by edge id.
+  //! \param [in] face_midpoint  The face midpoints, indexable by face id.
+  template< typename M, typename E, typename F >
+  void update_geometry(
+    const M & mesh, const E & edge_midpoint, const F & face_midpoint
+  );
+
+  //! \brief Release all the storage.
+  void clear();
+
+  //============================================================================
+  // Corner Interface
+  //============================================================================
+
+  //! \brief Return the number of corners.
+  std::size_t num_corners() const
+  { return corner_cells_.size(); }
+
+  //! \brief Return all the corner ids.
+  id_range_t corners() const
+  { return { 0, static_cast<id_t>( num_corners() ) }; }
+
+  //! \brief Return the corners of a cell.
+  //! \param [in] c  The cell id.
+  id_range_t cell_corners( std::size_t c ) const
+  { return { cell_corner_offsets_[c], cell_corner_offsets_[c+1] }; }
+
+  //! \brief Return the corners attached to a vertex.
+  //! \param [in] v  The vertex id.
+  id_list_t vertex_corners( std::size_t v ) const
+  {
+    auto first = vertex_corner_offsets_[v];
+    auto last = vertex_corner_offsets_[v+1];
+    return { vertex_corners_.data() + first, last - first };
+  }
+
+  //! \brief Return the cell a corner belongs to.
+  //! \param [in] cn  The corner id.
+  id_t corner_cell( std::size_t cn ) const
+  { return corner_cells_[cn]; }
+
+  //! \brief Return the vertex a corner is attached to.
+  //! \param [in] cn  The corner id.
+  id_t corner_vertex( std::size_t cn ) const
+  { return corner_vertices_[cn]; }
+
+  //============================================================================
+  // Wedge Interface
+  //============================================================================
+
+  //! \brief Return the number of wedges.
+  std::size_t num_wedges() const
+  { return wedge_faces_.size(); }
+
+  //! \brief Return all the wedge ids.
+  id_range_t wedges() const
+  { return { 0, static_cast<id_t>( num_wedges() ) }; }
+
+  //! \brief Return the wedges of a corner, in pairs.
+  //! \param [in] cn  The corner id.
+  id_range_t corner_wedges( std::size_t cn ) const
+  { return { corner_wedge_offsets_[cn], corner_wedge_offsets_[cn+1] }; }
+
+  //! \brief Return the face a wedge is attached to.
+  //! \remark In 2d, this is the same as the edge.
+  //! \param [in] w  The wedge id.
+  id_t wedge_face( std::size_t w ) const
+  { return wedge_faces_[w]; }
+
+  //! \brief Return the edge a wedge is attached to.
+  //! \param [in] w  The wedge id.
+  id_t wedge_edge( std::size_t w ) const
+  { return wedge_edges_[w]; }
+
+  //! \brief Return the outward unit facet normals of the wedges.
+  const storage_t<vector_t> & facet_normals() const
+  { return wedge_facet_normals_; }
+
+  //! \brief Return the facet areas of the wedges.
+  const storage_t<real_t> & facet_areas() const
+  { return wedge_facet_areas_; }
+
+  //! \brief Return the facet centroids of the wedges.
+  //! \remark These are only needed for boundary conditions, so they are
+  //!   stored in reduced precision when mixed precision is enabled.
+  const storage_t<storage_vector_t> & facet_centroids() const
+  { return wedge_facet_centroids_; }
+
+private:
+
+  //============================================================================
+  // Private Data
+  //============================================================================
+
+  //! \brief The first corner of each cell, with one extra entry.
+  storage_t<id_t> cell_corner_offsets_;
+  //! \brief The first wedge of each corner, with one extra entry.
+  storage_t<id_t> corner_wedge_offsets_;
+
+  //! \brief The cell of each corner.
+  storage_t<id_t> corner_cells_;
+  //! \brief The vertex of each corner.
+  storage_t<id_t> corner_vertices_;
+
+  //! \brief The corners attached to each vertex in compressed row storage.
+  //! \{
+  storage_t<id_t> vertex_corner_offsets_;
+  storage_t<id_t> vertex_corners_;
+  //! \}
+
+  //! \brief The face and edge of each wedge.
+  //! \{
+  storage_t<id_t> wedge_faces_;
+  storage_t<id_t> wedge_edges_;
+  //! \}
+
+  //! \brief The wedge geometry.
+  //! \{
+  storage_t<vector_t> wedge_facet_normals_;
+  storage_t<real_t> wedge_facet_areas_;
+  storage_t<storage_vector_t> wedge_facet_centroids_;
+  //! \}
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Find the edge of an entity that joins two vertices.
+//! \param [in] mesh  The mesh.
+//! \param [in] es  The edges to search.
+//! \param [in] a,b  The vertex ids.
+//! \return the edge id.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename E >
+std::size_t find_edge(
+  const M & mesh, const E & es, std::size_t a, std::size_t b
+) {
+  for ( auto e : es ) {
+    auto vs = mesh.vertices(e);
+    auto v0 = vs[0].id(), v1 = vs[1].id();
+    if ( (v0 == a && v1 == b) || (v0 == b && v1 == a) ) return e.id();
+  }
+  raise_runtime_error(
+    "No edge joins vertices " << a << " and " << b
+  );
+  return 0;
+}
+
+} // namespace detail
+
+//==============================================================================
+// Build the incidences
+//==============================================================================
+template< std::size_t N >
+template< typename M >
+void burton_dual_t<N>::build( const M & mesh )
+{
+
+  auto cs = mesh.cells();
+  auto num_cells = cs.size();
+  auto num_verts = mesh.num_vertices();
+
+  //----------------------------------------------------------------------------
+  // count the corners and wedges of each cell
+
+  std::vector<std::size_t> cell_wedges( num_cells+1, 0 );
+  cell_corner_offsets_.resize( num_cells+1 );
+  cell_corner_offsets_[0] = 0;
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    auto c = cs[i];
+    auto num_cell_verts = mesh.vertices(c).size();
+    cell_corner_offsets_[i+1] = num_cell_verts;
+    if ( num_dimensions == 2 )
+      cell_wedges[i+1] = 2*num_cell_verts;
+    else {
+      std::size_t n = 0;
+      for ( auto f : mesh.faces(c) ) n += 2*mesh.vertices(f).size();
+      cell_wedges[i+1] = n;
+    }
+  }
+
+  // sum in wide integers so overflows can be caught
+  std::size_t num_corners = 0, num_wedges = 0;
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    num_corners += cell_corner_offsets_[i+1];
+    cell_corner_offsets_[i+1] = num_corners;
+    num_wedges += cell_wedges[i+1];
+    cell_wedges[i+1] = num_wedges;
+  }
+
+  if ( num_wedges > std::numeric_limits<id_t>::max() )
+    raise_runtime_error(
+      "Too many wedges (" << num_wedges << ") for " << 8*sizeof(id_t)
+      << " bit local ids"
+    );
+
+  corner_cells_.resize( num_corners );
+  corner_vertices_.resize( num_corners );
+  corner_wedge_offsets_.resize( num_corners+1 );
+  wedge_faces_.resize( num_wedges );
+  wedge_edges_.resize( num_wedges );
+
+  //----------------------------------------------------------------------------
+  // fill in the corners and wedges of each cell.  This is the first write to
+  // them, so it uses the same static schedule as the solver loops.
+
+  #pragma omp parallel for schedule(static)
+  for ( counter_t i=0; i<num_cells; ++i ) {
+
+    auto c = cs[i];
+    auto vs = mesh.vertices(c);
+    auto num_cell_verts = vs.size();
+    auto first_corner = cell_corner_offsets_[i];
+
+    for ( std::size_t k=0; k<num_cell_verts; ++k ) {
+      corner_cells_[first_corner + k] = i;
+      corner_vertices_[first_corner + k] = vs[k].id();
+    }
+
+    auto w = cell_wedges[i];
+
+    // in 2d, the faces are the edges
+    if ( num_dimensions == 2 ) {
+      auto es = mesh.edges(c);
+      for ( std::size_t k=0; k<num_cell_verts; ++k ) {
+        auto v = vs[k].id();
+        auto next = vs[ (k+1) % num_cell_verts ].id();
+        auto prev = vs[ (k+num_cell_verts-1) % num_cell_verts ].id();
+        corner_wedge_offsets_[first_corner + k] = w;
+        auto right = detail::find_edge( mesh, es, v, next );
+        auto left = detail::find_edge( mesh, es, prev, v );
+        wedge_edges_[w] = wedge_faces_[w] = right; w++;
+        wedge_edges_[w] = wedge_faces_[w] = left; w++;
+      }
+    }
+
+    // in 3d, each face touching the vertex contributes a pair
+    else {
+      auto fs = mesh.faces(c);
+      for ( std::size_t k=0; k<num_cell_verts; ++k ) {
+        auto v = vs[k].id();
+        corner_wedge_offsets_[first_corner + k] = w;
+        for ( auto f : fs ) {
+          auto fvs = mesh.vertices(f);
+          auto num_face_verts = fvs.size();
+          std::size_t pos = 0;
+          while ( pos < num_face_verts && fvs[pos].id() != v ) pos++;
+          if ( pos == num_face_verts ) continue;
+          // the face vertices are ordered for the first cell
+          auto outward = ( mesh.cells(f).front() == c );
+          auto next = fvs[ (pos+1) % num_face_verts ].id();
+          auto prev = fvs[ (pos+num_face_verts-1) % num_face_verts ].id();
+          if ( !outward ) std::swap( next, prev );
+          auto es = mesh.edges(f);
+          wedge_faces_[w] = f.id();
+          wedge_edges_[w] = detail::find_edge( mesh, es, v, next ); w++;
+          wedge_faces_[w] = f.id();
+          wedge_edges_[w] = detail::find_edge( mesh, es, prev, v ); w++;
+        }
+      }
+    }
+
+  } // cells
+
+  corner_wedge_offsets_.back() = num_wedges;
+
+  //----------------------------------------------------------------------------
+  // invert the corner to vertex map
+
+  // the vertex lists are not walked by any static loop, so they are just
+  // spread over the threads by vertex
+  vertex_corner_offsets_.resize( num_verts+1 );
+  counter_t num_vert_counters = num_verts + 1;
+  #pragma omp parallel for schedule(static)
+  for ( counter_t v=0; v<num_vert_counters; ++v )
+    vertex_corner_offsets_[v] = 0;
+
+  for ( auto v : corner_vertices_ ) vertex_corner_offsets_[v+1]++;
+  for ( std::size_t v=0; v<num_verts; ++v )
+    vertex_corner_offsets_[v+1] += vertex_corner_offsets_[v];
+
+  vertex_corners_.resize( num_corners );
+  #pragma omp parallel for schedule(static)
+  for ( counter_t v=0; v<static_cast<counter_t>(num_verts); ++v ) {
+    auto last = vertex_corner_offsets_[v+1];
+    for ( auto j=vertex_corner_offsets_[v]; j<last; ++j ) 
+      vertex_corners_[j] = 0;
+  }
+
+  // corners are visited in order, so each list ends up sorted
+  std::vector<id_t> pos(
+    vertex_corner_offsets_.begin(), std::prev( vertex_corner_offsets_.end() )
+  );
+  for ( std::size_t cn=0; cn<num_corners; ++cn )
+    vertex_corners_[ pos[ corner_vertices_[cn] ]++ ] = cn;
+
+  //----------------------------------------------------------------------------
+  // size the geometry, it is first written by update_geometry()
+  wedge_facet_normals_.resize( num_wedges );
+  wedge_facet_areas_.resize( num_wedges );
+  wedge_facet_centroids_.resize( num_wedges );
+
+}
+
+//==============================================================================
+// Update the geometry
+//==============================================================================
+template< std::size_t N >
+template< typename M, typename E, typename F >
+void burton_dual_t<N>::update_geometry(
+  const M & mesh, const E & edge_midpoint, const F & face_midpoint
+) {
+
+  using triangle_t = geom::shapes::triangle<num_dimensions>;
+
+  auto vs = mesh.vertices();
+  counter_t num_cells = cell_corner_offsets_.size() - 1;
+
+  // the corners are swept cell by cell, like the solver loops, so the
+  // threads write the same wedges here as they did when they were built
+  #pragma omp parallel for schedule(static)
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    for ( auto cn : cell_corners(i) ) {
+      const auto & v = vs[ corner_vertices_[cn] ]->coordinates();
+      auto first = corner_wedge_offsets_[cn];
+      auto last = corner_wedge_offsets_[cn+1];
+      for ( auto w=first; w<last; w+=2 ) {
+        const auto & er = edge_midpoint[ wedge_edges_[w] ];
+        const auto & el = edge_midpoint[ wedge_edges_[w+1] ];
+        auto & nr = wedge_facet_normals_[w];
+        auto & nl = wedge_facet_normals_[w+1];
+        if ( num_dimensions == 2 ) {
+          nr[0] = er[1] - v[1];  nr[1] = v[0] - er[0];
+          nl[0] = v[1] - el[1];  nl[1] = el[0] - v[0];
+          wedge_facet_centroids_[w]   = 0.5 * ( er + v );
+          wedge_facet_centroids_[w+1] = 0.5 * ( el + v );
+        }
+        else {
+          const auto & f = face_midpoint[ wedge_faces_[w] ];
+          nr = triangle_t::normal( v, er, f );
+          nl = triangle_t::normal( v, f, el );
+          wedge_facet_centroids_[w]   = triangle_t::centroid( v, f, er );
+          wedge_facet_centroids_[w+1] = triangle_t::centroid( v, f, el );
+        }
+      }
+      for ( auto w=first; w<last; ++w ) {
+        wedge_facet_areas_[w] = abs( wedge_facet_normals_[w] );
+        wedge_facet_normals_[w] /= wedge_facet_areas_[w];
+      }
+    }
+  }
+
+}
+
+//==============================================================================
+// Release the storage
+//==============================================================================
+template< std::size_t N >
+void burton_dual_t<N>::clear()
+{
+  *this = burton_dual_t{};
+}
+
+} // namespace burton
+} // namespace mesh
+} // namespace flecsale
@@ -12,6 +12,7 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_fields.h"
 
 
 #ifdef HAVE_EXODUS
@@ -249,16 +250,19 @@ public:
     auto rspav = flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rspav );
     num_nf += rspav.size();
     // int scalars persistent at vertices
     auto ispav = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( ispav );
     num_nf += ispav.size();
     // real vectors persistent at vertices
     auto rvpav = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rvpav );
     num_nf += num_dims*rvpav.size();
 
     // variable extension for vectors
@@ -334,20 +338,19 @@ public:
     // number of element fields
     int num_ef = 0;
 
-    // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
-      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
-    num_ef += rspac.size();
+    // real scalars persistent at cells, in either precision
+    for_each_output_real_field( m, [&]( auto && ) { num_ef++; } );
     // int scalars persistent at cells
     auto ispac = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( ispac );
     num_ef += ispac.size();
     // real vectors persistent at cells
     auto rvpac = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( rvpac );
     num_ef += num_dims*rvpac.size();
 
     // put the number of element fields
@@ -359,11 +362,11 @@ public:
     // fill element variable names array
     inum = 1;
 
-    for(auto sf: rspac) {
+    for_each_output_real_field( m, [&]( auto && sf ) {
       auto label = validate_string( sf.label() );
       status = ex_put_var_name(exoid_, "e", inum++, label.c_str());
       assert(status == 0);
-    } // for
+    } );
     for(auto sf: ispac) {
       auto label = validate_string( sf.label() );
       status = ex_put_var_name(exoid_, "e", inum++, label.c_str());
@@ -399,12 +402,12 @@ public:
       inum = 1;
 
       // element field buffer
-      for(auto sf: rspac) {
+      for_each_output_real_field( m, [&]( auto && sf ) {
         size_t cid = 0;
         for(auto c: elem_this_blk) tmp[cid++] = sf[c];
         status = ex_put_elem_var(exoid_, time_step, inum++, elem_blk_id, num_elem_this_blk, tmp.data());
         assert(status == 0);
-      } // for
+      } );
       for(auto sf: ispac) {
         // cast int fields to real_t
         size_t cid = 0;
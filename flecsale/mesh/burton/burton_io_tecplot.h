@@ -12,6 +12,7 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_fields.h"
 #include "flecsale/utils/errors.h"
 #include "flecsale/utils/string_utils.h"
 
@@ -48,6 +49,7 @@ public:
   // other useful types
   using    size_t = typename mesh_t::size_t;
   using counter_t = typename mesh_t::counter_t;
+  using local_index_t = typename mesh_t::local_index_t;
   using integer_t = typename mesh_t::integer_t;
   using    real_t = typename mesh_t::real_t;
   using   point_t = typename mesh_t::point_t;
@@ -88,7 +90,7 @@ public:
       elem_zone_map( num_zones ),
       region_map( num_zones )
     {
-      std::vector< size_t > local_elem_id( num_zones, 0 );
+      std::vector< local_index_t > local_elem_id( num_zones, 0 );
 
       // determine a local cell zone ordering
       for ( auto c : m.cells() ) {
@@ -126,7 +128,7 @@ public:
         num_faces_this_zone += mesh.faces(c).size();
       
       // create a face map
-      std::vector< size_t > faces_this_zone; 
+      std::vector< local_index_t > faces_this_zone; 
       faces_this_zone.reserve( num_faces_this_zone );
       
       for ( auto c : elem_this_zone ) 
@@ -241,7 +243,7 @@ public:
     
     //! \brief  storage for the zone-to-element mapping
     std::vector< 
-      std::map< size_t, size_t > 
+      std::map< local_index_t, local_index_t > 
     > elem_zone_map;
 
     //! \brief  storage for the region-to-zone mapping
@@ -353,16 +355,19 @@ struct burton_io_tecplot_ascii_t :
     auto rspav = flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rspav );
     num_nf += rspav.size();
     // int scalars persistent at vertices
     auto ispav = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( ispav );
     num_nf += ispav.size();
     // real vectors persistent at vertices
     auto rvpav = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rvpav );
     num_nf += num_dims*rvpav.size();
 
     // fill node variable names array
@@ -389,28 +394,27 @@ struct burton_io_tecplot_ascii_t :
 
     // number of element fields
     int num_ef = 0;
-    // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
-      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
-    num_ef += rspac.size();
+    // real scalars persistent at cells, in either precision
+    for_each_output_real_field( m, [&]( auto && ) { num_ef++; } );
     // int scalars persistent at cells
     auto ispac = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( ispac );
     num_ef += ispac.size();
     // real vectors persistent at cells
     auto rvpac = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( rvpac );
     num_ef += num_dims*rvpac.size();
 
 
     // fill element variable names array
-    for(auto sf: rspac) {
+    for_each_output_real_field( m, [&]( auto && sf ) {
       auto label = validate_string( sf.label() );
       variables.emplace_back( make_pair( label, tec_var_location_t::cell ) );
-    }
+    } );
     for(auto sf: ispac) {
       auto label = validate_string( sf.label() );
       variables.emplace_back( make_pair( label, tec_var_location_t::cell ) );
@@ -547,9 +551,9 @@ struct burton_io_tecplot_ascii_t :
       // cell field data
 
       // element field buffer
-      for(auto sf: rspac) {
+      for_each_output_real_field( m, [&]( auto && sf ) {
         for(auto c: elem_this_zone) ofs << sf[c] << endl;
-      } // for
+      } );
       for(auto sf: ispac) {
         for(auto c: elem_this_zone) ofs << sf[c] << endl;
       } // for
@@ -733,14 +737,17 @@ struct burton_io_tecplot_binary_t :
     auto rspav = flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rspav );
     // int scalars persistent at vertices
     auto ispav = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( ispav );
     // real vectors persistent at vertices
     auto rvpav = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rvpav );
 
     // fill node variable names array
     for(auto sf: rspav) {
@@ -763,25 +770,23 @@ struct burton_io_tecplot_binary_t :
     //----------------------------------------------------------------------------
     // element field data
 
-    // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
-      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
     // int scalars persistent at cells
     auto ispac = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( ispac );
     // real vectors persistent at cells
     auto rvpac = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( rvpac );
 
 
     // fill element variable names array
-    for(auto sf: rspac) {
+    for_each_output_real_field( m, [&]( auto && sf ) {
       auto label = validate_string( sf.label() );
       variables.emplace_back( make_pair( label, tec_var_location_t::cell ) );
-    }
+    } );
     for(auto sf: ispac) {
       auto label = validate_string( sf.label() );
       variables.emplace_back( make_pair( label, tec_var_location_t::cell ) );
@@ -980,13 +985,13 @@ struct burton_io_tecplot_binary_t :
       // cell field data
 
       // element field buffer
-      for(auto sf: rspac) {
+      for_each_output_real_field( m, [&]( auto && sf ) {
         size_t cid = 0;
         vector<tec_real_t> vals( num_elem_this_zone );
         for(auto c: elem_this_zone) vals[cid++] = sf[c];
         status = TECDAT112( &num_elem_this_zone, vals.data(), &VIsDouble );
         assert( status == 0 && "error with TECDAT" );
-      } // for
+      } );
       for(auto sf: ispac) {
         // cast int fields to real_t
         size_t cid = 0;
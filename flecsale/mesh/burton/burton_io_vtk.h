@@ -14,6 +14,7 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_fields.h"
 #include "flecsale/mesh/vtk_utils.h"
 #include "flecsale/utils/errors.h"
 
@@ -155,6 +156,7 @@ public:
     using std::vector;
 
     using   size_t = typename mesh_t::size_t;
+    using local_index_t = typename mesh_t::local_index_t;
     using   real_t = typename mesh_t::real_t;
     using integer_t= typename mesh_t::integer_t;
     using vector_t = typename mesh_t::vector_t;
@@ -255,7 +257,7 @@ public:
           auto face_verts = m.vertices(f);
           auto num_face_verts = face_verts.size();
           // copy the face vert ids
-          vector< size_t > face_vert_ids( num_face_verts );
+          vector< local_index_t > face_vert_ids( num_face_verts );
           std::transform( 
             face_verts.begin(), face_verts.end(), face_vert_ids.begin(),
             [](auto && v) { return v.id(); } 
@@ -294,6 +296,7 @@ public:
     auto rspav = flecsi_get_accessors_all(
       m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rspav );
     for(auto sf: rspav) {
       auto label = validate_string( sf.label() );
       for(auto v: m.vertices()) vals[v.id()] = sf[v];
@@ -305,6 +308,7 @@ public:
     auto ispav = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( ispav );
     for(auto sf: ispav) {
       auto label = validate_string( sf.label() );
       for(auto v: m.vertices()) ivals[v.id()] = sf[v];
@@ -318,6 +322,7 @@ public:
     auto rvpav = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
     );
+    filter_output_fields( rvpav );
     for(auto vf: rvpav) {
       auto label = validate_string( vf.label() );
       for(auto v: m.vertices()) {
@@ -341,21 +346,19 @@ public:
     //----------------------------------------------------------------------------
     // element field data
 
-    // real scalars persistent at cells
-    auto rspac = flecsi_get_accessors_all(
-      m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-    );
-    for(auto sf: rspac) {
+    // real scalars persistent at cells, in either precision
+    for_each_output_real_field( m, [&]( auto && sf ) {
       auto label = validate_string( sf.label() );
       for(auto c: m.cells()) vals[c.id()] = sf[c];
       status = writer.write_field( label.c_str(), vals );
       assert( status == 0 && "error with cell data" );
-    } // for
+    } );
 
     // int scalars persistent at cells
     auto ispac = flecsi_get_accessors_all(
       m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( ispac );
     for(auto sf: ispac) {
       auto label = validate_string( sf.label() );
       for(auto c: m.cells()) ivals[c.id()] = sf[c];
@@ -369,6 +372,7 @@ public:
     auto rvpac = flecsi_get_accessors_all(
       m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
     );
+    filter_output_fields( rvpac );
     for(auto vf: rvpac) {
       auto label = validate_string( vf.label() );
       for(auto c: m.cells()) {
@@ -12,6 +12,7 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_fields.h"
 #ifdef HAVE_VTK
 #include "flecsale/mesh/vtk_utils.h"
 #endif
@@ -164,6 +165,7 @@ public:
       auto rspav = flecsi_get_accessors_all(
         m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
       );
+      filter_output_fields( rspav );
       for(auto sf: rspav) {
         auto label = validate_string( sf.label() );      
         rvals->SetName( label.c_str() );
@@ -181,6 +183,7 @@ public:
       auto ispav = flecsi_get_accessors_all(
         m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
       );
+      filter_output_fields( ispav );
       for(auto sf: ispav) {
         auto label = validate_string( sf.label() );
         ivals->SetName( label.c_str() );
@@ -199,6 +202,7 @@ public:
       auto rvpav = flecsi_get_accessors_all(
         m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
       );
+      filter_output_fields( rvpav );
       for(auto vf: rvpav) {
         auto label = validate_string( vf.label() );
         vvals->SetName( label.c_str() );
@@ -221,22 +225,17 @@ public:
       // get the point data object
       auto cd = ug->GetCellData();
 
-      // real scalars persistent at cells
-      rvals = vtk_array_t<real_t>::type::New();
-      rvals->SetNumberOfValues( num_cells_this_block );
-
-      auto rspac = flecsi_get_accessors_all(
-        m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-      );
-      for(auto sf: rspac) {
+      // real scalars persistent at cells, in either precision
+      for_each_output_real_field( m, [&]( auto && sf ) {
         auto label = validate_string( sf.label() );      
-        rvals->SetName( label.c_str() );
+        auto svals = vtk_array_t<real_t>::type::New();
+        svals->SetNumberOfValues( num_cells_this_block );
+        svals->SetName( label.c_str() );
         size_t cid = 0;
-        for(auto c: cells_this_block) rvals->SetValue( cid++, sf[c] );
-        cd->AddArray( rvals );
-      } // for
-
-      rvals->Delete();
+        for(auto c: cells_this_block) svals->SetValue( cid++, sf[c] );
+        cd->AddArray( svals );
+        svals->Delete();
+      } );
 
       // int scalars persistent at cells
       ivals = vtk_array_t<integer_t>::type::New();
@@ -245,6 +244,7 @@ public:
       auto ispac = flecsi_get_accessors_all(
         m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
       );
+      filter_output_fields( ispac );
       for(auto sf: ispac) {
         auto label = validate_string( sf.label() );
         ivals->SetName( label.c_str() );
@@ -263,6 +263,7 @@ public:
       auto rvpac = flecsi_get_accessors_all(
         m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
       );
+      filter_output_fields( rvpac );
       for(auto vf: rvpac) {
         auto label = validate_string( vf.label() );
         vvals->SetName( label.c_str() );
@@ -290,6 +291,10 @@ public:
     auto writer = vtkSmartPointer<vtkXMLMultiBlockDataWriter>::New();
     writer->SetFileName( name.c_str() );
     writer->SetInputDataObject( mb );
+    if ( current_output_options().compress )
+      writer->SetCompressorTypeToZLib();
+    else
+      writer->SetCompressorTypeToNone();
 
     writer->Write();
 
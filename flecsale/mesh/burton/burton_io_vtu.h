@@ -13,6 +13,7 @@
 // user includes
 #include "flecsi/io/io_base.h"
 #include "flecsale/mesh/burton/burton_mesh.h"
+#include "flecsale/mesh/output_fields.h"
 #ifdef HAVE_VTK
 #include "flecsale/mesh/vtk_utils.h"
 #endif
@@ -83,6 +84,10 @@ public:
     auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
     writer->SetFileName( name.c_str() );
     writer->SetInputDataObject( ug );
+    if ( current_output_options().compress )
+      writer->SetCompressorTypeToZLib();
+    else
+      writer->SetCompressorTypeToNone();
 
     writer->Write();
 
@@ -9,14 +9,20 @@
 #pragma once
 
 // user includes
+#include "flecsale/mesh/burton/burton_dual.h"
 #include "flecsale/mesh/burton/burton_mesh_topology.h"
+#include "flecsale/mesh/burton/burton_structured.h"
 #include "flecsale/mesh/burton/burton_types.h"
+#include "flecsale/utils/array_ref.h"
 #include "flecsale/utils/errors.h"
 
 #include "flecsi/data/data.h"
 #include "flecsi/execution/task.h"
 
 // system includes
+#include <algorithm>
+#include <cassert>
+#include <numeric>
 #include <set>
 #include <string>
 #include <sstream>
@@ -51,6 +57,17 @@ enum data_attributes_t : size_t {
 
 } // namespace attributes
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The amount of checking performed by burton_mesh_t::is_valid.
+////////////////////////////////////////////////////////////////////////////////
+enum class validation_level_t {
+  //! Only check the entity counts, the connectivity sizes and the face
+  //! orientation.
+  cheap,
+  //! Also audit the corners and wedges.
+  full
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief A specialization of the flecsi low-level mesh topology, state and
 ///   execution models.
@@ -90,18 +107,30 @@ public:
   //! Floating point data type.
   using real_t = typename config_t::real_t;
 
+  //! Reduced precision floating point data type.
+  using storage_real_t = typename config_t::storage_real_t;
+
   //! The size type.
   using size_t = typename config_t::size_t;
 
   //! The type used for loop indexing
   using counter_t = typename config_t::counter_t;
 
+  //! Process-local id type.
+  using local_index_t = typename config_t::local_index_t;
+
+  //! Global id type.
+  using global_index_t = typename config_t::global_index_t;
+
   //! Point data type.
   using point_t = typename config_t::point_t;
 
   //! Physics vector type.
   using vector_t = typename config_t::vector_t;
 
+  //! Reduced precision physics vector type.
+  using storage_vector_t = typename config_t::storage_vector_t;
+
   //! Vertex type.
   using vertex_t = typename types_t::vertex_t;
 
@@ -120,6 +149,14 @@ public:
   //! Corner type.
   using corner_t = typename types_t::corner_t;
 
+#ifdef USE_IMPLICIT_DUAL
+  //! The implicitly indexed corners and wedges.
+  using dual_t = burton_dual_t<N>;
+#endif
+
+  //! The structured grid description.
+  using structured_t = burton_structured_t<N>;
+
   //! \brief The locations of different bits that we set as flags
   using bits = typename config_t::bits;
 
@@ -162,6 +199,9 @@ public:
         create_cell( elem_vs );   
     } // for
 
+    // the entities are numbered the same, so the grid layout carries over
+    structured_ = src.structured_;
+
     // initialize everything
     init();
 
@@ -173,6 +213,9 @@ public:
     for ( auto c : cells() ) 
       c->region() = src_cells[c.id()]->region();
     set_num_regions( num_reg );
+
+    // the entities are numbered the same, so ownership carries over
+    set_num_owned( src.num_owned_cells(), src.num_owned_vertices() );
   }
 
   //! \brief allow move construction
@@ -183,6 +226,18 @@ public:
   {
     // call the base type operator to move the data
     base_t::operator=(std::move(other));
+    // move the tagged sets
+    face_sets_ = std::move(other.face_sets_);
+    edge_sets_ = std::move(other.edge_sets_);
+    vert_sets_ = std::move(other.vert_sets_);
+    boundary_faces_ = std::move(other.boundary_faces_);
+#ifdef USE_IMPLICIT_DUAL
+    dual_ = std::move(other.dual_);
+#endif
+    structured_ = std::move(other.structured_);
+    is_uniform_ = other.is_uniform_;
+    region_offsets_ = std::move(other.region_offsets_);
+    region_cell_ids_ = std::move(other.region_cell_ids_);
     // reset each entity mesh pointer
     for ( auto v : vertices() ) v->reset( *this );
     for ( auto e : edges() ) e->reset( *this );
@@ -213,12 +268,9 @@ public:
       case attributes::cells:
         return base_t::num_entities(cell_t::dimension);
       case attributes::corners:
-        return 
-          base_t::template 
-            num_entities<corner_t::dimension, corner_t::domain>();
+        return num_corners();
       case attributes::wedges:
-        return 
-          base_t::template num_entities<wedge_t::dimension, wedge_t::domain>();
+        return num_wedges();
       default:
         raise_runtime_error("unknown index space");
         return 0;
@@ -231,7 +283,7 @@ public:
   //============================================================================
 
   //! \brief Return the time associated with the mesh
-  auto time()
+  auto time() const
   {
     auto soln_time = flecsi_get_accessor(*this, mesh, time, real_t, global, 0 );
     return *soln_time;
@@ -256,7 +308,7 @@ public:
   }
 
   //! \brief Return the time associated with the mesh
-  auto time_step_counter()
+  auto time_step_counter() const
   {
     auto step = flecsi_get_accessor(*this, mesh, time_step, size_t, global, 0 );
     return *step;
@@ -674,7 +726,11 @@ public:
   //! \return The number of wedges in the burton mesh.
   size_t num_wedges() const
   {
+#ifdef USE_IMPLICIT_DUAL
+    return dual_.num_wedges();
+#else
     return base_t::template num_entities<wedge_t::dimension, wedge_t::domain>();
+#endif
   }
 
   //! \brief Return all wedges in the burton mesh.
@@ -754,7 +810,7 @@ public:
   //! \brief Return the precomputed facet centroids for each wedge.
   decltype(auto) wedge_facet_centroids() const 
   {
-    return flecsi_get_accessor( *this, mesh, wedge_facet_centroid, vector_t, dense, 0 );
+    return flecsi_get_accessor( *this, mesh, wedge_facet_centroid, storage_vector_t, dense, 0 );
   }
 
   //! \brief Return the precomputed facet area for each wdge.
@@ -771,8 +827,12 @@ public:
   //! \return The number of corners in the burton mesh.
   size_t num_corners() const
   {
+#ifdef USE_IMPLICIT_DUAL
+    return dual_.num_corners();
+#else
     return 
       base_t::template num_entities<corner_t::dimension, corner_t::domain>();
+#endif
   }
 
   //! \brief Return all corners in the burton mesh.
@@ -846,6 +906,95 @@ public:
   }
 
 
+#ifdef USE_IMPLICIT_DUAL
+
+  //============================================================================
+  // Implicit Corner and Wedge Interface
+  //============================================================================
+
+  //! \brief Return the implicitly indexed corners and wedges.
+  //!
+  //! These replace the corner and wedge entities above, which are empty 
+  //! when built with USE_IMPLICIT_DUAL.
+  const dual_t & dual() const
+  {
+    return dual_;
+  }
+
+#endif
+
+  //============================================================================
+  // Structured Grid Interface
+  //============================================================================
+
+  //! \brief Return true if the mesh is a logically structured grid.
+  //!
+  //! Structured meshes still have all the usual entities and connectivity,
+  //! but their ids can also be computed from (i,j,k) indices with
+  //! structured(), and the geometry is computed directly from the grid
+  //! spacing while the vertices have not moved.
+  bool is_structured() const
+  {
+    return structured_.is_set();
+  }
+
+  //! \brief Return the description of the structured grid.
+  const structured_t & structured() const
+  {
+    return structured_;
+  }
+
+  //! \brief Flag the mesh as a uniform structured grid.
+  //!
+  //! This must be called before init(), with the entities created in the
+  //! order used by box().
+  //!
+  //! \param [in] num_cells  The number of cells in each direction.
+  //! \param [in] min,max  The bounding box of the grid.
+  void set_structured( 
+    const typename structured_t::ijk_t & num_cells,
+    const point_t & min,
+    const point_t & max
+  ) {
+    structured_.set( num_cells, min, max );
+  }
+
+  //============================================================================
+  // Ownership Interface
+  //============================================================================
+
+  //! \brief Return the number of cells owned by this process.
+  //!
+  //! When the mesh is distributed, the owned cells are numbered first and
+  //! are followed by the ghost cells.
+  //! \return The number of owned cells.
+  size_t num_owned_cells() const
+  {
+    auto n = flecsi_get_accessor(*this, mesh, num_owned_cells, size_t, global, 0 );
+    return *n;
+  }
+
+  //! \brief Return the number of vertices owned by this process.
+  //!
+  //! When the mesh is distributed, the owned vertices are numbered first and
+  //! are followed by the ghost vertices.
+  //! \return The number of owned vertices.
+  size_t num_owned_vertices() const
+  {
+    auto n = flecsi_get_accessor(*this, mesh, num_owned_vertices, size_t, global, 0 );
+    return *n;
+  }
+
+  //! \brief Set the number of entities owned by this process.
+  //! \param [in]  num_cells  The number of owned cells.
+  //! \param [in]  num_verts  The number of owned vertices.
+  void set_num_owned(size_t num_cells, size_t num_verts)
+  {
+    *flecsi_get_accessor(*this, mesh, num_owned_cells, size_t, global, 0 ) = num_cells;
+    *flecsi_get_accessor(*this, mesh, num_owned_vertices, size_t, global, 0 ) = num_verts;
+  }
+
+
   //============================================================================
   // Region Interface
   //============================================================================
@@ -859,11 +1008,65 @@ public:
   }
 
   //! \brief set the number of regions in the burton mesh.
+  //!
+  //! This also regroups the cells by region, so call it after the cell
+  //! regions have been changed.
+  //!
   //! \param [in]  n  The number of regions in the burton mesh.
   void set_num_regions(size_t n)
   {
     auto n_acc = flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0 ) ;
     *n_acc = n;
+    index_regions();
+  }
+
+  //! \brief Return the ids of the cells in a region.
+  //!
+  //! The ids are in increasing order, so the owned cells come before the 
+  //! ghost cells.  Loops over a region touch only cells of one material, 
+  //! which lets them be written without a per-cell branch.
+  //!
+  //! \param [in]  r  The region id.
+  //! \return The cell ids.
+  utils::array_ref<counter_t> region_cell_ids(size_t r) const
+  {
+    assert( r+1 < region_offsets_.size() && "region id out of range" );
+    auto start = region_offsets_[r];
+    return utils::make_array_ref( 
+      region_cell_ids_.data() + start, region_offsets_[r+1] - start
+    );
+  }
+
+  //! \brief Group the cell ids by region.
+  //!
+  //! This is done by set_num_regions() and init(), but needs to be called 
+  //! again if the cell regions are modified without those.
+  void index_regions()
+  {
+    auto n = num_regions();
+    auto cs = cells();
+    auto num_cells = cs.size();
+
+    // count the cells in each region
+    region_offsets_.assign( n+1, 0 );
+    for ( counter_t i=0; i<num_cells; i++ ) {
+      auto r = cs[i]->region();
+      if ( r >= n )
+        raise_runtime_error( 
+          "Cell " << i << " is in region " << r << " but there are only " 
+          << n << " regions"
+        );
+      region_offsets_[r+1]++;
+    }
+    std::partial_sum( 
+      region_offsets_.begin(), region_offsets_.end(), region_offsets_.begin()
+    );
+
+    // now fill in the ids, in order
+    std::vector<counter_t> pos( region_offsets_.begin(), region_offsets_.end()-1 );
+    region_cell_ids_.resize( num_cells );
+    for ( counter_t i=0; i<num_cells; i++ )
+      region_cell_ids_[ pos[ cs[i]->region() ]++ ] = i;
   }
 
 
@@ -1033,7 +1236,9 @@ public:
   {
 
     base_t::template init<0>();
+#ifndef USE_IMPLICIT_DUAL
     base_t::template init_bindings<1>();
+#endif
 
     //mesh_.dump();
 
@@ -1069,7 +1274,7 @@ public:
     // register wedge data
     flecsi_register_data(*this, mesh, wedge_facet_area, real_t, dense, 1, attributes::wedges);
     flecsi_register_data(*this, mesh, wedge_facet_normal, vector_t, dense, 1, attributes::wedges);
-    flecsi_register_data(*this, mesh, wedge_facet_centroid, vector_t, dense, 1, attributes::wedges);
+    flecsi_register_data(*this, mesh, wedge_facet_centroid, storage_vector_t, dense, 1, attributes::wedges);
     
     // register time state
     flecsi_register_data(*this, mesh, time, real_t, global, 1 );
@@ -1084,261 +1289,169 @@ public:
     flecsi_register_data(*this, mesh, node_flags, bitfield_t, dense, 1, attributes::vertices);
     flecsi_register_data(*this, mesh, edge_flags, bitfield_t, dense, 1, attributes::edges);
 
-    auto point_flags = flecsi_get_accessor(*this, mesh, node_flags, bitfield_t, dense, 0);
-    auto edge_flags = flecsi_get_accessor(*this, mesh, edge_flags, bitfield_t, dense, 0);
-
     // register some flags for associating boundaries with entities
     flecsi_register_data(*this, mesh, node_tags, tag_list_t, dense, 1, attributes::vertices);
     flecsi_register_data(*this, mesh, edge_tags, tag_list_t, dense, 1, attributes::edges);
     flecsi_register_data(*this, mesh, face_tags, tag_list_t, dense, 1, attributes::faces);
     flecsi_register_data(*this, mesh, cell_tags, tag_list_t, dense, 1, attributes::cells);
 
-    // now set the boundary flags.
-    for ( auto f : faces() ) {
-      // if there is only one cell, it is a boundary
-      if ( f->is_boundary() ) {
-        // point flags
-        auto ps = vertices(f);
-        for ( auto p : ps ) 
-          point_flags[ p ].setbit( bits::boundary );
-        // edge flags are only for 3d
-        if ( num_dimensions == 3 ) {
-          auto es = edges(f);
-          for ( auto e : es ) 
-            edge_flags[e].setbit( bits::boundary );
-        } // dims
-      } // is_boundary
-    } // for
-
-    // identify the cell regions
+    // register the cell regions
     flecsi_register_data(*this, mesh, cell_region, size_t, dense, 1, attributes::cells);
     flecsi_register_data(*this, mesh, num_regions, size_t, global, 1);
 
-    auto cell_region = flecsi_get_accessor(*this, mesh, cell_region, size_t, dense, 0);
-    auto num_regions = flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0);
-
-    *num_regions = 1;
-
-    for ( auto c : cells() )
-      cell_region[c] = 0;
+    // register the number of entities owned by this process
+    flecsi_register_data(*this, mesh, num_owned_cells, size_t, global, 1);
+    flecsi_register_data(*this, mesh, num_owned_vertices, size_t, global, 1);
 
-    // update the geometry
-    update_geometry();
+    // now set the boundary flags.  Each thread only writes to the entities 
+    // it owns, so no synchronization is needed.
+    auto point_flags = flecsi_get_accessor(*this, mesh, node_flags, bitfield_t, dense, 0);
+    auto edge_flags = flecsi_get_accessor(*this, mesh, edge_flags, bitfield_t, dense, 0);
 
-  }
+    auto vs = vertices();
+    auto es = edges();
+    auto num_verts = vs.size();
+    auto num_edges = es.size();
 
+    #pragma omp parallel
+    {
 
-  //!---------------------------------------------------------------------------
-  //! \brief Check the burton mesh.
-  //!---------------------------------------------------------------------------
-  bool is_valid( bool raise_on_error = true )
-  {
-    // some includes
-    using math::dot_product;
+      // if there is only one cell, it is a boundary
+      #pragma omp for schedule(static) nowait
+      for ( counter_t i=0; i<num_verts; i++ ) {
+        auto p = vs[i];
+        for ( auto f : faces(p) )
+          if ( f->is_boundary() ) {
+            point_flags[ p ].setbit( bits::boundary );
+            break;
+          }
+      }
 
-    // a lambda function for raising errors or returning 
-    // false
-    auto raise_or_return = [=]( std::ostream & msg )
-      {
-        if ( raise_on_error )
-          raise_runtime_error( msg.rdbuf() );
-        else 
-          std::cerr << msg.rdbuf() << std::endl;
-        return false;
-      };
-    
-    // we use a stringstream to construct messages and pass them 
-    // simultanesously
-    std::stringstream ss;
+      // edge flags are only for 3d
+      if ( num_dimensions == 3 ) {
+        #pragma omp for schedule(static)
+        for ( counter_t i=0; i<num_edges; i++ ) {
+          auto e = es[i];
+          for ( auto f : faces(e) )
+            if ( f->is_boundary() ) {
+              edge_flags[e].setbit( bits::boundary );
+              break;
+            }
+        }
+      } // dims
 
+    } // end omp parallel
 
-    //--------------------------------------------------------------------------
-    // make sure face normal points out from first cell
-    bool bad_face = false;
+    // cache the list of boundary faces
     auto fs = faces();
     auto num_faces = fs.size();
-    
-    #pragma omp parallel for reduction( || : bad_face )
-    for( counter_t fid=0; fid<num_faces; ++fid ) {
-      auto f = fs[fid];
-      auto n = f->normal();
-      auto fx = f->midpoint();
-      auto c = cells(f).front();
-      auto cx = c->midpoint();
-      auto delta = fx - cx;
-      auto dot = dot_product( n, delta );      
-      if ( dot < 0 ) {
-        bad_face = bad_face || true;
-        #pragma omp critical
-        {
-          ss << "Face " << f.id() << " has opposite normal" << std::endl;
-        }
-      }
-    } 
+    std::vector<char> face_mask( num_faces );
 
-    if ( bad_face ) return raise_or_return( ss );
+    #pragma omp parallel for schedule(static)
+    for ( counter_t i=0; i<num_faces; i++ )
+      face_mask[i] = fs[i]->is_boundary() ? 1 : 0;
 
+    boundary_faces_.clear();
+    boundary_faces_.reserve( 
+      std::count( face_mask.begin(), face_mask.end(), 1 ) 
+    );
+    for ( counter_t i=0; i<num_faces; i++ )
+      if ( face_mask[i] ) boundary_faces_.emplace_back( fs[i] );
 
-    //--------------------------------------------------------------------------
-    // check all the corners and wedges
-    bool bad_corner = false;
-    auto cnrs = corners();
-    auto num_corners = cnrs.size();
+    // identify the cell regions
+    auto cell_region = flecsi_get_accessor(*this, mesh, cell_region, size_t, dense, 0);
+    auto num_regions = flecsi_get_accessor(*this, mesh, num_regions, size_t, global, 0);
 
-    //#omp parallel for reduction( || : bad_corner )
-    for( counter_t cnid=0; cnid<num_corners; ++cnid ) {
+    *num_regions = 1;
 
-      auto cn = cnrs[cnid];
-      auto cs = cells(cn);
-      auto fs = faces(cn);
-      auto es = edges(cn);
-      auto vs = vertices(cn);
-      auto ws = wedges(cn);
+    // everything is owned until the mesh is distributed
+    set_num_owned( num_cells(), num_vertices() );
 
-      if ( cs.size() != 1 ) {
-        #pragma omp critical
-        ss << "Corner " << cn.id() << " has " << cs.size() << "/=1 cells" 
-           << std::endl;
-      }
+    auto cs = cells();
+    auto num_cells = cs.size();
 
-      if ( fs.size() != num_dimensions ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << fs.size() << "/=" 
-             << num_dimensions << " faces" << std::endl;
-        }
-      }
+    #pragma omp parallel for schedule(static)
+    for ( counter_t i=0; i<num_cells; i++ )
+      cell_region[ cs[i] ] = 0;
 
-      if ( es.size() != num_dimensions ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << es.size() << "/=" 
-             << num_dimensions << " edges" << std::endl;
-        }
-      }
+    // everything starts in one region
+    index_regions();
 
-      if ( vs.size() != 1 ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << vs.size() << "/=1 vertices"
-             << std::endl;
-        }
-      }
+#ifdef USE_IMPLICIT_DUAL
+    // index the corners and wedges
+    dual_.build( *this );
+#endif
 
-      auto cl = cs.front();
-      auto vt = vs.front();
-      
-      if ( ws.size() % 2 != 0 ) {
-        #pragma omp critical
-        {
-          ss << "Corner " << cn.id() << " has " << ws.size() << "%2/=0 wedges"
-             << std::endl;
-        }
-      }
+    // make sure the grid description matches what was built
+    if ( structured_.is_set() && ( 
+      structured_.num_cells() != num_cells || 
+      structured_.num_vertices() != num_vertices() 
+    ) )
+      raise_runtime_error( 
+        "Structured grid has " << structured_.num_cells() << " cells and " 
+        << structured_.num_vertices() << " vertices, but the mesh has " 
+        << num_cells << " and " << num_vertices()
+      );
 
-      for ( auto wg = ws.begin(); wg != ws.end();  ) 
-        for ( auto i=0; i<2 && wg != ws.end(); i++, ++wg)
-        {
-          auto cls = cells( *wg );
-          auto fs = faces( *wg );
-          auto es = edges( *wg );
-          auto vs = vertices( *wg );
-          auto cns = corners( *wg );
-          if ( cls.size() != 1 ) {
-            #pragma omp critical
-            {          
-              ss << "Wedge " << (*wg).id() << " has " << cls.size() 
-                 << "/=1 cells" << std::endl;
-            }
-          }
-          if ( fs.size() != 1 ) {
-            #pragma omp critical 
-            {           
-              ss << "Wedge " << (*wg).id() << " has " << fs.size() 
-                 << "/=1 faces" << std::endl;
-            }
-          }
-          if ( es.size() != 1 ) {
-            #pragma omp critical 
-            {
-              ss << "Wedge " << (*wg).id() << " has " << es.size() 
-                 << "/=1 edges" << std::endl;
-            }
-          }
-          if ( vs.size() != 1 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has " << vs.size() 
-                 << "/=1 vertices" << std::endl;
-            }
-          }
-          if ( cns.size() != 1 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has " << cns.size() 
-                 << "/=1 corners" << std::endl;
-            }
-          }
-          auto vert = vs.front();
-          auto cell = cls.front();
-          auto corn = cns.front();
-          if ( vert != vt ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect vertex " 
-                 << vert.id() << "!=" << vt.id() << std::endl;
-            }
-          }
-          if ( cell != cl ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect cell " 
-                 << cell.id() << "!=" << cl.id() << std::endl;
-            }
-          }
-          if ( corn != cn ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has incorrect corner " 
-                 << corn.id() << "!=" << cn.id() << std::endl;
-            }
-          }
-          auto fc = fs.front();            
-          auto fx = fc->midpoint();
-          auto cx = cl->midpoint();
-          auto delta = fx - cx;
-          real_t dot;
-          if ( i == 0 ) {
-            auto n = (*wg)->facet_normal_right();
-            dot = dot_product( n, delta );
-          }
-          else {
-            auto n = (*wg)->facet_normal_left();
-            dot = dot_product( n, delta );
-          }
-          if ( dot < 0 ) {
-            #pragma omp critical
-            {
-              ss << "Wedge " << (*wg).id() << " has opposite normal" 
-                 << std::endl;
-            }
-          }
-        } // wedges
-      
-    } // corners
+    // only a freshly built grid can be uniform, this is checked once here
+    is_uniform_ = structured_.is_uniform( vertices() );
 
+    // update the geometry
+    compute_geometry_();
 
-    if ( bad_corner ) return raise_or_return( ss );
+  }
 
 
-    return true;
+  //!---------------------------------------------------------------------------
+  //! \brief Check the burton mesh.
+  //!
+  //! The cheap level checks that every dimension has entities, that each
+  //! cell and face has a sensible number of neighbors, that the cell to
+  //! face and cell to vertex connectivities agree in size with their
+  //! transposes, and that the face normals point out of their first cell.
+  //! The full level also audits the connectivity and orientation of every
+  //! corner and wedge.
+  //!
+  //! \param [in] raise_on_error  If true, raise an error when a check fails,
+  //!                             otherwise print the diagnostics.
+  //! \param [in] level  The amount of checking to perform.
+  //! \return True if the mesh is valid.
+  //!---------------------------------------------------------------------------
+  bool is_valid( 
+    bool raise_on_error = true, 
+    validation_level_t level = validation_level_t::full
+  ) const {
+    return validate_( true, level == validation_level_t::full, raise_on_error );
+  }
 
+  //!---------------------------------------------------------------------------
+  //! \brief Only audit the corners and wedges.
+  //!
+  //! \param [in] raise_on_error  If true, raise an error when a check fails,
+  //!                             otherwise print the diagnostics.
+  //! \return True if the corners and wedges are valid.
+  //!---------------------------------------------------------------------------
+  bool corners_are_valid( bool raise_on_error = true ) const
+  {
+    return validate_( false, true, raise_on_error );
   }
 
   //!---------------------------------------------------------------------------
   //! \brief Compute the goemetry.
+  //!
+  //! This is called after the vertices have moved, so a structured grid
+  //! uses the general shapes from then on.
   //!---------------------------------------------------------------------------
   void update_geometry()
+  {
+    is_uniform_ = false;
+    compute_geometry_();
+  }
+
+  //! \brief Compute the geometry of every entity.
+  //!
+  //! The arithmetic geometry is used while is_uniform_ is set.
+  void compute_geometry_()
   {
     // get the mesh info
     auto cs = cells();
@@ -1363,7 +1476,10 @@ public:
 
     auto wedge_facet_normal = flecsi_get_accessor(*this, mesh, wedge_facet_normal, vector_t, dense, 0);
     auto wedge_facet_area = flecsi_get_accessor(*this, mesh, wedge_facet_area, real_t, dense, 0);
-    auto wedge_facet_centroid = flecsi_get_accessor(*this, mesh, wedge_facet_centroid, vector_t, dense, 0); 
+    auto wedge_facet_centroid = flecsi_get_accessor(*this, mesh, wedge_facet_centroid, storage_vector_t, dense, 0); 
+
+    // a structured grid that has not moved can skip the general shapes
+    auto is_uniform = is_uniform_;
 
     //--------------------------------------------------------------------------
     // compute cell parameters
@@ -1371,24 +1487,51 @@ public:
     #pragma omp parallel
     {
 
-      #pragma omp for   nowait
-      for ( counter_t i=0; i<num_cells; i++ ) {
-        auto c = cs[i];
-        cell_volume[c] = c->volume();
-        cell_center[c] = c->centroid();
-        cell_min_length[c] = c->min_length();
-      } 
+      if ( is_uniform ) {
+        auto vol = structured_.cell_volume();
+        auto len = structured_.cell_min_length();
+        #pragma omp for   nowait
+        for ( counter_t i=0; i<num_cells; i++ ) {
+          auto c = cs[i];
+          cell_volume[c] = vol;
+          cell_center[c] = structured_.cell_centroid( i );
+          cell_min_length[c] = len;
+        }
+      }
+      else {
+        #pragma omp for   nowait
+        for ( counter_t i=0; i<num_cells; i++ ) {
+          auto c = cs[i];
+          cell_volume[c] = c->volume();
+          cell_center[c] = c->centroid();
+          cell_min_length[c] = c->min_length();
+        } 
+      }
 
       //--------------------------------------------------------------------------
       // compute face parameters
 
-      #pragma omp for nowait
-      for ( counter_t i=0; i<num_faces; i++ ) {
-        auto f = fs[i];
-        face_area[f] = f->area();
-        face_norm[f] = f->normal() / face_area[f];
-        face_midp[f] = f->midpoint();
-      } 
+      if ( is_uniform ) {
+        #pragma omp for nowait
+        for ( counter_t i=0; i<num_faces; i++ ) {
+          auto f = fs[i];
+          typename structured_t::face_vertices_t ids;
+          counter_t n = 0;
+          for ( auto v : vertices(f) ) ids[n++] = v.id();
+          structured_.face_geometry( 
+            ids, cells(f).front().id(), face_area[f], face_norm[f], face_midp[f]
+          );
+        }
+      }
+      else {
+        #pragma omp for nowait
+        for ( counter_t i=0; i<num_faces; i++ ) {
+          auto f = fs[i];
+          face_area[f] = f->area();
+          face_norm[f] = f->normal() / face_area[f];
+          face_midp[f] = f->midpoint();
+        } 
+      }
 
       //--------------------------------------------------------------------------
       // compute edge parameters
@@ -1437,11 +1580,22 @@ public:
 
     } // end omp parallel
 
+#ifdef USE_IMPLICIT_DUAL
+    // the implicit wedges need the edge and face midpoints
+    dual_.update_geometry( *this, edge_midp, face_midp );
+#endif
+
   }
 
 
   //============================================================================
   //! \brief Install a boundary and tag the relatex entities.
+  //!
+  //! Only the boundary faces are considered.  The predicate is evaluated in
+  //! parallel, so it must be safe to call from several threads at once.
+  //!
+  //! \param [in] p  The predicate that selects the faces of this boundary.
+  //! \return The tag of the new boundary.
   //============================================================================
   template< typename P >
   tag_t install_boundary( P && p ) 
@@ -1457,41 +1611,79 @@ public:
     auto & this_bnd_edges = edge_sets_[ this_bnd ];
     auto & this_bnd_verts = vert_sets_[ this_bnd ];
 
-    // add the face tags and collect the attached edge and vertices
-    for ( auto f : faces() )
-      if ( p( f ) ) {
-        // tag the face
-        f->tag( this_bnd );
-        this_bnd_faces.emplace_back( f );
-        // tag the vertices
-        auto vs = vertices( f );
-        this_bnd_verts.reserve( this_bnd_verts.size() + vs.size() );
-        for ( auto v : vs ) this_bnd_verts.emplace_back( v );
-        // tag edges in 3d
-        if ( num_dimensions == 3 ) {
-          auto es = edges( f );
-          this_bnd_edges.reserve( this_bnd_edges.size() + es.size() );
-          for ( auto e : es ) this_bnd_edges.emplace_back( e );
-        } // dims
-      }
+    // evaluate the predicate on all the boundary faces at once
+    auto num_bnd_faces = boundary_faces_.size();
+    std::vector<char> face_mask( num_bnd_faces );
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_bnd_faces; ++i )
+      face_mask[i] = p( boundary_faces_[i] ) ? 1 : 0;
 
-    // need to remove duplicates from edge and vertex lists
-    std::sort( this_bnd_edges.begin(), this_bnd_edges.end() );
-    std::sort( this_bnd_verts.begin(), this_bnd_verts.end() );
+    this_bnd_faces.reserve( 
+      std::count( face_mask.begin(), face_mask.end(), 1 ) 
+    );
+    for ( counter_t i=0; i<num_bnd_faces; ++i )
+      if ( face_mask[i] ) this_bnd_faces.emplace_back( boundary_faces_[i] );
+
+    // add the face tags and mark the attached edges and vertices.  Several
+    // threads may mark the same entity, but they all write the same value.
+    auto vs = vertices();
+    auto es = edges();
+    auto num_verts = vs.size();
+    auto num_edges = ( num_dimensions == 3 ) ? es.size() : 0;
+    auto num_faces = this_bnd_faces.size();
+
+    std::vector<char> vert_mask( num_verts, 0 );
+    std::vector<char> edge_mask( num_edges, 0 );
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_faces; ++i ) {
+      auto f = this_bnd_faces[i];
+      // tag the face
+      f->tag( this_bnd );
+      // mark the vertices
+      for ( auto v : vertices( f ) ) {
+        #pragma omp atomic write
+        vert_mask[ v.id() ] = 1;
+      }
+      // mark edges in 3d
+      if ( num_dimensions == 3 ) {
+        for ( auto e : edges( f ) ) {
+          #pragma omp atomic write
+          edge_mask[ e.id() ] = 1;
+        }
+      } // dims
+    }
 
-    this_bnd_edges.erase( 
-      std::unique( this_bnd_edges.begin(), this_bnd_edges.end() ), 
-      this_bnd_edges.end() 
+    // collect the marked entities, which are unique by construction
+    this_bnd_verts.reserve( 
+      std::count( vert_mask.begin(), vert_mask.end(), 1 ) 
     );
-    this_bnd_verts.erase( 
-      std::unique( this_bnd_verts.begin(), this_bnd_verts.end() ), 
-      this_bnd_verts.end() 
+    for ( counter_t i=0; i<num_verts; ++i )
+      if ( vert_mask[i] ) this_bnd_verts.emplace_back( vs[i] );
+
+    this_bnd_edges.reserve( 
+      std::count( edge_mask.begin(), edge_mask.end(), 1 ) 
     );
+    for ( counter_t i=0; i<num_edges; ++i )
+      if ( edge_mask[i] ) this_bnd_edges.emplace_back( es[i] );
+
+    // add the edge and vertex tags
+    auto num_bnd_edges = this_bnd_edges.size();
+    auto num_bnd_verts = this_bnd_verts.size();
+
+    #pragma omp parallel
+    {
 
-    // add the edge tags
-    for ( auto e : this_bnd_edges ) e->tag( this_bnd );
-    // add the vertex tags
-    for ( auto v : this_bnd_verts ) v->tag( this_bnd );
+      #pragma omp for nowait
+      for ( counter_t i=0; i<num_bnd_edges; ++i )
+        this_bnd_edges[i]->tag( this_bnd );
+
+      #pragma omp for
+      for ( counter_t i=0; i<num_bnd_verts; ++i )
+        this_bnd_verts[i]->tag( this_bnd );
+
+    } // end omp parallel
 
     // if it's two dimensions, copy the face list into the edge list
     // if ( num_dimensions == 2 )
@@ -1500,6 +1692,34 @@ public:
     return this_bnd;
   }
 
+  //============================================================================
+  //! \brief Get the list of boundary faces.
+  //! \return The faces that are only attached to one cell.
+  //============================================================================
+  const auto & boundary_faces() const noexcept
+  {
+    return boundary_faces_;
+  }
+
+  //============================================================================
+  //! \brief Return the number of installed boundaries.
+  //! \return The number of boundary tags handed out by install_boundary().
+  //============================================================================
+  size_t num_boundaries() const noexcept
+  {
+    return face_sets_.size();
+  }
+
+  //============================================================================
+  //! \brief Get the set of tagged faces associated with a specific id
+  //! \praram [in] id  The tag to lookup.
+  //! \return The set of tagged faces.
+  //============================================================================
+  const auto & tagged_faces( tag_t id ) const noexcept
+  {
+    return face_sets_[ id ];
+  }
+
   //============================================================================
   //! \brief Get the set of tagged vertices associated with a specific id
   //! \praram [in] id  The tag to lookup.
@@ -1606,6 +1826,388 @@ public:
   } // create_cell
 
 
+  //! \brief Run the mesh checks.
+  //!
+  //! Each thread collects its diagnostics in its own buffer, and the buffers
+  //! are merged once the checks are done.
+  //!
+  //! \param [in] check_mesh  If true, check the entity counts, the
+  //!                         connectivity sizes and the face orientation.
+  //! \param [in] check_corners  If true, audit the corners and wedges.
+  //! \param [in] raise_on_error  If true, raise an error when a check fails,
+  //!                             otherwise print the diagnostics.
+  //! \return True if the checks passed.
+  bool validate_( 
+    bool check_mesh, bool check_corners, bool raise_on_error 
+  ) const
+  {
+    // some includes
+    using math::dot_product;
+
+    // the merged messages
+    std::stringstream ss;
+
+    // the counts need to be right before any connectivity is walked
+    bool bad_count = check_mesh && !check_counts_( ss );
+
+    // the entities to check
+    auto cs = cells();
+    auto fs = faces();
+    auto vs = vertices();
+    counter_t num_cells = check_mesh && !bad_count ? cs.size() : 0;
+    counter_t num_faces = check_mesh && !bad_count ? fs.size() : 0;
+    counter_t num_verts = check_mesh && !bad_count ? vs.size() : 0;
+
+    // the total sizes of each connectivity and its transpose
+    counter_t cell_faces = 0, face_cells = 0;
+    counter_t cell_verts = 0, vert_cells = 0;
+
+#ifdef USE_IMPLICIT_DUAL
+    counter_t num_corners = check_corners ? dual_.num_corners() : 0;
+#else
+    auto cnrs = corners();
+    counter_t num_corners = check_corners ? cnrs.size() : 0;
+#endif
+
+    bool bad_cell = false;
+    bool bad_face = false;
+    bool bad_corner = false;
+
+    #pragma omp parallel \
+      reduction( || : bad_cell, bad_face, bad_corner ) \
+      reduction( + : cell_faces, face_cells, cell_verts, vert_cells )
+    {
+
+      // this threads messages
+      std::stringstream thread_ss;
+
+      //------------------------------------------------------------------------
+      // every cell needs enough faces and vertices to enclose a volume
+
+      #pragma omp for
+      for( counter_t cid=0; cid<num_cells; ++cid ) {
+        auto c = cs[cid];
+        auto nf = faces(c).size();
+        auto nv = vertices(c).size();
+        cell_faces += nf;
+        cell_verts += nv;
+        if ( nf < num_dimensions+1 || nv < num_dimensions+1 || 
+             ( num_dimensions == 2 && nf != nv ) ) {
+          bad_cell = true;
+          thread_ss << "Cell " << c.id() << " has " << nf << " faces and " 
+            << nv << " vertices" << std::endl;
+        }
+      }
+
+      //------------------------------------------------------------------------
+      // every face has one or two cells and enough vertices to span it
+
+      #pragma omp for
+      for( counter_t fid=0; fid<num_faces; ++fid ) {
+        auto f = fs[fid];
+        auto nc = cells(f).size();
+        auto nv = vertices(f).size();
+        face_cells += nc;
+        if ( nc < 1 || nc > 2 || nv < num_dimensions || 
+             ( num_dimensions == 2 && nv != 2 ) ) {
+          bad_face = true;
+          thread_ss << "Face " << f.id() << " has " << nc << " cells and " 
+            << nv << " vertices" << std::endl;
+        }
+      }
+
+      //------------------------------------------------------------------------
+      // the vertex to cell connectivity is only summed, it is checked 
+      // against its transpose below
+
+      #pragma omp for
+      for( counter_t vid=0; vid<num_verts; ++vid )
+        vert_cells += cells( vs[vid] ).size();
+
+      //------------------------------------------------------------------------
+      // make sure face normal points out from first cell
+      
+      #pragma omp for
+      for( counter_t fid=0; fid<num_faces; ++fid ) {
+        auto f = fs[fid];
+        if ( cells(f).size() == 0 ) continue;
+        auto n = f->normal();
+        auto fx = f->midpoint();
+        auto c = cells(f).front();
+        auto cx = c->midpoint();
+        auto delta = fx - cx;
+        auto dot = dot_product( n, delta );      
+        if ( dot < 0 ) {
+          bad_face = true;
+          thread_ss << "Face " << f.id() << " has opposite normal" << std::endl;
+        }
+      } 
+
+      //------------------------------------------------------------------------
+      // check all the corners and wedges
+
+      #pragma omp for
+      for( counter_t cnid=0; cnid<num_corners; ++cnid )
+#ifdef USE_IMPLICIT_DUAL
+        bad_corner = !check_dual_corner_( cnid, thread_ss ) || bad_corner;
+#else
+        bad_corner = !check_corner_( cnrs[cnid], thread_ss ) || bad_corner;
+#endif
+
+      // merge the messages
+      auto msg = thread_ss.str();
+      if ( !msg.empty() ) {
+        #pragma omp critical
+        ss << msg;
+      }
+
+    } // end omp parallel
+
+    // each connectivity must be the same size as its transpose
+    if ( cell_faces != face_cells ) {
+      bad_count = true;
+      ss << "The cells list " << cell_faces << " faces, but the faces list " 
+         << face_cells << " cells" << std::endl;
+    }
+
+    if ( cell_verts != vert_cells ) {
+      bad_count = true;
+      ss << "The cells list " << cell_verts << " vertices, but the vertices "
+         << "list " << vert_cells << " cells" << std::endl;
+    }
+
+    if ( !bad_count && !bad_cell && !bad_face && !bad_corner ) return true;
+
+    if ( raise_on_error )
+      raise_runtime_error( ss.rdbuf() );
+    else 
+      std::cerr << ss.rdbuf() << std::endl;
+    return false;
+  }
+
+  //! \brief Check the number of entities of each dimension.
+  //! \param [in,out] ss  The stream to write diagnostics to.
+  //! \return True if the counts are valid.
+  bool check_counts_( std::ostream & ss ) const
+  {
+    bool is_good = true;
+
+    for ( size_t d=0; d<=num_dimensions; ++d ) 
+      if ( base_t::num_entities(d) == 0 ) {
+        ss << "The mesh has no entities of dimension " << d << std::endl;
+        is_good = false;
+      }
+
+    if ( num_owned_cells() > num_cells() ) {
+      ss << "The mesh owns " << num_owned_cells() << " cells, but only has "
+         << num_cells() << std::endl;
+      is_good = false;
+    }
+
+    if ( num_owned_vertices() > num_vertices() ) {
+      ss << "The mesh owns " << num_owned_vertices() << " vertices, but only "
+         << "has " << num_vertices() << std::endl;
+      is_good = false;
+    }
+
+    return is_good;
+  }
+
+  //! \brief Check the number of entities attached to a corner.
+  //! \param [in] cn  The corner to check.
+  //! \param [in,out] ss  The stream to write diagnostics to.
+  //! \return True if the corner is valid.
+  template< typename C >
+  bool check_corner_counts_( const C & cn, std::ostream & ss ) const
+  {
+    bool is_good = true;
+
+    auto cs = cells(cn);
+    auto fs = faces(cn);
+    auto es = edges(cn);
+    auto vs = vertices(cn);
+    auto ws = wedges(cn);
+
+    if ( cs.size() != 1 ) {
+      ss << "Corner " << cn.id() << " has " << cs.size() << "/=1 cells" 
+         << std::endl;
+      is_good = false;
+    }
+
+    if ( fs.size() != num_dimensions ) {
+      ss << "Corner " << cn.id() << " has " << fs.size() << "/=" 
+         << num_dimensions << " faces" << std::endl;
+      is_good = false;
+    }
+
+    if ( es.size() != num_dimensions ) {
+      ss << "Corner " << cn.id() << " has " << es.size() << "/=" 
+         << num_dimensions << " edges" << std::endl;
+      is_good = false;
+    }
+
+    if ( vs.size() != 1 ) {
+      ss << "Corner " << cn.id() << " has " << vs.size() << "/=1 vertices"
+         << std::endl;
+      is_good = false;
+    }
+
+    if ( ws.size() % 2 != 0 ) {
+      ss << "Corner " << cn.id() << " has " << ws.size() << "%2/=0 wedges"
+         << std::endl;
+      is_good = false;
+    }
+
+    return is_good;
+  }
+
+#ifdef USE_IMPLICIT_DUAL
+  //! \brief Check an implicit corner and its wedges.
+  //! \param [in] cn  The corner id.
+  //! \param [in,out] ss  The stream to write diagnostics to.
+  //! \return True if the corner is valid.
+  bool check_dual_corner_( size_t cn, std::ostream & ss ) const
+  {
+    using math::dot_product;
+
+    bool is_good = true;
+
+    auto cl = cells()[ dual_.corner_cell(cn) ];
+    auto vt = dual_.corner_vertex(cn);
+    auto ws = dual_.corner_wedges(cn);
+
+    auto has_vertex = [vt]( auto && vs ) {
+      return std::any_of( vs.begin(), vs.end(), 
+        [vt]( auto && v ) { return v.id() == vt; } );
+    };
+
+    if ( !has_vertex( vertices(cl) ) ) {
+      ss << "Implicit corner " << cn << " has vertex " << vt 
+         << " which is not in cell " << cl.id() << std::endl;
+      is_good = false;
+    }
+
+    if ( ws.size() == 0 || ws.size() % 2 != 0 ) {
+      ss << "Implicit corner " << cn << " has " << ws.size() 
+         << " wedges" << std::endl;
+      return false;
+    }
+
+    const auto & normals = dual_.facet_normals();
+    auto fs = faces();
+    auto es = edges();
+
+    for ( auto w : ws ) {
+      auto fc = fs[ dual_.wedge_face(w) ];
+      auto ed = es[ dual_.wedge_edge(w) ];
+      if ( !has_vertex( vertices(ed) ) ) {
+        ss << "Implicit wedge " << w << " has edge " << ed.id() 
+           << " which does not touch vertex " << vt << std::endl;
+        is_good = false;
+      }
+      auto delta = fc->midpoint() - cl->midpoint();
+      if ( dot_product( normals[w], delta ) < 0 ) {
+        ss << "Implicit wedge " << w << " has opposite normal" << std::endl;
+        is_good = false;
+      }
+    }
+
+    return is_good;
+  }
+#endif
+
+  //! \brief Perform a full topological and geometric audit of a corner.
+  //! \param [in] cn  The corner to check.
+  //! \param [in,out] ss  The stream to write diagnostics to.
+  //! \return True if the corner is valid.
+  template< typename C >
+  bool check_corner_( const C & cn, std::ostream & ss ) const
+  {
+    using math::dot_product;
+
+    // the entity counts need to be right before the wedges can be checked
+    if ( !check_corner_counts_( cn, ss ) ) return false;
+
+    bool is_good = true;
+
+    auto cl = cells(cn).front();
+    auto vt = vertices(cn).front();
+    auto ws = wedges(cn);
+
+    for ( auto wg = ws.begin(); wg != ws.end();  ) 
+      for ( auto i=0; i<2 && wg != ws.end(); i++, ++wg)
+      {
+        auto cls = cells( *wg );
+        auto fs = faces( *wg );
+        auto es = edges( *wg );
+        auto vs = vertices( *wg );
+        auto cns = corners( *wg );
+        if ( cls.size() != 1 ) {
+          ss << "Wedge " << (*wg).id() << " has " << cls.size() 
+             << "/=1 cells" << std::endl;
+          is_good = false;
+        }
+        if ( fs.size() != 1 ) {
+          ss << "Wedge " << (*wg).id() << " has " << fs.size() 
+             << "/=1 faces" << std::endl;
+          is_good = false;
+        }
+        if ( es.size() != 1 ) {
+          ss << "Wedge " << (*wg).id() << " has " << es.size() 
+             << "/=1 edges" << std::endl;
+          is_good = false;
+        }
+        if ( vs.size() != 1 ) {
+          ss << "Wedge " << (*wg).id() << " has " << vs.size() 
+             << "/=1 vertices" << std::endl;
+          is_good = false;
+        }
+        if ( cns.size() != 1 ) {
+          ss << "Wedge " << (*wg).id() << " has " << cns.size() 
+             << "/=1 corners" << std::endl;
+          is_good = false;
+        }
+        auto vert = vs.front();
+        auto cell = cls.front();
+        auto corn = cns.front();
+        if ( vert != vt ) {
+          ss << "Wedge " << (*wg).id() << " has incorrect vertex " 
+             << vert.id() << "!=" << vt.id() << std::endl;
+          is_good = false;
+        }
+        if ( cell != cl ) {
+          ss << "Wedge " << (*wg).id() << " has incorrect cell " 
+             << cell.id() << "!=" << cl.id() << std::endl;
+          is_good = false;
+        }
+        if ( corn != cn ) {
+          ss << "Wedge " << (*wg).id() << " has incorrect corner " 
+             << corn.id() << "!=" << cn.id() << std::endl;
+          is_good = false;
+        }
+        auto fc = fs.front();            
+        auto fx = fc->midpoint();
+        auto cx = cl->midpoint();
+        auto delta = fx - cx;
+        real_t dot;
+        if ( i == 0 ) {
+          auto n = (*wg)->facet_normal_right();
+          dot = dot_product( n, delta );
+        }
+        else {
+          auto n = (*wg)->facet_normal_left();
+          dot = dot_product( n, delta );
+        }
+        if ( dot < 0 ) {
+          ss << "Wedge " << (*wg).id() << " has opposite normal" 
+             << std::endl;
+          is_good = false;
+        }
+      } // wedges
+
+    return is_good;
+  }
+
   //============================================================================
   // Private Data 
   //============================================================================
@@ -1617,6 +2219,26 @@ public:
   std::vector< std::vector<vertex_t*> > vert_sets_;
   //@ }
 
+  //! \brief The cached list of boundary faces
+  std::vector<face_t*> boundary_faces_;
+
+#ifdef USE_IMPLICIT_DUAL
+  //! \brief The implicitly indexed corners and wedges
+  dual_t dual_;
+#endif
+
+  //! \brief The structured grid description, if any
+  structured_t structured_;
+
+  //! \brief True while the vertices are where the structured grid put them
+  bool is_uniform_ = false;
+
+  //! \brief The cell ids grouped by region, in compressed row storage
+  //@ {
+  std::vector<counter_t> region_offsets_;
+  std::vector<counter_t> region_cell_ids_;
+  //@ }
+
 
 }; // class burton_mesh_t
 
@@ -0,0 +1,373 @@
+/*~--------------------------------------------------------------------------~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~--------------------------------------------------------------------------~*/
+////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \brief Provides the arithmetic (i,j,k) indexing of the logically
+//!   structured meshes created by mesh::box().
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/mesh/burton/burton_config.h"
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace flecsale {
+namespace mesh {
+namespace burton {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Describes a uniform, logically structured burton mesh.
+//!
+//! The vertices and cells are assumed to be numbered lexicographically with
+//! the x index running fastest, and the vertices of each cell to be listed
+//! counter clockwise starting from the lower-left(-back) one.  This is the
+//! ordering used by mesh::box().  With this, every cell-vertex, cell-cell
+//! and cell-corner relation can be computed directly from the ids, and all
+//! of the geometry follows from the origin and the grid spacing.
+//!
+//! \tparam N The number of dimensions.
+////////////////////////////////////////////////////////////////////////////////
+template< std::size_t N >
+class burton_structured_t {
+
+public:
+
+  //============================================================================
+  // Typedefs
+  //============================================================================
+
+  //! \brief the mesh traits
+  using config_t = burton_config_t<N>;
+
+  //! \brief Floating point data type.
+  using real_t = typename config_t::real_t;
+
+  //! \brief Point data type.
+  using point_t = typename config_t::point_t;
+
+  //! \brief Physics vector type.
+  using vector_t = typename config_t::vector_t;
+
+  //! \brief A logical (i,j,k) index.
+  using ijk_t = std::array<std::size_t, N>;
+
+  //! \brief The number of vertices of each cell.
+  static constexpr std::size_t num_cell_vertices = 1 << N;
+
+  //! \brief The number of vertices of each face.
+  static constexpr std::size_t num_face_vertices = 1 << (N-1);
+
+  //! \brief The vertex ids of a cell.
+  using cell_vertices_t = std::array<std::size_t, num_cell_vertices>;
+
+  //! \brief The vertex ids of a face.
+  using face_vertices_t = std::array<std::size_t, num_face_vertices>;
+
+  //! \brief The id returned for a missing neighbor.
+  static constexpr std::size_t invalid = std::numeric_limits<std::size_t>::max();
+
+  //============================================================================
+  // Setup
+  //============================================================================
+
+  //! \brief Describe the structured grid.
+  //! \param [in] num_cells  The number of cells in each direction.
+  //! \param [in] min,max  The bounding box of the grid.
+  void set(
+    const ijk_t & num_cells, const point_t & min, const point_t & max
+  ) {
+    num_cells_total_ = 1;
+    num_verts_total_ = 1;
+    for ( std::size_t d=0; d<N; ++d ) {
+      if ( num_cells[d] == 0 || !(max[d] > min[d]) )
+        raise_runtime_error(
+          "Bad structured grid in direction " << d << ": " << num_cells[d]
+          << " cells between " << min[d] << " and " << max[d]
+        );
+      num_cells_[d] = num_cells[d];
+      origin_[d] = min[d];
+      spacing_[d] = (max[d] - min[d]) / num_cells[d];
+      cell_stride_[d] = num_cells_total_;
+      vert_stride_[d] = num_verts_total_;
+      num_cells_total_ *= num_cells[d];
+      num_verts_total_ *= num_cells[d] + 1;
+    }
+    cell_volume_ = 1;
+    for ( std::size_t d=0; d<N; ++d ) cell_volume_ *= spacing_[d];
+    is_set_ = true;
+  }
+
+  //! \brief Forget the grid description.
+  void clear()
+  {
+    is_set_ = false;
+    num_cells_total_ = 0;
+    num_verts_total_ = 0;
+  }
+
+  //! \brief Return true if a grid has been described.
+  bool is_set() const
+  { return is_set_; }
+
+  //============================================================================
+  // Sizes and Spacing
+  //============================================================================
+
+  //! \brief Return the number of cells in direction \e d.
+  std::size_t num_cells( std::size_t d ) const
+  { return num_cells_[d]; }
+
+  //! \brief Return the total number of cells.
+  std::size_t num_cells() const
+  { return num_cells_total_; }
+
+  //! \brief Return the total number of vertices.
+  std::size_t num_vertices() const
+  { return num_verts_total_; }
+
+  //! \brief Return the lower corner of the grid.
+  const point_t & origin() const
+  { return origin_; }
+
+  //! \brief Return the grid spacing.
+  const vector_t & spacing() const
+  { return spacing_; }
+
+  //============================================================================
+  // Connectivity
+  //============================================================================
+
+  //! \brief Return the id of the cell at \e ijk.
+  std::size_t cell_id( const ijk_t & ijk ) const
+  {
+    std::size_t id = 0;
+    for ( std::size_t d=0; d<N; ++d ) id += cell_stride_[d] * ijk[d];
+    return id;
+  }
+
+  //! \brief Return the logical index of cell \e c.
+  ijk_t cell_ijk( std::size_t c ) const
+  {
+    ijk_t ijk;
+    for ( std::size_t d=0; d<N; ++d ) {
+      ijk[d] = c % num_cells_[d];
+      c /= num_cells_[d];
+    }
+    return ijk;
+  }
+
+  //! \brief Return the id of the vertex at \e ijk.
+  std::size_t vertex_id( const ijk_t & ijk ) const
+  {
+    std::size_t id = 0;
+    for ( std::size_t d=0; d<N; ++d ) id += vert_stride_[d] * ijk[d];
+    return id;
+  }
+
+  //! \brief Return the logical index of vertex \e v.
+  ijk_t vertex_ijk( std::size_t v ) const
+  {
+    ijk_t ijk;
+    for ( std::size_t d=0; d<N; ++d ) {
+      ijk[d] = v % (num_cells_[d]+1);
+      v /= num_cells_[d]+1;
+    }
+    return ijk;
+  }
+
+  //! \brief Return the vertices of cell \e c in the order used by box().
+  cell_vertices_t cell_vertices( std::size_t c ) const
+  {
+    // the counter clockwise offsets of a quad, repeated for each z-layer
+    constexpr std::size_t di[] = {0, 1, 1, 0};
+    constexpr std::size_t dj[] = {0, 0, 1, 1};
+    auto ijk = cell_ijk( c );
+    auto v0 = vertex_id( ijk );
+    cell_vertices_t vs;
+    for ( std::size_t l=0; l<num_cell_vertices; ++l ) {
+      auto q = l % 4;
+      vs[l] = v0 + di[q]*vert_stride_[0] + dj[q]*vert_stride_[1];
+      if ( N == 3 && l >= 4 ) vs[l] += vert_stride_[N-1];
+    }
+    return vs;
+  }
+
+  //! \brief Return the neighbor of cell \e c in direction \e d.
+  //! \param [in] c  The cell id.
+  //! \param [in] d  The direction.
+  //! \param [in] upper  If true, look in the positive direction.
+  //! \return The neighbor id, or #invalid on the boundary.
+  std::size_t cell_neighbor( std::size_t c, std::size_t d, bool upper ) const
+  {
+    auto i = ( c / cell_stride_[d] ) % num_cells_[d];
+    if ( upper )
+      return ( i+1 < num_cells_[d] ) ? c + cell_stride_[d] : invalid;
+    else
+      return ( i > 0 ) ? c - cell_stride_[d] : invalid;
+  }
+
+  //! \brief Return the id of the \e l'th corner of cell \e c.
+  //!
+  //! The corners of a cell are numbered consecutively in the order of its
+  //! vertices, see burton_dual_t.
+  std::size_t cell_corner( std::size_t c, std::size_t l ) const
+  { return num_cell_vertices * c + l; }
+
+  //============================================================================
+  // Geometry
+  //============================================================================
+
+  //! \brief Return the coordinates of vertex \e v.
+  //!
+  //! These are computed exactly as in box(), so they can be compared for
+  //! equality.
+  point_t vertex_coordinates( std::size_t v ) const
+  {
+    auto ijk = vertex_ijk( v );
+    point_t x;
+    for ( std::size_t d=0; d<N; ++d ) x[d] = origin_[d] + ijk[d] * spacing_[d];
+    return x;
+  }
+
+  //! \brief Return the centroid of cell \e c.
+  point_t cell_centroid( std::size_t c ) const
+  {
+    auto ijk = cell_ijk( c );
+    point_t x;
+    for ( std::size_t d=0; d<N; ++d )
+      x[d] = origin_[d] + ( ijk[d] + 0.5 ) * spacing_[d];
+    return x;
+  }
+
+  //! \brief Return the volume shared by all the cells.
+  real_t cell_volume() const
+  { return cell_volume_; }
+
+  //! \brief Return the minimum length shared by all the cells.
+  real_t cell_min_length() const
+  { return *std::min_element( spacing_.begin(), spacing_.end() ); }
+
+  //! \brief Compute the geometry of a face.
+  //!
+  //! The face normal is oriented out of the \e owner cell.
+  //!
+  //! \param [in] vs  The vertex ids of the face.
+  //! \param [in] owner  The id of the first cell attached to the face.
+  //! \param [out] area  The face area.
+  //! \param [out] normal  The unit face normal.
+  //! \param [out] midpoint  The face midpoint.
+  void face_geometry(
+    const face_vertices_t & vs,
+    std::size_t owner,
+    real_t & area,
+    vector_t & normal,
+    point_t & midpoint
+  ) const {
+
+    // the face is normal to the direction its vertices do not move in
+    auto first = vertex_ijk( vs[0] );
+    ijk_t sum = first;
+    std::array<bool, N> fixed;
+    fixed.fill( true );
+    for ( std::size_t l=1; l<num_face_vertices; ++l ) {
+      auto ijk = vertex_ijk( vs[l] );
+      for ( std::size_t d=0; d<N; ++d ) {
+        sum[d] += ijk[d];
+        if ( ijk[d] != first[d] ) fixed[d] = false;
+      }
+    }
+    std::size_t axis = 
+      std::find( fixed.begin(), fixed.end(), true ) - fixed.begin();
+    assert( axis < N && "face vertices are not on a lattice plane" );
+
+    // the area is the product of the other spacings
+    area = 1;
+    for ( std::size_t d=0; d<N; ++d ) {
+      if ( d != axis ) area *= spacing_[d];
+      midpoint[d] = origin_[d] + spacing_[d] * sum[d] / num_face_vertices;
+      normal[d] = 0;
+    }
+
+    // point away from the owner
+    auto cell = cell_ijk( owner );
+    normal[axis] = ( first[axis] > cell[axis] ) ? 1 : -1;
+  }
+
+  //! \brief Check that all vertices still sit on the lattice.
+  //!
+  //! The geometry shortcuts only hold while this is true, for example it
+  //! stops being the case once a Lagrangian mesh starts moving.
+  //!
+  //! \param [in] vs  The vertices of the mesh.
+  //! \return True if every vertex is where box() put it.
+  template< typename V >
+  bool is_uniform( V && vs ) const
+  {
+    if ( !is_set_ || vs.size() != num_verts_total_ ) return false;
+
+    // a tolerance relative to the spacing
+    auto tol = 100 * std::numeric_limits<real_t>::epsilon() * cell_min_length();
+
+    auto num_verts = vs.size();
+    int is_good = 1;
+
+    #pragma omp parallel for reduction( min : is_good )
+    for ( typename config_t::counter_t i=0; i<num_verts; ++i ) {
+      const auto & x = vs[i]->coordinates();
+      auto x0 = vertex_coordinates( i );
+      for ( std::size_t d=0; d<N; ++d )
+        if ( std::abs( x[d] - x0[d] ) > tol ) is_good = 0;
+    }
+
+    return is_good;
+  }
+
+private:
+
+  //============================================================================
+  // Private Data
+  //============================================================================
+
+  //! \brief True once a grid has been described
+  bool is_set_ = false;
+
+  //! \brief the number of cells in each direction
+  ijk_t num_cells_ = {};
+
+  //! \brief the id strides in each direction
+  //! \{
+  ijk_t cell_stride_ = {};
+  ijk_t vert_stride_ = {};
+  //! \}
+
+  //! \brief the total number of entities
+  //! \{
+  std::size_t num_cells_total_ = 0;
+  std::size_t num_verts_total_ = 0;
+  //! \}
+
+  //! \brief the grid origin and spacing
+  //! \{
+  point_t origin_;
+  vector_t spacing_;
+  //! \}
+
+  //! \brief the volume of every cell
+  real_t cell_volume_ = 0;
+
+};
+
+} // namespace burton
+} // namespace mesh
+} // namespace flecsale
@@ -13,6 +13,13 @@
 // user includes
 #include "burton_2d_test.h"
 
+// system includes
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+
 // using statements
 using std::cout;
 using std::endl;
@@ -83,6 +90,147 @@ TEST(burton_2d_factories, ptr_box) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test partitioning and reordering a mesh
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_2d_partition, reorder) {
+  using mesh_t = mesh_2d_t;
+  using real_t = mesh_t::real_t;
+
+  constexpr size_t num_parts = 4;
+  auto m = flecsale::mesh::box<mesh_t>(8, 8, 0.0, 0.0, 1.0, 1.0);
+
+  // every part gets the same number of cells
+  auto parts = flecsale::mesh::partition_cells( m, num_parts );
+  ASSERT_EQ( parts.size(), m.num_cells() );
+  std::vector<size_t> counts( num_parts, 0 );
+  for ( auto p : parts ) {
+    ASSERT_LT( p, num_parts );
+    counts[p]++;
+  }
+  for ( auto n : counts ) EXPECT_EQ( n, m.num_cells() / num_parts );
+
+  // every cell and face is owned once, and the ghost cells are never owned
+  auto subs = flecsale::mesh::decompose( m, parts, num_parts );
+  ASSERT_EQ( subs.size(), num_parts );
+  std::vector<size_t> cell_owners( m.num_cells(), 0 );
+  std::vector<size_t> face_owners( m.num_faces(), 0 );
+  auto fs = m.faces();
+  for ( size_t p=0; p<num_parts; ++p ) {
+    const auto & sub = subs[p];
+    EXPECT_EQ( sub.cells.size(), counts[p] );
+    ASSERT_EQ( sub.region_offsets.size(), m.num_regions()+1 );
+    EXPECT_EQ( sub.region_offsets.back(), sub.cells.size() );
+    for ( auto c : sub.cells ) {
+      EXPECT_EQ( parts[c], p );
+      cell_owners[c]++;
+    }
+    for ( auto c : sub.ghost_cells ) EXPECT_NE( parts[c], p );
+    for ( auto f : sub.faces ) {
+      face_owners[f]++;
+      // the cells of an owned face are either owned or ghosts
+      for ( auto c : m.cells( fs[f] ) ) {
+        if ( parts[c.id()] != p ) 
+          EXPECT_LT( sub.ghost_index( c.id() ), sub.ghost_cells.size() );
+      }
+    }
+  }
+  for ( auto n : cell_owners ) EXPECT_EQ( n, 1 );
+  for ( auto n : face_owners ) EXPECT_EQ( n, 1 );
+
+  // the halo copy holds the ghost values in order
+  ASSERT_FALSE( subs[0].ghost_cells.empty() );
+  std::vector<size_t> halo;
+  subs[0].update_ghosts( [&]( auto c ) { return parts[c]; }, halo );
+  ASSERT_EQ( halo.size(), subs[0].ghost_cells.size() );
+  for ( size_t i=0; i<halo.size(); ++i ) 
+    EXPECT_EQ( halo[i], parts[ subs[0].ghost_cells[i] ] );
+
+  // the reordered mesh numbers each partition contiguously
+  auto r = flecsale::mesh::reorder( m, parts );
+  ASSERT_EQ( r.num_cells(), m.num_cells() );
+  ASSERT_EQ( r.num_vertices(), m.num_vertices() );
+  EXPECT_TRUE( r.is_valid(false) );
+
+  real_t vol_m = 0, vol_r = 0;
+  for ( auto c : m.cells() ) vol_m += c->volume();
+  for ( auto c : r.cells() ) vol_r += c->volume();
+  EXPECT_NEAR( vol_m, vol_r, flecsale::common::test_tolerance );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test that the box pieces built for each rank match the whole box
+////////////////////////////////////////////////////////////////////////////////
+TEST(burton_2d_distributed, box_slab) {
+  using mesh_t = mesh_2d_t;
+  using real_t = mesh_t::real_t;
+
+  constexpr int num_ranks = 3;
+  std::array<size_t, 2> dims = {5, 7};
+  std::array<real_t, 2> xmin = {0.0, -1.0};
+  std::array<real_t, 2> xmax = {1.0, 2.0};
+
+  auto m = flecsale::mesh::box<mesh_t>( dims, xmin, xmax );
+  auto ms = m.cells();
+  auto mv = m.vertices();
+
+  // the whole mesh split by rows, like the pieces
+  auto first = flecsale::mesh::detail::split_layers( dims[1], num_ranks );
+  std::vector<size_t> parts( m.num_cells() );
+  for ( auto c : ms ) 
+    parts[c.id()] = flecsale::mesh::detail::layer_rank( first, c.id() / dims[0] );
+  auto global = flecsale::mesh::global_ownership( m, parts );
+
+  size_t num_owned = 0;
+
+  for ( int r=0; r<num_ranks; ++r ) {
+
+    flecsale::mesh::ownership_t owners;
+    auto piece = flecsale::mesh::box_slab<mesh_t>( 
+      dims, xmin, xmax, r, num_ranks, owners 
+    );
+    ASSERT_EQ( owners.cell_ids.size(), piece.num_cells() );
+    ASSERT_EQ( owners.vertex_ids.size(), piece.num_vertices() );
+
+    // the vertices are in the same place and have the same owner
+    for ( auto v : piece.vertices() ) {
+      auto gid = owners.vertex_ids[v.id()];
+      for ( int d=0; d<2; ++d )
+        EXPECT_EQ( v->coordinates()[d], mv[gid]->coordinates()[d] );
+      EXPECT_EQ( owners.vertex_ranks[v.id()], global.vertex_ranks[gid] );
+    }
+
+    // the cells are made of the same vertices and have the same owner
+    for ( auto c : piece.cells() ) {
+      auto gid = owners.cell_ids[c.id()];
+      auto pvs = piece.vertices(c);
+      auto gvs = m.vertices( ms[gid] );
+      ASSERT_EQ( pvs.size(), gvs.size() );
+      for ( size_t i=0; i<pvs.size(); ++i )
+        EXPECT_EQ( owners.vertex_ids[ pvs[i].id() ], gvs[i].id() );
+      EXPECT_EQ( owners.cell_ranks[c.id()], global.cell_ranks[gid] );
+      if ( owners.cell_ranks[c.id()] == r ) num_owned++;
+    }
+
+  }
+
+  // every cell is owned exactly once
+  EXPECT_EQ( num_owned, m.num_cells() );
+
+  // a single rank owns everything and has no ghosts
+  std::vector<size_t> one_part( m.num_cells(), 0 );
+  flecsale::mesh::halo_t halo;
+  auto local = flecsale::mesh::distribute( 
+    m, flecsale::mesh::global_ownership( m, one_part ), 0, halo 
+  );
+  EXPECT_EQ( local.num_cells(), m.num_cells() );
+  EXPECT_EQ( local.num_owned_cells(), m.num_cells() );
+  EXPECT_EQ( local.num_owned_vertices(), m.num_vertices() );
+  EXPECT_TRUE( halo.cells.empty() );
+  EXPECT_TRUE( halo.vertices.empty() );
+  EXPECT_TRUE( local.is_valid(false) );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief dump the mesh to std out
 ////////////////////////////////////////////////////////////////////////////////
@@ -404,6 +552,686 @@ TEST_F(burton_2d, normals) {
 } // TEST_F
 
 
+#ifdef USE_IMPLICIT_DUAL
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the implicitly indexed corners and wedges
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, dual) {
+
+  const auto & dual = mesh_.dual();
+  auto cs = mesh_.cells();
+  auto fs = mesh_.faces();
+
+  ASSERT_EQ( mesh_.num_corners(), dual.num_corners() );
+  ASSERT_EQ( mesh_.num_wedges(), dual.num_wedges() );
+  ASSERT_EQ( 2*dual.num_corners(), dual.num_wedges() );
+
+  // the corners follow the cell vertex ordering
+  for ( auto c : cs ) {
+    auto vs = mesh_.vertices(c);
+    auto cnrs = dual.cell_corners( c.id() );
+    ASSERT_EQ( vs.size(), cnrs.size() );
+    for ( size_t i=0; i<vs.size(); ++i ) {
+      ASSERT_EQ( c.id(), dual.corner_cell( cnrs[i] ) );
+      ASSERT_EQ( vs[i].id(), dual.corner_vertex( cnrs[i] ) );
+    }
+  }
+
+  for ( auto v : mesh_.vertices() ) {
+    ASSERT_EQ( mesh_.cells(v).size(), dual.vertex_corners( v.id() ).size() );
+    for ( auto cn : dual.vertex_corners( v.id() ) )
+      ASSERT_EQ( v.id(), dual.corner_vertex(cn) );
+  }
+
+  // the facets point out of the cell and close it
+  const auto & n = dual.facet_normals();
+  const auto & l = dual.facet_areas();
+
+  for ( auto c : cs ) {
+    auto cx = c->centroid();
+    vector_t sum(0);
+    for ( auto cn : dual.cell_corners( c.id() ) )
+      for ( auto w : dual.corner_wedges(cn) ) {
+        auto delta = fs[ dual.wedge_face(w) ]->centroid() - cx;
+        ASSERT_GT( dot_product( n[w], delta ), 0 );
+        for ( int d=0; d<2; ++d ) sum[d] += l[w] * n[w][d];
+      }
+    for ( int d=0; d<2; ++d )
+      ASSERT_NEAR( 0, sum[d], flecsale::common::test_tolerance );
+  }
+
+  ASSERT_TRUE( mesh_.is_valid(false) );
+
+} // TEST_F
+
+#endif // USE_IMPLICIT_DUAL
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the validation levels
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, validation) {
+
+  // a good mesh passes everything
+  EXPECT_TRUE( mesh_.is_valid(false, validation_level_t::cheap) );
+  EXPECT_TRUE( mesh_.is_valid(false, validation_level_t::full) );
+  EXPECT_TRUE( mesh_.corners_are_valid(false) );
+
+  // a single cell with its vertices ordered clockwise
+  auto make_cell = []( auto && ids ) {
+    mesh_t m;
+    m.init_parameters(4);
+    std::vector<vertex_t *> vs = {
+      m.create_vertex({0., 0.}), m.create_vertex({1., 0.}),
+      m.create_vertex({1., 1.}), m.create_vertex({0., 1.})
+    };
+    m.create_cell({ vs[ids[0]], vs[ids[1]], vs[ids[2]], vs[ids[3]] });
+    m.init();
+    return m;
+  };
+
+  auto good = make_cell( std::array<int,4>{0, 1, 2, 3} );
+  EXPECT_TRUE( good.is_valid(false) );
+
+  auto flipped = make_cell( std::array<int,4>{0, 3, 2, 1} );
+
+  // the faces point into the cell
+  EXPECT_FALSE( flipped.is_valid(false, validation_level_t::cheap) );
+  EXPECT_FALSE( flipped.is_valid(false, validation_level_t::full) );
+
+  // and so do the wedge facets, which the cheap level does not look at
+  EXPECT_FALSE( flipped.corners_are_valid(false) );
+
+  // claiming more owned cells than there are is caught by the cheap level
+  good.set_num_owned( good.num_cells()+1, good.num_vertices() );
+  EXPECT_FALSE( good.is_valid(false, validation_level_t::cheap) );
+  EXPECT_TRUE( good.corners_are_valid(false) );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the structured grid indexing and geometry
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, structured) {
+
+  ASSERT_TRUE( mesh_.is_structured() );
+
+  const auto & grid = mesh_.structured();
+  auto cs = mesh_.cells();
+
+  ASSERT_EQ( mesh_.num_cells(), grid.num_cells() );
+  ASSERT_EQ( mesh_.num_vertices(), grid.num_vertices() );
+  ASSERT_TRUE( grid.is_uniform( mesh_.vertices() ) );
+
+  // the arithmetic connectivity matches the explicit one
+  for ( auto c : cs ) {
+    ASSERT_EQ( c.id(), grid.cell_id( grid.cell_ijk(c.id()) ) );
+    auto vs = mesh_.vertices(c);
+    auto ids = grid.cell_vertices( c.id() );
+    ASSERT_EQ( vs.size(), ids.size() );
+    for ( size_t i=0; i<vs.size(); ++i ) {
+      ASSERT_EQ( vs[i].id(), ids[i] );
+#ifdef USE_IMPLICIT_DUAL
+      ASSERT_EQ( 
+        mesh_.dual().cell_corners( c.id() )[i], grid.cell_corner( c.id(), i ) 
+      );
+#endif
+    }
+    size_t num_neigh = 0;
+    for ( size_t d=0; d<num_dimensions; ++d )
+      for ( auto upper : {false, true} ) {
+        auto n = grid.cell_neighbor( c.id(), d, upper );
+        if ( n == grid.invalid ) continue;
+        ++num_neigh;
+        bool found = false;
+        for ( auto f : mesh_.faces(c) ) 
+          for ( auto other : mesh_.cells(f) )
+            if ( other.id() == n ) found = true;
+        ASSERT_TRUE( found );
+      }
+    size_t num_interior = 0;
+    for ( auto f : mesh_.faces(c) ) 
+      if ( !f->is_boundary() ) ++num_interior;
+    ASSERT_EQ( num_interior, num_neigh );
+  }
+
+  // the arithmetic geometry matches the general shapes
+  auto cell_volume = mesh_.cell_volumes();
+  auto cell_centroid = mesh_.cell_centroids();
+  auto cell_min_length = mesh_.cell_min_lengths();
+  for ( auto c : cs ) {
+    ASSERT_NEAR( c->volume(), cell_volume[c], test_tolerance );
+    ASSERT_NEAR( c->min_length(), cell_min_length[c], test_tolerance );
+    for ( int d=0; d<num_dimensions; ++d )
+      ASSERT_NEAR( c->centroid()[d], cell_centroid[c][d], test_tolerance );
+  }
+
+  auto face_area = mesh_.face_areas();
+  auto face_normal = mesh_.face_normals();
+  for ( auto f : mesh_.faces() ) {
+    auto n = f->normal();
+    ASSERT_NEAR( f->area(), face_area[f], test_tolerance );
+    for ( int d=0; d<num_dimensions; ++d )
+      ASSERT_NEAR( n[d] / f->area(), face_normal[f][d], test_tolerance );
+  }
+
+  // the grid layout survives a copy
+  auto copy = mesh_;
+  ASSERT_TRUE( copy.is_structured() );
+  ASSERT_EQ( grid.num_cells(), copy.structured().num_cells() );
+
+  // moving a vertex turns off the arithmetic geometry
+  auto v = mesh_.vertices()[ grid.vertex_id( {1, 1} ) ];
+  v->coordinates()[0] += 0.25;
+  ASSERT_FALSE( grid.is_uniform( mesh_.vertices() ) );
+  mesh_.update_geometry();
+  for ( auto c : cs )
+    ASSERT_NEAR( c->volume(), cell_volume[c], test_tolerance );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test grouping the cells by region
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, regions) {
+
+  auto cs = mesh_.cells();
+  auto num_cells = cs.size();
+
+  // everything starts in one region
+  ASSERT_EQ( 1, mesh_.num_regions() );
+  auto all = mesh_.region_cell_ids(0);
+  ASSERT_EQ( num_cells, all.size() );
+  for ( size_t i=0; i<num_cells; ++i )
+    ASSERT_EQ( i, all[i] );
+
+  // split the cells into three regions, round robin
+  for ( auto c : cs ) c->region() = c.id() % 3;
+  mesh_.set_num_regions( 3 );
+
+  size_t total = 0;
+  for ( size_t r=0; r<3; ++r ) {
+    auto ids = mesh_.region_cell_ids(r);
+    total += ids.size();
+    for ( size_t i=0; i<ids.size(); ++i ) {
+      ASSERT_EQ( r, cs[ ids[i] ]->region() );
+      if ( i > 0 ) ASSERT_LT( ids[i-1], ids[i] );
+    }
+  }
+  ASSERT_EQ( num_cells, total );
+
+  // the grouping survives a copy
+  auto copy = mesh_;
+  ASSERT_EQ( 3, copy.num_regions() );
+  ASSERT_EQ( mesh_.region_cell_ids(2).size(), copy.region_cell_ids(2).size() );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test assigning the cells to regions by position
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, assign_regions) {
+
+  // the left column goes in region 0, the right one in region 1
+  flecsale::mesh::assign_regions( mesh_, 2, 
+    []( const auto & x ) -> size_t { return x[0] < 1 ? 0 : 1; } 
+  );
+
+  ASSERT_EQ( 2, mesh_.num_regions() );
+  for ( size_t r=0; r<2; ++r ) {
+    auto ids = mesh_.region_cell_ids(r);
+    ASSERT_EQ( height, ids.size() );
+    for ( auto i : ids )
+      ASSERT_EQ( r, mesh_.cells()[i]->region() );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test locating points with the search tree
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, search) {
+
+  flecsale::mesh::cell_search_t<mesh_t> search( mesh_ );
+  auto cs = mesh_.cells();
+  auto cell_centroid = mesh_.cell_centroids();
+
+  // every centroid is found in its own cell
+  std::vector<vector_t> xs;
+  for ( auto c : cs ) xs.emplace_back( cell_centroid[c] );
+  std::vector<size_t> ids( xs.size() );
+  search.find_cells( xs, ids );
+  for ( auto c : cs ) ASSERT_EQ( c.id(), ids[c.id()] );
+
+  // points outside are not found
+  auto x = xs.front();
+  x[0] = -1;
+  ASSERT_EQ( search.invalid, search.find_cell( x ) );
+
+  // a vertex is found in one of the cells around it
+  auto vt = mesh_.vertices()[ mesh_.num_vertices() / 2 ];
+  auto id = search.find_cell( vt->coordinates() );
+  ASSERT_NE( search.invalid, id );
+  bool found = false;
+  for ( auto c : mesh_.cells(vt) ) if ( c.id() == id ) found = true;
+  ASSERT_TRUE( found );
+
+  // stretch and shear the mesh, the centroids move with it
+  for ( auto v : mesh_.vertices() ) {
+    auto & xv = v->coordinates();
+    xv[0] = 2*xv[0] + xv[1] / 2;
+  }
+  mesh_.update_geometry();
+  search.refit();
+
+  xs.clear();
+  for ( auto c : cs ) xs.emplace_back( cell_centroid[c] );
+  search.find_cells( xs, ids );
+  for ( auto c : cs ) ASSERT_EQ( c.id(), ids[c.id()] );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the in-situ extracts
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, extracts) {
+
+  auto cs = mesh_.cells();
+  auto num_cells = cs.size();
+  vector<real_t> val( num_cells );
+  for ( auto c : cs ) val[c.id()] = c.id();
+
+  // a plane on the middle grid line only cuts the cells below it
+  auto ids = flecsale::io::slice_cells( 
+    mesh_, vector_t{ 0, 1 }, vector_t{ 0, 1 } 
+  );
+  ASSERT_EQ( width, ids.size() );
+  for ( auto id : ids ) 
+    ASSERT_LT( mesh_.cell_centroids()[ cs[id] ][1], 1 );
+
+  // the histogram counts every cell once, and covers the data
+  auto hist = flecsale::io::compute_histogram( mesh_, val, 2, 0, 0 );
+  ASSERT_EQ( 0, hist.min );
+  ASSERT_EQ( num_cells - 1, hist.max );
+  ASSERT_EQ( num_cells, hist.counts[0] + hist.counts[1] );
+  ASSERT_NEAR( width*height, hist.volumes[0] + hist.volumes[1], test_tolerance );
+
+  // the statistics of two regions
+  for ( auto c : cs ) c->region() = c.id() % 2;
+  mesh_.set_num_regions( 2 );
+  auto stats = flecsale::io::compute_region_stats( mesh_, val );
+  ASSERT_EQ( 2, stats.size() );
+  for ( size_t r=0; r<2; ++r ) {
+    auto reg = mesh_.region_cell_ids(r);
+    real_t vol = 0, sum = 0;
+    for ( size_t i=0; i<reg.size(); ++i ) {
+      auto v = mesh_.cell_volumes()[ cs[reg[i]] ];
+      vol += v;
+      sum += v * val[ reg[i] ];
+    }
+    ASSERT_NEAR( vol, stats[r].volume, test_tolerance );
+    ASSERT_NEAR( sum / vol, stats[r].mean(), test_tolerance );
+    ASSERT_EQ( r, stats[r].min );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test recording the solution at a point
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, probes) {
+
+  using probes_t = flecsale::io::probe_recorder_t<mesh_t>;
+
+  // pretend this rank only owns the bottom half of the cells
+  auto mesh = flecsale::mesh::box<mesh_t>( 4, 4, 0, 0, 1, 1 );
+  mesh.set_num_owned( mesh.num_cells()/2, mesh.num_vertices() );
+
+  auto read_lines = []( const std::string & name ) {
+    std::ifstream file( name );
+    vector<std::string> lines;
+    for ( std::string line; std::getline( file, line ); ) 
+      lines.emplace_back( line );
+    return lines;
+  };
+
+  // the probe starts in a cell owned by another rank
+  const std::string name = "burton_2d_probes.csv";
+  std::remove( name.c_str() );
+  {
+    probes_t probes( mesh, { {0.375, 0.625} } );
+    probes.add_field( "id", 1, 
+      []( const auto & ids, real_t * vals ) {
+        for ( size_t i=0; i<ids.size(); ++i ) vals[i] = ids[i];
+      }
+    );
+    ASSERT_EQ( 0, probes.num_located() );
+    ASSERT_EQ( probes_t::invalid, probes.cells()[0] );
+
+    // nothing is written until the probe is found
+    probes.open( name, flecsale::io::probe_format_t::csv );
+    probes.sample( 0, 0 );
+    probes.flush();
+    ASSERT_FALSE( std::ifstream( name ).good() );
+
+    // move the mesh up so the probe ends up in an owned cell
+    for ( auto v : mesh.vertices() ) v->coordinates()[1] += 0.5;
+    mesh.update_geometry();
+    probes.relocate();
+    ASSERT_EQ( 1, probes.num_located() );
+    auto id = probes.cells()[0];
+    ASSERT_LT( id, mesh.num_owned_cells() );
+    auto xc = mesh.cell_centroids()[ mesh.cells()[id] ];
+    ASSERT_NEAR( 0.375, xc[0], test_tolerance );
+    ASSERT_NEAR( 0.625, xc[1], test_tolerance );
+
+    // the first sample creates the file, the rest is buffered until flushed
+    probes.sample( 0.5, 3 );
+    probes.sample( 1.0, 4 );
+    auto lines = read_lines( name );
+    ASSERT_EQ( 1, lines.size() );
+    ASSERT_EQ( "step,time,probe,x,y,id", lines[0] );
+
+    probes.flush();
+    lines = read_lines( name );
+    ASSERT_EQ( 3, lines.size() );
+    ASSERT_EQ( "3,0.5,0,0.375,0.625," + std::to_string(id), lines[1] );
+    ASSERT_EQ( "4,1,0,0.375,0.625," + std::to_string(id), lines[2] );
+  }
+
+  // a probe that follows the flow moves with its cell
+  mesh.set_num_owned( mesh.num_cells(), mesh.num_vertices() );
+  probes_t follow( mesh, { {0.375, 0.625} }, true );
+  auto id = follow.cells()[0];
+  ASSERT_NE( probes_t::invalid, id );
+  for ( auto v : mesh.vertices() ) v->coordinates()[0] += 0.25;
+  mesh.update_geometry();
+  follow.relocate();
+  ASSERT_EQ( id, follow.cells()[0] );
+  ASSERT_NEAR( 0.625, follow.points()[0][0], test_tolerance );
+  ASSERT_NEAR( 0.625, follow.points()[0][1], test_tolerance );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test writing and restoring a checkpoint
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, checkpoint) {
+
+  auto make = [&]() {
+    auto mesh = flecsale::mesh::box<mesh_t>( 4, 4, 0, 0, 1, 1 );
+    mesh.install_boundary( 
+      [&]( auto f ) { return f->midpoint()[0] < test_tolerance; } 
+    );
+    return mesh;
+  };
+
+  // move a vertex and change the state
+  auto mesh = make();
+  auto vs = mesh.vertices();
+  vs[6]->coordinates()[0] += 0.1;
+  mesh.update_geometry();
+  for ( auto c : mesh.cells() ) c->region() = c.id() % 2;
+  mesh.set_num_regions( 2 );
+  mesh.set_time( 0.5 );
+  mesh.increment_time_step_counter( 12 );
+
+  vector<real_t> val( mesh.num_cells() );
+  vector<size_t> ids( mesh.num_cells() );
+  for ( auto c : mesh.cells() ) {
+    val[c.id()] = c.id() + 1;
+    ids[c.id()] = c.id();
+  }
+
+  flecsale::io::checkpoint_writer_t writer;
+  flecsale::io::add_mesh_state( mesh, writer );
+  writer.add_field( "val", ids, val );
+  writer.add_value( "cfl", real_t(0.25) );
+  writer.commit( "burton_2d_checkpoint.bin" );
+  writer.wait();
+
+  // the background write was timed
+  ASSERT_GT( writer.last_write_seconds(), 0 );
+
+  // every section starts on an aligned address
+  flecsale::io::checkpoint_reader_t reader( "burton_2d_checkpoint.bin" );
+  ASSERT_EQ( 0, reinterpret_cast<std::uintptr_t>( reader.data("val") ) % 64 );
+
+  // restore into a freshly built mesh
+  auto restored = make();
+  restored.set_num_regions( 2 );
+  flecsale::io::restore_mesh_state( reader, restored );
+
+  vector<real_t> restored_val( restored.num_cells() );
+  reader.read_field( "val", ids, restored_val );
+
+  ASSERT_EQ( val, restored_val );
+  ASSERT_EQ( 0.25, reader.read_value<real_t>( "cfl" ) );
+  ASSERT_EQ( mesh.time(), restored.time() );
+  ASSERT_EQ( mesh.time_step_counter(), restored.time_step_counter() );
+  for ( auto c : restored.cells() ) {
+    ASSERT_EQ( c.id() % 2, c->region() );
+    ASSERT_NEAR( 
+      mesh.cell_volumes()[c], restored.cell_volumes()[c], test_tolerance 
+    );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test smoothing a perturbed mesh
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, rezone) {
+
+  constexpr size_t num_x = 4;
+  auto mesh = flecsale::mesh::box<mesh_t>( num_x, num_x, 0, 0, 1, 1 );
+  auto vs = mesh.vertices();
+
+  // every edge shows up once at each end, interior vertices have four
+  // neighbors, the others three or two
+  auto graph = flecsale::mesh::vertex_graph( mesh );
+  ASSERT_EQ( mesh.num_vertices() + 1, graph.offsets.size() );
+  ASSERT_EQ( 2*mesh.num_edges(), graph.indices.size() );
+  for ( auto v : vs ) {
+    auto i = v.id();
+    auto num_neigh = graph.offsets[i+1] - graph.offsets[i];
+    if ( v->is_boundary() ) {
+      ASSERT_GE( num_neigh, 2 );
+      ASSERT_LE( num_neigh, 3 );
+    }
+    else
+      ASSERT_EQ( 4, num_neigh );
+    for ( auto j=graph.offsets[i]; j<graph.offsets[i+1]; ++j ) {
+      auto n = graph.indices[j];
+      ASSERT_NE( i, n );
+      auto begin = graph.indices.begin();
+      ASSERT_EQ( 1, std::count( begin + graph.offsets[n], 
+        begin + graph.offsets[n+1], i ) );
+    }
+  }
+
+  // the square cells are perfect
+  ASSERT_NEAR( 1, flecsale::mesh::min_cell_quality( mesh ), test_tolerance );
+
+  // move the center vertex
+  auto & center = vs[ 2*(num_x+1) + 2 ]->coordinates();
+  ASSERT_NEAR( 0.5, center[0], test_tolerance );
+  ASSERT_NEAR( 0.5, center[1], test_tolerance );
+  center[0] += 0.1;
+  center[1] += 0.05;
+  mesh.update_geometry();
+  auto perturbed_quality = flecsale::mesh::min_cell_quality( mesh );
+  ASSERT_LT( perturbed_quality, 1 );
+
+  // remember the boundary
+  vector<point_t> boundary;
+  for ( auto v : vs ) 
+    if ( v->is_boundary() ) boundary.emplace_back( v->coordinates() );
+
+  // a half relaxed sweep moves the vertex half way to its neighbors
+  flecsale::mesh::relax_vertices( mesh, graph, 1, 0.5 );
+  ASSERT_NEAR( 0.55, center[0], test_tolerance );
+  ASSERT_NEAR( 0.525, center[1], test_tolerance );
+
+  // and enough full sweeps bring back the square cells
+  flecsale::mesh::relax_vertices( mesh, graph, 100, 1 );
+  mesh.update_geometry();
+  ASSERT_NEAR( 0.5, center[0], 1.e-6 );
+  ASSERT_NEAR( 0.5, center[1], 1.e-6 );
+  ASSERT_NEAR( 1, flecsale::mesh::min_cell_quality( mesh ), 1.e-5 );
+
+  // the boundary does not move
+  size_t cnt = 0;
+  for ( auto v : vs ) {
+    if ( !v->is_boundary() ) continue;
+    for ( size_t d=0; d<num_dimensions; ++d )
+      ASSERT_EQ( boundary[cnt][d], v->coordinates()[d] );
+    ++cnt;
+  }
+  ASSERT_EQ( boundary.size(), cnt );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test recovering the state of a cell after a remap
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, remap_recovery) {
+
+  using flecsale::mesh::recover_remapped_state;
+
+  // the state before the remap
+  real_t d = 2, e = 3;
+  vector_t v = {1, -1};
+
+  // a remap that halves the density, with the same velocity and energy
+  vector_t mom = {1, -1};
+  real_t ke = 0.5 * 2;
+  ASSERT_TRUE( 
+    recover_remapped_state<real_t>( 1, mom, 1*(3+ke), 1*3, 1.e-8, d, v, e ) 
+  );
+  ASSERT_NEAR( 1, d, test_tolerance );
+  ASSERT_NEAR( 1, v[0], test_tolerance );
+  ASSERT_NEAR( -1, v[1], test_tolerance );
+  ASSERT_NEAR( 3, e, test_tolerance );
+
+  // too little total energy falls back to the remapped internal energy
+  ASSERT_TRUE( 
+    recover_remapped_state<real_t>( 1, mom, 0.5, 2, 1.e-8, d, v, e ) 
+  );
+  ASSERT_NEAR( 2, e, test_tolerance );
+
+  // a collapsed density leaves the old state alone, whether it is zero, 
+  // tiny, negative or not a number
+  d = 2; e = 3; v = {1, -1};
+  for ( real_t rho : { real_t(0), real_t(1.e-20), real_t(-1),
+    std::numeric_limits<real_t>::quiet_NaN() } ) 
+  {
+    auto min_density = real_t(1.e-8) * d;
+    ASSERT_FALSE( 
+      recover_remapped_state( 
+        rho, mom, real_t(1), real_t(1), min_density, d, v, e 
+      )
+    );
+    ASSERT_EQ( 2, d );
+    ASSERT_EQ( 3, e );
+    ASSERT_EQ( 1, v[0] );
+    ASSERT_EQ( -1, v[1] );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the adaptive refinement
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_2d, amr) {
+
+  using flecsale::mesh::amr_flag_t;
+
+  // a unit box with its left side tagged
+  auto mesh = flecsale::mesh::box<mesh_t>( 4, 4, 0, 0, 1, 1 );
+  auto left = mesh.install_boundary( 
+    [&]( auto f ) { return f->midpoint()[0] < test_tolerance; } 
+  );
+
+  flecsale::mesh::amr_hierarchy_t<num_dimensions> amr( mesh, 2 );
+  ASSERT_EQ( amr.num_cells(), mesh.num_cells() );
+
+  // a field whose integral should be conserved
+  vector<real_t> val( mesh.num_cells() );
+  for ( auto c : mesh.cells() ) val[c.id()] = c.id() + 1;
+  auto integral = [&]() {
+    auto volume = mesh.cell_volumes();
+    real_t sum = 0;
+    for ( auto c : mesh.cells() ) sum += val[c.id()] * volume[c];
+    return sum;
+  };
+  auto total = integral();
+
+  // adapt the mesh and carry everything over
+  auto adapt = [&]( auto && pick ) {
+    vector<amr_flag_t> flags( amr.num_cells() );
+    for ( size_t c=0; c<flags.size(); ++c ) flags[c] = pick( c );
+    auto transfer = amr.adapt( flags );
+    auto new_mesh = amr.template build<mesh_t>();
+    flecsale::mesh::transfer_mesh_attributes( mesh, new_mesh, transfer );
+    vector<real_t> new_val( transfer.num_cells() );
+    transfer.average( val, new_val );
+    mesh = std::move( new_mesh );
+    val = std::move( new_val );
+    return transfer.changed;
+  };
+
+  // refine the corner cell, then the child in the middle of the box.  The
+  // second step also splits the three coarse cells next to it.
+  ASSERT_TRUE( adapt( [&]( auto c ) { 
+    return c == 0 ? amr_flag_t::refine : amr_flag_t::keep;
+  } ) );
+  ASSERT_EQ( 19, mesh.num_cells() );
+
+  ASSERT_TRUE( adapt( [&]( auto c ) { 
+    auto ijk = amr.ijk(c);
+    return ( amr.level(c) == 1 && ijk[0] == 1 && ijk[1] == 1 ) ?
+      amr_flag_t::refine : amr_flag_t::keep;
+  } ) );
+  ASSERT_EQ( 31, mesh.num_cells() );
+  ASSERT_FALSE( mesh.is_structured() );
+
+  // the cells match the tree, and are 2:1 balanced
+  auto volume = mesh.cell_volumes();
+  real_t total_volume = 0;
+  for ( auto c : mesh.cells() ) {
+    auto h = 0.25 / ( 1 << amr.level(c.id()) );
+    ASSERT_NEAR( h*h, volume[c], test_tolerance );
+    total_volume += volume[c];
+  }
+  ASSERT_NEAR( 1, total_volume, test_tolerance );
+
+  for ( auto f : mesh.faces() ) {
+    auto cs = mesh.cells(f);
+    if ( cs.size() < 2 ) continue;
+    auto l0 = amr.level( cs[0].id() );
+    auto l1 = amr.level( cs[1].id() );
+    ASSERT_LE( std::max(l0, l1) - std::min(l0, l1), 1u );
+  }
+
+  // the field and the tags came along
+  ASSERT_NEAR( total, integral(), test_tolerance );
+
+  real_t left_area = 0;
+  for ( auto f : mesh.tagged_faces(left) ) left_area += f->area();
+  ASSERT_NEAR( 1, left_area, test_tolerance );
+  ASSERT_EQ( 1, mesh.num_boundaries() );
+
+  ASSERT_TRUE( mesh.is_valid(false) );
+
+  // coarsening everything gets the original box back
+  while ( adapt( []( auto ) { return amr_flag_t::coarsen; } ) );
+  ASSERT_EQ( 16, mesh.num_cells() );
+  ASSERT_TRUE( mesh.is_structured() );
+  ASSERT_NEAR( total, integral(), test_tolerance );
+
+} // TEST_F
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief test the accessors
 ////////////////////////////////////////////////////////////////////////////////
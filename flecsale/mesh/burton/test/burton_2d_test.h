@@ -15,7 +15,15 @@
 #include "burton_test_base.h"
 
 // user includes
+#include "flecsale/io/checkpoint.h"
+#include "flecsale/io/extracts.h"
+#include "flecsale/io/probes.h"
+#include "flecsale/mesh/amr.h"
+#include "flecsale/mesh/distributed.h"
 #include "flecsale/mesh/factory.h"
+#include "flecsale/mesh/partition.h"
+#include "flecsale/mesh/rezone.h"
+#include "flecsale/mesh/search.h"
 
 // some general using statements
 using std::vector;
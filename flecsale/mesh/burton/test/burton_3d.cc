@@ -479,3 +479,196 @@ TEST_F(burton_3d, normals) {
   }
 
 } // TEST_F
+
+#ifdef USE_IMPLICIT_DUAL
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the implicitly indexed corners and wedges
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, dual) {
+
+  const auto & dual = mesh_.dual();
+  auto cs = mesh_.cells();
+  auto fs = mesh_.faces();
+
+  ASSERT_EQ( mesh_.num_corners(), dual.num_corners() );
+  ASSERT_EQ( mesh_.num_wedges(), dual.num_wedges() );
+  ASSERT_EQ( 6*dual.num_corners(), dual.num_wedges() );
+
+  // the corners follow the cell vertex ordering
+  for ( auto c : cs ) {
+    auto vs = mesh_.vertices(c);
+    auto cnrs = dual.cell_corners( c.id() );
+    ASSERT_EQ( vs.size(), cnrs.size() );
+    for ( size_t i=0; i<vs.size(); ++i ) {
+      ASSERT_EQ( c.id(), dual.corner_cell( cnrs[i] ) );
+      ASSERT_EQ( vs[i].id(), dual.corner_vertex( cnrs[i] ) );
+    }
+  }
+
+  for ( auto v : mesh_.vertices() ) {
+    ASSERT_EQ( mesh_.cells(v).size(), dual.vertex_corners( v.id() ).size() );
+    for ( auto cn : dual.vertex_corners( v.id() ) )
+      ASSERT_EQ( v.id(), dual.corner_vertex(cn) );
+  }
+
+  // the facets point out of the cell and close it
+  const auto & n = dual.facet_normals();
+  const auto & l = dual.facet_areas();
+
+  for ( auto c : cs ) {
+    auto cx = c->centroid();
+    vector_t sum(0);
+    for ( auto cn : dual.cell_corners( c.id() ) )
+      for ( auto w : dual.corner_wedges(cn) ) {
+        auto delta = fs[ dual.wedge_face(w) ]->centroid() - cx;
+        ASSERT_GT( dot_product( n[w], delta ), 0 );
+        for ( int d=0; d<3; ++d ) sum[d] += l[w] * n[w][d];
+      }
+    for ( int d=0; d<3; ++d )
+      ASSERT_NEAR( 0, sum[d], flecsale::common::test_tolerance );
+  }
+
+  ASSERT_TRUE( mesh_.is_valid(false) );
+
+} // TEST_F
+
+#endif // USE_IMPLICIT_DUAL
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the structured grid indexing and geometry
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, structured) {
+
+  ASSERT_TRUE( mesh_.is_structured() );
+
+  const auto & grid = mesh_.structured();
+  ASSERT_TRUE( grid.is_uniform( mesh_.vertices() ) );
+
+  // the arithmetic connectivity matches the explicit one
+  for ( auto c : mesh_.cells() ) {
+    auto vs = mesh_.vertices(c);
+    auto ids = grid.cell_vertices( c.id() );
+    ASSERT_EQ( vs.size(), ids.size() );
+    for ( size_t i=0; i<vs.size(); ++i )
+      ASSERT_EQ( vs[i].id(), ids[i] );
+  }
+
+  // the arithmetic geometry matches the general shapes
+  auto cell_volume = mesh_.cell_volumes();
+  auto cell_centroid = mesh_.cell_centroids();
+  for ( auto c : mesh_.cells() ) {
+    ASSERT_NEAR( c->volume(), cell_volume[c], test_tolerance );
+    for ( int d=0; d<num_dimensions; ++d )
+      ASSERT_NEAR( c->centroid()[d], cell_centroid[c][d], test_tolerance );
+  }
+
+  auto face_area = mesh_.face_areas();
+  auto face_normal = mesh_.face_normals();
+  for ( auto f : mesh_.faces() ) {
+    auto n = f->normal();
+    ASSERT_NEAR( f->area(), face_area[f], test_tolerance );
+    for ( int d=0; d<num_dimensions; ++d )
+      ASSERT_NEAR( n[d] / f->area(), face_normal[f][d], test_tolerance );
+  }
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test locating points with the search tree
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, search) {
+
+  flecsale::mesh::cell_search_t<mesh_t> search( mesh_ );
+  auto cs = mesh_.cells();
+  auto cell_centroid = mesh_.cell_centroids();
+
+  // every centroid is found in its own cell
+  std::vector<vector_t> xs;
+  for ( auto c : cs ) xs.emplace_back( cell_centroid[c] );
+  std::vector<size_t> ids( xs.size() );
+  search.find_cells( xs, ids );
+  for ( auto c : cs ) ASSERT_EQ( c.id(), ids[c.id()] );
+
+  // points outside are not found
+  auto x = xs.front();
+  x[0] = -1;
+  ASSERT_EQ( search.invalid, search.find_cell( x ) );
+
+  // a vertex is found in one of the cells around it
+  auto vt = mesh_.vertices()[ mesh_.num_vertices() / 2 ];
+  auto id = search.find_cell( vt->coordinates() );
+  ASSERT_NE( search.invalid, id );
+  bool found = false;
+  for ( auto c : mesh_.cells(vt) ) if ( c.id() == id ) found = true;
+  ASSERT_TRUE( found );
+
+  // stretch and shear the mesh, the centroids move with it
+  for ( auto v : mesh_.vertices() ) {
+    auto & xv = v->coordinates();
+    xv[0] = 2*xv[0] + xv[1] / 2;
+  }
+  mesh_.update_geometry();
+  search.refit();
+
+  xs.clear();
+  for ( auto c : cs ) xs.emplace_back( cell_centroid[c] );
+  search.find_cells( xs, ids );
+  for ( auto c : cs ) ASSERT_EQ( c.id(), ids[c.id()] );
+
+} // TEST_F
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test the adaptive refinement
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_3d, amr) {
+
+  using flecsale::mesh::amr_flag_t;
+
+  auto mesh = flecsale::mesh::box<mesh_t>( 2, 2, 2, 0, 0, 0, 1, 1, 1 );
+  flecsale::mesh::amr_hierarchy_t<num_dimensions> amr( mesh, 2 );
+
+  auto adapt = [&]( auto && pick ) {
+    vector<amr_flag_t> flags( amr.num_cells() );
+    for ( size_t c=0; c<flags.size(); ++c ) flags[c] = pick( c );
+    auto transfer = amr.adapt( flags );
+    auto new_mesh = amr.template build<mesh_t>();
+    flecsale::mesh::transfer_mesh_attributes( mesh, new_mesh, transfer );
+    mesh = std::move( new_mesh );
+    return transfer.changed;
+  };
+
+  // a uniform refinement is still made of hexahedra
+  ASSERT_TRUE( adapt( []( auto ) { return amr_flag_t::refine; } ) );
+  ASSERT_EQ( 64, mesh.num_cells() );
+  ASSERT_TRUE( mesh.is_valid(false) );
+
+  while ( adapt( []( auto ) { return amr_flag_t::coarsen; } ) );
+  ASSERT_EQ( 8, mesh.num_cells() );
+
+  // refining a corner cell, and then the child in the middle, leaves
+  // hanging nodes, so the coarse cells are polyhedra
+  adapt( []( auto c ) { 
+    return c == 0 ? amr_flag_t::refine : amr_flag_t::keep;
+  } );
+  ASSERT_EQ( 15, mesh.num_cells() );
+
+  adapt( [&]( auto c ) { 
+    auto ijk = amr.ijk(c);
+    return ( amr.level(c) == 1 && ijk[0] == 1 && ijk[1] == 1 && ijk[2] == 1 ) ?
+      amr_flag_t::refine : amr_flag_t::keep;
+  } );
+  ASSERT_EQ( 71, mesh.num_cells() );
+
+  auto volume = mesh.cell_volumes();
+  real_t total_volume = 0;
+  for ( auto c : mesh.cells() ) {
+    auto h = 0.5 / ( 1 << amr.level(c.id()) );
+    ASSERT_NEAR( h*h*h, volume[c], test_tolerance );
+    total_volume += volume[c];
+  }
+  ASSERT_NEAR( 1, total_volume, test_tolerance );
+
+  ASSERT_TRUE( mesh.is_valid(false) );
+
+} // TEST_F
@@ -13,7 +13,9 @@
 #include "burton_test_base.h"
 
 // user includes
+#include "flecsale/mesh/amr.h"
 #include "flecsale/mesh/factory.h"
+#include "flecsale/mesh/search.h"
 
 // some general using statements
 using std::vector;
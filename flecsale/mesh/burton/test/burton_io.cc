@@ -26,6 +26,7 @@ TEST_F(burton_io, read_write_exo_2d) {
   string name("mixed.exo");
   ASSERT_FALSE(read_mesh(name, m));
   // check the mesh
+  EXPECT_TRUE( m.is_valid(false, validation_level_t::cheap) );
   EXPECT_TRUE( m.is_valid(false) );
   // create state data on b
   create_data(m);
@@ -260,6 +261,48 @@ TEST_F(burton_io, write_vtk_3d) {
 #endif // HAVE_EXODUS
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief test that both precisions of cell fields are written
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(burton_io, write_mixed_precision) {
+  auto m = flecsale::mesh::box<mesh_2d_t>( 4, 3, 0, 0, 1, 1 );
+  // create state data in both precisions
+  create_mixed_data(m);
+  auto num_cells = m.num_cells();
+  auto num_verts = m.num_vertices();
+  // compare the values read back
+  auto check = [&]( const auto & vals, double offset ) {
+    ASSERT_EQ( vals.size(), num_cells );
+    for ( auto c : m.cells() ) 
+      ASSERT_EQ( vals[c.id()], c.id() + offset );
+  };
+  // write a vtk file
+  string name = output_prefix()+vtk_extension;
+  ASSERT_FALSE(write_mesh(name, m, false));
+  check( read_vtk_cell_field( name, "pressure", num_cells ), 0 );
+  check( read_vtk_cell_field( name, "temperature", num_cells ), 0.5 );
+  // write an ascii tecplot file
+  name = output_prefix()+".dat";
+  ASSERT_FALSE(write_mesh(name, m));
+  check( read_dat_cell_field( name, "pressure", 2, num_verts, num_cells ), 0 );
+  check( read_dat_cell_field( name, "temperature", 2, num_verts, num_cells ), 0.5 );
+  // only write the selected fields
+  {
+    flecsale::mesh::scoped_output_options_t scope( { {"temperature"}, false } );
+    name = output_prefix()+"-selected"+vtk_extension;
+    ASSERT_FALSE(write_mesh(name, m, false));
+    EXPECT_TRUE( read_vtk_cell_field( name, "pressure", num_cells ).empty() );
+    check( read_vtk_cell_field( name, "temperature", num_cells ), 0.5 );
+    name = output_prefix()+"-selected.dat";
+    ASSERT_FALSE(write_mesh(name, m));
+    EXPECT_TRUE( 
+      read_dat_cell_field( name, "pressure", 2, num_verts, num_cells ).empty() 
+    );
+    check( read_dat_cell_field( name, "temperature", 2, num_verts, num_cells ), 0.5 );
+  }
+} // TEST_F
+
+
 // Below tests have their own readers
 
 #ifdef HAVE_VTK
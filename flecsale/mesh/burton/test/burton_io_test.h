@@ -14,6 +14,22 @@
 // test include
 #include "burton_test_base.h"
 
+// user includes
+#include "flecsale/mesh/factory.h"
+
+#ifdef HAVE_VTK
+#  include <vtkCellData.h>
+#  include <vtkDataArray.h>
+#  include <vtkSmartPointer.h>
+#  include <vtkUnstructuredGrid.h>
+#  include <vtkXMLUnstructuredGridReader.h>
+#endif
+
+// system includes
+#include <fstream>
+#include <sstream>
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief A utility for creating data
 ////////////////////////////////////////////////////////////////////////////////
@@ -54,6 +70,126 @@ void create_data(M & mesh )
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A utility for creating cell data in both precisions
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+void create_mixed_data(M & mesh ) 
+{
+
+  //! \brief the mesh float type
+  using real_t   = typename M::real_t;
+  //! \brief the reduced precision float type
+  using storage_real_t = typename M::storage_real_t;
+
+  // register
+  flecsi_register_data(mesh, hydro, pressure, real_t, dense, 1, cells);
+  flecsi_register_data(mesh, hydro, temperature, storage_real_t, dense, 1, cells);
+  // access
+  auto p = flecsi_get_accessor(mesh, hydro, pressure, real_t, dense, 0);
+  auto t = flecsi_get_accessor(mesh, hydro, temperature, storage_real_t, dense, 0);
+  // set attributes
+  p.attributes().set(persistent);
+  t.attributes().set(persistent);
+  // initialize, these are exact in either precision
+  for(auto c: mesh.cells()) {
+    p[c] = c.id();
+    t[c] = c.id() + 0.5;
+  } // for
+}
+
+#ifdef HAVE_VTK
+
+//! \brief The extension of the vtk files that are read back
+constexpr auto vtk_extension = ".vtu";
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Read a cell field back from a vtu file.
+//!
+//! \return The values, or an empty list if the field was not found.
+////////////////////////////////////////////////////////////////////////////////
+inline std::vector<double> read_vtk_cell_field( 
+  const string & name, const string & label, std::size_t num_cells ) 
+{
+  auto reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+  reader->SetFileName( name.c_str() );
+  reader->Update();
+  auto array = reader->GetOutput()->GetCellData()->GetArray( label.c_str() );
+  std::vector<double> vals;
+  if ( !array || array->GetNumberOfTuples() != num_cells ) return vals;
+  vals.resize( num_cells );
+  for ( std::size_t i=0; i<num_cells; ++i ) 
+    vals[i] = array->GetComponent( i, 0 );
+  return vals;
+}
+
+#else
+
+//! \brief The extension of the vtk files that are read back
+constexpr auto vtk_extension = ".vtk";
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Read a cell field back from an ascii legacy vtk file.
+//!
+//! \return The values, or an empty list if the field was not found.
+////////////////////////////////////////////////////////////////////////////////
+inline std::vector<double> read_vtk_cell_field( 
+  const string & name, const string & label, std::size_t num_cells ) 
+{
+  std::ifstream ifs( name );
+  string token;
+  // find the field header, and skip to the values
+  while ( ifs >> token )
+    if ( token == "SCALARS" && ifs >> token && token == label ) break;
+  while ( ifs >> token && token != "default" );
+  // read the values
+  std::vector<double> vals( num_cells );
+  for ( auto & v : vals ) ifs >> v;
+  if ( !ifs ) vals.clear();
+  return vals;
+}
+
+#endif // HAVE_VTK
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Read a cell field back from an ascii tecplot file.
+//!
+//! This assumes a single zone, and that the coordinates are the only nodal
+//! variables.
+//!
+//! \return The values, or an empty list if the field was not found.
+////////////////////////////////////////////////////////////////////////////////
+inline std::vector<double> read_dat_cell_field( 
+  const string & name, const string & label, std::size_t num_dims,
+  std::size_t num_verts, std::size_t num_cells ) 
+{
+  std::ifstream ifs( name );
+  string line;
+  // the variable names follow the VARIABLES line
+  while ( std::getline( ifs, line ) && line.find("VARIABLES") == string::npos );
+  std::getline( ifs, line );
+  std::istringstream iss( line );
+  std::vector<string> labels;
+  for ( string token; iss >> token; ) 
+    labels.emplace_back( token.substr( 1, token.size()-2 ) );
+  // the data follows the zone header
+  while ( std::getline( ifs, line ) && line.find("VARLOCATION") == string::npos );
+  // skip the variables before the one requested
+  std::vector<double> vals;
+  double val;
+  for ( std::size_t i=0; i<labels.size(); ++i ) {
+    auto n = ( i < num_dims ) ? num_verts : num_cells;
+    if ( labels[i] == label ) {
+      vals.resize( n );
+      for ( auto & v : vals ) ifs >> v;
+      break;
+    }
+    for ( std::size_t j=0; j<n; ++j ) ifs >> val;
+  }
+  if ( !ifs ) vals.clear();
+  return vals;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief test fixture for creating the mesh
 ////////////////////////////////////////////////////////////////////////////////
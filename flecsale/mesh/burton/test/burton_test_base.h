@@ -23,6 +23,7 @@ using mesh_3d_t   = flecsale::mesh::burton::burton_mesh_3d_t;
 using std::string;
 using flecsale::mesh::write_mesh;
 using flecsale::mesh::read_mesh;
+using flecsale::mesh::burton::validation_level_t;
 
 ////////////////////////////////////////////////////////////////////////////////
 //! \brief base test fixture for burton
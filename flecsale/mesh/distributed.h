@@ -0,0 +1,788 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some functionality for distributing a mesh over several mpi ranks
+///        and keeping the ghost entities up to date.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/mesh/partition.h"
+#include "flecsale/utils/errors.h"
+#include "flecsale/utils/mpi_utils.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The global ids and owning ranks of the entities of a mesh.
+//!
+//! The mesh described can either be the whole mesh, or any piece of it that
+//! contains all the cells owned by a rank and their ghosts.
+////////////////////////////////////////////////////////////////////////////////
+struct ownership_t {
+  //! \brief The global id of each cell.
+  std::vector<common::global_index_t> cell_ids;
+  //! \brief The global id of each vertex.
+  std::vector<common::global_index_t> vertex_ids;
+  //! \brief The rank owning each cell.
+  std::vector<int> cell_ranks;
+  //! \brief The rank owning each vertex.
+  std::vector<int> vertex_ranks;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The communication pattern for the ghost entities of a rank.
+//!
+//! All lists hold local entity ids.  The send list of one rank lines up
+//! with the receive list of its neighbor.
+////////////////////////////////////////////////////////////////////////////////
+struct halo_t {
+
+  //! \brief The entities exchanged with one neighboring rank.
+  struct neighbor_t {
+    //! \brief The neighbor's rank.
+    int rank;
+    //! \brief The owned entities sent to the neighbor.
+    std::vector<common::local_index_t> send;
+    //! \brief The ghost entities received from the neighbor.
+    std::vector<common::local_index_t> recv;
+  };
+
+  //! \brief The cell neighbors.
+  std::vector<neighbor_t> cells;
+  //! \brief The vertex neighbors.
+  std::vector<neighbor_t> vertices;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Exchanges the ghost values of a set of fields.
+//!
+//! The exchange is split into a start and a finish so that work that does
+//! not touch the ghost entities can be done while the messages are in
+//! flight.
+////////////////////////////////////////////////////////////////////////////////
+class halo_exchange_t {
+
+public:
+
+  //! \brief The list of neighbors type.
+  using neighbors_t = std::vector<halo_t::neighbor_t>;
+
+  //! \brief Main constructor.
+  //! \param [in] neighbors  The neighbors to exchange with.
+  explicit halo_exchange_t( const neighbors_t & neighbors ) :
+    neighbors_( neighbors ),
+    send_buffers_( neighbors.size() ),
+    recv_buffers_( neighbors.size() )
+  {}
+
+  //! \brief Make sure all messages are complete before going away.
+  ~halo_exchange_t()
+  { finish(); }
+
+  //! \brief Disallow copying.
+  //! \{
+  halo_exchange_t( const halo_exchange_t & ) = delete;
+  halo_exchange_t & operator=( const halo_exchange_t & ) = delete;
+  //! \}
+
+  //! \brief Post the messages for a set of fields.
+  //!
+  //! The fields must be indexable by local entity id and store trivially
+  //! copyable values.  They are copied into this object and only written to
+  //! in finish().
+  //!
+  //! \param [in] fields  The fields to exchange.
+  template< typename... As >
+  void start( As... fields )
+  {
+    // make sure the previous exchange is done
+    finish();
+    if ( neighbors_.empty() ) return;
+
+    // the total number of bytes per entity
+    std::size_t entity_bytes = 0;
+    using expand_t = int[];
+    (void) expand_t{ 0, ( entity_bytes += value_size(fields), 0 )... };
+
+#ifdef HAVE_MPI
+
+    auto num_neigh = neighbors_.size();
+    requests_.resize( 2*num_neigh );
+
+    // post the receives first
+    for ( std::size_t n=0; n<num_neigh; ++n ) {
+      const auto & neigh = neighbors_[n];
+      auto & buf = recv_buffers_[n];
+      buf.resize( entity_bytes * neigh.recv.size() );
+      MPI_Irecv(
+        buf.data(), buf.size(), MPI_BYTE, neigh.rank, tag_, MPI_COMM_WORLD,
+        &requests_[n]
+      );
+    }
+
+    // pack and send the owned values
+    for ( std::size_t n=0; n<num_neigh; ++n ) {
+      const auto & neigh = neighbors_[n];
+      auto & buf = send_buffers_[n];
+      buf.resize( entity_bytes * neigh.send.size() );
+      auto pos = buf.data();
+      (void) expand_t{ 0, ( pack( fields, neigh.send, pos ), 0 )... };
+      MPI_Isend(
+        buf.data(), buf.size(), MPI_BYTE, neigh.rank, tag_, MPI_COMM_WORLD,
+        &requests_[num_neigh + n]
+      );
+    }
+
+    // the receive buffers are unpacked in the same order
+    unpack_ = [this, fields...]() mutable
+    {
+      for ( std::size_t n=0; n<neighbors_.size(); ++n ) {
+        const char * pos = recv_buffers_[n].data();
+        using expand_t = int[];
+        (void) expand_t{ 0, ( unpack( fields, neighbors_[n].recv, pos ), 0 )... };
+      }
+    };
+
+    pending_ = true;
+
+#else
+
+    raise_runtime_error( "Exchanging ghost values requires mpi" );
+
+#endif
+  }
+
+  //! \brief Wait for the posted messages and store the ghost values.
+  void finish()
+  {
+    if ( !pending_ ) return;
+#ifdef HAVE_MPI
+    MPI_Waitall( requests_.size(), requests_.data(), MPI_STATUSES_IGNORE );
+#endif
+    unpack_();
+    unpack_ = nullptr;
+    pending_ = false;
+  }
+
+  //! \brief Exchange the ghost values of a set of fields and wait for them.
+  //! \param [in] fields  The fields to exchange.
+  template< typename... As >
+  void exchange( As... fields )
+  {
+    start( fields... );
+    finish();
+  }
+
+private:
+
+  //! \brief Return the size of one value of a field.
+  template< typename A >
+  static std::size_t value_size( const A & field )
+  { return sizeof( std::decay_t<decltype(field[0])> ); }
+
+  //! \brief Copy the values of a list of entities into a buffer.
+  template< typename A >
+  static void pack(
+    A & field, const std::vector<common::local_index_t> & ids, char * & pos
+  ) {
+    using value_t = std::decay_t<decltype(field[0])>;
+    static_assert( std::is_trivially_copyable<value_t>::value,
+      "ghost values must be trivially copyable" );
+    for ( auto id : ids ) {
+      const value_t & val = field[id];
+      std::memcpy( pos, &val, sizeof(value_t) );
+      pos += sizeof(value_t);
+    }
+  }
+
+  //! \brief Copy the values of a list of entities out of a buffer.
+  template< typename A >
+  static void unpack(
+    A & field,
+    const std::vector<common::local_index_t> & ids,
+    const char * & pos
+  ) {
+    using value_t = std::decay_t<decltype(field[0])>;
+    for ( auto id : ids ) {
+      value_t & val = field[id];
+      std::memcpy( &val, pos, sizeof(value_t) );
+      pos += sizeof(value_t);
+    }
+  }
+
+  //! \brief The message tag used for all exchanges.
+  static constexpr int tag_ = 1001;
+
+  //! \brief The neighbors.
+  neighbors_t neighbors_;
+  //! \brief The message buffers.
+  //! \{
+  std::vector< std::vector<char> > send_buffers_;
+  std::vector< std::vector<char> > recv_buffers_;
+  //! \}
+#ifdef HAVE_MPI
+  //! \brief The outstanding requests.
+  std::vector<MPI_Request> requests_;
+#endif
+  //! \brief Unpacks the received values.
+  std::function<void()> unpack_;
+  //! \brief True while an exchange is outstanding.
+  bool pending_ = false;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the ownership of a whole mesh from a cell partitioning.
+//!
+//! A vertex is owned by the lowest rank of its attached cells.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] parts  the rank of each cell
+//! \return the ownership
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+ownership_t global_ownership(
+  const T & mesh, const std::vector<std::size_t> & parts
+) {
+  using counter_t = typename T::counter_t;
+
+  ownership_t owners;
+
+  auto num_cells = mesh.num_cells();
+  owners.cell_ids.resize( num_cells );
+  std::iota( owners.cell_ids.begin(), owners.cell_ids.end(), 0 );
+  owners.cell_ranks.assign( parts.begin(), parts.end() );
+
+  auto vs = mesh.vertices();
+  auto num_verts = vs.size();
+  owners.vertex_ids.resize( num_verts );
+  std::iota( owners.vertex_ids.begin(), owners.vertex_ids.end(), 0 );
+  owners.vertex_ranks.resize( num_verts );
+
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_verts; ++i ) {
+    auto owner = std::numeric_limits<int>::max();
+    for ( auto c : mesh.cells( vs[i] ) )
+      owner = std::min( owner, owners.cell_ranks[c.id()] );
+    owners.vertex_ranks[i] = owner;
+  }
+
+  return owners;
+}
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Split a number of layers evenly over the ranks.
+//! \param [in] num_layers  The number of layers.
+//! \param [in] size  The number of ranks.
+//! \return the first layer of each rank, with one extra entry.
+////////////////////////////////////////////////////////////////////////////////
+inline std::vector<std::size_t> split_layers(
+  std::size_t num_layers, int size
+) {
+  if ( num_layers < static_cast<std::size_t>(size) )
+    raise_runtime_error(
+      "Cannot split " << num_layers << " layers of cells over " << size
+      << " ranks"
+    );
+  std::vector<std::size_t> first( size+1 );
+  for ( int r=0; r<=size; ++r ) first[r] = num_layers * r / size;
+  return first;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the rank owning a layer.
+//! \param [in] first  The first layer of each rank.
+//! \param [in] layer  The layer to look up.
+////////////////////////////////////////////////////////////////////////////////
+inline int layer_rank(
+  const std::vector<std::size_t> & first, std::size_t layer
+) {
+  auto it = std::upper_bound( first.begin(), first.end(), layer );
+  return std::distance( first.begin(), it ) - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Exchange the requested ghost ids and build the send lists.
+//!
+//! \param [in] owned_ids  The global ids of the owned entities, in local
+//!   order.
+//! \param [in] requests  The requested global ids of each neighbor.
+//! \param [in,out] neighbors  The neighbors with their receive lists, the
+//!   send lists are filled in.
+////////////////////////////////////////////////////////////////////////////////
+inline void build_send_lists(
+  const std::vector<common::global_index_t> & owned_ids,
+  const std::vector< std::vector<common::global_index_t> > & requests,
+  std::vector<halo_t::neighbor_t> & neighbors
+) {
+
+  auto size = utils::comm_size();
+
+#ifdef HAVE_MPI
+
+  using id_t = common::global_index_t;
+
+  // tell everyone how many ids are needed from them
+  std::vector<int> send_counts( size, 0 ), recv_counts( size, 0 );
+  for ( std::size_t n=0; n<neighbors.size(); ++n )
+    send_counts[ neighbors[n].rank ] = requests[n].size();
+
+  MPI_Alltoall(
+    send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT,
+    MPI_COMM_WORLD
+  );
+
+  std::vector<int> send_displs( size+1, 0 ), recv_displs( size+1, 0 );
+  std::partial_sum(
+    send_counts.begin(), send_counts.end(), send_displs.begin()+1
+  );
+  std::partial_sum(
+    recv_counts.begin(), recv_counts.end(), recv_displs.begin()+1
+  );
+
+  // now send the ids themselves
+  std::vector<id_t> send_ids( send_displs.back() );
+  for ( std::size_t n=0; n<neighbors.size(); ++n )
+    std::copy(
+      requests[n].begin(), requests[n].end(),
+      send_ids.begin() + send_displs[ neighbors[n].rank ]
+    );
+
+  std::vector<id_t> recv_ids( recv_displs.back() );
+  MPI_Alltoallv(
+    send_ids.data(), send_counts.data(), send_displs.data(),
+    utils::detail::mpi_type<id_t>::value(),
+    recv_ids.data(), recv_counts.data(), recv_displs.data(),
+    utils::detail::mpi_type<id_t>::value(),
+    MPI_COMM_WORLD
+  );
+
+  // map the requested global ids to local ones
+  std::unordered_map<id_t, common::local_index_t> local_ids;
+  local_ids.reserve( owned_ids.size() );
+  for ( std::size_t i=0; i<owned_ids.size(); ++i )
+    local_ids.emplace( owned_ids[i], i );
+
+  for ( int r=0; r<size; ++r ) {
+    if ( recv_counts[r] == 0 ) continue;
+    auto it = std::find_if(
+      neighbors.begin(), neighbors.end(),
+      [r]( const auto & n ) { return n.rank == r; }
+    );
+    if ( it == neighbors.end() ) {
+      neighbors.emplace_back( halo_t::neighbor_t{r, {}, {}} );
+      it = std::prev( neighbors.end() );
+    }
+    it->send.reserve( recv_counts[r] );
+    for ( auto j=recv_displs[r]; j<recv_displs[r+1]; ++j ) {
+      auto lid = local_ids.find( recv_ids[j] );
+      if ( lid == local_ids.end() )
+        raise_runtime_error(
+          "Rank " << r << " requested entity " << recv_ids[j]
+          << " which is not owned here"
+        );
+      it->send.emplace_back( lid->second );
+    }
+  }
+
+#else
+
+  if ( !neighbors.empty() )
+    raise_runtime_error(
+      "The mesh has ghosts owned by other ranks, but there is no mpi"
+    );
+
+#endif
+
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the piece of a 2d box mesh needed by one rank.
+//!
+//! The cells are split into slabs of whole rows, one per rank, and only the
+//! slab plus one row of ghost cells on each side is ever created.  The
+//! coordinates and global ids match the ones of the full box() mesh.
+//!
+//! \param [in] num_cells  the number of cells in the x and y dir
+//! \param [in] mins  the min coordinate in the x and y dir
+//! \param [in] maxs  the max coordinate in the x and y dir
+//! \param [in] rank  the rank to build the piece for
+//! \param [in] size  the number of ranks
+//! \param [out] owners  the global ids and owners of the piece's entities
+//! \return the mesh piece
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename I >
+std::enable_if_t<T::num_dimensions == 2, T>
+box_slab(
+  const std::array<I, 2> & num_cells,
+  const std::array<typename T::real_t, 2> & mins,
+  const std::array<typename T::real_t, 2> & maxs,
+  int rank,
+  int size,
+  ownership_t & owners
+) {
+
+  using counter_t = typename T::counter_t;
+  using vertex_t = typename T::vertex_t;
+
+  std::size_t num_cells_x = num_cells[0];
+  std::size_t num_cells_y = num_cells[1];
+  auto num_vert_x = num_cells_x + 1;
+
+  auto delta_x = ( maxs[0] - mins[0] ) / num_cells_x;
+  auto delta_y = ( maxs[1] - mins[1] ) / num_cells_y;
+
+  // the rows of this rank, plus the ghost rows
+  auto first = detail::split_layers( num_cells_y, size );
+  auto j_begin = first[rank] > 0 ? first[rank] - 1 : 0;
+  auto j_end = std::min( first[rank+1] + 1, num_cells_y );
+
+  T mesh;
+  mesh.init_parameters( (j_end - j_begin + 1) * num_vert_x );
+
+  owners = ownership_t();
+
+  // create the individual vertices
+  std::vector<vertex_t *> vs;
+  for ( counter_t j = j_begin; j <= j_end; ++j ) {
+    auto y = mins[1] + j * delta_y;
+    // a vertex belongs to the lowest rank of its cells
+    auto owner = detail::layer_rank( first, j > 0 ? j-1 : 0 );
+    for ( counter_t i = 0; i < num_vert_x; ++i ) {
+      auto x = mins[0] + i * delta_x;
+      vs.emplace_back( mesh.create_vertex( {x, y} ) );
+      owners.vertex_ids.emplace_back( i + num_vert_x * j );
+      owners.vertex_ranks.emplace_back( owner );
+    }
+  }
+
+  // define each cell
+  auto index = [=](auto i, auto j) { return i + num_vert_x * (j - j_begin); };
+
+  for ( counter_t j = j_begin; j < j_end; ++j ) {
+    auto owner = detail::layer_rank( first, j );
+    for ( counter_t i = 0; i < num_cells_x; ++i ) {
+      mesh.create_cell( {vs[index(i, j)], vs[index(i + 1, j)],
+                         vs[index(i + 1, j + 1)], vs[index(i, j + 1)]} );
+      owners.cell_ids.emplace_back( i + num_cells_x * j );
+      owners.cell_ranks.emplace_back( owner );
+    }
+  }
+
+  // now finalize the mesh setup
+  mesh.init();
+
+  return mesh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the piece of a 3d box mesh needed by one rank.
+//!
+//! The cells are split into slabs of whole planes in the z direction.
+//! \see the 2d version for the details.
+//!
+//! \param [in] num_cells  the number of cells in the x, y and z dir
+//! \param [in] mins  the min coordinate in the x, y and z dir
+//! \param [in] maxs  the max coordinate in the x, y and z dir
+//! \param [in] rank  the rank to build the piece for
+//! \param [in] size  the number of ranks
+//! \param [out] owners  the global ids and owners of the piece's entities
+//! \return the mesh piece
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename I >
+std::enable_if_t<T::num_dimensions == 3, T>
+box_slab(
+  const std::array<I, 3> & num_cells,
+  const std::array<typename T::real_t, 3> & mins,
+  const std::array<typename T::real_t, 3> & maxs,
+  int rank,
+  int size,
+  ownership_t & owners
+) {
+
+  using counter_t = typename T::counter_t;
+  using vertex_t = typename T::vertex_t;
+
+  std::size_t num_cells_x = num_cells[0];
+  std::size_t num_cells_y = num_cells[1];
+  std::size_t num_cells_z = num_cells[2];
+  auto num_vert_x = num_cells_x + 1;
+  auto num_vert_y = num_cells_y + 1;
+
+  auto delta_x = ( maxs[0] - mins[0] ) / num_cells_x;
+  auto delta_y = ( maxs[1] - mins[1] ) / num_cells_y;
+  auto delta_z = ( maxs[2] - mins[2] ) / num_cells_z;
+
+  // the planes of this rank, plus the ghost planes
+  auto first = detail::split_layers( num_cells_z, size );
+  auto k_begin = first[rank] > 0 ? first[rank] - 1 : 0;
+  auto k_end = std::min( first[rank+1] + 1, num_cells_z );
+
+  T mesh;
+  mesh.init_parameters( (k_end - k_begin + 1) * num_vert_x * num_vert_y );
+
+  owners = ownership_t();
+
+  // create the individual vertices
+  std::vector<vertex_t *> vs;
+  for ( counter_t k = k_begin; k <= k_end; ++k ) {
+    auto z = mins[2] + k * delta_z;
+    // a vertex belongs to the lowest rank of its cells
+    auto owner = detail::layer_rank( first, k > 0 ? k-1 : 0 );
+    for ( counter_t j = 0; j < num_vert_y; ++j ) {
+      auto y = mins[1] + j * delta_y;
+      for ( counter_t i = 0; i < num_vert_x; ++i ) {
+        auto x = mins[0] + i * delta_x;
+        vs.emplace_back( mesh.create_vertex( {x, y, z} ) );
+        owners.vertex_ids.emplace_back( i + num_vert_x * (j + num_vert_y * k) );
+        owners.vertex_ranks.emplace_back( owner );
+      }
+    }
+  }
+
+  // define each cell
+  auto index = [=](auto i, auto j, auto k) {
+    return i + num_vert_x * (j + num_vert_y * (k - k_begin));
+  };
+
+  for ( counter_t k = k_begin; k < k_end; ++k ) {
+    auto owner = detail::layer_rank( first, k );
+    for ( counter_t j = 0; j < num_cells_y; ++j )
+      for ( counter_t i = 0; i < num_cells_x; ++i ) {
+        mesh.create_cell( {
+          vs[index(i, j, k)], vs[index(i + 1, j, k)],
+          vs[index(i + 1, j + 1, k)], vs[index(i, j + 1, k)],
+          vs[index(i, j, k + 1)], vs[index(i + 1, j, k + 1)],
+          vs[index(i + 1, j + 1, k + 1)], vs[index(i, j + 1, k + 1)]
+        } );
+        owners.cell_ids.emplace_back( i + num_cells_x * (j + num_cells_y * k) );
+        owners.cell_ranks.emplace_back( owner );
+      }
+  }
+
+  // now finalize the mesh setup
+  mesh.init();
+
+  return mesh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the local mesh of a rank.
+//!
+//! The local mesh holds the cells owned by the rank, followed by a layer of
+//! ghost cells that share a vertex with an owned cell.  The vertices are
+//! also numbered with the owned ones first.  Within each group, the
+//! entities are sorted by owner and global id, so the ghosts received from
+//! each neighbor are contiguous.
+//!
+//! \param [in] src  the whole mesh, or a piece containing at least the
+//!   owned cells and their ghosts
+//! \param [in] owners  the global ids and owners of the source entities
+//! \param [in] rank  the rank to build the mesh for
+//! \param [out] halo  the ghost exchange pattern
+//! \return the local mesh
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T distribute(
+  const T & src, const ownership_t & owners, int rank, halo_t & halo
+) {
+
+  using vertex_t = typename T::vertex_t;
+
+  auto src_cells = src.cells();
+  auto src_verts = src.vertices();
+  auto num_src_cells = src_cells.size();
+  auto num_src_verts = src_verts.size();
+
+  // mark the owned cells and their ghosts
+  std::vector<char> cell_mask( num_src_cells, 0 );
+  std::vector<char> vert_mask( num_src_verts, 0 );
+
+  for ( auto c : src_cells )
+    if ( owners.cell_ranks[c.id()] == rank )
+      for ( auto v : src.vertices(c) ) vert_mask[v.id()] = 1;
+
+  for ( auto v : src_verts )
+    if ( vert_mask[v.id()] )
+      for ( auto c : src.cells(v) ) cell_mask[c.id()] = 1;
+
+  std::fill( vert_mask.begin(), vert_mask.end(), 0 );
+  for ( auto c : src_cells )
+    if ( cell_mask[c.id()] )
+      for ( auto v : src.vertices(c) ) vert_mask[v.id()] = 1;
+
+  // sort them owned first, then by owner and global id
+  auto order = [&](
+    const std::vector<char> & mask,
+    const std::vector<int> & ranks,
+    const std::vector<common::global_index_t> & ids
+  ) {
+    std::vector<std::size_t> list;
+    for ( std::size_t i=0; i<mask.size(); ++i )
+      if ( mask[i] ) list.emplace_back( i );
+    std::sort( list.begin(), list.end(),
+      [&]( auto a, auto b ) {
+        auto ra = ranks[a] == rank ? -1 : ranks[a];
+        auto rb = ranks[b] == rank ? -1 : ranks[b];
+        return ra < rb || ( ra == rb && ids[a] < ids[b] );
+      }
+    );
+    return list;
+  };
+
+  auto cell_order = order( cell_mask, owners.cell_ranks, owners.cell_ids );
+  auto vert_order = order( vert_mask, owners.vertex_ranks, owners.vertex_ids );
+
+  check_local_index_range( cell_order.size(), "local cells" );
+  check_local_index_range( vert_order.size(), "local vertices" );
+
+  constexpr auto unset = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> new_vert_id( num_src_verts, unset );
+  for ( std::size_t i=0; i<vert_order.size(); ++i )
+    new_vert_id[ vert_order[i] ] = i;
+
+  // create the local mesh
+  T mesh;
+  mesh.init_parameters( vert_order.size() );
+
+  std::vector<vertex_t*> vs;
+  vs.reserve( vert_order.size() );
+  for ( auto vid : vert_order )
+    vs.emplace_back( mesh.create_vertex( src_verts[vid]->coordinates() ) );
+
+  for ( auto cid : cell_order ) {
+    auto verts = src.vertices( src_cells[cid] );
+    std::vector<vertex_t*> elem_vs;
+    elem_vs.reserve( verts.size() );
+    for ( auto v : verts ) elem_vs.emplace_back( vs[ new_vert_id[v.id()] ] );
+    mesh.create_cell( elem_vs );
+  }
+
+  mesh.init();
+
+  // copy the region ids
+  auto cs = mesh.cells();
+  for ( std::size_t i=0; i<cell_order.size(); ++i )
+    cs[i]->region() = src_cells[ cell_order[i] ]->region();
+  mesh.set_num_regions( src.num_regions() );
+
+  // build the exchange pattern for one kind of entity
+  auto build_halo = [&](
+    const std::vector<std::size_t> & list,
+    const std::vector<int> & ranks,
+    const std::vector<common::global_index_t> & ids,
+    std::vector<halo_t::neighbor_t> & neighbors
+  ) {
+    std::vector<common::global_index_t> owned_ids;
+    std::vector< std::vector<common::global_index_t> > requests;
+    neighbors.clear();
+    for ( std::size_t i=0; i<list.size(); ++i ) {
+      auto r = ranks[ list[i] ];
+      auto gid = ids[ list[i] ];
+      if ( r == rank ) {
+        owned_ids.emplace_back( gid );
+        continue;
+      }
+      if ( neighbors.empty() || neighbors.back().rank != r ) {
+        neighbors.emplace_back( halo_t::neighbor_t{r, {}, {}} );
+        requests.emplace_back();
+      }
+      neighbors.back().recv.emplace_back( i );
+      requests.back().emplace_back( gid );
+    }
+    detail::build_send_lists( owned_ids, requests, neighbors );
+    return owned_ids.size();
+  };
+
+  auto num_owned_cells = build_halo(
+    cell_order, owners.cell_ranks, owners.cell_ids, halo.cells
+  );
+  auto num_owned_verts = build_halo(
+    vert_order, owners.vertex_ranks, owners.vertex_ids, halo.vertices
+  );
+
+  mesh.set_num_owned( num_owned_cells, num_owned_verts );
+
+  return mesh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the name of the file written by this rank.
+//!
+//! With more than one rank, the rank number is appended to the base name.
+//!
+//! \param [in] basename  the file name without the extension
+//! \param [in] postfix  the file extension
+//! \return the file name
+////////////////////////////////////////////////////////////////////////////////
+inline std::string rank_file_name(
+  const std::string & basename, const std::string & postfix,
+  int rank = utils::comm_rank()
+) {
+  std::stringstream ss;
+  ss << basename;
+  if ( utils::comm_size() > 1 )
+    ss << "-" << std::setw( 5 ) << std::setfill( '0' ) << rank;
+  ss << "." << postfix;
+  return ss.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Write an index file listing the files written by all the ranks.
+//!
+//! The index uses the VisIt ".visit" format and is only written by the
+//! first rank, and only if there is more than one rank.
+//!
+//! \param [in] basename  the file name without the extension
+//! \param [in] postfix  the extension of the files written by each rank
+////////////////////////////////////////////////////////////////////////////////
+inline void write_index(
+  const std::string & basename, const std::string & postfix
+) {
+  auto size = utils::comm_size();
+  if ( size < 2 || utils::comm_rank() != 0 ) return;
+
+  auto filename = basename + ".visit";
+  std::ofstream file( filename );
+  if ( !file )
+    raise_runtime_error( "Could not open \"" << filename << "\"" );
+
+  // the pieces are referenced relative to the index
+  auto dir = basename.find_last_of( '/' );
+  auto strip = [&]( const std::string & name ) {
+    return dir == std::string::npos ? name : name.substr( dir+1 );
+  };
+
+  file << "!NBLOCKS " << size << std::endl;
+  for ( int r=0; r<size; ++r )
+    file << strip( rank_file_name( basename, postfix, r ) ) << std::endl;
+}
+
+} // namespace
+} // namespace
@@ -12,6 +12,7 @@
 // user includes
 #include "flecsale/math/constants.h"
 #include "flecsale/math/matrix.h"
+#include "flecsale/utils/errors.h"
 
 // system includes
 #include <array>
@@ -77,6 +78,10 @@ box(typename T::size_t num_cells_x, typename T::size_t num_cells_y,
                                  vs[index(i + 1, j + 1)], vs[index(i, j + 1)]});
     }
 
+  // the cells are numbered lexicographically, so flag the grid layout
+  mesh.set_structured({num_cells_x, num_cells_y}, {min_x, min_y},
+                      {max_x, max_y});
+
   // now finalize the mesh setup
   mesh.init();
 
@@ -171,6 +176,10 @@ ptr_box(typename T::size_t num_cells_x, typename T::size_t num_cells_y,
                                  vs[index(i + 1, j + 1)], vs[index(i, j + 1)]});
     }
 
+  // the cells are numbered lexicographically, so flag the grid layout
+  mesh.set_structured({num_cells_x, num_cells_y}, {min_x, min_y},
+                      {max_x, max_y});
+
   // now finalize the mesh setup
   mesh.init();
 
@@ -287,6 +296,10 @@ box(typename T::size_t num_cells_x, typename T::size_t num_cells_y,
             vs[vert_index(i, j + 1, k + 1)],
         });
 
+  // the cells are numbered lexicographically, so flag the grid layout
+  mesh.set_structured({num_cells_x, num_cells_y, num_cells_z},
+                      {min_x, min_y, min_z}, {max_x, max_y, max_z});
+
   // now finalize the mesh setup
   mesh.init();
 
@@ -404,6 +417,10 @@ ptr_box(typename T::size_t num_cells_x, typename T::size_t num_cells_y,
             vs[vert_index(i, j + 1, k + 1)],
         });
 
+  // the cells are numbered lexicographically, so flag the grid layout
+  mesh.set_structured({num_cells_x, num_cells_y, num_cells_z},
+                      {min_x, min_y, min_z}, {max_x, max_y, max_z});
+
   // now finalize the mesh setup
   mesh.init();
 
@@ -560,5 +577,31 @@ void rotate( T & mesh, typename T::real_t degrees )
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Assign every cell to a region based on where its centroid is.
+//!
+//! \param [in,out] mesh     the mesh whose cells are assigned
+//! \param [in] num_regions  the number of regions in the mesh
+//! \param [in] region_of    returns the region id of a point
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+void assign_regions( T & mesh, std::size_t num_regions, F && region_of )
+{
+
+  for ( auto c : mesh.cells() ) {
+    auto r = region_of( c->centroid() );
+    if ( r >= num_regions )
+      raise_runtime_error(
+        "Cell " << c.id() << " was put in region " << r << " but there are "
+        << "only " << num_regions << " regions"
+      );
+    c->region() = r;
+  }
+
+  // regroup the cells by their new regions
+  mesh.set_num_regions( num_regions );
+
+}
+
 } // namespace mesh
 } // namespace flecsale
@@ -10,12 +10,15 @@
 #pragma once
 
 // user includes
+#include "flecsale/mesh/output_fields.h"
+
 #ifdef HAVE_OPENSSL
 #  include <flecsi/utils/checksum.h>
 #endif
 
 // system includes
 #include <iomanip>
+#include <type_traits>
 
 namespace flecsale {
 namespace mesh {
@@ -120,15 +123,12 @@ int checksum( T & mesh )
   // Checksum Cell Solution Quantities
   auto cels = mesh.cells();
 
-  // real scalars persistent at cells
-  auto rspac = flecsi_get_accessors_all(
-    mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-  );
-  for(auto sf: rspac) {
+  // real scalars persistent at cells, in either precision
+  for_each_real_field( mesh, [&]( auto && sf ) {
     auto cs = checksum( cels, sf );
     std::cout << std::left << std::setw(32) << sf.label() << " " 
               << std::setw(32) << cs.strvalue << std::endl;
-  }
+  } );
   // int scalars persistent at cells
   auto ispac = flecsi_get_accessors_all(
     mesh, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
@@ -0,0 +1,158 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Controls which fields the mesh writers output.
+///
+/// The writers are picked by file extension through the flecsi io registry,
+/// so they cannot be handed any extra arguments.  Instead, they all consult
+/// the options set here before writing.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The options used by the mesh writers.
+////////////////////////////////////////////////////////////////////////////////
+struct output_options_t {
+
+  //! \brief The labels of the persistent fields to write.  If it is empty,
+  //! all of them are written.
+  std::vector<std::string> fields;
+
+  //! \brief If true, writers that support it compress the data.
+  bool compress = false;
+
+  //! \brief Check if a field should be written.
+  //! \param [in] label  The field label.
+  bool selected( const std::string & label ) const
+  {
+    return fields.empty() ||
+      std::find( fields.begin(), fields.end(), label ) != fields.end();
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the options the writers currently use.
+////////////////////////////////////////////////////////////////////////////////
+inline output_options_t & current_output_options()
+{
+  static output_options_t options;
+  return options;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sets the output options for the lifetime of this object.
+//!
+//! \code
+//!   {
+//!     scoped_output_options_t scope( { {"density", "pressure"}, true } );
+//!     write_mesh( "small.vtu", mesh );
+//!   }
+//! \endcode
+////////////////////////////////////////////////////////////////////////////////
+class scoped_output_options_t {
+
+public:
+
+  //! \brief Constructor.
+  //! \param [in] options  The options to use.
+  explicit scoped_output_options_t( output_options_t options )
+    : saved_( std::move(current_output_options()) )
+  {
+    current_output_options() = std::move(options);
+  }
+
+  //! \brief Destructor.  Restores the previous options.
+  ~scoped_output_options_t()
+  {
+    current_output_options() = std::move(saved_);
+  }
+
+  //! \brief The options cannot be saved twice.
+  //! \{
+  scoped_output_options_t( const scoped_output_options_t & ) = delete;
+  scoped_output_options_t & operator=( const scoped_output_options_t & ) =
+    delete;
+  //! \}
+
+private:
+
+  //! \brief the options to restore
+  output_options_t saved_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Remove the field accessors that are not currently selected.
+//! \param [in,out] accessors  The accessors of the candidate fields.
+////////////////////////////////////////////////////////////////////////////////
+template< typename A >
+void filter_output_fields( A & accessors )
+{
+  const auto & options = current_output_options();
+  if ( options.fields.empty() ) return;
+  accessors.erase(
+    std::remove_if( accessors.begin(), accessors.end(),
+      [&]( const auto & a ) { return !options.selected( a.label() ); }
+    ),
+    accessors.end()
+  );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to each real scalar field persistent at cells.
+//!
+//! The full precision fields are visited first, then the reduced precision
+//! ones.  These are only a separate type when mixed precision is enabled.
+//!
+//! \param [in] mesh  The mesh the fields live on.
+//! \param [in] f  The function to apply to each field accessor.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename F >
+void for_each_real_field( M & mesh, F && f )
+{
+  using real_t = typename M::real_t;
+  auto rspac = flecsi_get_accessors_all(
+    mesh, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+  );
+  for ( auto & sf : rspac ) f( sf );
+#ifdef USE_MIXED_PRECISION
+  using storage_real_t = typename M::storage_real_t;
+  auto sspac = flecsi_get_accessors_all(
+    mesh, storage_real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
+  );
+  for ( auto & sf : sspac ) f( sf );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Apply a function to each real scalar field persistent at cells
+//!        that is currently selected for output.
+//!
+//! \param [in] mesh  The mesh the fields live on.
+//! \param [in] f  The function to apply to each field accessor.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M, typename F >
+void for_each_output_real_field( M & mesh, F && f )
+{
+  const auto & options = current_output_options();
+  for_each_real_field( mesh, [&]( auto & sf ) {
+    if ( options.selected( sf.label() ) ) f( sf );
+  } );
+}
+
+} // namespace
+} // namespace
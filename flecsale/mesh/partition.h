@@ -0,0 +1,516 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some functionality for partitioning the cells of a mesh, and
+///        decomposing it into sub-domains that are each worked on by one
+///        thread.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/utils/errors.h"
+
+#ifdef HAVE_METIS
+#  include <metis.h>
+#endif
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+// system includes
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The cell adjacency graph in compressed row storage.
+////////////////////////////////////////////////////////////////////////////////
+struct cell_graph_t {
+  //! \brief The offsets of the neighbors of each cell, with one extra entry.
+  std::vector<common::local_index_t> offsets;
+  //! \brief The neighbor indices.
+  std::vector<common::local_index_t> indices;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Make sure a number of entities fits in a local id.
+//!
+//! \param [in] n  the number of entities
+//! \param [in] what  what is being counted, for the error message
+////////////////////////////////////////////////////////////////////////////////
+inline void check_local_index_range( std::size_t n, const char * what )
+{
+  using local_index_t = common::local_index_t;
+  if ( n > std::numeric_limits<local_index_t>::max() )
+    raise_runtime_error(
+      "Too many " << what << " (" << n << ") for " << 8*sizeof(local_index_t)
+      << " bit local ids, reconfigure with USE_64BIT_IDS=ON"
+    );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A sub-domain of a mesh.
+//!
+//! A sub-domain is worked on by one thread.  It owns a set of cells, and
+//! every face is owned by exactly one sub-domain, so each face is computed
+//! once.  The values of the ghost cells, the neighbors across the owned
+//! faces that belong to someone else, are read through a local halo copy
+//! instead of straight from the global fields.  All the ids refer to the
+//! global mesh.
+////////////////////////////////////////////////////////////////////////////////
+struct subdomain_t {
+  //! \brief The owned cells, grouped by region and sorted within each one.
+  std::vector<common::local_index_t> cells;
+  //! \brief Where each region starts in the owned cells, with one extra
+  //!        entry.
+  std::vector<common::local_index_t> region_offsets;
+  //! \brief The owned faces, sorted.
+  std::vector<common::local_index_t> faces;
+  //! \brief The cells across the owned faces that are owned by another
+  //!        sub-domain or rank, sorted.
+  std::vector<common::local_index_t> ghost_cells;
+
+  //! \brief The value returned by ghost_index() for a cell that is not a
+  //!        ghost.
+  static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+  //! \brief Find where a cell is in the ghost list.
+  //! \param [in] c  The cell id.
+  //! \return The position of the cell in the ghost list, or \e npos if the
+  //!         cell is not a ghost of this sub-domain.
+  std::size_t ghost_index( std::size_t c ) const
+  {
+    auto it = std::lower_bound( ghost_cells.begin(), ghost_cells.end(), c );
+    if ( it == ghost_cells.end() || *it != c ) return npos;
+    return std::distance( ghost_cells.begin(), it );
+  }
+
+  //! \brief Refresh the halo copy of the ghost values.
+  //! \param [in] global  Called with a cell id, returns its global value.
+  //! \param [in,out] halo  The local copies, in the order of the ghost list.
+  template< typename F, typename T >
+  void update_ghosts( F && global, std::vector<T> & halo ) const
+  {
+    halo.resize( ghost_cells.size() );
+    for ( std::size_t i=0; i<ghost_cells.size(); ++i )
+      halo[i] = std::forward<F>(global)( ghost_cells[i] );
+  }
+};
+
+//! \brief The sub-domains of a mesh.
+using subdomains_t = std::vector<subdomain_t>;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The number of sub-domains used when none are asked for, which is
+//!        one per thread.
+////////////////////////////////////////////////////////////////////////////////
+inline std::size_t default_num_subdomains()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the face adjacency graph of the cells.
+//!
+//! \param [in] mesh the mesh object
+//! \return the cell graph
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+cell_graph_t cell_graph( const T & mesh )
+{
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  auto num_cells = cs.size();
+
+  check_local_index_range( num_cells, "cells" );
+
+  cell_graph_t graph;
+  graph.offsets.resize( num_cells + 1, 0 );
+
+  // count the neighbors first
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    std::size_t n = 0;
+    for ( auto f : mesh.faces(cs[i]) )
+      if ( !f->is_boundary() ) n++;
+    graph.offsets[i+1] = n;
+  }
+
+  // sum in wide integers so an overflow can be caught
+  std::size_t num_neighbors = 0;
+  for ( auto & n : graph.offsets ) {
+    num_neighbors += n;
+    n = num_neighbors;
+  }
+  check_local_index_range( num_neighbors, "cell neighbors" );
+  graph.indices.resize( num_neighbors );
+
+  // now fill them in
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    auto c = cs[i];
+    auto pos = graph.offsets[i];
+    for ( auto f : mesh.faces(c) ) {
+      if ( f->is_boundary() ) continue;
+      for ( auto n : mesh.cells(f) )
+        if ( n != c ) graph.indices[pos++] = n.id();
+    }
+  }
+
+  return graph;
+}
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Recursively bisect a set of cells.
+//!
+//! The cells are ordered with a breadth first search starting from a
+//! pseudo-peripheral cell, and the first part of that ordering becomes the
+//! first half.  This keeps each half connected whenever possible.
+//!
+//! \param [in] graph  The cell adjacency graph.
+//! \param [in,out] cells  The cells to bisect, cleared on return.
+//! \param [in] first_part  The id of the first part to assign.
+//! \param [in] num_parts  The number of parts to split the cells into.
+//! \param [out] parts  The part ids of each cell.
+//! \param [in,out] mark  Scratch storage for marking cells.
+//! \param [in,out] num_marks  The last marker used.
+////////////////////////////////////////////////////////////////////////////////
+inline void bisect_cells(
+  const cell_graph_t & graph,
+  std::vector<std::size_t> & cells,
+  std::size_t first_part,
+  std::size_t num_parts,
+  std::vector<std::size_t> & parts,
+  std::vector<std::size_t> & mark,
+  std::size_t & num_marks
+) {
+
+  if ( cells.empty() ) return;
+
+  if ( num_parts == 1 ) {
+    for ( auto c : cells ) parts[c] = first_part;
+    cells.clear();
+    return;
+  }
+
+  // order the cells with a breadth first search.  disconnected pieces are
+  // appended one after the other.
+  auto bfs = [&]( std::size_t start )
+  {
+    auto in_set = ++num_marks;
+    for ( auto c : cells ) mark[c] = in_set;
+    auto seen = ++num_marks;
+
+    std::vector<std::size_t> order;
+    order.reserve( cells.size() );
+
+    auto push = [&]( std::size_t c ) { mark[c] = seen; order.push_back(c); };
+    push( start );
+
+    std::size_t next = 0;
+    for ( std::size_t head = 0; order.size() < cells.size(); ) {
+      if ( head == order.size() ) {
+        while ( mark[ cells[next] ] != in_set ) next++;
+        push( cells[next] );
+      }
+      auto c = order[head++];
+      for ( auto j=graph.offsets[c]; j<graph.offsets[c+1]; ++j ) {
+        auto n = graph.indices[j];
+        if ( mark[n] == in_set ) push( n );
+      }
+    }
+
+    return order;
+  };
+
+  // the last cell reached is a good pseudo-peripheral starting point
+  auto order = bfs( cells.front() );
+  order = bfs( order.back() );
+
+  // split the ordering proportionally to the number of parts on each side
+  auto num_left = num_parts / 2;
+  auto split = cells.size() * num_left / num_parts;
+
+  std::vector<std::size_t> left( order.begin(), order.begin() + split );
+  std::vector<std::size_t> right( order.begin() + split, order.end() );
+
+  cells.clear();
+  cells.shrink_to_fit();
+  order.clear();
+  order.shrink_to_fit();
+
+  bisect_cells( graph, left, first_part, num_left, parts, mark, num_marks );
+  bisect_cells(
+    graph, right, first_part + num_left, num_parts - num_left, parts, mark,
+    num_marks
+  );
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Partition the cells of a mesh.
+//!
+//! METIS is used if it is available, otherwise the cells are partitioned
+//! using recursive graph bisection.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] num_parts  the number of partitions
+//! \return the partition id of each cell
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+std::vector<std::size_t> partition_cells( const T & mesh, std::size_t num_parts )
+{
+  auto num_cells = mesh.num_cells();
+  std::vector<std::size_t> parts( num_cells, 0 );
+
+  if ( num_parts < 1 )
+    raise_runtime_error( "Need at least one partition" );
+
+  if ( num_parts == 1 || num_cells == 0 ) return parts;
+
+  auto graph = cell_graph( mesh );
+
+#ifdef HAVE_METIS
+
+  idx_t num_verts = num_cells;
+  idx_t num_constraints = 1;
+  idx_t num_metis_parts = num_parts;
+  idx_t edge_cut;
+
+  std::vector<idx_t> xadj( graph.offsets.begin(), graph.offsets.end() );
+  std::vector<idx_t> adjncy( graph.indices.begin(), graph.indices.end() );
+  std::vector<idx_t> metis_parts( num_cells );
+
+  idx_t options[METIS_NOPTIONS];
+  METIS_SetDefaultOptions( options );
+  options[METIS_OPTION_NUMBERING] = 0;
+  // the threads wait on the largest part, so allow almost no imbalance
+  options[METIS_OPTION_UFACTOR] = 1;
+
+  auto ret = METIS_PartGraphKway(
+    &num_verts, &num_constraints, xadj.data(), adjncy.data(),
+    nullptr, nullptr, nullptr, &num_metis_parts, nullptr, nullptr,
+    options, &edge_cut, metis_parts.data()
+  );
+
+  if ( ret != METIS_OK )
+    raise_runtime_error( "METIS_PartGraphKway failed with error " << ret );
+
+  std::copy( metis_parts.begin(), metis_parts.end(), parts.begin() );
+
+#else
+
+  std::vector<std::size_t> cells( num_cells );
+  std::iota( cells.begin(), cells.end(), 0 );
+
+  std::vector<std::size_t> mark( num_cells, 0 );
+  std::size_t num_marks = 0;
+
+  detail::bisect_cells( graph, cells, 0, num_parts, parts, mark, num_marks );
+
+#endif
+
+  return parts;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Create a copy of a mesh where the cells of each partition are
+//!        numbered contiguously.
+//!
+//! Vertices are numbered in the order they are first used by the cells, so
+//! each partition's vertices are also mostly contiguous.  Loops over the
+//! entities with a static schedule then keep each thread within its own
+//! partition when the number of partitions matches the number of threads.
+//!
+//! \param [in] src  the mesh to reorder
+//! \param [in] parts  the partition id of each cell
+//! \return the reordered mesh
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T reorder( const T & src, const std::vector<std::size_t> & parts )
+{
+  using vertex_t = typename T::vertex_t;
+
+  auto src_cells = src.cells();
+  auto src_verts = src.vertices();
+  auto num_cells = src_cells.size();
+  auto num_verts = src_verts.size();
+
+  // sort the cells by partition, keeping the original order within one
+  std::vector<std::size_t> cell_order( num_cells );
+  std::iota( cell_order.begin(), cell_order.end(), 0 );
+  std::stable_sort(
+    cell_order.begin(), cell_order.end(),
+    [&]( auto a, auto b ) { return parts[a] < parts[b]; }
+  );
+
+  // number the vertices in the order they are first used
+  constexpr auto unset = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> vert_order;
+  std::vector<std::size_t> new_vert_id( num_verts, unset );
+  vert_order.reserve( num_verts );
+  for ( auto cid : cell_order )
+    for ( auto v : src.vertices( src_cells[cid] ) )
+      if ( new_vert_id[v.id()] == unset ) {
+        new_vert_id[v.id()] = vert_order.size();
+        vert_order.emplace_back( v.id() );
+      }
+
+  T mesh;
+  mesh.init_parameters( num_verts );
+
+  // create vertices
+  std::vector<vertex_t*> vs;
+  vs.reserve( vert_order.size() );
+  for ( auto vid : vert_order )
+    vs.emplace_back( mesh.create_vertex( src_verts[vid]->coordinates() ) );
+
+  // create cells
+  for ( auto cid : cell_order ) {
+    auto verts = src.vertices( src_cells[cid] );
+    std::vector<vertex_t*> elem_vs;
+    elem_vs.reserve( verts.size() );
+    for ( auto v : verts ) elem_vs.emplace_back( vs[ new_vert_id[v.id()] ] );
+    mesh.create_cell( elem_vs );
+  }
+
+  // initialize everything
+  mesh.init();
+
+  // copy the region ids
+  auto cs = mesh.cells();
+  for ( std::size_t i=0; i<num_cells; ++i )
+    cs[i]->region() = src_cells[ cell_order[i] ]->region();
+  mesh.set_num_regions( src.num_regions() );
+
+  return mesh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Split the owned cells of a mesh into contiguous blocks.
+//!
+//! This partitions a mesh without renumbering it.  The blocks match the
+//! static schedule of a plain loop over the cells.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] num_parts  the number of blocks
+//! \return the block of each cell, the cells past the owned ones get
+//!         \e num_parts
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+std::vector<std::size_t> partition_blocks( const T & mesh, std::size_t num_parts )
+{
+  if ( num_parts < 1 )
+    raise_runtime_error( "Need at least one partition" );
+
+  std::size_t num_cells = mesh.num_cells();
+  std::size_t num_owned = mesh.num_owned_cells();
+
+  std::vector<std::size_t> parts( num_cells, num_parts );
+  for ( std::size_t p=0; p<num_parts; ++p ) {
+    auto first = num_owned * p / num_parts;
+    auto last = num_owned * (p+1) / num_parts;
+    std::fill( parts.begin() + first, parts.begin() + last, p );
+  }
+
+  return parts;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the sub-domains of a partitioned mesh.
+//!
+//! A face is owned by the lowest numbered partition of its attached cells.
+//! The ghost layer contains the cells across the owned faces, which is all
+//! a face based scheme reads.  Cells with a partition id of \e num_parts or
+//! more, like the ghost cells of another rank, are owned by no sub-domain.
+//!
+//! \param [in] mesh the mesh object
+//! \param [in] parts  the partition id of each cell
+//! \param [in] num_parts  the number of partitions
+//! \return the list of sub-domains
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+subdomains_t decompose(
+  const T & mesh,
+  const std::vector<std::size_t> & parts,
+  std::size_t num_parts
+) {
+  using counter_t = typename T::counter_t;
+
+  auto cs = mesh.cells();
+  auto num_regions = mesh.num_regions();
+
+  if ( parts.size() != cs.size() )
+    raise_runtime_error( 
+      "Got " << parts.size() << " partition ids for " << cs.size() << " cells"
+    );
+
+  subdomains_t subdomains( num_parts );
+
+  // the owned cells
+  for ( auto c : cs ) {
+    auto p = parts[c.id()];
+    if ( p < num_parts ) subdomains[p].cells.emplace_back( c.id() );
+  }
+
+  // the owned faces
+  for ( auto f : mesh.faces() ) {
+    auto owner = num_parts;
+    for ( auto c : mesh.cells(f) ) owner = std::min( owner, parts[c.id()] );
+    if ( owner < num_parts ) subdomains[owner].faces.emplace_back( f.id() );
+  }
+
+  // the regions and the ghost cells, each sub-domain is independent
+  #pragma omp parallel for
+  for ( counter_t p=0; p<num_parts; ++p ) {
+    auto & sub = subdomains[p];
+
+    // group the cells by region, keeping them sorted within each one
+    std::stable_sort( 
+      sub.cells.begin(), sub.cells.end(),
+      [&]( auto a, auto b ) { return cs[a]->region() < cs[b]->region(); }
+    );
+    sub.region_offsets.assign( num_regions + 1, 0 );
+    for ( auto cid : sub.cells ) sub.region_offsets[ cs[cid]->region() + 1 ]++;
+    std::partial_sum( 
+      sub.region_offsets.begin(), sub.region_offsets.end(), 
+      sub.region_offsets.begin() 
+    );
+
+    auto fs = mesh.faces();
+    for ( auto fid : sub.faces )
+      for ( auto n : mesh.cells( fs[fid] ) )
+        if ( parts[n.id()] != static_cast<std::size_t>(p) ) 
+          sub.ghost_cells.emplace_back( n.id() );
+    std::sort( sub.ghost_cells.begin(), sub.ghost_cells.end() );
+    sub.ghost_cells.erase(
+      std::unique( sub.ghost_cells.begin(), sub.ghost_cells.end() ),
+      sub.ghost_cells.end()
+    );
+  }
+
+  return subdomains;
+}
+
+} // namespace
+} // namespace
@@ -16,3 +16,48 @@
 
 // portage library includes
 #include <portage/driver/driver.h>
+
+namespace flecsale {
+namespace mesh {
+
+namespace detail {
+
+//! \brief Picks the first order portage driver for a number of dimensions.
+//! \{
+template< int N, typename M, typename S >
+struct portage_1st_order_driver;
+
+template< typename M, typename S >
+struct portage_1st_order_driver<2, M, S> {
+  using type = Portage::Driver<
+    Portage::SearchKDTree,
+    Portage::IntersectR2D,
+    Portage::Interpolate_1stOrder,
+    2, M, S
+  >;
+};
+
+template< typename M, typename S >
+struct portage_1st_order_driver<3, M, S> {
+  using type = Portage::Driver<
+    Portage::SearchKDTree,
+    Portage::IntersectR3D,
+    Portage::Interpolate_1stOrder,
+    3, M, S
+  >;
+};
+//! \}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The first order portage remap driver for a mesh type.
+//! \tparam M  the mesh type
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+using portage_1st_order_driver_t = typename detail::portage_1st_order_driver<
+  M::num_dimensions, portage_mesh_t<M>, portage_state_t<M>
+>::type;
+
+} // namespace
+} // namespace
@@ -18,6 +18,7 @@
 #include <portage/wonton/mesh/AuxMeshTopology.h>
 
 // system includes
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <vector>
@@ -191,6 +192,9 @@ public:
     cells_(mesh.cells()), faces_(mesh.faces()),
     vertices_(mesh.vertices()), mesh_(&mesh)
   {
+    // the adjacency lists are needed before the auxiliary entities are built
+    update_adjacency();
+
     // base class (AuxMeshTopology) method that has to be called here
     // and not in the constructor of the base class because it needs
     // access to methods in this class which in turn need access to
@@ -397,16 +401,10 @@ public:
     std::vector<T> *adj_cells
   ) const 
   {
-    auto this_cell = cells_[cell_id];
-    adj_cells->clear();
-    // Loop over all nodes of this cell
-    for (auto node : mesh_->vertices(this_cell)) {
-      // Loop over all cells associated with this node
-      for (auto cell : mesh_->cells(node)) {
-        if (cell != this_cell)
-          adj_cells->emplace_back(cell.global_id());
-      }
-    }
+    adj_cells->assign(
+      cell_adj_cells_.begin() + cell_adj_offsets_[cell_id],
+      cell_adj_cells_.begin() + cell_adj_offsets_[cell_id+1]
+    );
   }
 
   //! \brief Get "adjacent" nodes of given node
@@ -425,20 +423,17 @@ public:
     std::vector<T> *adj_nodes
   ) const 
   {
-    auto this_node = vertices_[node_id];
-    adj_nodes->clear();
-    // Loop over cells associated with this node
-    for (auto cell : mesh_->cells(this_node)) {
-      // Loop over nodes of this cell
-      for (auto node : mesh_->vertices(cell)) {
-        if (this_node != node)
-          adj_nodes->emplace_back(node.global_id());
-      }
-    }
+    adj_nodes->assign(
+      node_adj_nodes_.begin() + node_adj_offsets_[node_id],
+      node_adj_nodes_.begin() + node_adj_offsets_[node_id+1]
+    );
   }
 
   //! @brief Get adjacent "dual cells" of a given "dual cell"
   //!
+  //! The dual cells of two nodes are adjacent if the nodes share a cell, so
+  //! these are the same as the cell adjacent nodes.
+  //!
   //! \param [in] node_id  The node index
   //! \param [in] type  The type of indexes to include (ghost, shared, 
   //!   all, etc...) 
@@ -450,20 +445,9 @@ public:
     std::vector<T> *adj_nodes
   ) const 
   {
-    auto this_node = vertices_[node_id];
-    adj_nodes->clear();
-    // Loop over cells associated with this node
-    for (auto cell : mesh_->cells(this_node)) {
-      // Loop over the nodes associated with this cell
-      for (auto node : mesh_->vertices(cell)) {
-        if (this_node != node)
-          adj_nodes->emplace_back(node.global_id());
-      }
-    }
+    node_get_cell_adj_nodes( node_id, type, adj_nodes );
   }
 
-
-
   //!  \brief Get the coords of a node
   //!  \param[in] node_id The ID of the node.
   //!  \param[in,out] pp The Portage::Point object containing the coordinate
@@ -610,6 +594,65 @@ public:
     return element_type_t::UNKNOWN_TOPOLOGY;
   }
 
+  //============================================================================
+  // Public Members Specific To This Wrapper
+  //============================================================================
+
+  //! \brief Rebuild the node adjacency lists.
+  //!
+  //! Portage asks for the neighbors of each entity many times during the
+  //! search and intersection, so they are built once and stored in
+  //! compressed row storage.  Each list is sorted and has no duplicates.
+  //! This only has to be called again if the topology of the mesh changes,
+  //! moving the vertices does not invalidate the lists.
+  void update_adjacency()
+  {
+    // gather the unique neighbors of each entity, excluding itself
+    auto build = []( 
+      const auto & ents, auto && get_neighbors, 
+      std::vector<size_t> & offsets, std::vector<size_t> & indices
+    ) {
+      offsets.assign( 1, 0 );
+      offsets.reserve( ents.size()+1 );
+      indices.clear();
+      for ( auto e : ents ) {
+        auto start = indices.size();
+        get_neighbors( e, indices );
+        auto first = indices.begin() + start;
+        std::sort( first, indices.end() );
+        indices.erase( std::unique( first, indices.end() ), indices.end() );
+        indices.erase( 
+          std::remove( first, indices.end(), e.id() ), indices.end()
+        );
+        offsets.emplace_back( indices.size() );
+      }
+    };
+
+    // cells that share a node
+    build( 
+      cells_, 
+      [this]( auto c, auto & ids ) {
+        for ( auto v : mesh_->vertices(c) )
+          for ( auto n : mesh_->cells(v) )
+            ids.emplace_back( n.id() );
+      },
+      cell_adj_offsets_,
+      cell_adj_cells_
+    );
+
+    // nodes that share a cell
+    build( 
+      vertices_, 
+      [this]( auto v, auto & ids ) {
+        for ( auto c : mesh_->cells(v) )
+          for ( auto n : mesh_->vertices(c) )
+            ids.emplace_back( n.id() );
+      },
+      node_adj_offsets_,
+      node_adj_nodes_
+    );
+  }
+
   //============================================================================
   // Private Members
   //============================================================================
@@ -625,6 +668,19 @@ private:
   //! \brief the list of veritices
   decltype( mesh_->vertices() ) vertices_;
 
+  //! \brief the cells sharing a node with each cell, in compressed row
+  //! storage
+  //! \{
+  std::vector<size_t> cell_adj_offsets_;
+  std::vector<size_t> cell_adj_cells_;
+  //! \}
+  //! \brief the nodes sharing a cell with each node, in compressed row
+  //! storage
+  //! \{
+  std::vector<size_t> node_adj_offsets_;
+  std::vector<size_t> node_adj_nodes_;
+  //! \}
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -9,6 +9,7 @@
 #pragma once
 
 // user includes
+#include "flecsale/utils/errors.h"
 
 // library includes
 #include <portage/support/portage.h>
@@ -17,6 +18,8 @@
 #include <utility>
 #include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace flecsale {
 namespace mesh {
@@ -70,6 +73,36 @@ public:
   //============================================================================
 
 
+  //! \brief Rebuild the index of fields by name.
+  //!
+  //! Portage looks up each variable by name several times per remap, so the
+  //! field locations and data pointers are gathered once into a hash table.
+  //! The index is built on the first lookup, and rebuilt whenever a name is
+  //! not found, so fields registered after this wrapper was created are
+  //! picked up.  Call this if the storage of an existing field moves.
+  void update_fields() const
+  {
+    fields_.clear();
+
+    auto add_fields = [this]( auto && field_list, entity_kind_t kind ) {
+      for (auto var : field_list) {
+        // the first match wins, the cells are searched before the nodes
+        fields_.emplace( var.label(), field_t{ kind, &var[0] } );
+      }
+    };
+
+    add_fields(
+      flecsi_get_accessors_all(*mesh_, real_t, dense, 0, flecsi_is_at(cells)),
+      entity_kind_t::CELL
+    );
+    add_fields(
+      flecsi_get_accessors_all(*mesh_, real_t, dense, 0, flecsi_is_at(vertices)),
+      entity_kind_t::NODE
+    );
+
+    fields_built_ = true;
+  }
+
   //! \brief Get the entity type on which the given field is defined
   //! \param[in] var_name The string name of the data field
   //! \return The Entity_kind enum for the entity type on which the field is defined
@@ -78,23 +111,10 @@ public:
   //!        OR WE HAVE TO GENERALIZE THE FIND FUNCTION!!!
   //! \todo  THIS ALSO DOES NOT CHECK FOR OTHER ENTITY TYPES LIKE EDGE, FACE,
   //!        SIDE, WEDGE AND CORNER
-  entity_kind_t get_entity(std::string var_name) const 
+  entity_kind_t get_entity(const std::string & var_name) const 
   {
-    auto cell_field_list = flecsi_get_accessors_all(
-      *mesh_, real_t, dense, 0, flecsi_is_at(cells)
-    );
-    for (auto var : cell_field_list)
-      if (var.label() == var_name) 
-        return entity_kind_t::CELL;
-
-    auto nodal_field_list = flecsi_get_accessors_all(
-      *mesh_, real_t, dense, 0, flecsi_is_at(vertices)
-    );
-    for (auto var : nodal_field_list)
-      if (var.label() == var_name) 
-        return entity_kind_t::NODE;
-
-    return entity_kind_t::UNKNOWN_KIND;
+    auto field = find_field( var_name );
+    return field ? field->kind : entity_kind_t::UNKNOWN_KIND;
   }
 
 
@@ -105,34 +125,35 @@ public:
   template <class T>
   void get_data(
     entity_kind_t on_what,
-    std::string var_name, 
+    const std::string & var_name, 
     T ** data
   ) const {
     // Ignore on_what here - the state manager knows where it lives
     // based on its name
+    auto field = find_field( var_name );
 
-    // first check cells
-    auto cell_field_list = flecsi_get_accessors_all(
-      *mesh_, real_t, dense, 0, flecsi_is_at(cells)
-    );
-    for (auto var : cell_field_list)
-      if (var.label() == var_name) {
-        *data = &var[0];
-        return;
-      }
+    // if we didnt find it, there is something wrong
+    if ( !field )
+      raise_runtime_error( "Could not find variable \"" << var_name 
+        << "\" to ReMAP!" );
 
-    // now check nodes
-    auto nodal_field_list = flecsi_get_accessors_all(
-      *mesh_, real_t, dense, 0, flecsi_is_at(vertices)
-    );
-    for (auto var : nodal_field_list)
-      if (var.label() == var_name)  {
-        *data = &var[0];
-        return;
-      }
+    *data = field->data;
+  }
 
-    // if we got here, there is something wrong
-    raise_runtime_error( "Could not find variable to ReMAP!" );
+  //! \brief Get pointers to the data of several fields at once
+  //! \param[in] on_what The entity type on which to get the data
+  //! \param[in] var_names The string names of the data fields
+  //! \param[in,out] data The pointers to the arrays of data, in the same
+  //!   order as the names
+  template <class T>
+  void get_data(
+    entity_kind_t on_what,
+    const std::vector<std::string> & var_names, 
+    std::vector<T *> * data
+  ) const {
+    data->resize( var_names.size() );
+    for ( std::size_t i=0; i<var_names.size(); ++i )
+      get_data( on_what, var_names[i], &(*data)[i] );
   }
 
 
@@ -181,9 +202,37 @@ public:
 
 private:
 
+  //! \brief The location and storage of a field
+  struct field_t {
+    //! \brief the entity kind the field lives on
+    entity_kind_t kind;
+    //! \brief the start of the field data
+    real_t * data;
+  };
+
+  //! \brief Find a field by name, updating the index if it is missing.
+  //! \param[in] var_name The string name of the data field
+  //! \return A pointer to the field, or null if there is no such field
+  const field_t * find_field( const std::string & var_name ) const
+  {
+    if ( !fields_built_ ) update_fields();
+    auto it = fields_.find( var_name );
+    if ( it == fields_.end() ) {
+      update_fields();
+      it = fields_.find( var_name );
+      if ( it == fields_.end() ) return nullptr;
+    }
+    return &it->second;
+  }
+
   //! \brief the flecsi mesh pointer
   mesh_t * mesh_ = nullptr;
 
+  //! \brief the fields, indexed by name
+  mutable std::unordered_map< std::string, field_t > fields_;
+  //! \brief true once the index has been built
+  mutable bool fields_built_ = false;
+
 };  // Flecsi_State_Wrapper
 
 } // namespace 
@@ -13,6 +13,8 @@
 #include "portage_2d_test.h"
 
 // system includes
+#include <algorithm>
+#include <map>
 #include <vector>
 
 namespace math = flecsale::math;
@@ -103,6 +105,99 @@ TEST_F(portage_2d, first_order)
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! \brief check the cached neighbor lists
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(portage_2d, adjacency)
+{
+
+  // number of cells wide and high
+  constexpr size_t num_x = 5;
+  constexpr size_t num_y = 4;
+
+  auto mesh_a = mesh::box<mesh_t>( num_x, num_y, 0, 0, 1, 1 );
+  portage_mesh_t mesh_wrapper( mesh_a );
+
+  constexpr auto all = Portage::Entity_type::ALL;
+  std::vector<int> adj, other;
+
+  // every list is unique, excludes itself, and is symmetric
+  auto check = [&]( auto num_ents, auto && get ) {
+    std::map<size_t, size_t> counts;
+    for ( size_t i=0; i<num_ents; ++i ) {
+      get( i, &adj );
+      EXPECT_TRUE( std::is_sorted( adj.begin(), adj.end() ) );
+      EXPECT_EQ( std::adjacent_find( adj.begin(), adj.end() ), adj.end() );
+      EXPECT_EQ( std::count( adj.begin(), adj.end(), i ), 0 );
+      for ( auto j : adj ) {
+        get( j, &other );
+        EXPECT_EQ( std::count( other.begin(), other.end(), i ), 1 );
+      }
+      counts[ adj.size() ]++;
+    }
+    return counts;
+  };
+
+  // the interior cells touch eight others, the corners three
+  auto cell_counts = check( mesh_a.num_cells(), [&]( auto i, auto * a ) {
+    mesh_wrapper.cell_get_node_adj_cells( i, all, a );
+  } );
+  EXPECT_EQ( cell_counts[8], (num_x-2)*(num_y-2) );
+  EXPECT_EQ( cell_counts[3], 4 );
+
+  // the interior nodes share a cell with eight others, the corners three
+  auto node_counts = check( mesh_a.num_vertices(), [&]( auto i, auto * a ) {
+    mesh_wrapper.node_get_cell_adj_nodes( i, all, a );
+  } );
+  EXPECT_EQ( node_counts[8], (num_x-1)*(num_y-1) );
+  EXPECT_EQ( node_counts[3], 4 );
+
+  // the dual cells are adjacent through the same nodes
+  for ( size_t i=0; i<mesh_a.num_vertices(); ++i ) {
+    mesh_wrapper.node_get_cell_adj_nodes( i, all, &adj );
+    mesh_wrapper.dual_cell_get_node_adj_cells( i, all, &other );
+    EXPECT_EQ( adj, other );
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief check the field lookups by name
+////////////////////////////////////////////////////////////////////////////////
+TEST_F(portage_2d, state_lookup)
+{
+
+  auto mesh_a = mesh::box<mesh_t>( 4, 4, 0, 0, 1, 1 );
+
+  // the wrapper can be created before the fields are registered
+  portage_state_t state_wrapper( mesh_a );
+
+  flecsi_register_data(mesh_a, hydro, cell_data, real_t, dense, 1, cells);
+  flecsi_register_data(mesh_a, hydro, node_data, real_t, dense, 1, vertices);
+
+  auto a = flecsi_get_accessor(mesh_a, hydro, cell_data, real_t, dense, 0);
+  auto b = flecsi_get_accessor(mesh_a, hydro, node_data, real_t, dense, 0);
+
+  using entity_kind_t = Portage::Entity_kind;
+
+  EXPECT_EQ( state_wrapper.get_entity("cell_data"), entity_kind_t::CELL );
+  EXPECT_EQ( state_wrapper.get_entity("node_data"), entity_kind_t::NODE );
+  EXPECT_EQ( state_wrapper.get_entity("no_data"), entity_kind_t::UNKNOWN_KIND );
+
+  real_t * data = nullptr;
+  state_wrapper.get_data( entity_kind_t::CELL, "cell_data", &data );
+  EXPECT_EQ( data, &a[0] );
+
+  // several fields at once
+  std::vector<std::string> var_names = { "node_data", "cell_data" };
+  std::vector<real_t *> all_data;
+  state_wrapper.get_data( entity_kind_t::CELL, var_names, &all_data );
+  ASSERT_EQ( all_data.size(), 2 );
+  EXPECT_EQ( all_data[0], &b[0] );
+  EXPECT_EQ( all_data[1], &a[0] );
+
+}
+
 #ifdef HAVE_EXODUS
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,231 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some functionality for improving the quality of a mesh that has
+///        been moved with the flow.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/common/types.h"
+#include "flecsale/mesh/partition.h"
+#include "flecsale/utils/mpi_utils.h"
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief The vertex adjacency graph in compressed row storage.
+////////////////////////////////////////////////////////////////////////////////
+struct vertex_graph_t {
+  //! \brief The offsets of the neighbors of each vertex, with one extra entry.
+  std::vector<common::local_index_t> offsets;
+  //! \brief The neighbor indices.
+  std::vector<common::local_index_t> indices;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Build the edge adjacency graph of the vertices.
+//!
+//! \param [in] mesh the mesh object
+//! \return the vertex graph
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+vertex_graph_t vertex_graph( const T & mesh )
+{
+  auto num_verts = mesh.num_vertices();
+  check_local_index_range( num_verts, "vertices" );
+
+  vertex_graph_t graph;
+  graph.offsets.resize( num_verts + 1, 0 );
+
+  // count the neighbors first, every edge adds one to each end
+  for ( auto e : mesh.edges() )
+    for ( auto v : mesh.vertices(e) )
+      graph.offsets[ v.id() + 1 ]++;
+
+  // sum in wide integers so an overflow can be caught
+  std::size_t num_neighbors = 0;
+  for ( auto & n : graph.offsets ) {
+    num_neighbors += n;
+    n = num_neighbors;
+  }
+  check_local_index_range( num_neighbors, "vertex neighbors" );
+  graph.indices.resize( num_neighbors );
+
+  // now fill them in
+  std::vector<std::size_t> pos( graph.offsets.begin(), graph.offsets.end()-1 );
+  for ( auto e : mesh.edges() ) {
+    auto vs = mesh.vertices(e);
+    auto a = vs[0].id();
+    auto b = vs[1].id();
+    graph.indices[ pos[a]++ ] = b;
+    graph.indices[ pos[b]++ ] = a;
+  }
+
+  return graph;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Smooth the vertex positions with equipotential relaxation.
+//!
+//! Each sweep moves every interior vertex towards the average position of
+//! its edge neighbors, which is a Jacobi iteration of the discrete Laplace
+//! equations for the coordinates.  The boundary vertices are held fixed.
+//! The new positions are blended with the old ones,
+//! \f$ x \leftarrow x + \omega ( \bar{x} - x ) \f$, where \f$ \omega \f$ is
+//! the relaxation factor.
+//!
+//! The geometry is not updated.
+//!
+//! \param [in,out] mesh  the mesh object
+//! \param [in] graph  the vertex graph of the mesh
+//! \param [in] num_sweeps  the number of relaxation sweeps
+//! \param [in] relaxation  the relaxation factor, between zero and one
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void relax_vertices(
+  T & mesh,
+  const vertex_graph_t & graph,
+  std::size_t num_sweeps,
+  typename T::real_t relaxation
+) {
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  using vector_t = typename T::vector_t;
+  constexpr auto num_dims = T::num_dimensions;
+
+  auto vs = mesh.vertices();
+  counter_t num_verts = vs.size();
+
+  if ( graph.offsets.size() != static_cast<std::size_t>( num_verts + 1 ) )
+    raise_runtime_error( "The vertex graph does not match the mesh" );
+
+  // the boundary vertices stay put
+  std::vector<char> fixed( num_verts );
+  #pragma omp parallel for
+  for ( counter_t i=0; i<num_verts; ++i )
+    fixed[i] = vs[i]->is_boundary() ? 1 : 0;
+
+  std::vector<vector_t> new_coords( num_verts );
+
+  for ( std::size_t sweep=0; sweep<num_sweeps; ++sweep ) {
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_verts; ++i ) {
+      const auto & x = vs[i]->coordinates();
+      auto start = graph.offsets[i];
+      auto end = graph.offsets[i+1];
+      if ( fixed[i] || end == start ) {
+        new_coords[i] = x;
+        continue;
+      }
+      vector_t avg( 0 );
+      for ( auto j=start; j<end; ++j ) {
+        const auto & xn = vs[ graph.indices[j] ]->coordinates();
+        for ( int d=0; d<num_dims; ++d ) avg[d] += xn[d];
+      }
+      real_t fact = relaxation / (end - start);
+      for ( int d=0; d<num_dims; ++d )
+        new_coords[i][d] = x[d] + fact * avg[d] - relaxation * x[d];
+    }
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_verts; ++i )
+      vs[i]->coordinates() = new_coords[i];
+
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the quality of the worst cell.
+//!
+//! The quality of a cell is \f$ h^d / V \f$, where \e h is its minimum
+//! length and \e V its volume.  It is one for a square or a cube, and goes
+//! to zero as a cell is flattened.  Only the owned cells are checked, and
+//! the result is the minimum over all the ranks.
+//!
+//! \param [in] mesh  the mesh object, with up to date geometry
+//! \return the minimum cell quality
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+typename T::real_t min_cell_quality( const T & mesh )
+{
+  using counter_t = typename T::counter_t;
+  using real_t = typename T::real_t;
+  constexpr auto num_dims = T::num_dimensions;
+
+  auto cs = mesh.cells();
+  counter_t num_cells = mesh.num_owned_cells();
+  auto volume = mesh.cell_volumes();
+  auto min_length = mesh.cell_min_lengths();
+
+  auto quality = std::numeric_limits<real_t>::max();
+
+  #pragma omp parallel for reduction( min : quality )
+  for ( counter_t i=0; i<num_cells; ++i ) {
+    auto c = cs[i];
+    auto q = std::pow( min_length[c], num_dims ) / volume[c];
+    // an inverted cell is as bad as it gets
+    if ( !( volume[c] > 0 ) ) q = 0;
+    quality = std::min( quality, q );
+  }
+
+  return utils::global_min( quality );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Recover the specific state of a cell from remapped conserved
+//!        quantities.
+//!
+//! The velocity and internal energy are the remapped momentum and energy
+//! divided by the remapped density.  Total energy is conserved unless that
+//! would leave a non-positive internal energy, in which case the remapped
+//! internal energy is used.
+//!
+//! A remap can leave a cell with next to no mass, and dividing by its
+//! density would give a meaningless velocity and energy.  If the remapped 
+//! density is not above \e min_density, or is not a number, the cell keeps
+//! the state it had before the remap.
+//!
+//! \param [in] rho  the remapped density
+//! \param [in] mom  the remapped momentum per unit volume
+//! \param [in] rho_et  the remapped total energy per unit volume
+//! \param [in] rho_ie  the remapped internal energy per unit volume
+//! \param [in] min_density  the smallest density that is divided by
+//! \param [in,out] d  the density, holding the value before the remap
+//! \param [in,out] v  the velocity, holding the value before the remap
+//! \param [in,out] e  the specific internal energy, holding the value 
+//!                    before the remap
+//! \return false if the density collapsed and the cell was left alone
+////////////////////////////////////////////////////////////////////////////////
+template< typename R, typename V >
+bool recover_remapped_state( 
+  R rho, const V & mom, R rho_et, R rho_ie, R min_density, 
+  R & d, V & v, R & e 
+) {
+  if ( !( rho > min_density ) || !std::isfinite( rho ) ) return false;
+
+  d = rho;
+  R ke = 0;
+  for ( std::size_t dim=0; dim<v.size(); ++dim ) {
+    v[dim] = mom[dim] / rho;
+    ke += v[dim] * v[dim];
+  }
+  auto ie = rho_et / rho - 0.5 * ke;
+  e = ( ie > 0 ) ? ie : rho_ie / rho;
+  return true;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,517 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief A bounding volume hierarchy for locating points in the cells of a
+///        burton mesh.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace flecsale {
+namespace mesh {
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check if a point is inside a triangle.
+//! \param [in] a,b,c  The triangle vertices.
+//! \param [in] x  The point.
+//! \param [in] tol  The relative tolerance on the barycentric coordinates.
+//! \return True if \e x is inside, or within \e tol of the boundary.
+////////////////////////////////////////////////////////////////////////////////
+template< typename A, typename B, typename C, typename X, typename T >
+bool simplex_contains(
+  const A & a, const B & b, const C & c, const X & x, T tol,
+  std::integral_constant<std::size_t, 2>
+) {
+  auto orient = []( const auto & p, const auto & q, const auto & r ) {
+    return (q[0]-p[0])*(r[1]-p[1]) - (q[1]-p[1])*(r[0]-p[0]);
+  };
+  auto det = orient( a, b, c );
+  if ( det == 0 ) return false;
+  auto thresh = - tol * det * det;
+  // each barycentric coordinate, scaled by det^2
+  return
+    orient( x, b, c ) * det >= thresh &&
+    orient( a, x, c ) * det >= thresh &&
+    orient( a, b, x ) * det >= thresh;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Check if a point is inside a tetrahedron.
+//! \param [in] a,b,c,d  The tetrahedron vertices.
+//! \param [in] x  The point.
+//! \param [in] tol  The relative tolerance on the barycentric coordinates.
+//! \return True if \e x is inside, or within \e tol of the boundary.
+////////////////////////////////////////////////////////////////////////////////
+template< 
+  typename A, typename B, typename C, typename D, typename X, typename T 
+>
+bool simplex_contains(
+  const A & a, const B & b, const C & c, const D & d, const X & x, T tol,
+  std::integral_constant<std::size_t, 3>
+) {
+  auto orient = [](
+    const auto & p, const auto & q, const auto & r, const auto & s
+  ) {
+    T u[3], v[3], w[3];
+    for ( int i=0; i<3; ++i ) {
+      u[i] = q[i] - p[i];
+      v[i] = r[i] - p[i];
+      w[i] = s[i] - p[i];
+    }
+    return
+      u[0]*(v[1]*w[2] - v[2]*w[1]) -
+      u[1]*(v[0]*w[2] - v[2]*w[0]) +
+      u[2]*(v[0]*w[1] - v[1]*w[0]);
+  };
+  auto det = orient( a, b, c, d );
+  if ( det == 0 ) return false;
+  auto thresh = - tol * det * det;
+  // each barycentric coordinate, scaled by det^2
+  return
+    orient( x, b, c, d ) * det >= thresh &&
+    orient( a, x, c, d ) * det >= thresh &&
+    orient( a, b, x, d ) * det >= thresh &&
+    orient( a, b, c, x ) * det >= thresh;
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A bounding volume hierarchy over the cells of a mesh.
+//!
+//! The tree is built once over the bounding boxes of the cells by splitting
+//! at the median along the longest axis.  When the vertices move, refit()
+//! recomputes the boxes bottom-up without changing the tree, which is much
+//! cheaper than a rebuild and stays efficient as long as the mesh does not
+//! tangle too much.  Call rebuild() if the cells were renumbered or the
+//! queries slow down.
+//!
+//! A point is located by descending into every box that contains it and
+//! testing the candidate cells exactly.  Each cell is split into triangles
+//! (2d) or tetrahedra (3d) that share the cell centroid, the same way its
+//! volume is computed, so non-convex but star-shaped cells are handled.
+//!
+//! The index keeps a reference to the mesh, so it must not outlive it.
+//!
+//! \tparam M  The mesh type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename M >
+class cell_search_t {
+
+public:
+
+  //============================================================================
+  // Typedefs
+  //============================================================================
+
+  //! \brief the mesh type
+  using mesh_t = M;
+
+  //! \brief the number of dimensions
+  static constexpr std::size_t num_dimensions = mesh_t::num_dimensions;
+
+  //! \brief the real type
+  using real_t = typename mesh_t::real_t;
+
+  //! \brief the loop counter type
+  using counter_t = typename mesh_t::counter_t;
+
+  //! \brief an axis aligned bounding box, stored as the min and max corners
+  struct box_t {
+    std::array<real_t, num_dimensions> min;
+    std::array<real_t, num_dimensions> max;
+  };
+
+  //! \brief The id returned when no cell contains the point.
+  static constexpr std::size_t invalid = std::numeric_limits<std::size_t>::max();
+
+  //! \brief The maximum number of cells in a leaf.
+  static constexpr std::size_t leaf_size = 4;
+
+  //============================================================================
+  // Construction
+  //============================================================================
+
+  //! \brief Constructor.
+  //! \param [in] mesh  The mesh to index.
+  //! \param [in] tolerance  How far outside a cell a point may be, relative
+  //!   to the size of the cell, and still be found in it.
+  cell_search_t(
+    const mesh_t & mesh,
+    real_t tolerance = 100 * std::numeric_limits<real_t>::epsilon()
+  ) : mesh_(&mesh), tolerance_(tolerance)
+  {
+    rebuild();
+  }
+
+  //! \brief Rebuild the tree from scratch.
+  void rebuild()
+  {
+    auto num_cells = mesh_->num_cells();
+
+    compute_cell_boxes();
+
+    // the box centers are what gets sorted
+    centers_.resize( num_cells );
+    for ( std::size_t i=0; i<num_cells; ++i )
+      for ( std::size_t d=0; d<num_dimensions; ++d )
+        centers_[i][d] = (cell_boxes_[i].min[d] + cell_boxes_[i].max[d]) / 2;
+
+    cell_ids_.resize( num_cells );
+    std::iota( cell_ids_.begin(), cell_ids_.end(), 0 );
+
+    nodes_.clear();
+    nodes_.reserve( 2 * num_cells / leaf_size + 1 );
+    if ( num_cells > 0 ) build( 0, num_cells );
+
+    centers_.clear();
+    centers_.shrink_to_fit();
+  }
+
+  //! \brief Update the boxes after the vertices have moved.
+  //!
+  //! The tree structure is kept, so this is only valid if the mesh
+  //! connectivity did not change.
+  void refit()
+  {
+    if ( cell_ids_.size() != mesh_->num_cells() )
+      raise_runtime_error(
+        "The mesh changed from " << cell_ids_.size() << " to "
+        << mesh_->num_cells() << " cells, the search tree needs a rebuild"
+      );
+
+    compute_cell_boxes();
+
+    // the children always come after their parent, so walking backwards
+    // visits them first.  Leaves are done in parallel.
+    counter_t num_nodes = nodes_.size();
+
+    #pragma omp parallel for
+    for ( counter_t n=0; n<num_nodes; ++n ) {
+      auto & node = nodes_[n];
+      if ( node.count == 0 ) continue;
+      node.box = cell_boxes_[ cell_ids_[node.first] ];
+      for ( auto i=node.first+1; i<node.first+node.count; ++i )
+        expand( node.box, cell_boxes_[ cell_ids_[i] ] );
+    }
+
+    for ( counter_t n=num_nodes-1; n>=0; --n ) {
+      auto & node = nodes_[n];
+      if ( node.count > 0 ) continue;
+      node.box = nodes_[n+1].box;
+      expand( node.box, nodes_[node.right].box );
+    }
+  }
+
+  //============================================================================
+  // Queries
+  //============================================================================
+
+  //! \brief Return the number of cells indexed.
+  std::size_t num_cells() const
+  { return cell_ids_.size(); }
+
+  //! \brief Return the bounding box of the whole mesh.
+  const box_t & bounds() const
+  {
+    assert( !nodes_.empty() && "the mesh has no cells" );
+    return nodes_.front().box;
+  }
+
+  //! \brief Call a function with every cell whose box overlaps a box.
+  //!
+  //! This gives the candidates for an intersection search, like the ones
+  //! needed by a remap.
+  //!
+  //! \param [in] box  The box to search.
+  //! \param [in] f  Called as f(id) for each candidate cell.
+  template< typename F >
+  void for_each_overlap( const box_t & box, F && f ) const
+  {
+    traverse(
+      [&]( const box_t & b ) { return overlaps( b, box ); },
+      std::forward<F>(f)
+    );
+  }
+
+  //! \brief Find the cell containing a point.
+  //! \param [in] x  The point.
+  //! \return The cell id, or #invalid if the point is outside the mesh.  A
+  //!   point on a shared face can be returned in either cell.
+  template< typename P >
+  std::size_t find_cell( const P & x ) const
+  {
+    std::size_t found = invalid;
+    traverse(
+      [&]( const box_t & b ) { return found == invalid && contains( b, x ); },
+      [&]( std::size_t id ) {
+        if ( found == invalid && cell_contains( id, x ) ) found = id;
+      }
+    );
+    return found;
+  }
+
+  //! \brief Find the cells containing a list of points, in parallel.
+  //! \param [in] xs  The points, indexable by [0,n).
+  //! \param [out] ids  The cell ids, indexable by [0,n), see find_cell().
+  template< typename P, typename I >
+  void find_cells( const P & xs, I && ids ) const
+  {
+    counter_t num_points = xs.size();
+    #pragma omp parallel for schedule(dynamic, 64)
+    for ( counter_t i=0; i<num_points; ++i )
+      ids[i] = find_cell( xs[i] );
+  }
+
+  //! \brief Check if a cell contains a point.
+  //! \param [in] id  The cell id.
+  //! \param [in] x  The point.
+  //! \return True if \e x is inside the cell, to within the tolerance.
+  template< typename P >
+  bool cell_contains( std::size_t id, const P & x ) const
+  {
+    return cell_contains(
+      id, x, std::integral_constant<std::size_t, num_dimensions>()
+    );
+  }
+
+private:
+
+  //============================================================================
+  // Private Types
+  //============================================================================
+
+  //! \brief A node of the tree.  The left child of an interior node
+  //! immediately follows it.
+  struct node_t {
+    //! the bounding box of everything below
+    box_t box;
+    //! the first cell in cell_ids_, for a leaf
+    std::size_t first = 0;
+    //! the number of cells, zero for an interior node
+    std::size_t count = 0;
+    //! the index of the right child, for an interior node
+    std::size_t right = 0;
+  };
+
+  //============================================================================
+  // Private Member Functions
+  //============================================================================
+
+  //! \brief Grow a box to include another.
+  static void expand( box_t & a, const box_t & b )
+  {
+    for ( std::size_t d=0; d<num_dimensions; ++d ) {
+      a.min[d] = std::min( a.min[d], b.min[d] );
+      a.max[d] = std::max( a.max[d], b.max[d] );
+    }
+  }
+
+  //! \brief Check if two boxes overlap.
+  static bool overlaps( const box_t & a, const box_t & b )
+  {
+    for ( std::size_t d=0; d<num_dimensions; ++d )
+      if ( a.max[d] < b.min[d] || b.max[d] < a.min[d] ) return false;
+    return true;
+  }
+
+  //! \brief Check if a box contains a point.
+  template< typename P >
+  static bool contains( const box_t & a, const P & x )
+  {
+    for ( std::size_t d=0; d<num_dimensions; ++d )
+      if ( x[d] < a.min[d] || x[d] > a.max[d] ) return false;
+    return true;
+  }
+
+  //! \brief Compute the bounding box of every cell, padded by the tolerance.
+  void compute_cell_boxes()
+  {
+    auto cs = mesh_->cells();
+    counter_t num_cells = cs.size();
+    cell_boxes_.resize( num_cells );
+
+    #pragma omp parallel for
+    for ( counter_t i=0; i<num_cells; ++i ) {
+      auto & box = cell_boxes_[i];
+      box.min.fill(  std::numeric_limits<real_t>::max() );
+      box.max.fill( -std::numeric_limits<real_t>::max() );
+      for ( auto v : mesh_->vertices( cs[i] ) ) {
+        const auto & x = v->coordinates();
+        for ( std::size_t d=0; d<num_dimensions; ++d ) {
+          box.min[d] = std::min( box.min[d], x[d] );
+          box.max[d] = std::max( box.max[d], x[d] );
+        }
+      }
+      for ( std::size_t d=0; d<num_dimensions; ++d ) {
+        auto pad = tolerance_ * ( box.max[d] - box.min[d] );
+        box.min[d] -= pad;
+        box.max[d] += pad;
+      }
+    }
+  }
+
+  //! \brief Build the subtree over cell_ids_[first, last).
+  //! \return The index of the new node.
+  std::size_t build( std::size_t first, std::size_t last )
+  {
+    auto n = nodes_.size();
+    nodes_.emplace_back();
+
+    // the box of everything, and the bounds of the centers
+    auto box = cell_boxes_[ cell_ids_[first] ];
+    box_t centers{ centers_[cell_ids_[first]], centers_[cell_ids_[first]] };
+    for ( auto i=first+1; i<last; ++i ) {
+      auto id = cell_ids_[i];
+      expand( box, cell_boxes_[id] );
+      expand( centers, box_t{ centers_[id], centers_[id] } );
+    }
+    nodes_[n].box = box;
+
+    // small enough for a leaf
+    if ( last - first <= leaf_size ) {
+      nodes_[n].first = first;
+      nodes_[n].count = last - first;
+      return n;
+    }
+
+    // split at the median along the longest axis of the centers
+    std::size_t axis = 0;
+    for ( std::size_t d=1; d<num_dimensions; ++d )
+      if ( centers.max[d] - centers.min[d] > centers.max[axis] - centers.min[axis] )
+        axis = d;
+    auto mid = first + (last - first) / 2;
+    std::nth_element(
+      cell_ids_.begin() + first,
+      cell_ids_.begin() + mid,
+      cell_ids_.begin() + last,
+      [&]( auto a, auto b ) { return centers_[a][axis] < centers_[b][axis]; }
+    );
+
+    // the left child is next, the right one goes after the whole left subtree
+    build( first, mid );
+    auto right = build( mid, last );
+    nodes_[n].right = right;
+    return n;
+  }
+
+  //! \brief Walk the tree.
+  //! \param [in] visit  Called with a box, returns true to descend into it.
+  //! \param [in] f  Called with the id of each cell in a visited leaf.
+  template< typename V, typename F >
+  void traverse( V && visit, F && f ) const
+  {
+    if ( nodes_.empty() ) return;
+
+    // the depth is logarithmic because of the median splits
+    std::array<std::size_t, 64> stack;
+    std::size_t top = 0;
+    stack[top++] = 0;
+
+    while ( top > 0 ) {
+      const auto & node = nodes_[ stack[--top] ];
+      if ( !visit( node.box ) ) continue;
+      if ( node.count > 0 ) {
+        for ( auto i=node.first; i<node.first+node.count; ++i ) {
+          auto id = cell_ids_[i];
+          if ( visit( cell_boxes_[id] ) ) f( id );
+        }
+      }
+      else {
+        assert( top+2 <= stack.size() );
+        stack[top++] = node.right;
+        stack[top++] = &node - nodes_.data() + 1;
+      }
+    }
+  }
+
+  //! \brief Check if a polygon contains a point.
+  template< typename P >
+  bool cell_contains(
+    std::size_t id, const P & x, std::integral_constant<std::size_t, 2> tag
+  ) const {
+    auto c = mesh_->cells()[id];
+    const auto & xc = mesh_->cell_centroids()[c];
+    auto vs = mesh_->vertices(c);
+    auto n = vs.size();
+    for ( std::size_t i=0; i<n; ++i ) {
+      const auto & a = vs[i]->coordinates();
+      const auto & b = vs[ (i+1) % n ]->coordinates();
+      if ( detail::simplex_contains( xc, a, b, x, tolerance_, tag ) )
+        return true;
+    }
+    return false;
+  }
+
+  //! \brief Check if a polyhedron contains a point.
+  template< typename P >
+  bool cell_contains(
+    std::size_t id, const P & x, std::integral_constant<std::size_t, 3> tag
+  ) const {
+    auto c = mesh_->cells()[id];
+    const auto & xc = mesh_->cell_centroids()[c];
+    for ( auto f : mesh_->faces(c) ) {
+      auto vs = mesh_->vertices(f);
+      auto n = vs.size();
+      // the face center
+      auto xf = vs[0]->coordinates();
+      for ( std::size_t i=1; i<n; ++i ) xf += vs[i]->coordinates();
+      xf /= static_cast<real_t>(n);
+      for ( std::size_t i=0; i<n; ++i ) {
+        const auto & a = vs[i]->coordinates();
+        const auto & b = vs[ (i+1) % n ]->coordinates();
+        if ( detail::simplex_contains( xc, xf, a, b, x, tolerance_, tag ) )
+          return true;
+      }
+    }
+    return false;
+  }
+
+  //============================================================================
+  // Private Data
+  //============================================================================
+
+  //! \brief the mesh being searched
+  const mesh_t * mesh_ = nullptr;
+
+  //! \brief the relative tolerance of the containment tests
+  real_t tolerance_ = 0;
+
+  //! \brief the nodes, in depth first order
+  std::vector<node_t> nodes_;
+
+  //! \brief the cell ids, in leaf order
+  std::vector<std::size_t> cell_ids_;
+
+  //! \brief the padded bounding box of each cell
+  std::vector<box_t> cell_boxes_;
+
+  //! \brief the box centers, only kept during a build
+  std::vector< std::array<real_t, num_dimensions> > centers_;
+
+};
+
+//! \brief the definition of the invalid id, for when it is bound to a reference
+template< typename M >
+constexpr std::size_t cell_search_t<M>::invalid;
+
+} // namespace mesh
+} // namespace flecsale
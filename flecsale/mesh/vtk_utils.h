@@ -11,6 +11,7 @@
 
 // user includes
 #include "flecsale/io/vtk.h"
+#include "flecsale/mesh/output_fields.h"
 
 #ifdef HAVE_VTK
 #  include <vtkCellArray.h>
@@ -128,6 +129,7 @@ static auto write_fields_to_vtk( M & m, vtkUnstructuredGrid* ug )
   auto rspav = flecsi_get_accessors_all(
     m, real_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
+  filter_output_fields( rspav );
   for(auto sf: rspav) {
     auto label = validate_string( sf.label() );      
     auto vals = vtkSmartPointer< typename vtk_array_t<real_t>::type >::New();
@@ -141,6 +143,7 @@ static auto write_fields_to_vtk( M & m, vtkUnstructuredGrid* ug )
   auto ispav = flecsi_get_accessors_all(
     m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
+  filter_output_fields( ispav );
   for(auto sf: ispav) {
     auto label = validate_string( sf.label() );
     auto vals = vtkSmartPointer< typename vtk_array_t<integer_t>::type >::New();
@@ -154,6 +157,7 @@ static auto write_fields_to_vtk( M & m, vtkUnstructuredGrid* ug )
   auto rvpav = flecsi_get_accessors_all(
     m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,vertices)
   );
+  filter_output_fields( rvpav );
   for(auto vf: rvpav) {
     auto label = validate_string( vf.label() );
     auto vals = vtkSmartPointer< typename vtk_array_t<real_t>::type >::New();
@@ -176,23 +180,21 @@ static auto write_fields_to_vtk( M & m, vtkUnstructuredGrid* ug )
   auto cd = ug->GetCellData();
 
 
-  // real scalars persistent at cells
-  auto rspac = flecsi_get_accessors_all(
-    m, real_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
-  );
-  for(auto sf: rspac) {
+  // real scalars persistent at cells, in either precision
+  for_each_output_real_field( m, [&]( auto && sf ) {
     auto label = validate_string( sf.label() );      
     auto vals = vtkSmartPointer< typename vtk_array_t<real_t>::type >::New();
     vals->SetNumberOfValues( num_cells );
     vals->SetName( label.c_str() );
     for(auto c: m.cells()) vals->SetValue( c.id(), sf[c] );
     cd->AddArray( vals );
-  } // for
+  } );
 
   // int scalars persistent at cells
   auto ispac = flecsi_get_accessors_all(
     m, integer_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
   );
+  filter_output_fields( ispac );
   for(auto sf: ispac) {
     auto label = validate_string( sf.label() );
     auto vals = vtkSmartPointer< typename vtk_array_t<integer_t>::type >::New();
@@ -206,6 +208,7 @@ static auto write_fields_to_vtk( M & m, vtkUnstructuredGrid* ug )
   auto rvpac = flecsi_get_accessors_all(
     m, vector_t, dense, 0, flecsi_has_attribute_at(persistent,cells)
   );
+  filter_output_fields( rvpac );
   for(auto vf: rvpac) {
     auto label = validate_string( vf.label() );
     auto vals = vtkSmartPointer< typename vtk_array_t<real_t>::type >::New();
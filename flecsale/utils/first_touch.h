@@ -0,0 +1,88 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Storage whose pages are placed by the threads that first write it.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief An allocator that default initializes instead of value
+//!        initializing.
+//!
+//! A std::vector value initializes every element it adds, so resizing a
+//! vector of numbers writes zeros to all of it from the calling thread.
+//! Under a first-touch memory policy that puts every page on the socket of
+//! that one thread.  With this allocator, elements added without a value
+//! are left uninitialized, and the pages are only placed once the elements
+//! are first written, which can then be done in parallel.  Elements added
+//! with a value are constructed as usual.
+//!
+//! \tparam T  The value type.
+//! \tparam A  The allocator to adapt.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename A = std::allocator<T> >
+class default_init_allocator : public A {
+
+  //! \brief The traits of the adapted allocator.
+  using traits_t = std::allocator_traits<A>;
+
+public:
+
+  //! \brief Rebind to another value type.
+  template< typename U >
+  struct rebind {
+    using other = default_init_allocator<
+      U, typename traits_t::template rebind_alloc<U>
+    >;
+  };
+
+  //! \brief Use the constructors of the adapted allocator.
+  using A::A;
+
+  //! \brief Default initialize an element.
+  //! \param [in] p  Where to construct the element.
+  template< typename U >
+  void construct( U * p )
+    noexcept( std::is_nothrow_default_constructible<U>::value )
+  { ::new( static_cast<void*>(p) ) U; }
+
+  //! \brief Construct an element from some arguments.
+  //! \param [in] p  Where to construct the element.
+  //! \param [in] args  The constructor arguments.
+  template< typename U, typename... Args >
+  void construct( U * p, Args &&... args )
+  {
+    traits_t::construct( 
+      static_cast<A&>(*this), p, std::forward<Args>(args)... 
+    );
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief A vector that is not zeroed when it grows.
+//!
+//! Resize it, and then write every element in a parallel loop with the same
+//! static schedule as the loops that use it.
+//!
+//! \tparam T  The value type.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+using first_touch_vector = std::vector< T, default_init_allocator<T> >;
+
+} // namespace
+} // namespace
@@ -0,0 +1,244 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Some thin wrappers around the MPI functionality used by the apps.
+///
+/// Without MPI, or before MPI is initialized, everything behaves as if
+/// there was a single rank.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// user includes
+#include "flecsale/utils/errors.h"
+
+// system includes
+#ifdef HAVE_MPI
+#  include <mpi.h>
+#endif
+
+#include <cstddef>
+
+namespace flecsale {
+namespace utils {
+
+#ifdef HAVE_MPI
+
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Map a c++ type to an mpi datatype.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+struct mpi_type {};
+
+//! \brief Define an mpi type specialization.
+#define FLECSALE_MPI_TYPE( type, mpi_datatype )                                \
+  template<>                                                                   \
+  struct mpi_type<type> {                                                      \
+    static MPI_Datatype value() { return mpi_datatype; }                       \
+  }
+
+FLECSALE_MPI_TYPE( char, MPI_CHAR );
+FLECSALE_MPI_TYPE( int, MPI_INT );
+FLECSALE_MPI_TYPE( unsigned, MPI_UNSIGNED );
+FLECSALE_MPI_TYPE( long, MPI_LONG );
+FLECSALE_MPI_TYPE( unsigned long, MPI_UNSIGNED_LONG );
+FLECSALE_MPI_TYPE( long long, MPI_LONG_LONG );
+FLECSALE_MPI_TYPE( unsigned long long, MPI_UNSIGNED_LONG_LONG );
+FLECSALE_MPI_TYPE( float, MPI_FLOAT );
+FLECSALE_MPI_TYPE( double, MPI_DOUBLE );
+
+#undef FLECSALE_MPI_TYPE
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return true if mpi is currently usable.
+////////////////////////////////////////////////////////////////////////////////
+inline bool mpi_active()
+{
+  int initialized = 0, finalized = 0;
+  MPI_Initialized( &initialized );
+  MPI_Finalized( &finalized );
+  return initialized && !finalized;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Reduce an array in place over all ranks.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void all_reduce( T * data, std::size_t n, MPI_Op op )
+{
+  if ( !mpi_active() ) return;
+  auto ret = MPI_Allreduce(
+    MPI_IN_PLACE, data, n, mpi_type<T>::value(), op, MPI_COMM_WORLD
+  );
+  if ( ret != MPI_SUCCESS )
+    raise_runtime_error( "MPI_Allreduce failed with error " << ret );
+}
+
+} // namespace detail
+
+#endif // HAVE_MPI
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the rank of this process.
+////////////////////////////////////////////////////////////////////////////////
+inline int comm_rank()
+{
+#ifdef HAVE_MPI
+  int rank = 0;
+  if ( detail::mpi_active() ) MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  return rank;
+#else
+  return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the number of ranks.
+////////////////////////////////////////////////////////////////////////////////
+inline int comm_size()
+{
+#ifdef HAVE_MPI
+  int size = 1;
+  if ( detail::mpi_active() ) MPI_Comm_size( MPI_COMM_WORLD, &size );
+  return size;
+#else
+  return 1;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sum an array in place over all ranks.
+//! \param [in,out] data  The values to sum.
+//! \param [in] n  The number of values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void global_sum( T * data, std::size_t n )
+{
+#ifdef HAVE_MPI
+  detail::all_reduce( data, n, MPI_SUM );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the sum of a value over all ranks.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T global_sum( T x )
+{
+  global_sum( &x, 1 );
+  return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Take the maximum of an array in place over all ranks.
+//! \param [in,out] data  The values.
+//! \param [in] n  The number of values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void global_max( T * data, std::size_t n )
+{
+#ifdef HAVE_MPI
+  detail::all_reduce( data, n, MPI_MAX );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Take the minimum of an array in place over all ranks.
+//! \param [in,out] data  The values.
+//! \param [in] n  The number of values.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void global_min( T * data, std::size_t n )
+{
+#ifdef HAVE_MPI
+  detail::all_reduce( data, n, MPI_MIN );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the maximum of a value over all ranks.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T global_max( T x )
+{
+#ifdef HAVE_MPI
+  detail::all_reduce( &x, 1, MPI_MAX );
+#endif
+  return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return the minimum of a value over all ranks.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T global_min( T x )
+{
+#ifdef HAVE_MPI
+  detail::all_reduce( &x, 1, MPI_MIN );
+#endif
+  return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Return true if the flag is set on any rank.
+////////////////////////////////////////////////////////////////////////////////
+inline bool global_or( bool flag )
+{
+  int x = flag ? 1 : 0;
+  return global_max( x ) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Makes sure mpi is initialized for the lifetime of this object.
+//!
+//! If the runtime already initialized mpi, nothing is done.  Otherwise mpi
+//! is initialized here and finalized when this object is destroyed.
+////////////////////////////////////////////////////////////////////////////////
+class mpi_session_t {
+
+public:
+
+  //! \brief Main constructor.
+  //! \param [in,out] argc,argv  The command line arguments.
+  mpi_session_t( int & argc, char ** & argv )
+  {
+#ifdef HAVE_MPI
+    int initialized = 0;
+    MPI_Initialized( &initialized );
+    if ( !initialized ) {
+      MPI_Init( &argc, &argv );
+      owner_ = true;
+    }
+#endif
+  }
+
+  //! \brief Destructor, finalizes mpi if it was initialized here.
+  ~mpi_session_t()
+  {
+#ifdef HAVE_MPI
+    int finalized = 0;
+    MPI_Finalized( &finalized );
+    if ( owner_ && !finalized ) MPI_Finalize();
+#endif
+  }
+
+  //! \brief Disallow copying.
+  //! \{
+  mpi_session_t( const mpi_session_t & ) = delete;
+  mpi_session_t & operator=( const mpi_session_t & ) = delete;
+  //! \}
+
+private:
+
+  //! \brief True if this object initialized mpi.
+  bool owner_ = false;
+
+};
+
+} // namespace
+} // namespace
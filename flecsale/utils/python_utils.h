@@ -17,6 +17,11 @@
 // use python
 #include <Python.h>
 
+// system includes
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
 namespace flecsale {
 namespace utils {
 
@@ -196,6 +201,118 @@ auto python_get_value( double arg )
   return pvalue;
 }
 
+//! \brief Pass an existing object as an argument.  A new reference is 
+//! returned, since setting a tuple element steals it.
+inline auto python_get_value( PyObject * arg )
+{
+  Py_INCREF(arg);
+  return arg;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief The buffer protocol format character of a type.
+///////////////////////////////////////////////////////////////////////////////
+template< typename T, typename Enable = void >
+struct python_buffer_format {};
+
+template<> struct python_buffer_format<float>
+{ static constexpr const char * value = "f"; };
+
+template<> struct python_buffer_format<double>
+{ static constexpr const char * value = "d"; };
+
+template< typename T >
+struct python_buffer_format< T, 
+  std::enable_if_t< std::is_integral<T>::value && std::is_signed<T>::value > 
+> {
+  static constexpr const char * value = 
+    sizeof(T) == 1 ? "b" : sizeof(T) == 2 ? "h" : sizeof(T) == 4 ? "i" : "q";
+};
+
+template< typename T >
+struct python_buffer_format< T, 
+  std::enable_if_t< std::is_integral<T>::value && std::is_unsigned<T>::value > 
+> {
+  static constexpr const char * value = 
+    sizeof(T) == 1 ? "B" : sizeof(T) == 2 ? "H" : sizeof(T) == 4 ? "I" : "Q";
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Wrap an array in a python memoryview, without copying it.
+//!
+//! The array is laid out in C order.  It has to outlive the view, and 
+//! anything created from it, such as a NumPy array.
+//!
+//! \param [in] data  The start of the array.
+//! \param [in] shape  The extents of each dimension.
+//! \param [in] writable  If true, python may modify the data.
+//! \return A new reference to the view.
+///////////////////////////////////////////////////////////////////////////////
+template< typename T >
+auto python_array_view( 
+  T * data, const std::vector<Py_ssize_t> & shape, bool writable = true 
+) {
+#if PY_MAJOR_VERSION < 3
+  raise_implemented_error("Array views need python 3.");
+  return static_cast<PyObject*>(nullptr);
+#else
+  Py_ssize_t n = 1;
+  for ( auto s : shape ) n *= s;
+
+  // the view copies the shape, but keeps pointing to the format
+  Py_buffer buffer;
+  buffer.buf = const_cast< std::remove_const_t<T> * >( data );
+  buffer.obj = nullptr;
+  buffer.len = n * sizeof(T);
+  buffer.itemsize = sizeof(T);
+  buffer.readonly = writable ? 0 : 1;
+  buffer.ndim = shape.size();
+  buffer.format = const_cast<char*>( python_buffer_format<T>::value );
+  buffer.shape = const_cast<Py_ssize_t*>( shape.data() );
+  buffer.strides = nullptr;
+  buffer.suboffsets = nullptr;
+  buffer.internal = nullptr;
+
+  auto pview = PyMemoryView_FromBuffer( &buffer );
+  if (!pview) {
+    python_check();
+    raise_runtime_error("Cannot create array view.");
+  }
+  return pview;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Create a new, empty python dictionary.
+//! \return A new reference to the dictionary.
+///////////////////////////////////////////////////////////////////////////////
+inline auto python_new_dict()
+{
+  auto pdict = PyDict_New();
+  if (!pdict) {
+    python_check();
+    raise_runtime_error("Cannot create dictionary.");
+  }
+  return pdict;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Add an item to a python dictionary.
+//! \param [in,out] py_dict  The dictionary.
+//! \param [in] key  The key.
+//! \param [in] py_value  The value.  Its reference is stolen.
+///////////////////////////////////////////////////////////////////////////////
+inline void python_set_item( 
+  PyObject * py_dict, const std::string & key, PyObject * py_value 
+) {
+  auto err = PyDict_SetItemString(py_dict, key.c_str(), py_value);
+  Py_DECREF(py_value);
+  if (err) {
+    python_check();
+    raise_runtime_error("Cannot set item \"" << key << "\".");
+  }
+}
+
 auto python_get_tuple_element( PyObject * py_tup, std::size_t i )
 {
   auto n = PyTuple_GET_SIZE(py_tup);
@@ -284,6 +401,30 @@ auto python_call_function( PyObject * py_func, Args&&... args )
   return pval;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Convert a buffer to a NumPy array, without copying it.
+//!
+//! If NumPy is not available, the buffer itself is returned.
+//!
+//! \param [in] py_buffer  The object supporting the buffer protocol.  Its 
+//!                        reference is stolen.
+//! \return A new reference to the array.
+///////////////////////////////////////////////////////////////////////////////
+inline auto python_as_numpy( PyObject * py_buffer )
+{
+  auto pnumpy = PyImport_ImportModule("numpy");
+  if (!pnumpy) {
+    PyErr_Clear();
+    return py_buffer;
+  }
+  auto pfunc = python_get_attribute(pnumpy, "asarray");
+  auto parray = python_call_function(pfunc, py_buffer);
+  Py_DECREF(pfunc);
+  Py_DECREF(pnumpy);
+  Py_DECREF(py_buffer);
+  return parray;
+}
+
 
 } // namespace utils
 } // namespace flecsale
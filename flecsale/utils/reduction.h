@@ -0,0 +1,144 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief Reductions whose result does not depend on the number of threads.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// system includes
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace flecsale {
+namespace utils {
+
+//! \brief The default number of items summed sequentially in each block.
+constexpr std::size_t reduction_block_size = 256;
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sums a range of items in a fixed order.
+//!
+//! An OpenMP reduction adds the thread-private sums in whatever order the
+//! threads finish, so the rounding changes with the number of threads.
+//! Here the range is cut into blocks whose bounds only depend on the
+//! number of items.  Each block is summed sequentially, by whichever thread
+//! owns it, and the block sums are then combined with a fixed pairwise tree.
+//! The result is bitwise identical for any number of threads, and the
+//! pairwise step keeps the rounding error growing like log(n) across blocks.
+//!
+//! \code
+//!   blocked_sum_t<real_t> sum( n, 0 );
+//!   auto num_blocks = sum.num_blocks();
+//!   #pragma omp parallel for
+//!   for ( std::size_t b=0; b<num_blocks; ++b ) {
+//!     real_t block_sum(0);
+//!     for ( auto i=sum.begin(b); i<sum.end(b); ++i ) block_sum += x[i];
+//!     sum[b] = block_sum;
+//!   }
+//!   auto total = sum.sum();
+//! \endcode
+//!
+//! \tparam T  The type of the sum.  It needs a copy constructor and +=.
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+class blocked_sum_t {
+
+public:
+
+  //! \brief Constructor.
+  //! \param [in] n  The number of items to sum.
+  //! \param [in] zero  The value of an empty sum.
+  //! \param [in] block_size  The number of items in each block.
+  blocked_sum_t(
+    std::size_t n,
+    const T & zero,
+    std::size_t block_size = reduction_block_size
+  ) : size_(n), block_size_( std::max<std::size_t>(block_size, 1) ),
+      partials_( (n + block_size_ - 1) / block_size_, zero ), zero_(zero)
+  {}
+
+  //! \brief Return the number of blocks.
+  std::size_t num_blocks() const
+  { return partials_.size(); }
+
+  //! \brief Return the first item of block \e b.
+  std::size_t begin( std::size_t b ) const
+  { return b * block_size_; }
+
+  //! \brief Return one past the last item of block \e b.
+  std::size_t end( std::size_t b ) const
+  { return std::min( (b+1) * block_size_, size_ ); }
+
+  //! \brief Access the sum of block \e b.
+  //!
+  //! Accumulate into a local and store it once, since neighboring blocks
+  //! share cache lines.
+  T & operator[]( std::size_t b )
+  { return partials_[b]; }
+
+  //! \brief Combine the block sums with a fixed pairwise tree.
+  //! \return The total.
+  T sum() const
+  {
+    if ( partials_.empty() ) return zero_;
+    auto tree = partials_;
+    auto n = tree.size();
+    for ( std::size_t stride=1; stride<n; stride*=2 )
+      for ( std::size_t i=0; i+stride<n; i+=2*stride )
+        tree[i] += tree[i+stride];
+    return tree[0];
+  }
+
+private:
+
+  //! \brief the number of items
+  std::size_t size_ = 0;
+  //! \brief the number of items per block
+  std::size_t block_size_ = reduction_block_size;
+  //! \brief the sum of each block
+  std::vector<T> partials_;
+  //! \brief the value of an empty sum
+  T zero_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! \brief Sum over a range in parallel, independent of the number of threads.
+//!
+//! \param [in] n  The number of items.
+//! \param [in] zero  The value of an empty sum.
+//! \param [in] f  Called as f(i, sum) for each item i, in order within a
+//!                block.  It adds the contribution of item i to sum.
+//! \param [in] block_size  The number of items in each block.
+//! \return The total.
+//! \see blocked_sum_t
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+T reproducible_sum(
+  std::size_t n,
+  const T & zero,
+  F && f,
+  std::size_t block_size = reduction_block_size
+) {
+  blocked_sum_t<T> sum( n, zero, block_size );
+  auto num_blocks = sum.num_blocks();
+
+  #pragma omp parallel for
+  for ( std::size_t b=0; b<num_blocks; ++b ) {
+    T block_sum( zero );
+    auto end = sum.end(b);
+    for ( auto i=sum.begin(b); i<end; ++i ) f( i, block_sum );
+    sum[b] = block_sum;
+  }
+
+  return sum.sum();
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,46 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/first_touch.h"
+
+// system includes
+#include <cinchtest.h>
+#include <string>
+
+using namespace flecsale::utils;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test that a first touch vector behaves like a vector.
+///////////////////////////////////////////////////////////////////////////////
+TEST(first_touch, vector) {
+
+  // the uninitialized values are all written in parallel
+  first_touch_vector<double> x;
+  x.resize( 1000 );
+  long long n = x.size();
+  #pragma omp parallel for schedule(static)
+  for ( long long i=0; i<n; ++i ) x[i] = i;
+  for ( long long i=0; i<n; ++i ) ASSERT_EQ( i, x[i] );
+
+  // growing with a value still sets the new elements
+  x.resize( 1010, -1 );
+  for ( long long i=n; i<1010; ++i ) ASSERT_EQ( -1, x[i] );
+  ASSERT_EQ( n-1, x[n-1] );
+
+  // the existing values survive a reallocation
+  x.reserve( 10*x.capacity() );
+  for ( long long i=0; i<n; ++i ) ASSERT_EQ( i, x[i] );
+
+  // and anything with a constructor is still constructed
+  first_touch_vector<std::string> s( 3 );
+  for ( const auto & si : s ) ASSERT_TRUE( si.empty() );
+  s.emplace_back( "abc" );
+  ASSERT_EQ( "abc", s.back() );
+
+} // TEST
@@ -8,3 +8,11 @@ def square(list):
 
 def add(a, b):
     return a + b
+
+def scale(a, f):
+    for i in range(len(a)):
+        a[i] *= f
+    return len(a)
+
+def columns(a):
+    return a.shape[1]
@@ -81,5 +81,45 @@ TEST(python_utils, embedded)
 
 } // TEST
 
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test handing arrays to python without copying them.
+///////////////////////////////////////////////////////////////////////////////
+TEST(python_utils, array_view) 
+{
+
+  // setup the python interpreter
+  python_initialize();
+  auto py_path = python_add_to_path(".");
+  auto py_module = python_import( "python_test" );
+
+  // python modifies the original data
+  std::vector<double> data = { 1, 2, 3, 4, 5, 6 };
+  auto py_view = python_array_view( data.data(), {6} );
+  auto py_func = python_get_attribute(py_module, "scale");
+  auto py_res = python_call_function( py_func, py_view, 2. );
+  ASSERT_EQ( 6, python_as_long(py_res) );
+  for ( int i=0; i<6; ++i ) ASSERT_EQ( 2*(i+1), data[i] );
+  python_free(py_res);
+  python_free(py_func);
+  python_free(py_view);
+
+  // the shape is kept
+  py_view = python_array_view( data.data(), {3, 2} );
+  py_func = python_get_attribute(py_module, "columns");
+  py_res = python_call_function( py_func, py_view );
+  ASSERT_EQ( 2, python_as_long(py_res) );
+  python_free(py_res);
+  python_free(py_func);
+  python_free(py_view);
+
+  // free up references.
+  python_free(py_module);
+  python_free(py_path);
+
+  // shut down python
+  python_finalize();
+
+} // TEST
+
 
 #endif // HAVE_PYTHON
@@ -0,0 +1,79 @@
+/*~-------------------------------------------------------------------------~~*
+ * Copyright (c) 2016 Los Alamos National Laboratory, LLC
+ * All rights reserved
+ *~-------------------------------------------------------------------------~~*/
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+////////////////////////////////////////////////////////////////////////////////
+
+// user includes
+#include "flecsale/utils/reduction.h"
+
+// system includes
+#include <cinchtest.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// explicitly use some stuff
+using std::vector;
+
+using namespace flecsale::utils;
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test the block bounds.
+///////////////////////////////////////////////////////////////////////////////
+TEST(reduction, blocks) {
+
+  blocked_sum_t<int> sum( 10, 0, 4 );
+  ASSERT_EQ( 3, sum.num_blocks() );
+  ASSERT_EQ( 0, sum.begin(0) );
+  ASSERT_EQ( 4, sum.end(0) );
+  ASSERT_EQ( 8, sum.begin(2) );
+  ASSERT_EQ( 10, sum.end(2) );
+
+  for ( std::size_t b=0; b<sum.num_blocks(); ++b )
+    sum[b] = sum.end(b) - sum.begin(b);
+  ASSERT_EQ( 10, sum.sum() );
+
+  blocked_sum_t<int> empty( 0, 7 );
+  ASSERT_EQ( 0, empty.num_blocks() );
+  ASSERT_EQ( 7, empty.sum() );
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//! \brief Test that the sum does not change with the number of threads.
+///////////////////////////////////////////////////////////////////////////////
+TEST(reduction, reproducible) {
+
+  // values spanning many orders of magnitude, so the order matters
+  std::size_t n = 100000;
+  vector<double> x(n);
+  for ( std::size_t i=0; i<n; ++i )
+    x[i] = std::sin( 0.37*i ) * std::pow( 10., static_cast<int>(i % 17) - 8 );
+
+  auto add = [&x]( auto i, double & sum ) { sum += x[i]; };
+
+  auto expected = reproducible_sum( n, 0., add );
+
+#ifdef _OPENMP
+  auto max_threads = omp_get_max_threads();
+  for ( int nt : {1, 2, 3, 4, 7} ) {
+    omp_set_num_threads( nt );
+    auto actual = reproducible_sum( n, 0., add );
+    ASSERT_EQ( 0, std::memcmp( &expected, &actual, sizeof(double) ) );
+  }
+  omp_set_num_threads( max_threads );
+#endif
+
+  // the serial sum should agree to within roundoff
+  double serial(0);
+  for ( auto xi : x ) serial += xi;
+  ASSERT_NEAR( serial, expected, 1.e-12 * std::abs(serial) + 1.e-12 );
+
+}
@@ -57,7 +57,8 @@ def numSplit(line):
 ################################################################################
 # check for numerical equivalence
 ################################################################################
-def softEquiv(ref, target, relative_tolerance, absolute_tolerance):
+def softEquiv(ref, target, relative_tolerance, absolute_tolerance,
+              scaled_tolerance=-1.):
 
 
     isEquiv = True
@@ -82,6 +83,13 @@ def softEquiv(ref, target, relative_tolerance, absolute_tolerance):
             absolute_tolerance > 0 ) :
         isEquiv = False
 
+    # check the tolerance scaled by the magnitude, which is relative for
+    # large values and absolute for values smaller than one
+    # .. ignore if negative tolerance
+    elif ( err > max(ref_abs, 1.) * scaled_tolerance and
+            scaled_tolerance > 0 ) :
+        isEquiv = False
+
     # return the results
     return [isEquiv, err, rel_err]
 
@@ -140,7 +148,8 @@ def compareStrings(f, options, expLine, actLine, lineNum):
     for col in range(0, len(exp)):
         expVal = exp[col]
         actVal = act[col]
-        [isEquiv, abs_err, rel_err] = softEquiv(expVal, actVal, options.rel_tol, options.abs_tol)
+        [isEquiv, abs_err, rel_err] = softEquiv(expVal, actVal, options.rel_tol, options.abs_tol,
+                                              options.scaled_tol)
 
         # for very verbose, always print errors
         if options.verbosity > VERBOSE:
@@ -233,6 +242,10 @@ if __name__ == '__main__':
                       action="store", type="float", dest="abs_tol", default=-1.,
                       help="Absolute error when comparing doubles.")
 
+    parser.add_option("-s", "--scaled",
+                      action="store", type="float", dest="scaled_tol", default=-1.,
+                      help="Error relative to max(|value|,1) when comparing doubles.")
+
     (options, args) = parser.parse_args()
 
     # print usage
@@ -242,7 +255,7 @@ if __name__ == '__main__':
 
 
     # check if relative or absolute tolerance was specified
-    if options.rel_tol < 0 and options.abs_tol < 0:
+    if options.rel_tol < 0 and options.abs_tol < 0 and options.scaled_tol < 0:
         options.abs_tol = options.tol
         options.rel_tol = options.tol
 
@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+#####################################################################
+# File: scaling.py
+#
+# Description: Run the hydro apps over a range of box mesh sizes and
+#   OpenMP thread counts, and tabulate the per-task wall times and
+#   the parallel efficiency.
+#
+#   Each run uses a small lua wrapper that loads the original input
+#   deck and overrides the mesh dimensions, the number of steps and
+#   turns off the solution output.  The per-task timings are collected
+#   through the apps' "--timings" option.
+#
+# Example:
+#
+#   scaling.py --build-dir build --apps hydro_2d,maire_hydro_2d \
+#     --sizes 100,200,400 --threads 1,2,4,8 --bind close \
+#     --places cores --output scaling.csv
+#####################################################################
+
+import os
+import sys
+import csv
+import shutil
+import subprocess
+import tempfile
+from optparse import OptionParser
+
+################################################################################
+# The known apps
+################################################################################
+
+# the location of the executable and the default input deck, relative
+# to the build and source directories respectively
+APPS = {
+    "hydro_2d" :
+        ( "apps/hydro/2d/hydro_2d", "apps/hydro/2d/shock_box_2d.lua", 2 ),
+    "hydro_3d" :
+        ( "apps/hydro/3d/hydro_3d", "apps/hydro/3d/shock_box_3d.lua", 3 ),
+    "maire_hydro_2d" :
+        ( "apps/maire_hydro/2d/maire_hydro_2d",
+          "apps/maire_hydro/2d/sedov_2d.lua", 2 ),
+    "maire_hydro_3d" :
+        ( "apps/maire_hydro/3d/maire_hydro_3d",
+          "apps/maire_hydro/3d/sedov_3d.lua", 3 ),
+}
+
+# the lua wrapper template
+WRAPPER = """
+dofile("{input}")
+hydro.mesh.dimensions = {{ {dims} }}
+hydro.output_freq = 0
+hydro.max_steps = {steps}
+
+-- decks that size a source by the cell size, like sedov, compute it from
+-- their own mesh dimensions, so redo it for the new ones
+if delta_vol ~= nil then
+  local m = hydro.mesh
+  num_cells = m.dimensions
+  delta_vol = 1
+  delta_r = 1.e-12
+  for i = 1,#num_cells do
+    local dx = (m.xmax[i] - m.xmin[i]) / num_cells[i]
+    delta_vol = delta_vol * dx
+    delta_r = delta_r + math.pow( dx/2, 2 )
+  end
+  delta_r = math.sqrt( delta_r )
+end
+"""
+
+################################################################################
+# Parse a comma separated list
+################################################################################
+def parse_list(string, conv=str):
+    return [ conv(s) for s in string.split(",") if s.strip() ]
+
+################################################################################
+# Parse a mesh size.  "N" means N cells in every direction, while
+# "NxM" or "NxMxL" sets each direction explicitly.
+################################################################################
+def parse_size(string, num_dims):
+    dims = [ int(s) for s in string.split("x") ]
+    if len(dims) == 1:
+        dims = dims * num_dims
+    if len(dims) != num_dims:
+        raise ValueError(
+            "Size '%s' does not match a %dd mesh" % (string, num_dims) )
+    return dims
+
+################################################################################
+# Read the timings csv written by an app
+################################################################################
+def read_timings(filename):
+    timings = {}
+    with open(filename) as f:
+        for row in csv.DictReader(f):
+            timings[ row["task"] ] = \
+                ( int(row["calls"]), float(row["seconds"]) )
+    return timings
+
+################################################################################
+# Run one case and return its timings
+################################################################################
+def run_case(options, exe, input_file, dims, threads, work_dir):
+
+    # write the lua wrapper
+    wrapper = os.path.join(work_dir, "scaling.lua")
+    with open(wrapper, "w") as f:
+        f.write( WRAPPER.format(
+            input = os.path.abspath(input_file).replace("\\", "/"),
+            dims = ", ".join( str(d) for d in dims ),
+            steps = options.steps ) )
+
+    # set the threading environment
+    env = dict(os.environ)
+    env["OMP_NUM_THREADS"] = str(threads)
+    if options.bind:
+        env["OMP_PROC_BIND"] = options.bind
+    if options.places:
+        env["OMP_PLACES"] = options.places
+
+    # the numa placement policy
+    cmd = []
+    if options.numa == "interleave":
+        cmd = [ "numactl", "--interleave=all" ]
+    elif options.numa == "localalloc":
+        cmd = [ "numactl", "--localalloc" ]
+
+    timings_file = os.path.join(work_dir, "timings.csv")
+    cmd += [ exe, "-f", wrapper, "--timings", timings_file ]
+
+    # run the case as many times as requested and keep the fastest total
+    best = None
+    for i in range(options.repeat):
+        if options.verbose:
+            print( " ".join(cmd) )
+        with open(os.devnull, "w") as devnull:
+            stdout = None if options.verbose else devnull
+            subprocess.check_call( cmd, env=env, cwd=work_dir, stdout=stdout )
+        timings = read_timings(timings_file)
+        if best is None or timings["total"][1] < best["total"][1]:
+            best = timings
+
+    return best
+
+################################################################################
+# Main
+################################################################################
+def main():
+
+    usage = "usage: %prog [options]"
+    parser = OptionParser(usage=usage)
+    parser.add_option("-b", "--build-dir", dest="build_dir", default="build",
+                      help="The build directory containing the apps.")
+    parser.add_option("-s", "--source-dir", dest="source_dir",
+                      default=os.path.join(os.path.dirname(__file__), ".."),
+                      help="The source directory containing the input decks.")
+    parser.add_option("-a", "--apps", dest="apps",
+                      default="hydro_2d,hydro_3d,maire_hydro_2d,maire_hydro_3d",
+                      help="A comma separated list of apps to run.")
+    parser.add_option("-i", "--input", dest="input", default=None,
+                      help="Override the input deck used for every app.")
+    parser.add_option("-n", "--sizes", dest="sizes", default="50,100,200",
+                      help="A comma separated list of box sizes, e.g. "
+                      "100,200 or 100x50.")
+    parser.add_option("-t", "--threads", dest="threads", default="1,2,4,8",
+                      help="A comma separated list of thread counts.")
+    parser.add_option("-m", "--mode", dest="mode", default="strong",
+                      choices=["strong", "weak"],
+                      help="Strong scaling keeps the mesh fixed, weak scaling "
+                      "grows the first mesh dimension with the thread count.")
+    parser.add_option("--steps", dest="steps", type="int", default=20,
+                      help="The number of time steps to take.")
+    parser.add_option("-r", "--repeat", dest="repeat", type="int", default=1,
+                      help="The number of repetitions, the fastest is kept.")
+    parser.add_option("--bind", dest="bind", default=None,
+                      help="The value of OMP_PROC_BIND, e.g. close or spread.")
+    parser.add_option("--places", dest="places", default=None,
+                      help="The value of OMP_PLACES, e.g. cores or sockets.")
+    parser.add_option("--numa", dest="numa", default="default",
+                      choices=["default", "interleave", "localalloc"],
+                      help="The numactl memory placement policy.")
+    parser.add_option("-o", "--output", dest="output", default=None,
+                      help="Write the results to this csv file instead of "
+                      "stdout.")
+    parser.add_option("-v", "--verbose", dest="verbose", action="store_true",
+                      default=False, help="Show the app output.")
+
+    (options, args) = parser.parse_args()
+
+    apps = parse_list(options.apps)
+    sizes = parse_list(options.sizes)
+    threads = sorted( parse_list(options.threads, int) )
+
+    if not threads or threads[0] < 1:
+        parser.error("The thread counts must be positive")
+
+    for app in apps:
+        if app not in APPS:
+            parser.error("Unknown app '%s'" % app)
+
+    # weak scaling multiplies the mesh by the ratio of the thread counts
+    if options.mode == "weak":
+        for p in threads:
+            if p % threads[0] != 0:
+                parser.error(
+                    "Weak scaling needs every thread count to be a multiple "
+                    "of the smallest one, %d is not a multiple of %d" %
+                    (p, threads[0]) )
+
+    if options.numa != "default" and not shutil.which("numactl"):
+        parser.error("numactl is required for --numa=%s" % options.numa)
+
+    # the results
+    out = open(options.output, "w") if options.output else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow( [ "app", "mode", "size", "threads", "task", "calls",
+                       "seconds", "speedup", "efficiency" ] )
+
+    work_dir = tempfile.mkdtemp(prefix="flecsale_scaling_")
+
+    try:
+
+        for app in apps:
+
+            exe_path, input_path, num_dims = APPS[app]
+            exe = os.path.join(options.build_dir, exe_path)
+            input_file = options.input or \
+                os.path.join(options.source_dir, input_path)
+
+            for size in sizes:
+
+                base_dims = parse_size(size, num_dims)
+
+                # the timings of the smallest thread count are the baseline
+                base = None
+
+                for p in threads:
+
+                    # in weak scaling mode the work per thread is constant
+                    dims = list(base_dims)
+                    if options.mode == "weak":
+                        dims[0] *= p // threads[0]
+
+                    timings = run_case(
+                        options, exe, input_file, dims, p, work_dir )
+                    if base is None:
+                        base = timings
+
+                    for task in sorted(timings):
+                        calls, seconds = timings[task]
+                        base_seconds = base[task][1] if task in base else 0
+                        if seconds > 0 and base_seconds > 0:
+                            speedup = base_seconds / seconds
+                            if options.mode == "strong":
+                                efficiency = speedup * threads[0] / p
+                            else:
+                                efficiency = speedup
+                        else:
+                            speedup = efficiency = float("nan")
+                        writer.writerow( [
+                            app, options.mode,
+                            "x".join( str(d) for d in dims ), p, task, calls,
+                            "%.9e" % seconds, "%.4f" % speedup,
+                            "%.4f" % efficiency ] )
+
+                    out.flush()
+
+    finally:
+        shutil.rmtree(work_dir, ignore_errors=True)
+        if options.output:
+            out.close()
+
+
+if __name__ == "__main__":
+    main()